@@ -22,6 +22,8 @@ namespace UnrealBuildTool.Rules
 				new string[] {
 					"Core",
 					"CoreUObject",
+					"Engine",
+					"Json",
 					"NdiMediaFactory",
 					"Networking",
 					"Projects",
@@ -39,9 +41,16 @@ namespace UnrealBuildTool.Rules
 				new string[] {
 					"NdiMedia/Private",
 					"NdiMedia/Private/Assets",
+					"NdiMedia/Private/Metadata",
+					"NdiMedia/Private/Multiview",
 					"NdiMedia/Private/Ndi",
 					"NdiMedia/Private/Player",
+					"NdiMedia/Private/Recording",
 					"NdiMedia/Private/Shared",
+					"NdiMedia/Private/Sync",
+					"NdiMedia/Private/Tests",
+					"NdiMedia/Private/Thumbnails",
+					"NdiMedia/Private/Video",
 				}
 			);
 
@@ -51,7 +60,7 @@ namespace UnrealBuildTool.Rules
 				}
 			);
 
-			// add NDI libraries
+			// add NDI libraries (desktop platforms load the runtime dynamically, see FNdi)
 			string NdiDir = Path.GetFullPath(Path.Combine(ModuleDirectory, "..", "..", "ThirdParty"));
 
 			PrivateIncludePaths.Add(Path.Combine(NdiDir, "include"));
@@ -66,11 +75,8 @@ namespace UnrealBuildTool.Rules
             else if (Target.Platform == UnrealTargetPlatform.Linux)
 			{
                 string LibDir = Path.Combine(NdiDir, "lib", "linux", "x86_64-linux-gnu-5.4");
-                string LibPath = Path.Combine(LibDir, "libndi.a");
                 string DllPath = Path.Combine(LibDir, "libndi.so.1.0.1");
 
-                PublicAdditionalLibraries.Add(LibPath);
-                PublicAdditionalLibraries.Add("stdc++");
                 RuntimeDependencies.Add(new RuntimeDependency(DllPath));
             }
 			else if (Target.Platform == UnrealTargetPlatform.Mac)
@@ -78,9 +84,6 @@ namespace UnrealBuildTool.Rules
                 string LibDir = Path.Combine(NdiDir, "lib", "apple", "x64");
                 string DllPath = Path.Combine(LibDir, "libndi.dylib");
 
-                PublicLibraryPaths.Add(LibDir);
-                PublicAdditionalLibraries.Add(DllPath);
-                PublicDelayLoadDLLs.Add(DllPath);
                 RuntimeDependencies.Add(new RuntimeDependency(DllPath));
 			}
 			else if (Target.Platform == UnrealTargetPlatform.Win32)
@@ -88,9 +91,6 @@ namespace UnrealBuildTool.Rules
                 string LibDir = Path.Combine(NdiDir, "lib", "windows", "x86");
                 string DllPath = Path.Combine(LibDir, "Processing.NDI.Lib.x86.dll");
 
-                PublicLibraryPaths.Add(LibDir);
-                PublicAdditionalLibraries.Add("Processing.NDI.Lib.x86.lib");
-                PublicDelayLoadDLLs.Add("Processing.NDI.Lib.x86.dll");
                 RuntimeDependencies.Add(new RuntimeDependency(DllPath));
             }
 			else if (Target.Platform == UnrealTargetPlatform.Win64)
@@ -98,9 +98,6 @@ namespace UnrealBuildTool.Rules
                 string LibDir = Path.Combine(NdiDir, "lib", "windows", "x64");
                 string DllPath = Path.Combine(LibDir, "Processing.NDI.Lib.x64.dll");
 
-                PublicLibraryPaths.Add(LibDir);
-                PublicAdditionalLibraries.Add("Processing.NDI.Lib.x64.lib");
-                PublicDelayLoadDLLs.Add("Processing.NDI.Lib.x64.dll");
                 RuntimeDependencies.Add(new RuntimeDependency(DllPath));
 			}
 			else
@@ -2,6 +2,8 @@
 
 #include "NdiMediaFinder.h"
 
+#include "HAL/PlatformTime.h"
+#include "INdiMediaBackend.h"
 #include "Ndi.h"
 #include "NdiMediaPrivate.h"
 
@@ -60,15 +62,15 @@ void UNdiMediaFinder::ClearGroupFilters()
 
 bool UNdiMediaFinder::GetSources(TArray<FNdiMediaSourceId>& OutSources) const
 {
-	if (!FNdi::IsInitialized() || (FindInstance == nullptr))
+	if (!Backend.IsValid() || (FindInstance == nullptr))
 	{
 		return false;
 	}
 
-	uint32_t NumSources = 0;
-	const NDIlib_source_t* Sources = NDIlib_find_get_current_sources(FindInstance, &NumSources);
+	uint32 NumSources = 0;
+	const NDIlib_source_t* Sources = Backend->FindGetCurrentSources(FindInstance, NumSources);
 
-	for (uint32_t SourceIndex = 0; SourceIndex < NumSources; ++SourceIndex)
+	for (uint32 SourceIndex = 0; SourceIndex < NumSources; ++SourceIndex)
 	{
 		const NDIlib_source_t& Source = Sources[SourceIndex];
 		OutSources.Add(FNdiMediaSourceId(
@@ -85,7 +87,11 @@ bool UNdiMediaFinder::Initialize()
 {
 	Shutdown();
 
-	if (!FNdi::IsInitialized())
+	const double StartTime = FPlatformTime::Seconds();
+
+	Backend = FNdi::GetBackend();
+
+	if (!Backend.IsValid())
 	{
 		return false;
 	}
@@ -100,14 +106,18 @@ bool UNdiMediaFinder::Initialize()
 		FindCreate.p_groups = TCHAR_TO_ANSI(*GroupsString);
 	}
 
-	FindInstance = NDIlib_find_create_v2(&FindCreate);
+	FindInstance = Backend->FindCreate(FindCreate);
 
 	if (FindInstance == nullptr)
 	{
 		UE_LOG(LogNdiMedia, Warning, TEXT("Failed to create NDI Find instance"));
+		Backend.Reset();
+
 		return false;
 	}
 
+	UE_LOG(LogNdiMedia, Log, TEXT("Started NDI source discovery in %.1f ms"), (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
 	return true;
 }
 
@@ -147,11 +157,13 @@ void UNdiMediaFinder::Shutdown()
 		return;
 	}
 
-	if (FNdi::IsInitialized())
+	// the backend keeps the runtime alive until the find instance is destroyed
+	if (Backend.IsValid())
 	{
-		NDIlib_find_destroy(FindInstance);
+		Backend->FindDestroy(FindInstance);
 	}
 
+	Backend.Reset();
 	FindInstance = nullptr;
 }
 
@@ -0,0 +1,89 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaMultiviewSource.h"
+#include "NdiMediaPrivate.h"
+
+
+/* UNdiMediaMultiviewSource structors
+ *****************************************************************************/
+
+UNdiMediaMultiviewSource::UNdiMediaMultiviewSource()
+	: Bandwidth(ENdiMediaBandwidth::Lowest)
+	, Columns(0)
+	, OutputHeight(1080)
+	, OutputWidth(1920)
+{ }
+
+
+/* IMediaOptions interface
+ *****************************************************************************/
+
+int64 UNdiMediaMultiviewSource::GetMediaOption(const FName& Key, int64 DefaultValue) const
+{
+	if (Key == NdiMedia::BandwidthOption)
+	{
+		// tiles always receive video
+		return (Bandwidth == ENdiMediaBandwidth::Highest)
+			? NDIlib_recv_bandwidth_e::NDIlib_recv_bandwidth_highest
+			: NDIlib_recv_bandwidth_e::NDIlib_recv_bandwidth_lowest;
+	}
+
+	if (Key == NdiMedia::MultiviewColumnsOption)
+	{
+		return Columns;
+	}
+
+	if (Key == NdiMedia::MultiviewHeightOption)
+	{
+		return OutputHeight;
+	}
+
+	if (Key == NdiMedia::MultiviewWidthOption)
+	{
+		return OutputWidth;
+	}
+
+	return Super::GetMediaOption(Key, DefaultValue);
+}
+
+
+bool UNdiMediaMultiviewSource::HasMediaOption(const FName& Key) const
+{
+	if ((Key == NdiMedia::BandwidthOption) ||
+		(Key == NdiMedia::MultiviewColumnsOption) ||
+		(Key == NdiMedia::MultiviewHeightOption) ||
+		(Key == NdiMedia::MultiviewWidthOption))
+	{
+		return true;
+	}
+
+	return Super::HasMediaOption(Key);
+}
+
+
+/* UMediaSource interface
+ *****************************************************************************/
+
+FString UNdiMediaMultiviewSource::GetUrl() const
+{
+	return FString(TEXT("ndimv://")) + FString::Join(Sources, TEXT("|"));
+}
+
+
+bool UNdiMediaMultiviewSource::Validate() const
+{
+	if ((OutputWidth <= 0) || (OutputHeight <= 0))
+	{
+		return false;
+	}
+
+	for (const FString& Source : Sources)
+	{
+		if (!Source.IsEmpty())
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
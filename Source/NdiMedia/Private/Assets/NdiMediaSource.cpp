@@ -4,6 +4,7 @@
 #include "NdiMediaPrivate.h"
 
 #include "Interfaces/IPv4/IPv4Endpoint.h"
+#include "NdiMediaTally.h"
 
 
 /* UNdiMediaSource structors
@@ -12,21 +13,43 @@
 UNdiMediaSource::UNdiMediaSource()
 	: Bandwidth(ENdiMediaBandwidth::Highest)
 	, ColorFormat(ENdiMediaColorFormat::UYVY)
+	, DeinterlaceMode(ENdiMediaDeinterlaceMode::Weave)
 	, PreferredNumAudioChannels(2)
 	, PreferredAudioSampleRate(48000)
 	, PreferredVideoWidth(0)
 	, PreferredVideoHeight(0)
+	, ConformVideoSize(false)
 	, PreferredFrameRateNumerator(0)
 	, PreferredFrameRateDenominator(0)
 	, PreferredFrameFormat(ENdiMediaFrameFormatPreference::NoPreference)
+	, TallyMode(ENdiMediaTallyMode::Automatic)
+	, TimeShiftDuration(0)
+	, TimeShiftMemoryBudget(512)
+	, YuvConversion(ENdiMediaYuvConversion::Sink)
+	, YuvRange(ENdiMediaYuvRange::Limited)
 { }
 
 
+/* UNdiMediaSource interface
+ *****************************************************************************/
+
+void UNdiMediaSource::SetTallyMode(ENdiMediaTallyMode Mode)
+{
+	TallyMode = Mode;
+	FNdiMediaTally::SetOverride(GetUrl(), Mode);
+}
+
+
 /* IMediaOptions interface
  *****************************************************************************/
 
 FString UNdiMediaSource::GetMediaOption(const FName& Key, const FString& DefaultValue) const
 {
+	if (Key == NdiMedia::BackupSourcesOption)
+	{
+		return FString::Join(BackupSources, TEXT("|"));
+	}
+
 	if (Key == NdiMedia::ProgressiveOption)
 	{
 		if (PreferredFrameFormat == ENdiMediaFrameFormatPreference::Fielded)
@@ -40,6 +63,21 @@ FString UNdiMediaSource::GetMediaOption(const FName& Key, const FString& Default
 		}
 	}
 
+	if (Key == NdiMedia::RecordingDirectoryOption)
+	{
+		return RecordingDirectory;
+	}
+
+	if (Key == NdiMedia::SyncGroupOption)
+	{
+		return SyncGroup;
+	}
+
+	if (Key == NdiMedia::TimeShiftSpillDirectoryOption)
+	{
+		return TimeShiftSpillDirectory;
+	}
+
 	return Super::GetMediaOption(Key, DefaultValue);
 }
 
@@ -66,6 +104,9 @@ int64 UNdiMediaSource::GetMediaOption(const FName& Key, int64 DefaultValue) cons
 		case ENdiMediaBandwidth::Lowest:
 			return NDIlib_recv_bandwidth_e::NDIlib_recv_bandwidth_lowest;
 
+		case ENdiMediaBandwidth::MetadataOnly:
+			return NDIlib_recv_bandwidth_e::NDIlib_recv_bandwidth_metadata_only;
+
 		default:
 			return NDIlib_recv_bandwidth_e::NDIlib_recv_bandwidth_highest;
 		}
@@ -73,7 +114,48 @@ int64 UNdiMediaSource::GetMediaOption(const FName& Key, int64 DefaultValue) cons
 
 	if (Key == NdiMedia::ColorFormatOption)
 	{
-		return (int64)ColorFormat;
+		switch (ColorFormat)
+		{
+		case ENdiMediaColorFormat::BGRA:
+			return NDIlib_recv_color_format_e::NDIlib_recv_color_format_e_BGRX_BGRA;
+
+		case ENdiMediaColorFormat::RGBA:
+			return NDIlib_recv_color_format_e::NDIlib_recv_color_format_e_RGBX_RGBA;
+
+		case ENdiMediaColorFormat::UYVA:
+			return NdiMedia::RecvColorFormatFastest;
+
+		case ENdiMediaColorFormat::UYVY_RGBA:
+			return NDIlib_recv_color_format_e::NDIlib_recv_color_format_e_UYVY_RGBA;
+
+		default:
+			return NDIlib_recv_color_format_e::NDIlib_recv_color_format_e_UYVY_BGRA;
+		}
+	}
+
+	if (Key == NdiMedia::ConformVideoSizeOption)
+	{
+		return ConformVideoSize ? 1 : 0;
+	}
+
+	if (Key == NdiMedia::DeinterlaceModeOption)
+	{
+		return (int64)DeinterlaceMode;
+	}
+
+	if (Key == NdiMedia::TallyModeOption)
+	{
+		return (int64)TallyMode;
+	}
+
+	if (Key == NdiMedia::TimeShiftDurationOption)
+	{
+		return TimeShiftDuration;
+	}
+
+	if (Key == NdiMedia::TimeShiftMemoryBudgetOption)
+	{
+		return TimeShiftMemoryBudget;
 	}
 
 	if (Key == NdiMedia::VideoHeightOption)
@@ -86,6 +168,16 @@ int64 UNdiMediaSource::GetMediaOption(const FName& Key, int64 DefaultValue) cons
 		return PreferredVideoWidth;
 	}
 
+	if (Key == NdiMedia::YuvConversionOption)
+	{
+		return (int64)YuvConversion;
+	}
+
+	if (Key == NdiMedia::YuvRangeOption)
+	{
+		return (int64)YuvRange;
+	}
+
 	if (Key == NdiMedia::FrameRateDOption)
 	{
 		return PreferredFrameRateDenominator;
@@ -104,13 +196,24 @@ bool UNdiMediaSource::HasMediaOption(const FName& Key) const
 {
 	if ((Key == NdiMedia::AudioChannelsOption) ||
 		(Key == NdiMedia::AudioSampleRateOption) ||
+		(Key == NdiMedia::BackupSourcesOption) ||
 		(Key == NdiMedia::BandwidthOption) ||
 		(Key == NdiMedia::ColorFormatOption) ||
+		(Key == NdiMedia::ConformVideoSizeOption) ||
+		(Key == NdiMedia::DeinterlaceModeOption) ||
 		(Key == NdiMedia::FrameRateDOption) ||
 		(Key == NdiMedia::FrameRateNOption) ||
 		(Key == NdiMedia::ProgressiveOption) ||
+		(Key == NdiMedia::RecordingDirectoryOption) ||
+		(Key == NdiMedia::SyncGroupOption) ||
+		(Key == NdiMedia::TallyModeOption) ||
+		(Key == NdiMedia::TimeShiftDurationOption) ||
+		(Key == NdiMedia::TimeShiftMemoryBudgetOption) ||
+		(Key == NdiMedia::TimeShiftSpillDirectoryOption) ||
 		(Key == NdiMedia::VideoHeightOption) ||
-		(Key == NdiMedia::VideoWidthOption))
+		(Key == NdiMedia::VideoWidthOption) ||
+		(Key == NdiMedia::YuvConversionOption) ||
+		(Key == NdiMedia::YuvRangeOption))
 	{
 		return true;
 	}
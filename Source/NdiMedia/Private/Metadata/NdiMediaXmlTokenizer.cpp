@@ -0,0 +1,567 @@
+// Copyright 1998-2016 Epic Games, Inc. All Rights Reserved.
+
+#include "NdiMediaXmlTokenizer.h"
+
+#include "Misc/CString.h"
+
+
+/* FNdiMediaXmlSpan interface
+ *****************************************************************************/
+
+int32 FNdiMediaXmlSpan::Decode(ANSICHAR* OutBuffer, int32 BufferSize) const
+{
+	if ((OutBuffer == nullptr) || (BufferSize <= 0))
+	{
+		return 0;
+	}
+
+	int32 Written = 0;
+	int32 Index = 0;
+
+	while ((Index < Length) && (Written < BufferSize - 1))
+	{
+		const ANSICHAR Char = Data[Index];
+
+		if (Char != '&')
+		{
+			OutBuffer[Written++] = Char;
+			++Index;
+
+			continue;
+		}
+
+		// find end of entity
+		int32 End = Index + 1;
+
+		while ((End < Length) && (End - Index <= 8) && (Data[End] != ';'))
+		{
+			++End;
+		}
+
+		if ((End >= Length) || (Data[End] != ';'))
+		{
+			OutBuffer[Written++] = Char; // not an entity
+			++Index;
+
+			continue;
+		}
+
+		const FNdiMediaXmlSpan Entity(Data + Index + 1, End - Index - 1);
+		ANSICHAR Decoded = 0;
+
+		if (Entity.Equals("amp")) { Decoded = '&'; }
+		else if (Entity.Equals("lt")) { Decoded = '<'; }
+		else if (Entity.Equals("gt")) { Decoded = '>'; }
+		else if (Entity.Equals("quot")) { Decoded = '"'; }
+		else if (Entity.Equals("apos")) { Decoded = '\''; }
+		else if ((Entity.Length > 1) && (Entity.Data[0] == '#'))
+		{
+			const bool Hex = (Entity.Data[1] == 'x') || (Entity.Data[1] == 'X');
+			int32 Code = 0;
+
+			for (int32 DigitIndex = Hex ? 2 : 1; DigitIndex < Entity.Length; ++DigitIndex)
+			{
+				const ANSICHAR Digit = Entity.Data[DigitIndex];
+
+				if ((Digit >= '0') && (Digit <= '9'))
+				{
+					Code = Code * (Hex ? 16 : 10) + (Digit - '0');
+				}
+				else if (Hex && (Digit >= 'a') && (Digit <= 'f'))
+				{
+					Code = Code * 16 + (Digit - 'a' + 10);
+				}
+				else if (Hex && (Digit >= 'A') && (Digit <= 'F'))
+				{
+					Code = Code * 16 + (Digit - 'A' + 10);
+				}
+				else
+				{
+					Code = -1;
+					break;
+				}
+			}
+
+			// only ASCII can be represented without re-encoding
+			Decoded = ((Code > 0) && (Code < 128)) ? (ANSICHAR)Code : '?';
+		}
+
+		if (Decoded == 0)
+		{
+			OutBuffer[Written++] = Char; // unknown entity
+			++Index;
+
+			continue;
+		}
+
+		OutBuffer[Written++] = Decoded;
+		Index = End + 1;
+	}
+
+	OutBuffer[Written] = '\0';
+
+	return Written;
+}
+
+
+bool FNdiMediaXmlSpan::Equals(const ANSICHAR* Other) const
+{
+	if (Other == nullptr)
+	{
+		return (Length == 0);
+	}
+
+	int32 Index = 0;
+
+	while ((Index < Length) && (Other[Index] != '\0'))
+	{
+		if (Data[Index] != Other[Index])
+		{
+			return false;
+		}
+
+		++Index;
+	}
+
+	return (Index == Length) && (Other[Index] == '\0');
+}
+
+
+bool FNdiMediaXmlSpan::ToDouble(double& OutValue) const
+{
+	// copy to a small stack buffer, so the number is terminated
+	ANSICHAR Buffer[64];
+	int32 BufferLength = 0;
+
+	for (int32 Index = 0; Index < Length; ++Index)
+	{
+		const ANSICHAR Char = Data[Index];
+
+		if ((Char == ' ') || (Char == '\t') || (Char == '\r') || (Char == '\n'))
+		{
+			continue;
+		}
+
+		if (!(((Char >= '0') && (Char <= '9')) || (Char == '+') || (Char == '-') || (Char == '.') || (Char == 'e') || (Char == 'E')))
+		{
+			return false;
+		}
+
+		if (BufferLength == ARRAY_COUNT(Buffer) - 1)
+		{
+			return false;
+		}
+
+		Buffer[BufferLength++] = Char;
+	}
+
+	if (BufferLength == 0)
+	{
+		return false;
+	}
+
+	Buffer[BufferLength] = '\0';
+	OutValue = FCStringAnsi::Atod(Buffer);
+
+	return true;
+}
+
+
+bool FNdiMediaXmlSpan::ToInt64(int64& OutValue) const
+{
+	int32 Index = 0;
+
+	// skip leading whitespace
+	while ((Index < Length) && ((Data[Index] == ' ') || (Data[Index] == '\t')))
+	{
+		++Index;
+	}
+
+	bool Negative = false;
+
+	if ((Index < Length) && ((Data[Index] == '-') || (Data[Index] == '+')))
+	{
+		Negative = (Data[Index] == '-');
+		++Index;
+	}
+
+	const int32 FirstDigit = Index;
+	int64 Value = 0;
+
+	while ((Index < Length) && (Data[Index] >= '0') && (Data[Index] <= '9'))
+	{
+		Value = Value * 10 + (Data[Index] - '0');
+		++Index;
+	}
+
+	if (Index == FirstDigit)
+	{
+		return false;
+	}
+
+	// skip trailing whitespace
+	while ((Index < Length) && ((Data[Index] == ' ') || (Data[Index] == '\t')))
+	{
+		++Index;
+	}
+
+	if (Index != Length)
+	{
+		return false;
+	}
+
+	OutValue = Negative ? -Value : Value;
+
+	return true;
+}
+
+
+FString FNdiMediaXmlSpan::ToString() const
+{
+	if (Length == 0)
+	{
+		return FString();
+	}
+
+	FUTF8ToTCHAR Converted(Data, Length);
+
+	return FString(Converted.Length(), Converted.Get());
+}
+
+
+/* FNdiMediaXmlTokenizer structors
+ *****************************************************************************/
+
+FNdiMediaXmlTokenizer::FNdiMediaXmlTokenizer(const ANSICHAR* InData, int32 InLength)
+	: Data(InData)
+	, Depth(0)
+	, Error(false)
+	, InTag(false)
+	, Length(0)
+	, Position(0)
+{
+	if (InData != nullptr)
+	{
+		// stop at the terminator, if any
+		while ((Length < InLength) && (InData[Length] != '\0'))
+		{
+			++Length;
+		}
+	}
+}
+
+
+/* FNdiMediaXmlTokenizer interface
+ *****************************************************************************/
+
+bool FNdiMediaXmlTokenizer::Next(FNdiMediaXmlToken& OutToken)
+{
+	if (Error)
+	{
+		return false;
+	}
+
+	if (InTag)
+	{
+		return NextInTag(OutToken);
+	}
+
+	while (Position < Length)
+	{
+		// character data
+		if (Data[Position] != '<')
+		{
+			const int32 Start = Position;
+			bool Whitespace = true;
+
+			while ((Position < Length) && (Data[Position] != '<'))
+			{
+				Whitespace &= IsSpace(Data[Position]);
+				++Position;
+			}
+
+			if (Whitespace)
+			{
+				continue;
+			}
+
+			OutToken.Type = ENdiMediaXmlToken::Text;
+			OutToken.Name = FNdiMediaXmlSpan();
+			OutToken.Value = FNdiMediaXmlSpan(Data + Start, Position - Start);
+			OutToken.Depth = Depth;
+
+			return true;
+		}
+
+		const int32 Remaining = Length - Position;
+
+		if (Remaining < 2)
+		{
+			return Fail();
+		}
+
+		const ANSICHAR Marker = Data[Position + 1];
+
+		// processing instruction
+		if (Marker == '?')
+		{
+			if (!SkipPast("?>", 2))
+			{
+				return Fail();
+			}
+
+			continue;
+		}
+
+		if (Marker == '!')
+		{
+			// comment
+			if ((Remaining >= 4) && (Data[Position + 2] == '-') && (Data[Position + 3] == '-'))
+			{
+				Position += 4;
+
+				if (!SkipPast("-->", 3))
+				{
+					return Fail();
+				}
+
+				continue;
+			}
+
+			// CDATA section
+			if ((Remaining >= 9) && (FCStringAnsi::Strncmp(Data + Position, "<![CDATA[", 9) == 0))
+			{
+				Position += 9;
+
+				const int32 Start = Position;
+
+				if (!SkipPast("]]>", 3))
+				{
+					return Fail();
+				}
+
+				OutToken.Type = ENdiMediaXmlToken::Text;
+				OutToken.Name = FNdiMediaXmlSpan();
+				OutToken.Value = FNdiMediaXmlSpan(Data + Start, Position - Start - 3);
+				OutToken.Depth = Depth;
+
+				return true;
+			}
+
+			// DOCTYPE and other declarations
+			if (!SkipPast(">", 1))
+			{
+				return Fail();
+			}
+
+			continue;
+		}
+
+		// end tag
+		if (Marker == '/')
+		{
+			Position += 2;
+
+			const FNdiMediaXmlSpan Name = ReadName();
+			SkipSpace();
+
+			if (Name.IsEmpty() || (Position >= Length) || (Data[Position] != '>') || (Depth == 0))
+			{
+				return Fail();
+			}
+
+			++Position;
+			--Depth;
+
+			OutToken.Type = ENdiMediaXmlToken::EndElement;
+			OutToken.Name = Name;
+			OutToken.Value = FNdiMediaXmlSpan();
+			OutToken.Depth = Depth;
+
+			return true;
+		}
+
+		// start tag
+		++Position;
+
+		const FNdiMediaXmlSpan Name = ReadName();
+
+		if (Name.IsEmpty())
+		{
+			return Fail();
+		}
+
+		InTag = true;
+		OpenElement = Name;
+
+		OutToken.Type = ENdiMediaXmlToken::BeginElement;
+		OutToken.Name = Name;
+		OutToken.Value = FNdiMediaXmlSpan();
+		OutToken.Depth = Depth;
+
+		return true;
+	}
+
+	return false;
+}
+
+
+void FNdiMediaXmlTokenizer::Reset()
+{
+	Depth = 0;
+	Error = false;
+	InTag = false;
+	OpenElement = FNdiMediaXmlSpan();
+	Position = 0;
+}
+
+
+/* FNdiMediaXmlTokenizer implementation
+ *****************************************************************************/
+
+bool FNdiMediaXmlTokenizer::Fail()
+{
+	Error = true;
+	InTag = false;
+
+	return false;
+}
+
+
+bool FNdiMediaXmlTokenizer::IsNameChar(ANSICHAR Char)
+{
+	// bytes >= 0x80 are part of UTF-8 sequences, which are valid in names
+	return ((Char >= 'a') && (Char <= 'z')) ||
+		((Char >= 'A') && (Char <= 'Z')) ||
+		((Char >= '0') && (Char <= '9')) ||
+		(Char == '_') || (Char == '-') || (Char == '.') || (Char == ':') ||
+		((uint8)Char >= 0x80);
+}
+
+
+bool FNdiMediaXmlTokenizer::NextInTag(FNdiMediaXmlToken& OutToken)
+{
+	SkipSpace();
+
+	if (Position >= Length)
+	{
+		return Fail();
+	}
+
+	const ANSICHAR Char = Data[Position];
+
+	// end of start tag
+	if (Char == '>')
+	{
+		++Position;
+		++Depth;
+		InTag = false;
+
+		return Next(OutToken);
+	}
+
+	// empty element
+	if (Char == '/')
+	{
+		if ((Position + 1 >= Length) || (Data[Position + 1] != '>'))
+		{
+			return Fail();
+		}
+
+		Position += 2;
+		InTag = false;
+
+		OutToken.Type = ENdiMediaXmlToken::EndElement;
+		OutToken.Name = OpenElement;
+		OutToken.Value = FNdiMediaXmlSpan();
+		OutToken.Depth = Depth;
+
+		return true;
+	}
+
+	// attribute
+	const FNdiMediaXmlSpan Name = ReadName();
+
+	if (Name.IsEmpty())
+	{
+		return Fail();
+	}
+
+	SkipSpace();
+
+	if ((Position >= Length) || (Data[Position] != '='))
+	{
+		return Fail();
+	}
+
+	++Position;
+	SkipSpace();
+
+	if ((Position >= Length) || ((Data[Position] != '"') && (Data[Position] != '\'')))
+	{
+		return Fail();
+	}
+
+	const ANSICHAR Quote = Data[Position++];
+	const int32 Start = Position;
+
+	while ((Position < Length) && (Data[Position] != Quote))
+	{
+		++Position;
+	}
+
+	if (Position >= Length)
+	{
+		return Fail();
+	}
+
+	OutToken.Type = ENdiMediaXmlToken::Attribute;
+	OutToken.Name = Name;
+	OutToken.Value = FNdiMediaXmlSpan(Data + Start, Position - Start);
+	OutToken.Depth = Depth;
+
+	++Position;
+
+	return true;
+}
+
+
+FNdiMediaXmlSpan FNdiMediaXmlTokenizer::ReadName()
+{
+	const int32 Start = Position;
+
+	while ((Position < Length) && IsNameChar(Data[Position]))
+	{
+		++Position;
+	}
+
+	return FNdiMediaXmlSpan(Data + Start, Position - Start);
+}
+
+
+bool FNdiMediaXmlTokenizer::SkipPast(const ANSICHAR* Terminator, int32 TerminatorLength)
+{
+	while (Position + TerminatorLength <= Length)
+	{
+		if (FCStringAnsi::Strncmp(Data + Position, Terminator, TerminatorLength) == 0)
+		{
+			Position += TerminatorLength;
+			return true;
+		}
+
+		++Position;
+	}
+
+	Position = Length;
+
+	return false;
+}
+
+
+void FNdiMediaXmlTokenizer::SkipSpace()
+{
+	while ((Position < Length) && IsSpace(Data[Position]))
+	{
+		++Position;
+	}
+}
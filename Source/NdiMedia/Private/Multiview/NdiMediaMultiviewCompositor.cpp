@@ -0,0 +1,379 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaMultiviewCompositor.h"
+#include "NdiMediaPrivate.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
+#include "INdiMediaBackend.h"
+#include "NdiMediaConnectionMonitor.h"
+#include "NdiMediaVideoKernels.h"
+#include "NdiMediaVideoScaler.h"
+
+
+DECLARE_CYCLE_STAT(TEXT("Multiview Composite"), STAT_NdiMedia_MultiviewComposite, STATGROUP_NdiMedia);
+
+
+/* FNdiMediaMultiviewCompositor structors
+ *****************************************************************************/
+
+FNdiMediaMultiviewCompositor::FNdiMediaMultiviewCompositor()
+	: Dimensions(FIntPoint::ZeroValue)
+	, DirtyRect(0, 0, 0, 0)
+	, FullyDirty(false)
+	, NumConnectedTiles(0)
+	, NumPendingTiles(0)
+	, NumTileFrames(0)
+	, NumUpdatedTiles(0)
+{ }
+
+
+FNdiMediaMultiviewCompositor::~FNdiMediaMultiviewCompositor()
+{
+	Close();
+}
+
+
+/* FNdiMediaMultiviewCompositor interface
+ *****************************************************************************/
+
+void FNdiMediaMultiviewCompositor::Close()
+{
+	// tearing down connections may block, so receivers are destroyed on the monitor thread
+	for (FTile& Tile : Tiles)
+	{
+		if (Tile.Request.IsValid())
+		{
+			Monitor->CancelReceiverRequest(Tile.Request.ToSharedRef());
+		}
+		else if (Tile.ReceiverInstance != nullptr)
+		{
+			Monitor->RetireReceiver(Tile.Backend.ToSharedRef(), Tile.ReceiverInstance);
+		}
+
+		delete Tile.Scaler;
+	}
+
+	Tiles.Empty();
+	Buffer.Empty();
+	Monitor.Reset();
+
+	Dimensions = FIntPoint::ZeroValue;
+	DirtyRect = FIntRect(0, 0, 0, 0);
+	FullyDirty = false;
+	NumConnectedTiles = 0;
+	NumPendingTiles = 0;
+	NumUpdatedTiles = 0;
+}
+
+
+void FNdiMediaMultiviewCompositor::GetFrame(NDIlib_video_frame_v2_t& OutFrame) const
+{
+	OutFrame.xres = Dimensions.X;
+	OutFrame.yres = Dimensions.Y;
+	OutFrame.FourCC = NDIlib_FourCC_type_BGRA;
+	OutFrame.frame_rate_N = 0;
+	OutFrame.frame_rate_D = 0;
+	OutFrame.picture_aspect_ratio = 0.0f;
+	OutFrame.frame_format_type = NDIlib_frame_format_type_progressive;
+	OutFrame.timecode = (int64)(FPlatformTime::Seconds() * ETimespan::TicksPerSecond);
+	OutFrame.p_data = (uint8_t*)Buffer.GetData();
+	OutFrame.line_stride_in_bytes = Dimensions.X * 4;
+	OutFrame.p_metadata = nullptr;
+	OutFrame.timestamp = 0;
+}
+
+
+FNdiMediaMultiviewStats FNdiMediaMultiviewCompositor::GetStats() const
+{
+	FNdiMediaMultiviewStats Stats;
+	{
+		Stats.Composites = CompositeStats;
+		Stats.NumConnectedTiles = NumConnectedTiles;
+		Stats.NumTiles = Tiles.Num();
+		Stats.NumTileFrames = NumTileFrames;
+		Stats.NumUpdatedTiles = NumUpdatedTiles;
+	}
+
+	return Stats;
+}
+
+
+bool FNdiMediaMultiviewCompositor::HasReceivers() const
+{
+	for (const FTile& Tile : Tiles)
+	{
+		if (Tile.ReceiverInstance != nullptr)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+bool FNdiMediaMultiviewCompositor::Open(const TSharedRef<FNdiMediaConnectionMonitor, ESPMode::ThreadSafe>& InMonitor, const TArray<FString>& Sources, const FNdiMediaMultiviewSettings& Settings, const TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe>& ConnectionMetadata)
+{
+	Close();
+
+	if ((Sources.Num() == 0) || (Settings.Width <= 0) || (Settings.Height <= 0))
+	{
+		return false;
+	}
+
+	Monitor = InMonitor;
+	Dimensions = FIntPoint(Settings.Width, Settings.Height);
+
+	// start with an opaque black output
+	Buffer.SetNumUninitialized(Dimensions.X * Dimensions.Y * 4);
+	ClearRect(FIntRect(FIntPoint::ZeroValue, Dimensions));
+	FullyDirty = true;
+
+	// lay out tiles in rows
+	const int32 Columns = (Settings.Columns > 0) ? FMath::Min(Settings.Columns, Sources.Num()) : FMath::CeilToInt(FMath::Sqrt((float)Sources.Num()));
+	const int32 Rows = (Sources.Num() + Columns - 1) / Columns;
+
+	NDIlib_recv_create_t RcvCreateDesc;
+	{
+		RcvCreateDesc.color_format = NDIlib_recv_color_format_e_BGRX_BGRA;
+		RcvCreateDesc.bandwidth = Settings.LowBandwidth ? NDIlib_recv_bandwidth_lowest : NDIlib_recv_bandwidth_highest;
+		RcvCreateDesc.allow_video_fields = false;
+	}
+
+	for (int32 SourceIndex = 0; SourceIndex < Sources.Num(); ++SourceIndex)
+	{
+		const int32 Column = SourceIndex % Columns;
+		const int32 Row = SourceIndex / Columns;
+
+		FTile& Tile = Tiles[Tiles.AddDefaulted()];
+		{
+			Tile.Connected = false;
+			Tile.Dirty = false;
+			Tile.ImageRect = FIntRect(0, 0, 0, 0);
+			Tile.ReceiverInstance = nullptr;
+			Tile.Rect = FIntRect(
+				Column * Dimensions.X / Columns,
+				Row * Dimensions.Y / Rows,
+				(Column + 1) * Dimensions.X / Columns,
+				(Row + 1) * Dimensions.Y / Rows
+			);
+			Tile.Request = Monitor->RequestReceiver(Sources[SourceIndex], RcvCreateDesc, ConnectionMetadata);
+			Tile.Scaler = new FNdiMediaVideoScaler;
+			Tile.Source = Sources[SourceIndex];
+		}
+	}
+
+	NumPendingTiles = Tiles.Num();
+
+	return true;
+}
+
+
+void FNdiMediaMultiviewCompositor::TakeReceivers()
+{
+	if (NumPendingTiles == 0)
+	{
+		return;
+	}
+
+	for (FTile& Tile : Tiles)
+	{
+		if (!Tile.Request.IsValid() || !Tile.Request->IsComplete())
+		{
+			continue;
+		}
+
+		Tile.Backend = Tile.Request->GetBackend();
+		Tile.ReceiverInstance = Tile.Request->GetReceiverInstance();
+		Tile.Request.Reset();
+
+		--NumPendingTiles;
+
+		// tiles without a receiver stay black
+		if ((Tile.ReceiverInstance == nullptr) && Tile.Backend.IsValid())
+		{
+			UE_LOG(LogNdiMedia, Warning, TEXT("Failed to create receiver for multiview tile %s"), *Tile.Source);
+		}
+	}
+}
+
+
+bool FNdiMediaMultiviewCompositor::Update()
+{
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NdiMedia_MultiviewComposite);
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// tiles cover disjoint rectangles of the output, so they can be drawn in parallel
+	ParallelFor(Tiles.Num(), [this](int32 TileIndex)
+	{
+		UpdateTile(Tiles[TileIndex]);
+	});
+
+	DirtyRect = FullyDirty ? FIntRect(FIntPoint::ZeroValue, Dimensions) : FIntRect(0, 0, 0, 0);
+	FullyDirty = false;
+	NumConnectedTiles = 0;
+	NumUpdatedTiles = 0;
+
+	for (const FTile& Tile : Tiles)
+	{
+		if (Tile.Connected)
+		{
+			++NumConnectedTiles;
+		}
+
+		if (!Tile.Dirty)
+		{
+			continue;
+		}
+
+		if (DirtyRect.Area() == 0)
+		{
+			DirtyRect = Tile.Rect;
+		}
+		else
+		{
+			DirtyRect.Min = DirtyRect.Min.ComponentMin(Tile.Rect.Min);
+			DirtyRect.Max = DirtyRect.Max.ComponentMax(Tile.Rect.Max);
+		}
+
+		++NumUpdatedTiles;
+	}
+
+	if (DirtyRect.Area() == 0)
+	{
+		return false;
+	}
+
+	// updates that only polled the receivers are not counted
+	CompositeStats.Add(FPlatformTime::Cycles64() - StartCycles);
+	NumTileFrames += NumUpdatedTiles;
+
+	return true;
+}
+
+
+/* FNdiMediaMultiviewCompositor implementation
+ *****************************************************************************/
+
+void FNdiMediaMultiviewCompositor::ClearRect(const FIntRect& Rect)
+{
+	const int32 Stride = Dimensions.X * 4;
+
+	for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; ++Y)
+	{
+		uint32* Pixel = (uint32*)(Buffer.GetData() + Y * Stride + Rect.Min.X * 4);
+
+		for (int32 X = Rect.Min.X; X < Rect.Max.X; ++X)
+		{
+			*Pixel++ = 0xff000000;
+		}
+	}
+}
+
+
+bool FNdiMediaMultiviewCompositor::DrawTile(FTile& Tile, const NDIlib_video_frame_v2_t& VideoFrame)
+{
+	const bool Bgr = (VideoFrame.FourCC == NDIlib_FourCC_type_BGRA) || (VideoFrame.FourCC == NDIlib_FourCC_type_BGRX);
+	const bool Rgb = (VideoFrame.FourCC == NDIlib_FourCC_type_RGBA) || (VideoFrame.FourCC == NDIlib_FourCC_type_RGBX);
+
+	if ((!Bgr && !Rgb) || (VideoFrame.p_data == nullptr) || (VideoFrame.xres <= 0) || (VideoFrame.yres <= 0))
+	{
+		return false;
+	}
+
+	// fit the frame into the tile, keeping its aspect ratio (zero means square pixels)
+	const FIntPoint TileSize = Tile.Rect.Size();
+	const float AspectRatio = (VideoFrame.picture_aspect_ratio > 0.0f) ? VideoFrame.picture_aspect_ratio : ((float)VideoFrame.xres / VideoFrame.yres);
+
+	FIntPoint ImageSize(TileSize.X, FMath::RoundToInt(TileSize.X / AspectRatio));
+
+	if (ImageSize.Y > TileSize.Y)
+	{
+		ImageSize = FIntPoint(FMath::RoundToInt(TileSize.Y * AspectRatio), TileSize.Y);
+	}
+
+	ImageSize = ImageSize.ComponentMax(FIntPoint(1, 1)).ComponentMin(TileSize);
+
+	const FIntPoint ImageMin = Tile.Rect.Min + (TileSize - ImageSize) / 2;
+	const FIntRect ImageRect(ImageMin, ImageMin + ImageSize);
+
+	// the letterbox only needs to be cleared when the image moves
+	if (ImageRect != Tile.ImageRect)
+	{
+		ClearRect(Tile.Rect);
+		Tile.ImageRect = ImageRect;
+	}
+
+	const int32 Stride = Dimensions.X * 4;
+	uint8* Dest = Buffer.GetData() + ImageRect.Min.Y * Stride + ImageRect.Min.X * 4;
+
+	Tile.Scaler->Process(VideoFrame.p_data, VideoFrame.xres, VideoFrame.yres, VideoFrame.line_stride_in_bytes, Dest, ImageSize.X, ImageSize.Y, Stride);
+
+	// the output is opaque BGRA
+	for (int32 Row = 0; Row < ImageSize.Y; ++Row)
+	{
+		uint8* RowData = Dest + Row * Stride;
+
+		if (Rgb)
+		{
+			NdiMediaVideo::SwapRedBlueRow(RowData, RowData, ImageSize.X);
+		}
+
+		for (int32 X = 0; X < ImageSize.X; ++X)
+		{
+			RowData[X * 4 + 3] = 0xff;
+		}
+	}
+
+	return true;
+}
+
+
+void FNdiMediaMultiviewCompositor::UpdateTile(FTile& Tile)
+{
+	Tile.Dirty = false;
+
+	if (Tile.ReceiverInstance == nullptr)
+	{
+		return;
+	}
+
+	INdiMediaBackend& Backend = *Tile.Backend;
+
+	Tile.Connected = (Backend.RecvGetNumConnections(Tile.ReceiverInstance) > 0);
+
+	// skip queued frames, only the newest one is visible
+	NDIlib_video_frame_v2_t VideoFrame;
+	bool HasFrame = false;
+
+	while (true)
+	{
+		NDIlib_video_frame_v2_t NextFrame;
+
+		if (Backend.RecvCapture(Tile.ReceiverInstance, &NextFrame, nullptr, nullptr, 0) != NDIlib_frame_type_video)
+		{
+			break;
+		}
+
+		if (HasFrame)
+		{
+			Backend.RecvFreeVideo(Tile.ReceiverInstance, VideoFrame);
+		}
+
+		VideoFrame = NextFrame;
+		HasFrame = true;
+	}
+
+	if (HasFrame)
+	{
+		Tile.Dirty = DrawTile(Tile, VideoFrame);
+		Backend.RecvFreeVideo(Tile.ReceiverInstance, VideoFrame);
+	}
+}
@@ -0,0 +1,298 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NdiMediaStageStats.h"
+
+
+class FNdiMediaConnectionMetadata;
+class FNdiMediaConnectionMonitor;
+class FNdiMediaReceiverRequest;
+class FNdiMediaVideoScaler;
+class INdiMediaBackend;
+
+struct NDIlib_video_frame_v2_t;
+
+
+/**
+ * Settings of a multiviewer.
+ */
+struct FNdiMediaMultiviewSettings
+{
+	/** Number of tile columns (0 = as many columns as rows). */
+	int32 Columns;
+
+	/** Height of the output (in pixels). */
+	int32 Height;
+
+	/** Whether tiles are received at the lowest bandwidth (the senders' preview streams). */
+	bool LowBandwidth;
+
+	/** Width of the output (in pixels). */
+	int32 Width;
+
+public:
+
+	/** Default constructor (1920x1080 output at the lowest bandwidth). */
+	FNdiMediaMultiviewSettings()
+		: Columns(0)
+		, Height(1080)
+		, LowBandwidth(true)
+		, Width(1920)
+	{ }
+};
+
+
+/**
+ * Statistics of a multiviewer.
+ */
+struct FNdiMediaMultiviewStats
+{
+	/** Time spent capturing and drawing tiles in updates that changed the output. */
+	FNdiMediaStageStats Composites;
+
+	/** Number of tiles whose receivers are connected. */
+	int32 NumConnectedTiles;
+
+	/** Number of tiles. */
+	int32 NumTiles;
+
+	/** Number of tile frames that were drawn. */
+	uint64 NumTileFrames;
+
+	/** Number of tiles that changed in the most recent update. */
+	int32 NumUpdatedTiles;
+};
+
+
+/**
+ * Composites the video of multiple NDI sources into a single BGRA frame.
+ *
+ * Each source is received into a tile of the output. On each update, the newest
+ * frame of every tile is captured and scaled into the tile's rectangle, keeping
+ * its aspect ratio. Tiles are processed in parallel on task graph worker threads,
+ * and tiles that didn't receive a new frame are left untouched, so that the cost
+ * of an update grows with the number of tiles that actually changed.
+ *
+ * The rectangle that changed in the most recent update is tracked, so that
+ * callers only need to upload the output when a tile was redrawn.
+ *
+ * Receivers are created and destroyed on the connection monitor thread, because
+ * both may block. Tiles stay black until their receivers were created and taken
+ * over with TakeReceivers.
+ *
+ * Receivers deliver BGRA, and fielded video is deinterlaced by the NDI runtime.
+ * Functions must be called from the same thread.
+ */
+class FNdiMediaMultiviewCompositor
+{
+public:
+
+	/** Default constructor. */
+	FNdiMediaMultiviewCompositor();
+
+	/** Destructor. */
+	~FNdiMediaMultiviewCompositor();
+
+public:
+
+	/**
+	 * Disconnect all tiles and release the output.
+	 *
+	 * Receivers are destroyed on the connection monitor thread, and receivers
+	 * that are still being created are destroyed as soon as they were created.
+	 *
+	 * @see IsOpen, Open
+	 */
+	void Close();
+
+	/**
+	 * Get the rectangle of the output that changed in the most recent update.
+	 *
+	 * @return The rectangle (empty if nothing changed).
+	 * @see Update
+	 */
+	const FIntRect& GetDirtyRect() const
+	{
+		return DirtyRect;
+	}
+
+	/**
+	 * Describe the output as a video frame.
+	 *
+	 * The frame references the output buffer, which remains valid until the next update.
+	 *
+	 * @param OutFrame Will contain the frame.
+	 */
+	void GetFrame(NDIlib_video_frame_v2_t& OutFrame) const;
+
+	/**
+	 * Get the number of tiles whose receivers are connected.
+	 *
+	 * @return Number of tiles.
+	 */
+	int32 GetNumConnectedTiles() const
+	{
+		return NumConnectedTiles;
+	}
+
+	/**
+	 * Get the multiviewer's statistics.
+	 *
+	 * @return Statistics.
+	 */
+	FNdiMediaMultiviewStats GetStats() const;
+
+	/**
+	 * Whether any tile has a receiver.
+	 *
+	 * @return true if at least one receiver was created, false otherwise.
+	 * @see IsOpening
+	 */
+	bool HasReceivers() const;
+
+	/**
+	 * Whether tiles are being received.
+	 *
+	 * @return true if open, false otherwise.
+	 * @see Close, IsOpening, Open
+	 */
+	bool IsOpen() const
+	{
+		return (Tiles.Num() > 0);
+	}
+
+	/**
+	 * Whether the receivers of some tiles are still being created.
+	 *
+	 * @return true if opening, false otherwise.
+	 * @see Open, TakeReceivers
+	 */
+	bool IsOpening() const
+	{
+		return (NumPendingTiles > 0);
+	}
+
+	/**
+	 * Connect to a set of sources.
+	 *
+	 * Tiles are laid out in rows, in the order of the sources. Their receivers
+	 * are requested from the connection monitor, and must be taken over with
+	 * TakeReceivers once they were created.
+	 *
+	 * @param InMonitor The connection monitor that creates and destroys the receivers.
+	 * @param Sources The names or IP endpoints of the sources.
+	 * @param Settings The multiviewer settings.
+	 * @param ConnectionMetadata The metadata to send to the sources.
+	 * @return true on success, false otherwise.
+	 * @see Close, IsOpen, IsOpening
+	 */
+	bool Open(const TSharedRef<FNdiMediaConnectionMonitor, ESPMode::ThreadSafe>& InMonitor, const TArray<FString>& Sources, const FNdiMediaMultiviewSettings& Settings, const TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe>& ConnectionMetadata);
+
+	/**
+	 * Take over the receivers that were created since the last call.
+	 *
+	 * @see IsOpening
+	 */
+	void TakeReceivers();
+
+	/**
+	 * Capture the newest frames of all tiles and draw them into the output.
+	 *
+	 * @return true if the output changed, false otherwise.
+	 * @see GetDirtyRect, GetFrame
+	 */
+	bool Update();
+
+protected:
+
+	/** A tile of the output. */
+	struct FTile
+	{
+		/** The backend that the tile's receiver was created on. */
+		TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> Backend;
+
+		/** Whether the tile's receiver is connected. */
+		bool Connected;
+
+		/** Whether the tile was redrawn in the current update. */
+		bool Dirty;
+
+		/** The rectangle that the most recent frame was drawn into. */
+		FIntRect ImageRect;
+
+		/** The tile's receiver instance (nullptr if it couldn't be created). */
+		void* ReceiverInstance;
+
+		/** The tile's rectangle in the output. */
+		FIntRect Rect;
+
+		/** The request for the tile's receiver (nullptr if not pending). */
+		TSharedPtr<FNdiMediaReceiverRequest, ESPMode::ThreadSafe> Request;
+
+		/** Scales frames into the tile. */
+		FNdiMediaVideoScaler* Scaler;
+
+		/** The source's name or IP endpoint. */
+		FString Source;
+	};
+
+	/**
+	 * Fill a rectangle of the output with opaque black.
+	 *
+	 * @param Rect The rectangle to fill.
+	 */
+	void ClearRect(const FIntRect& Rect);
+
+	/**
+	 * Draw a video frame into a tile.
+	 *
+	 * @param Tile The tile to draw.
+	 * @param VideoFrame The frame to draw (BGRA, BGRX, RGBA or RGBX).
+	 * @return true if the frame was drawn, false if its format is not supported.
+	 */
+	bool DrawTile(FTile& Tile, const NDIlib_video_frame_v2_t& VideoFrame);
+
+	/**
+	 * Capture the newest frame of a tile and draw it (on a worker thread).
+	 *
+	 * @param Tile The tile to update.
+	 */
+	void UpdateTile(FTile& Tile);
+
+private:
+
+	/** The output buffer (BGRA). */
+	TArray<uint8> Buffer;
+
+	/** Time spent capturing and drawing tiles in updates that changed the output. */
+	FNdiMediaStageStats CompositeStats;
+
+	/** Size of the output (in pixels). */
+	FIntPoint Dimensions;
+
+	/** The rectangle that changed in the most recent update. */
+	FIntRect DirtyRect;
+
+	/** Whether the entire output must be uploaded on the next update. */
+	bool FullyDirty;
+
+	/** The connection monitor that creates and destroys the receivers. */
+	TSharedPtr<FNdiMediaConnectionMonitor, ESPMode::ThreadSafe> Monitor;
+
+	/** Number of tiles whose receivers are connected. */
+	int32 NumConnectedTiles;
+
+	/** Number of tiles whose receivers are still being created. */
+	int32 NumPendingTiles;
+
+	/** Number of tile frames that were drawn. */
+	uint64 NumTileFrames;
+
+	/** Number of tiles that changed in the most recent update. */
+	int32 NumUpdatedTiles;
+
+	/** The output's tiles. */
+	TArray<FTile> Tiles;
+};
@@ -0,0 +1,308 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "NdiMediaAllowPlatformTypes.h"
+	#include "Processing.NDI.Lib.h"
+#include "NdiMediaHidePlatformTypes.h"
+
+
+/**
+ * Interface for implementations of the NDI finder, receiver and sender API.
+ *
+ * The functions mirror the NDIlib_* functions of the NDI SDK, so that the
+ * player, the samplers and the finder can run against either the NDI runtime
+ * or an in-process stand-in, such as the loopback backend used for testing
+ * and benchmarking without a network.
+ *
+ * Instance handles are owned by the backend that created them and must only
+ * be passed back to that backend. All functions may be called from any thread.
+ *
+ * @see FNdi::GetBackend, FNdiMediaLoopbackBackend, FNdiMediaSdkBackend
+ */
+class INdiMediaBackend
+{
+public:
+
+	/**
+	 * Get the name of this backend.
+	 *
+	 * @return Backend name.
+	 */
+	virtual FName GetName() const = 0;
+
+public:
+
+	/**
+	 * Create a source finder.
+	 *
+	 * @param Settings The finder settings.
+	 * @return The finder instance, or nullptr on failure.
+	 * @see FindDestroy
+	 */
+	virtual NDIlib_find_instance_t FindCreate(const NDIlib_find_create_t& Settings) = 0;
+
+	/**
+	 * Destroy a source finder.
+	 *
+	 * @param Instance The finder instance to destroy.
+	 * @see FindCreate
+	 */
+	virtual void FindDestroy(NDIlib_find_instance_t Instance) = 0;
+
+	/**
+	 * Get the sources that are currently known to a finder.
+	 *
+	 * @param Instance The finder instance.
+	 * @param OutNumSources Will contain the number of sources.
+	 * @return The sources, which remain valid until the next call or until the finder is destroyed.
+	 */
+	virtual const NDIlib_source_t* FindGetCurrentSources(NDIlib_find_instance_t Instance, uint32& OutNumSources) = 0;
+
+public:
+
+	/**
+	 * Add a metadata frame that is sent to the source whenever a receiver connects.
+	 *
+	 * @param Instance The receiver instance.
+	 * @param Metadata The metadata frame.
+	 * @see RecvClearConnectionMetadata
+	 */
+	virtual void RecvAddConnectionMetadata(NDIlib_recv_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) = 0;
+
+	/**
+	 * Capture a frame from a receiver.
+	 *
+	 * Only frames of the types whose pointers are set will be captured.
+	 *
+	 * @param Instance The receiver instance.
+	 * @param OutVideo Will contain the video frame, or nullptr to not capture video.
+	 * @param OutAudio Will contain the audio frame, or nullptr to not capture audio.
+	 * @param OutMetadata Will contain the metadata frame, or nullptr to not capture metadata.
+	 * @param Timeout How long to wait for a frame (in milliseconds).
+	 * @return The type of the captured frame.
+	 * @see RecvFreeAudio, RecvFreeMetadata, RecvFreeVideo
+	 */
+	virtual NDIlib_frame_type_e RecvCapture(NDIlib_recv_instance_t Instance, NDIlib_video_frame_v2_t* OutVideo, NDIlib_audio_frame_v2_t* OutAudio, NDIlib_metadata_frame_t* OutMetadata, uint32 Timeout) = 0;
+
+	/**
+	 * Clear all connection metadata of a receiver.
+	 *
+	 * @param Instance The receiver instance.
+	 * @see RecvAddConnectionMetadata
+	 */
+	virtual void RecvClearConnectionMetadata(NDIlib_recv_instance_t Instance) = 0;
+
+	/**
+	 * Create a receiver.
+	 *
+	 * @param Settings The receiver settings.
+	 * @return The receiver instance, or nullptr on failure.
+	 * @see RecvDestroy
+	 */
+	virtual NDIlib_recv_instance_t RecvCreate(const NDIlib_recv_create_t& Settings) = 0;
+
+	/**
+	 * Destroy a receiver.
+	 *
+	 * @param Instance The receiver instance to destroy.
+	 * @see RecvCreate
+	 */
+	virtual void RecvDestroy(NDIlib_recv_instance_t Instance) = 0;
+
+	/**
+	 * Release an audio frame that was captured from a receiver.
+	 *
+	 * @param Instance The receiver instance.
+	 * @param Audio The audio frame to release.
+	 */
+	virtual void RecvFreeAudio(NDIlib_recv_instance_t Instance, const NDIlib_audio_frame_v2_t& Audio) = 0;
+
+	/**
+	 * Release a metadata frame that was captured from a receiver.
+	 *
+	 * @param Instance The receiver instance.
+	 * @param Metadata The metadata frame to release.
+	 */
+	virtual void RecvFreeMetadata(NDIlib_recv_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) = 0;
+
+	/**
+	 * Release a video frame that was captured from a receiver.
+	 *
+	 * @param Instance The receiver instance.
+	 * @param Video The video frame to release.
+	 */
+	virtual void RecvFreeVideo(NDIlib_recv_instance_t Instance, const NDIlib_video_frame_v2_t& Video) = 0;
+
+	/**
+	 * Get the number of connections of a receiver.
+	 *
+	 * @param Instance The receiver instance.
+	 * @return Number of connections.
+	 */
+	virtual int32 RecvGetNumConnections(NDIlib_recv_instance_t Instance) = 0;
+
+	/**
+	 * Get the frame counters of a receiver.
+	 *
+	 * @param Instance The receiver instance.
+	 * @param OutTotal Will contain the number of received frames.
+	 * @param OutDropped Will contain the number of dropped frames.
+	 */
+	virtual void RecvGetPerformance(NDIlib_recv_instance_t Instance, NDIlib_recv_performance_t& OutTotal, NDIlib_recv_performance_t& OutDropped) = 0;
+
+	/**
+	 * Get the number of frames that are queued in a receiver.
+	 *
+	 * @param Instance The receiver instance.
+	 * @param OutQueue Will contain the queue depths.
+	 */
+	virtual void RecvGetQueue(NDIlib_recv_instance_t Instance, NDIlib_recv_queue_t& OutQueue) = 0;
+
+	/**
+	 * Send a metadata frame from a receiver to its source.
+	 *
+	 * @param Instance The receiver instance.
+	 * @param Metadata The metadata frame.
+	 * @return true if the frame was sent, false if the receiver is not connected.
+	 */
+	virtual bool RecvSendMetadata(NDIlib_recv_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) = 0;
+
+	/**
+	 * Set the tally state that a receiver reports to its source.
+	 *
+	 * @param Instance The receiver instance.
+	 * @param Tally The tally state.
+	 * @return true if the tally was sent, false if the receiver is not connected.
+	 */
+	virtual bool RecvSetTally(NDIlib_recv_instance_t Instance, const NDIlib_tally_t& Tally) = 0;
+
+	/**
+	 * Whether receivers can be created with the given color format.
+	 *
+	 * Runtimes don't reliably reject color formats they don't understand, so
+	 * formats that not all runtimes support must be checked before use.
+	 *
+	 * @param ColorFormat The color format (NDIlib_recv_color_format_e or NdiMedia::RecvColorFormatFastest).
+	 * @return true if supported, false otherwise.
+	 * @see RecvCreate
+	 */
+	virtual bool RecvSupportsColorFormat(int64 ColorFormat) const = 0;
+
+public:
+
+	/**
+	 * Add a metadata frame that is sent to receivers whenever they connect.
+	 *
+	 * @param Instance The sender instance.
+	 * @param Metadata The metadata frame.
+	 * @see SendClearConnectionMetadata
+	 */
+	virtual void SendAddConnectionMetadata(NDIlib_send_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) = 0;
+
+	/**
+	 * Send an audio frame.
+	 *
+	 * @param Instance The sender instance.
+	 * @param Audio The audio frame.
+	 */
+	virtual void SendAudio(NDIlib_send_instance_t Instance, const NDIlib_audio_frame_v2_t& Audio) = 0;
+
+	/**
+	 * Capture a metadata frame that a receiver sent to a sender.
+	 *
+	 * @param Instance The sender instance.
+	 * @param OutMetadata Will contain the metadata frame.
+	 * @param Timeout How long to wait for a frame (in milliseconds).
+	 * @return The type of the captured frame.
+	 * @see SendFreeMetadata
+	 */
+	virtual NDIlib_frame_type_e SendCapture(NDIlib_send_instance_t Instance, NDIlib_metadata_frame_t& OutMetadata, uint32 Timeout) = 0;
+
+	/**
+	 * Clear all connection metadata of a sender.
+	 *
+	 * @param Instance The sender instance.
+	 * @see SendAddConnectionMetadata
+	 */
+	virtual void SendClearConnectionMetadata(NDIlib_send_instance_t Instance) = 0;
+
+	/**
+	 * Create a sender.
+	 *
+	 * @param Settings The sender settings.
+	 * @return The sender instance, or nullptr on failure.
+	 * @see SendDestroy
+	 */
+	virtual NDIlib_send_instance_t SendCreate(const NDIlib_send_create_t& Settings) = 0;
+
+	/**
+	 * Destroy a sender.
+	 *
+	 * @param Instance The sender instance to destroy.
+	 * @see SendCreate
+	 */
+	virtual void SendDestroy(NDIlib_send_instance_t Instance) = 0;
+
+	/**
+	 * Release a metadata frame that was captured from a sender.
+	 *
+	 * @param Instance The sender instance.
+	 * @param Metadata The metadata frame to release.
+	 */
+	virtual void SendFreeMetadata(NDIlib_send_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) = 0;
+
+	/**
+	 * Get the number of receivers that are connected to a sender.
+	 *
+	 * @param Instance The sender instance.
+	 * @param Timeout How long to wait for a connection (in milliseconds).
+	 * @return Number of connections.
+	 */
+	virtual int32 SendGetNumConnections(NDIlib_send_instance_t Instance, uint32 Timeout) = 0;
+
+	/**
+	 * Get the tally state that the receivers of a sender report.
+	 *
+	 * @param Instance The sender instance.
+	 * @param OutTally Will contain the tally state.
+	 * @param Timeout How long to wait for the tally to change (in milliseconds).
+	 * @return true if the tally changed, false otherwise.
+	 */
+	virtual bool SendGetTally(NDIlib_send_instance_t Instance, NDIlib_tally_t& OutTally, uint32 Timeout) = 0;
+
+	/**
+	 * Send a metadata frame.
+	 *
+	 * @param Instance The sender instance.
+	 * @param Metadata The metadata frame.
+	 */
+	virtual void SendMetadata(NDIlib_send_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) = 0;
+
+	/**
+	 * Send a video frame.
+	 *
+	 * @param Instance The sender instance.
+	 * @param Video The video frame.
+	 */
+	virtual void SendVideo(NDIlib_send_instance_t Instance, const NDIlib_video_frame_v2_t& Video) = 0;
+
+public:
+
+	/**
+	 * Convert a planar floating point audio frame to interleaved 16-bit samples.
+	 *
+	 * The destination's sample buffer and reference level must be set by the caller.
+	 *
+	 * @param Source The audio frame to convert.
+	 * @param Dest The interleaved audio frame.
+	 */
+	virtual void AudioToInterleaved16s(const NDIlib_audio_frame_v2_t& Source, NDIlib_audio_frame_interleaved_16s_t& Dest) = 0;
+
+public:
+
+	/** Virtual destructor. */
+	virtual ~INdiMediaBackend() { }
+};
@@ -4,77 +4,376 @@
 #include "NdiMediaPrivate.h"
 
 #include "IPluginManager.h"
+#include "HAL/PlatformMisc.h"
 #include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
 #include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "NdiMediaSdkBackend.h"
+#include "UObject/UObjectGlobals.h"
+
+
+#if NDIMEDIA_DLL_PLATFORM
+
+namespace NdiMediaRuntime
+{
+	/** Oldest major version of the NDI runtime that is supported. */
+	static const int32 MinMajorVersion = 2;
+
+	/** Environment variable that holds the directory of the installed NDI runtime. */
+	static const TCHAR* RuntimeDirVariable = TEXT("NDI_RUNTIME_DIR_V2");
+
+	// file name of the runtime library, and directory of the bundled runtime below ThirdParty/lib
+#if PLATFORM_LINUX
+	static const TCHAR* LibName = TEXT("libndi.so.1.0.1");
+	static const TCHAR* LibSubDir = TEXT("linux/x86_64-linux-gnu-5.4");
+#elif PLATFORM_MAC
+	static const TCHAR* LibName = TEXT("libndi.dylib");
+	static const TCHAR* LibSubDir = TEXT("apple/x64");
+#elif PLATFORM_WINDOWS
+	#if PLATFORM_64BITS
+		static const TCHAR* LibName = TEXT("Processing.NDI.Lib.x64.dll");
+		static const TCHAR* LibSubDir = TEXT("windows/x64");
+	#else
+		static const TCHAR* LibName = TEXT("Processing.NDI.Lib.x86.dll");
+		static const TCHAR* LibSubDir = TEXT("windows/x86");
+	#endif
+#endif
+}
+
+#endif //NDIMEDIA_DLL_PLATFORM
+
+
+namespace NdiMediaRuntime
+{
+	/**
+	 * Major version of runtimes whose version string has no version number.
+	 *
+	 * Early version 2 runtimes only report their build date, i.e. "NDI SDK LINUX
+	 * 16:28:20 Apr 10 2017". Runtimes older than version 2 don't export the
+	 * NDIlib_v2 function table and can't be loaded at all.
+	 */
+	static const int32 UnversionedMajorVersion = 2;
+
+	/**
+	 * Get the major version number from an NDI runtime's version string.
+	 *
+	 * @param Version The version string, i.e. "NDI SDK WIN64 10:13:34 Jun 20 2017 2.1.0.3".
+	 * @return The major version, or INDEX_NONE if the string has no version number.
+	 */
+	static int32 ParseMajorVersion(const FString& Version)
+	{
+		TArray<FString> Tokens;
+		Version.ParseIntoArrayWS(Tokens);
+
+		// the version number is the last dotted token
+		for (int32 TokenIndex = Tokens.Num() - 1; TokenIndex >= 0; --TokenIndex)
+		{
+			const FString& Token = Tokens[TokenIndex];
+
+			if ((Token.Len() > 0) && FChar::IsDigit(Token[0]) && Token.Contains(TEXT(".")) && !Token.Contains(TEXT(":")))
+			{
+				return FCString::Atoi(*Token);
+			}
+		}
+
+		return INDEX_NONE;
+	}
+
+	/**
+	 * Get the major version of an NDI runtime.
+	 *
+	 * @param Lib The function table of the runtime.
+	 * @param OutVersion Will contain the runtime's version string.
+	 * @return The major version, or INDEX_NONE if it couldn't be determined.
+	 */
+	static int32 GetMajorVersion(const NDIlib_v2& Lib, FString& OutVersion)
+	{
+		OutVersion = (Lib.NDIlib_version != nullptr) ? ANSI_TO_TCHAR(Lib.NDIlib_version()) : FString();
+
+		const int32 MajorVersion = ParseMajorVersion(OutVersion);
+
+		if (MajorVersion != INDEX_NONE)
+		{
+			return MajorVersion;
+		}
+
+		// early version 2 runtimes only report the SDK's platform and build date
+		if (OutVersion.StartsWith(TEXT("NDI SDK")))
+		{
+			return UnversionedMajorVersion;
+		}
+
+		return INDEX_NONE;
+	}
+}
 
 
 /* Static initialization
  *****************************************************************************/
 
+TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> FNdi::Backend;
+FCriticalSection FNdi::BackendCriticalSection;
+volatile bool FNdi::Available = true;
+const NDIlib_v2* FNdi::Lib = nullptr;
 void* FNdi::LibHandle = nullptr;
+FNdi::ERuntimeState FNdi::RuntimeState = FNdi::ERuntimeState::Uninitialized;
+TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> FNdi::SdkBackend;
 
 
-/* FVlc static functions
+/* FNdi static functions
  *****************************************************************************/
 
+TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> FNdi::GetBackend()
+{
+	FScopeLock Lock(&BackendCriticalSection);
+
+	if (!Backend.IsValid() && (RuntimeState == ERuntimeState::Uninitialized))
+	{
+		InitializeRuntime();
+		UpdateAvailability();
+	}
+
+	return Backend;
+}
+
+
 bool FNdi::Initialize()
 {
-#if NDIMEDIA_DLL_PLATFORM
+	FScopeLock Lock(&BackendCriticalSection);
 
-	// determine directory paths
-	const FString BaseDir = IPluginManager::Get().FindPlugin("NdiMedia")->GetBaseDir();
-	const FString LibDir = FPaths::Combine(*BaseDir, TEXT("ThirdParty"), TEXT("lib"));
+	if (RuntimeState == ERuntimeState::Initialized)
+	{
+		return true;
+	}
 
-#if PLATFORM_LINUX
-	const FString Lib = FPaths::Combine(*LibDir, TEXT("linux"), TEXT("x86_64-linux-gnu-5.4"), TEXT("libndi.so.1.0.1"));
-#elif PLATFORM_MAC
-	const FString Lib = FPaths::Combine(*LibDir, TEXT("apple"), TEXT("x64"), TEXT("libndi.dylib"));
-#elif PLATFORM_WINDOWS
-	#if PLATFORM_64BITS
-		const FString Lib = FPaths::Combine(*LibDir, TEXT("windows"), TEXT("x64"), TEXT("Processing.NDI.Lib.x64.dll"));
-	#else
-		const FString Lib = FPaths::Combine(*LibDir, TEXT("windows"), TEXT("x86"), TEXT("Processing.NDI.Lib.x86.dll"));
-	#endif
-#endif
+	const bool Result = InitializeRuntime();
+	UpdateAvailability();
+
+	return Result;
+}
+
+
+bool FNdi::IsAvailable()
+{
+	return Available;
+}
+
+
+bool FNdi::IsInitialized()
+{
+	return GetBackend().IsValid();
+}
+
+
+void FNdi::SetBackend(const TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe>& NewBackend)
+{
+	FScopeLock Lock(&BackendCriticalSection);
+	Backend = NewBackend.IsValid() ? NewBackend : SdkBackend;
+	UpdateAvailability();
+}
 
-	LibHandle = FPlatformProcess::GetDllHandle(*Lib);
 
-	if (LibHandle == nullptr)
+void FNdi::Shutdown()
+{
+	FScopeLock Lock(&BackendCriticalSection);
+
+	// the runtime is destroyed when its last user releases the backend
+	Backend.Reset();
+	RuntimeState = ERuntimeState::Unavailable;
+	SdkBackend.Reset();
+	UpdateAvailability();
+
+	// a runtime that was loaded but never initialized is still owned here
+	Lib = nullptr;
+
+	if (LibHandle != nullptr)
 	{
-		UE_LOG(LogNdiMedia, Warning, TEXT("Failed to load required library %s. Plug-in will not be functional."), *Lib);
-		return false;
+		FPlatformProcess::FreeDllHandle(LibHandle);
+		LibHandle = nullptr;
 	}
+}
+
+
+/* FNdi implementation
+ *****************************************************************************/
+
+bool FNdi::InitializeRuntime()
+{
+	// failures are final until Initialize is called again
+	RuntimeState = ERuntimeState::Unavailable;
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	if (Lib == nullptr)
+	{
+#if NDIMEDIA_DLL_PLATFORM
+		if (!LoadRuntime())
+		{
+			UE_LOG(LogNdiMedia, Warning, TEXT("Failed to load a usable NDI runtime. Plug-in will not be functional."));
+			return false;
+		}
+#else
+		Lib = NDIlib_v2_load();
 
+		FString MissingEntry;
+
+		if ((Lib == nullptr) || !FNdiMediaSdkBackend::IsSupported(*Lib, MissingEntry))
+		{
+			UE_LOG(LogNdiMedia, Warning, TEXT("NDI runtime is missing %s. Plug-in will not be functional."), *MissingEntry);
+			Lib = nullptr;
+
+			return false;
+		}
 #endif //NDIMEDIA_DLL_PLATFORM
+	}
 
-	if (!NDIlib_is_supported_CPU())
+	const double LoadedTime = FPlatformTime::Seconds();
+
+	if (!Lib->NDIlib_is_supported_CPU())
 	{
 		UE_LOG(LogNdiMedia, Error, TEXT("Cannot initialize NDI: CPU is not supported"));
 		return false;
 	}
 
-	if (!NDIlib_initialize())
+	if (!Lib->NDIlib_initialize())
 	{
+		UE_LOG(LogNdiMedia, Error, TEXT("Failed to initialize NDI"));
 		return false;
 	}
 
+	FString Version;
+	const int32 MajorVersion = NdiMediaRuntime::GetMajorVersion(*Lib, Version);
+
+	if (MajorVersion == INDEX_NONE)
+	{
+		UE_LOG(LogNdiMedia, Warning, TEXT("Couldn't determine the version of the NDI runtime (%s). Features that require newer runtimes will be disabled."), *Version);
+	}
+
+	// the backend owns the runtime from now on
+	SdkBackend = MakeShareable(new FNdiMediaSdkBackend(*Lib, LibHandle, MajorVersion));
+	RuntimeState = ERuntimeState::Initialized;
+
+	Lib = nullptr;
+	LibHandle = nullptr;
+
+	if (!Backend.IsValid())
+	{
+		Backend = SdkBackend;
+	}
+
+	const double EndTime = FPlatformTime::Seconds();
+
+	UE_LOG(LogNdiMedia, Log, TEXT("Initialized NDI runtime in %.1f ms (library load %.1f ms, SDK initialization %.1f ms)"),
+		(EndTime - StartTime) * 1000.0,
+		(LoadedTime - StartTime) * 1000.0,
+		(EndTime - LoadedTime) * 1000.0
+	);
+
 	return true;
 }
 
 
-bool FNdi::IsInitialized()
+#if NDIMEDIA_DLL_PLATFORM
+
+bool FNdi::LoadRuntime()
 {
-	return (LibHandle != nullptr);
+	TArray<FString> Candidates;
+
+	// configured library
+	FString ConfiguredPath = GetDefault<UNdiMediaSettings>()->RuntimeLibraryPath;
+
+	if (!ConfiguredPath.IsEmpty())
+	{
+		if (FPaths::DirectoryExists(ConfiguredPath))
+		{
+			ConfiguredPath = FPaths::Combine(*ConfiguredPath, NdiMediaRuntime::LibName);
+		}
+
+		Candidates.Add(ConfiguredPath);
+	}
+
+	// installed runtime
+	TCHAR RuntimeDir[1024] = { 0 };
+	FPlatformMisc::GetEnvironmentVariable(NdiMediaRuntime::RuntimeDirVariable, RuntimeDir, ARRAY_COUNT(RuntimeDir));
+
+	if (RuntimeDir[0] != TEXT('\0'))
+	{
+		Candidates.Add(FPaths::Combine(RuntimeDir, NdiMediaRuntime::LibName));
+	}
+
+	// bundled runtime
+	const FString BaseDir = IPluginManager::Get().FindPlugin("NdiMedia")->GetBaseDir();
+	Candidates.Add(FPaths::Combine(*BaseDir, TEXT("ThirdParty"), TEXT("lib"), NdiMediaRuntime::LibSubDir, NdiMediaRuntime::LibName));
+
+	for (const FString& Candidate : Candidates)
+	{
+		if (LoadRuntime(Candidate))
+		{
+			return true;
+		}
+	}
+
+	return false;
 }
 
 
-void FNdi::Shutdown()
+bool FNdi::LoadRuntime(const FString& Path)
 {
-	if (LibHandle != nullptr)
+	void* Handle = FPlatformProcess::GetDllHandle(*Path);
+
+	if (Handle == nullptr)
 	{
-		NDIlib_destroy();
+		UE_LOG(LogNdiMedia, Log, TEXT("Failed to load NDI runtime %s"), *Path);
+		return false;
+	}
 
-		FPlatformProcess::FreeDllHandle(LibHandle);
-		LibHandle = nullptr;
+	typedef const NDIlib_v2* (*FLoadFunc)(void);
+	FLoadFunc LoadFunc = (FLoadFunc)FPlatformProcess::GetDllExport(Handle, TEXT("NDIlib_v2_load"));
+	const NDIlib_v2* LoadedLib = (LoadFunc != nullptr) ? LoadFunc() : nullptr;
+
+	if (LoadedLib == nullptr)
+	{
+		UE_LOG(LogNdiMedia, Warning, TEXT("NDI runtime %s has no function table"), *Path);
+		FPlatformProcess::FreeDllHandle(Handle);
+
+		return false;
+	}
+
+	FString MissingEntry;
+
+	if (!FNdiMediaSdkBackend::IsSupported(*LoadedLib, MissingEntry))
+	{
+		UE_LOG(LogNdiMedia, Warning, TEXT("NDI runtime %s is missing %s"), *Path, *MissingEntry);
+		FPlatformProcess::FreeDllHandle(Handle);
+
+		return false;
+	}
+
+	FString Version;
+	const int32 MajorVersion = NdiMediaRuntime::GetMajorVersion(*LoadedLib, Version);
+
+	// unknown versions are accepted, because all required entry points are present
+	if ((MajorVersion != INDEX_NONE) && (MajorVersion < NdiMediaRuntime::MinMajorVersion))
+	{
+		UE_LOG(LogNdiMedia, Warning, TEXT("NDI runtime %s is too old (%s, version %i or newer is required)"), *Path, *Version, NdiMediaRuntime::MinMajorVersion);
+		FPlatformProcess::FreeDllHandle(Handle);
+
+		return false;
 	}
+
+	UE_LOG(LogNdiMedia, Log, TEXT("Loaded NDI runtime %s (%s)"), *Path, *Version);
+
+	Lib = LoadedLib;
+	LibHandle = Handle;
+
+	return true;
+}
+
+#endif //NDIMEDIA_DLL_PLATFORM
+
+
+void FNdi::UpdateAvailability()
+{
+	Available = Backend.IsValid() || (RuntimeState == ERuntimeState::Uninitialized);
 }
@@ -2,16 +2,139 @@
 
 #pragma once
 
+#include "CoreMinimal.h"
 
+
+class INdiMediaBackend;
+
+struct NDIlib_v2;
+
+
+/**
+ * Manages the NDI runtime.
+ *
+ * The runtime is loaded and initialized on demand, when the backend is first
+ * requested by a player, finder or thumbnail probe, so that sessions that never
+ * use NDI don't pay for it. A failed initialization is not retried until it is
+ * requested explicitly.
+ *
+ * On desktop platforms the runtime library is loaded dynamically, and all calls
+ * are made through its function table, so that newer runtimes can be used
+ * without rebuilding the plug-in. The library configured in the plug-in settings
+ * is tried first, followed by the installed runtime and the bundled runtime.
+ */
 class FNdi
 {
 public:
 
+	/**
+	 * Get the backend that NDI calls are made on.
+	 *
+	 * Initializes the NDI runtime if needed, unless a different backend was set.
+	 *
+	 * @return The backend, or nullptr if NDI is not available.
+	 * @see SetBackend
+	 */
+	static TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> GetBackend();
+
+	/**
+	 * Load and initialize the NDI runtime now.
+	 *
+	 * @return true on success, false otherwise.
+	 * @see IsInitialized, Shutdown
+	 */
 	static bool Initialize();
+
+	/**
+	 * Whether NDI is or may become available, without initializing the runtime.
+	 *
+	 * Never blocks, so it can be called on the game thread while the runtime is
+	 * being initialized on another thread. Returns true if the runtime hasn't been
+	 * initialized yet, in which case initialization may still fail later.
+	 *
+	 * @return true if available, false otherwise.
+	 * @see IsInitialized
+	 */
+	static bool IsAvailable();
+
+	/**
+	 * Whether NDI is available, initializing the runtime if needed.
+	 *
+	 * @return true if available, false otherwise.
+	 * @see Initialize, IsAvailable
+	 */
 	static bool IsInitialized();
+
+	/**
+	 * Replace the backend that NDI calls are made on.
+	 *
+	 * Receivers and finders keep using the backend they were created on, so players
+	 * and finders must be reopened for the change to affect them.
+	 *
+	 * @param NewBackend The backend to use, or nullptr to restore the NDI runtime.
+	 * @see GetBackend
+	 */
+	static void SetBackend(const TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe>& NewBackend);
+
+	/**
+	 * Shut down the NDI runtime.
+	 *
+	 * The runtime won't be initialized on demand afterwards. Players and finders that
+	 * still hold the backend keep using it, and the runtime is destroyed and unloaded
+	 * when the last of them releases it.
+	 *
+	 * @see Initialize
+	 */
 	static void Shutdown();
 
 private:
 
+	/** States of the NDI runtime. */
+	enum class ERuntimeState : uint8
+	{
+		/** The runtime will be initialized on demand. */
+		Uninitialized,
+
+		/** The runtime is initialized. */
+		Initialized,
+
+		/** The runtime failed to initialize or was shut down. */
+		Unavailable
+	};
+
+	/**
+	 * Load and initialize the NDI runtime (caller holds the lock).
+	 *
+	 * @return true on success, false otherwise.
+	 */
+	static bool InitializeRuntime();
+
+	/**
+	 * Load the first usable NDI runtime library (caller holds the lock).
+	 *
+	 * @return true on success, false otherwise.
+	 */
+	static bool LoadRuntime();
+
+	/**
+	 * Load an NDI runtime library, and check its entry points and version (caller holds the lock).
+	 *
+	 * @param Path The path to the library.
+	 * @return true on success, false otherwise.
+	 */
+	static bool LoadRuntime(const FString& Path);
+
+	/** Update the availability flag from the backend and runtime state (caller holds the lock). */
+	static void UpdateAvailability();
+
+private:
+
+	static volatile bool Available;
+
+	static TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> Backend;
+	static FCriticalSection BackendCriticalSection;
+	static const NDIlib_v2* Lib;
 	static void* LibHandle;
+	static ERuntimeState RuntimeState;
+	static TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> SdkBackend;
 };
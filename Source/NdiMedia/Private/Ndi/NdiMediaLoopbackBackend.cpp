@@ -0,0 +1,1180 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaLoopbackBackend.h"
+#include "NdiMediaPrivate.h"
+
+#include "HAL/PlatformProcess.h"
+#include "Math/RandomStream.h"
+#include "Misc/ScopeLock.h"
+#include "NdiMediaAudioConversion.h"
+
+
+namespace NdiMediaLoopback
+{
+	/** 75% color bars (white, yellow, cyan, green, magenta, red, blue, black) as 8-bit RGB. */
+	static const uint8 BarsRgb[8][3] =
+	{
+		{ 191, 191, 191 }, { 191, 191, 0 }, { 0, 191, 191 }, { 0, 191, 0 },
+		{ 191, 0, 191 }, { 191, 0, 0 }, { 0, 0, 191 }, { 0, 0, 0 }
+	};
+
+	/** 75% color bars as 8-bit BT.709 limited range Y, Cb, Cr. */
+	static const uint8 BarsYuv[8][3] =
+	{
+		{ 180, 128, 128 }, { 168, 44, 136 }, { 145, 147, 44 }, { 133, 63, 52 },
+		{ 63, 193, 204 }, { 51, 109, 212 }, { 28, 212, 120 }, { 16, 128, 128 }
+	};
+
+	/** Frequency of the test tone (in Hz). */
+	static const int32 ToneFrequency = 1000;
+
+	/** Amplitude of the test tone (relative to the NDI reference level). */
+	static const float ToneAmplitude = 0.5f;
+
+	/** Schedules the frames of a synthetic stream. */
+	struct FStream
+	{
+		/** Whether the stream produces frames. */
+		bool Enabled;
+
+		/** Index of the next frame. */
+		int64 Index;
+
+		/** Nominal time between frames (in ticks). */
+		double IntervalTicks;
+
+		/** Time at which the next frame is due. */
+		FTimespan NextDue;
+
+		/** Number of dropped frames. */
+		int64 NumDropped;
+
+		/** Number of frames that were delivered or dropped. */
+		int64 NumTotal;
+
+		/** Nominal time of the first frame. */
+		FTimespan StartTime;
+
+		/** Default constructor. */
+		FStream()
+			: Enabled(false)
+			, Index(0)
+			, IntervalTicks(0.0)
+			, NumDropped(0)
+			, NumTotal(0)
+		{ }
+
+		/** Start the stream with its first frame due at the given time. */
+		void Start(double InIntervalTicks, FTimespan InStartTime)
+		{
+			Enabled = (InIntervalTicks > 0.0);
+			Index = 0;
+			IntervalTicks = InIntervalTicks;
+			NextDue = InStartTime;
+			StartTime = InStartTime;
+		}
+
+		/** Get the nominal time of the given frame. */
+		FTimespan GetNominalTime(int64 FrameIndex) const
+		{
+			return StartTime + FTimespan((int64)(FrameIndex * IntervalTicks));
+		}
+
+		/** Get the number of frames that are due at the given time. */
+		int64 GetNumDue(FTimespan Now) const
+		{
+			if (!Enabled || (Now < NextDue))
+			{
+				return 0;
+			}
+
+			return 1 + (int64)((Now - NextDue).GetTicks() / IntervalTicks);
+		}
+
+		/** Move on to the next frame. */
+		void Advance(FRandomStream& Random, float Jitter)
+		{
+			++Index;
+			++NumTotal;
+			NextDue = GetNominalTime(Index) + FTimespan((int64)(Random.GetFraction() * Jitter * IntervalTicks));
+		}
+
+		/** Drop the oldest frames that don't fit into the queue at the given time. */
+		void Drop(FTimespan Now, int32 MaxQueueDepth, FRandomStream& Random, float Jitter)
+		{
+			const int64 NumDrop = GetNumDue(Now) - MaxQueueDepth;
+
+			if (NumDrop > 0)
+			{
+				Index += NumDrop - 1;
+				NumDropped += NumDrop;
+				NumTotal += NumDrop - 1;
+				Advance(Random, Jitter);
+			}
+		}
+	};
+
+	/** Copy a string into a null-terminated UTF-8 buffer. */
+	static void CopyUtf8(const FString& String, TArray<ANSICHAR>& OutBuffer)
+	{
+		FTCHARToUTF8 Converted(*String);
+
+		OutBuffer.SetNumUninitialized(Converted.Length() + 1);
+		FMemory::Memcpy(OutBuffer.GetData(), Converted.Get(), Converted.Length());
+		OutBuffer[Converted.Length()] = '\0';
+	}
+
+	/** Copy a metadata frame into a null-terminated buffer. */
+	static void CopyMetadata(const NDIlib_metadata_frame_t& Metadata, TArray<ANSICHAR>& OutBuffer)
+	{
+		const int32 Length = (Metadata.p_data != nullptr) ? FCStringAnsi::Strlen(Metadata.p_data) : 0;
+
+		OutBuffer.SetNumUninitialized(Length + 1);
+		FMemory::Memcpy(OutBuffer.GetData(), Metadata.p_data, Length);
+		OutBuffer[Length] = '\0';
+	}
+
+	/** Fill a video frame buffer with color bars. */
+	static void FillColorBars(uint32 FourCC, int32 Width, int32 Height, int32 Stride, uint8* Buffer)
+	{
+		for (int32 Y = 0; Y < Height; ++Y)
+		{
+			uint8* Row = Buffer + Y * Stride;
+
+			if ((FourCC == NDIlib_FourCC_type_UYVY) || (FourCC == NDIlib_FourCC_type_UYVA))
+			{
+				for (int32 X = 0; X < Width; X += 2)
+				{
+					const uint8* Bar = BarsYuv[X * 8 / Width];
+
+					Row[X * 2 + 0] = Bar[1];
+					Row[X * 2 + 1] = Bar[0];
+					Row[X * 2 + 2] = Bar[2];
+					Row[X * 2 + 3] = Bar[0];
+				}
+			}
+			else
+			{
+				const bool Bgr = (FourCC == NDIlib_FourCC_type_BGRA) || (FourCC == NDIlib_FourCC_type_BGRX);
+				const bool Alpha = (FourCC == NDIlib_FourCC_type_BGRA) || (FourCC == NDIlib_FourCC_type_RGBA);
+
+				for (int32 X = 0; X < Width; ++X)
+				{
+					const uint8* Bar = BarsRgb[X * 8 / Width];
+
+					Row[X * 4 + 0] = Bgr ? Bar[2] : Bar[0];
+					Row[X * 4 + 1] = Bar[1];
+					Row[X * 4 + 2] = Bgr ? Bar[0] : Bar[2];
+					Row[X * 4 + 3] = Alpha ? (uint8)(X * 255 / FMath::Max(Width - 1, 1)) : 255;
+				}
+			}
+		}
+
+		// the alpha plane of UYVA frames follows the UYVY plane
+		if (FourCC == NDIlib_FourCC_type_UYVA)
+		{
+			uint8* AlphaPlane = Buffer + Height * Stride;
+
+			for (int32 Y = 0; Y < Height; ++Y)
+			{
+				for (int32 X = 0; X < Width; ++X)
+				{
+					AlphaPlane[Y * Width + X] = (uint8)(X * 255 / FMath::Max(Width - 1, 1));
+				}
+			}
+		}
+	}
+
+	/** Check whether two comma separated group lists have a group in common. */
+	static bool GroupsOverlap(const TArray<FString>& Groups, const TArray<FString>& OtherGroups)
+	{
+		for (const FString& Group : Groups)
+		{
+			for (const FString& OtherGroup : OtherGroups)
+			{
+				if (Group.Equals(OtherGroup, ESearchCase::IgnoreCase))
+				{
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	/** Parse a comma separated list of groups (an empty list means the public group). */
+	static TArray<FString> ParseGroups(const char* GroupsString)
+	{
+		TArray<FString> Groups;
+
+		if (GroupsString != nullptr)
+		{
+			FString(UTF8_TO_TCHAR(GroupsString)).ParseIntoArray(Groups, TEXT(","), true);
+
+			for (FString& Group : Groups)
+			{
+				Group.Trim();
+				Group.TrimTrailing();
+			}
+		}
+
+		if (Groups.Num() == 0)
+		{
+			Groups.Add(TEXT("public"));
+		}
+
+		return Groups;
+	}
+}
+
+
+/* FNdiMediaLoopbackBackend nested types
+ *****************************************************************************/
+
+struct FNdiMediaLoopbackBackend::FFinder
+{
+	/** The groups that the finder is searching. */
+	TArray<FString> Groups;
+
+	/** Whether the finder reports sources on the local machine. */
+	bool ShowLocalSources;
+
+	/** The sources reported by the most recent query. */
+	TArray<NDIlib_source_t> Sources;
+
+	/** The strings referenced by Sources. */
+	TArray<TArray<ANSICHAR>> Strings;
+};
+
+
+struct FNdiMediaLoopbackBackend::FReceiver
+{
+	/** Audio buffers that are not currently captured. */
+	TArray<float*> AvailableAudioBuffers;
+
+	/** Video buffers that are not currently captured. */
+	TArray<uint8*> AvailableVideoBuffers;
+
+	/** All audio buffers owned by this receiver. */
+	TArray<float*> AudioBuffers;
+
+	/** The audio stream. */
+	NdiMediaLoopback::FStream AudioStream;
+
+	/** Metadata frames that are sent on each new connection. */
+	TArray<TArray<ANSICHAR>> ConnectionMetadata;
+
+	/** Critical section for synchronizing access to the receiver's state. */
+	FCriticalSection CriticalSection;
+
+	/** The metadata stream. */
+	NdiMediaLoopback::FStream MetadataStream;
+
+	/** Random stream that generates the jitter. */
+	FRandomStream Random;
+
+	/** The name or address of the source the receiver is connected to. */
+	FString SourceName;
+
+	/** The tally state set by the receiver. */
+	NDIlib_tally_t Tally;
+
+	/** One period of the test tone. */
+	TArray<float> ToneTable;
+
+	/** All video buffers owned by this receiver. */
+	TArray<uint8*> VideoBuffers;
+
+	/** Size of each video buffer (in bytes). */
+	int32 VideoBufferSize;
+
+	/** Whether the video is sent as separate fields. */
+	bool VideoFields;
+
+	/** FourCC of the received video frames. */
+	uint32 VideoFourCC;
+
+	/** Frame format type of the received video frames (for fields, that of the first field). */
+	NDIlib_frame_format_type_e VideoFrameFormat;
+
+	/** Height of the received video frames. */
+	int32 VideoHeight;
+
+	/** Metadata attached to each video frame. */
+	TArray<ANSICHAR> VideoMetadata;
+
+	/** Line stride of the received video frames (in bytes). */
+	int32 VideoStride;
+
+	/** The video stream. */
+	NdiMediaLoopback::FStream VideoStream;
+
+	/** Width of the received video frames. */
+	int32 VideoWidth;
+
+	/** Default constructor. */
+	FReceiver()
+		: VideoBufferSize(0)
+		, VideoFields(false)
+		, VideoFourCC(0)
+		, VideoFrameFormat(NDIlib_frame_format_type_progressive)
+		, VideoHeight(0)
+		, VideoStride(0)
+		, VideoWidth(0)
+	{
+		Tally.on_preview = false;
+		Tally.on_program = false;
+	}
+
+	/** Destructor. */
+	~FReceiver()
+	{
+		for (float* Buffer : AudioBuffers)
+		{
+			FMemory::Free(Buffer);
+		}
+
+		for (uint8* Buffer : VideoBuffers)
+		{
+			FMemory::Free(Buffer);
+		}
+	}
+};
+
+
+struct FNdiMediaLoopbackBackend::FSender
+{
+	/** Metadata frames that are sent on each new connection. */
+	TArray<TArray<ANSICHAR>> ConnectionMetadata;
+
+	/** The groups that the sender is published in. */
+	TArray<FString> Groups;
+
+	/** Metadata frames received from connected receivers. */
+	TArray<TArray<ANSICHAR>> IncomingMetadata;
+
+	/** The tally state that was last reported. */
+	NDIlib_tally_t LastTally;
+
+	/** The sender's full source name. */
+	FString Name;
+};
+
+
+/* FNdiMediaLoopbackBackend structors
+ *****************************************************************************/
+
+FNdiMediaLoopbackBackend::FNdiMediaLoopbackBackend(const FNdiMediaLoopbackSettings& InSettings, const TSharedRef<INdiMediaClock, ESPMode::ThreadSafe>& InClock)
+	: Clock(InClock)
+	, MachineName(FPlatformProcess::ComputerName())
+	, NumCreatedReceivers(0)
+	, Settings(InSettings)
+{
+	Settings.Jitter = FMath::Clamp(Settings.Jitter, 0.0f, 0.99f);
+	Settings.MaxQueueDepth = FMath::Max(Settings.MaxQueueDepth, 1);
+}
+
+
+FNdiMediaLoopbackBackend::~FNdiMediaLoopbackBackend()
+{
+	for (FFinder* Finder : Finders)
+	{
+		delete Finder;
+	}
+
+	for (FReceiver* Receiver : Receivers)
+	{
+		delete Receiver;
+	}
+
+	for (FSender* Sender : Senders)
+	{
+		delete Sender;
+	}
+}
+
+
+/* FNdiMediaLoopbackBackend interface
+ *****************************************************************************/
+
+void FNdiMediaLoopbackBackend::GetPerformance(NDIlib_recv_performance_t& OutTotal, NDIlib_recv_performance_t& OutDropped)
+{
+	FMemory::Memzero(OutTotal);
+	FMemory::Memzero(OutDropped);
+
+	FScopeLock Lock(&CriticalSection);
+
+	for (FReceiver* Receiver : Receivers)
+	{
+		NDIlib_recv_performance_t ReceiverDropped;
+		NDIlib_recv_performance_t ReceiverTotal;
+
+		RecvGetPerformance(Receiver, ReceiverTotal, ReceiverDropped);
+
+		OutDropped.m_audio_frames += ReceiverDropped.m_audio_frames;
+		OutDropped.m_metadata_frames += ReceiverDropped.m_metadata_frames;
+		OutDropped.m_video_frames += ReceiverDropped.m_video_frames;
+
+		OutTotal.m_audio_frames += ReceiverTotal.m_audio_frames;
+		OutTotal.m_metadata_frames += ReceiverTotal.m_metadata_frames;
+		OutTotal.m_video_frames += ReceiverTotal.m_video_frames;
+	}
+}
+
+
+/* INdiMediaBackend interface
+ *****************************************************************************/
+
+FName FNdiMediaLoopbackBackend::GetName() const
+{
+	static FName LoopbackName(TEXT("Loopback"));
+	return LoopbackName;
+}
+
+
+NDIlib_find_instance_t FNdiMediaLoopbackBackend::FindCreate(const NDIlib_find_create_t& FindSettings)
+{
+	FFinder* Finder = new FFinder;
+	{
+		Finder->Groups = NdiMediaLoopback::ParseGroups(FindSettings.p_groups);
+		Finder->ShowLocalSources = FindSettings.show_local_sources;
+	}
+
+	FScopeLock Lock(&CriticalSection);
+	Finders.Add(Finder);
+
+	return Finder;
+}
+
+
+void FNdiMediaLoopbackBackend::FindDestroy(NDIlib_find_instance_t Instance)
+{
+	FFinder* Finder = (FFinder*)Instance;
+	{
+		FScopeLock Lock(&CriticalSection);
+		Finders.Remove(Finder);
+	}
+
+	delete Finder;
+}
+
+
+const NDIlib_source_t* FNdiMediaLoopbackBackend::FindGetCurrentSources(NDIlib_find_instance_t Instance, uint32& OutNumSources)
+{
+	FFinder* Finder = (FFinder*)Instance;
+
+	Finder->Sources.Reset();
+	Finder->Strings.Reset();
+
+	// all loopback sources run on the local machine
+	if (Finder->ShowLocalSources)
+	{
+		TArray<FString> Names;
+		TArray<FString> Addresses;
+
+		if (NdiMediaLoopback::GroupsOverlap(Finder->Groups, NdiMediaLoopback::ParseGroups(nullptr)))
+		{
+			for (int32 SourceIndex = 0; SourceIndex < Settings.NumSources; ++SourceIndex)
+			{
+				Names.Add(FString::Printf(TEXT("%s (Loopback %i)"), *MachineName, SourceIndex + 1));
+				Addresses.Add(FString::Printf(TEXT("127.0.0.1:%i"), 5961 + SourceIndex));
+			}
+		}
+
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			for (int32 SenderIndex = 0; SenderIndex < Senders.Num(); ++SenderIndex)
+			{
+				const FSender* Sender = Senders[SenderIndex];
+
+				if (NdiMediaLoopback::GroupsOverlap(Finder->Groups, Sender->Groups))
+				{
+					Names.Add(Sender->Name);
+					Addresses.Add(FString::Printf(TEXT("127.0.0.1:%i"), 5961 + Settings.NumSources + SenderIndex));
+				}
+			}
+		}
+
+		Finder->Strings.SetNum(Names.Num() * 2);
+
+		for (int32 NameIndex = 0; NameIndex < Names.Num(); ++NameIndex)
+		{
+			NdiMediaLoopback::CopyUtf8(Names[NameIndex], Finder->Strings[NameIndex * 2]);
+			NdiMediaLoopback::CopyUtf8(Addresses[NameIndex], Finder->Strings[NameIndex * 2 + 1]);
+
+			NDIlib_source_t Source;
+			{
+				Source.p_ndi_name = Finder->Strings[NameIndex * 2].GetData();
+				Source.p_ip_address = Finder->Strings[NameIndex * 2 + 1].GetData();
+			}
+
+			Finder->Sources.Add(Source);
+		}
+	}
+
+	OutNumSources = Finder->Sources.Num();
+
+	return Finder->Sources.GetData();
+}
+
+
+void FNdiMediaLoopbackBackend::RecvAddConnectionMetadata(NDIlib_recv_instance_t Instance, const NDIlib_metadata_frame_t& Metadata)
+{
+	FReceiver* Receiver = (FReceiver*)Instance;
+	{
+		FScopeLock Lock(&Receiver->CriticalSection);
+		NdiMediaLoopback::CopyMetadata(Metadata, Receiver->ConnectionMetadata[Receiver->ConnectionMetadata.AddDefaulted()]);
+	}
+
+	// receivers are always connected, so the metadata is sent right away
+	RecvSendMetadata(Instance, Metadata);
+}
+
+
+NDIlib_frame_type_e FNdiMediaLoopbackBackend::RecvCapture(NDIlib_recv_instance_t Instance, NDIlib_video_frame_v2_t* OutVideo, NDIlib_audio_frame_v2_t* OutAudio, NDIlib_metadata_frame_t* OutMetadata, uint32 Timeout)
+{
+	FReceiver* Receiver = (FReceiver*)Instance;
+	const FTimespan Deadline = Clock->GetTime() + FTimespan::FromMilliseconds(Timeout);
+
+	while (true)
+	{
+		const FTimespan Now = Clock->GetTime();
+		FTimespan WaitUntil = Deadline;
+
+		{
+			FScopeLock Lock(&Receiver->CriticalSection);
+
+			NdiMediaLoopback::FStream* Streams[] = { &Receiver->VideoStream, &Receiver->AudioStream, &Receiver->MetadataStream };
+			const bool Requested[] = { (OutVideo != nullptr), (OutAudio != nullptr), (OutMetadata != nullptr) };
+			int32 Earliest = INDEX_NONE;
+
+			for (int32 StreamIndex = 0; StreamIndex < 3; ++StreamIndex)
+			{
+				NdiMediaLoopback::FStream* Stream = Streams[StreamIndex];
+
+				if (!Stream->Enabled)
+				{
+					continue;
+				}
+
+				// the queues fill up whether they're captured or not
+				Stream->Drop(Now, Settings.MaxQueueDepth, Receiver->Random, Settings.Jitter);
+
+				if (Requested[StreamIndex] && ((Earliest == INDEX_NONE) || (Stream->NextDue < Streams[Earliest]->NextDue)))
+				{
+					Earliest = StreamIndex;
+				}
+			}
+
+			if (Earliest != INDEX_NONE)
+			{
+				NdiMediaLoopback::FStream& Stream = *Streams[Earliest];
+
+				if (Stream.NextDue > Now)
+				{
+					WaitUntil = FMath::Min(Stream.NextDue, Deadline);
+				}
+				else if (Earliest == 0)
+				{
+					// video frame
+					uint8* Buffer = nullptr;
+
+					if (Receiver->AvailableVideoBuffers.Num() > 0)
+					{
+						Buffer = Receiver->AvailableVideoBuffers.Pop(false);
+					}
+					else
+					{
+						// buffers are filled once, so that many large receivers don't need a separate pattern copy
+						Buffer = (uint8*)FMemory::Malloc(Receiver->VideoBufferSize);
+						NdiMediaLoopback::FillColorBars(Receiver->VideoFourCC, Receiver->VideoWidth, Receiver->VideoHeight, Receiver->VideoStride, Buffer);
+						Receiver->VideoBuffers.Add(Buffer);
+					}
+
+					FMemory::Memcpy(Buffer, &Stream.Index, sizeof(int64));
+
+					OutVideo->xres = Receiver->VideoWidth;
+					OutVideo->yres = Receiver->VideoHeight;
+					OutVideo->FourCC = (NDIlib_FourCC_type_e)Receiver->VideoFourCC;
+					OutVideo->frame_rate_N = Settings.VideoFrameRateN;
+					OutVideo->frame_rate_D = Settings.VideoFrameRateD;
+					OutVideo->picture_aspect_ratio = 0.0f;
+					OutVideo->frame_format_type = (Receiver->VideoFields && ((Stream.Index & 1) != 0))
+						? NDIlib_frame_format_type_field_1
+						: Receiver->VideoFrameFormat;
+					OutVideo->timecode = Stream.GetNominalTime(Stream.Index).GetTicks();
+					OutVideo->p_data = Buffer;
+					OutVideo->line_stride_in_bytes = Receiver->VideoStride;
+					OutVideo->p_metadata = (Receiver->VideoMetadata.Num() > 0) ? Receiver->VideoMetadata.GetData() : nullptr;
+					OutVideo->timestamp = Stream.NextDue.GetTicks();
+
+					Stream.Advance(Receiver->Random, Settings.Jitter);
+
+					return NDIlib_frame_type_video;
+				}
+				else if (Earliest == 1)
+				{
+					// audio frame
+					const int32 NumChannels = Settings.AudioChannels;
+					const int32 NumSamples = Settings.AudioSamplesPerFrame;
+
+					float* Buffer = nullptr;
+
+					if (Receiver->AvailableAudioBuffers.Num() > 0)
+					{
+						Buffer = Receiver->AvailableAudioBuffers.Pop(false);
+					}
+					else
+					{
+						Buffer = (float*)FMemory::Malloc(NumChannels * NumSamples * sizeof(float));
+						Receiver->AudioBuffers.Add(Buffer);
+					}
+
+					const TArray<float>& ToneTable = Receiver->ToneTable;
+					const int32 FirstSample = (int32)((Stream.Index * NumSamples) % ToneTable.Num());
+
+					for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+					{
+						float* Channel = Buffer + ChannelIndex * NumSamples;
+
+						for (int32 SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+						{
+							Channel[SampleIndex] = ToneTable[(FirstSample + SampleIndex) % ToneTable.Num()];
+						}
+					}
+
+					OutAudio->sample_rate = Settings.AudioSampleRate;
+					OutAudio->no_channels = NumChannels;
+					OutAudio->no_samples = NumSamples;
+					OutAudio->timecode = Stream.GetNominalTime(Stream.Index).GetTicks();
+					OutAudio->p_data = Buffer;
+					OutAudio->channel_stride_in_bytes = NumSamples * sizeof(float);
+					OutAudio->p_metadata = nullptr;
+					OutAudio->timestamp = Stream.NextDue.GetTicks();
+
+					Stream.Advance(Receiver->Random, Settings.Jitter);
+
+					return NDIlib_frame_type_audio;
+				}
+				else
+				{
+					// metadata frame
+					FString Text = FString::Printf(TEXT("<ndi_loopback frame=\"%lld\" timestamp=\"%lld\""), Stream.Index, Stream.NextDue.GetTicks());
+
+					while (Text.Len() < Settings.MetadataSize - 2)
+					{
+						Text.AppendChar(TEXT(' '));
+					}
+
+					Text += TEXT("/>");
+
+					FTCHARToUTF8 Converted(*Text);
+					char* Data = (char*)FMemory::Malloc(Converted.Length() + 1);
+					{
+						FMemory::Memcpy(Data, Converted.Get(), Converted.Length());
+						Data[Converted.Length()] = '\0';
+					}
+
+					OutMetadata->length = Converted.Length() + 1;
+					OutMetadata->timecode = Stream.GetNominalTime(Stream.Index).GetTicks();
+					OutMetadata->p_data = Data;
+
+					Stream.Advance(Receiver->Random, Settings.Jitter);
+
+					return NDIlib_frame_type_metadata;
+				}
+			}
+		}
+
+		if (Now >= Deadline)
+		{
+			return NDIlib_frame_type_none;
+		}
+
+		Clock->Wait(WaitUntil - Now);
+	}
+}
+
+
+void FNdiMediaLoopbackBackend::RecvClearConnectionMetadata(NDIlib_recv_instance_t Instance)
+{
+	FReceiver* Receiver = (FReceiver*)Instance;
+
+	FScopeLock Lock(&Receiver->CriticalSection);
+	Receiver->ConnectionMetadata.Empty();
+}
+
+
+NDIlib_recv_instance_t FNdiMediaLoopbackBackend::RecvCreate(const NDIlib_recv_create_t& RecvSettings)
+{
+	const bool HasAlpha = Settings.VideoAlpha;
+	uint32 FourCC = 0;
+
+	// like the NDI runtime, deliver the format that the receiver asked for
+	switch ((int64)RecvSettings.color_format)
+	{
+	case NDIlib_recv_color_format_e_BGRX_BGRA:
+		FourCC = HasAlpha ? NDIlib_FourCC_type_BGRA : NDIlib_FourCC_type_BGRX;
+		break;
+
+	case NDIlib_recv_color_format_e_RGBX_RGBA:
+		FourCC = HasAlpha ? NDIlib_FourCC_type_RGBA : NDIlib_FourCC_type_RGBX;
+		break;
+
+	case NDIlib_recv_color_format_e_UYVY_BGRA:
+		FourCC = HasAlpha ? NDIlib_FourCC_type_BGRA : NDIlib_FourCC_type_UYVY;
+		break;
+
+	case NDIlib_recv_color_format_e_UYVY_RGBA:
+		FourCC = HasAlpha ? NDIlib_FourCC_type_RGBA : NDIlib_FourCC_type_UYVY;
+		break;
+
+	case NdiMedia::RecvColorFormatFastest:
+		FourCC = HasAlpha ? NDIlib_FourCC_type_UYVA : NDIlib_FourCC_type_UYVY;
+		break;
+
+	default:
+		return nullptr;
+	}
+
+	FReceiver* Receiver = new FReceiver;
+	const FTimespan Now = Clock->GetTime();
+
+	// source
+	const NDIlib_source_t& Source = RecvSettings.source_to_connect_to;
+
+	if ((Source.p_ndi_name != nullptr) && (Source.p_ndi_name[0] != '\0'))
+	{
+		Receiver->SourceName = UTF8_TO_TCHAR(Source.p_ndi_name);
+	}
+	else if (Source.p_ip_address != nullptr)
+	{
+		Receiver->SourceName = UTF8_TO_TCHAR(Source.p_ip_address);
+	}
+
+	// video
+	const bool ReceiveVideo = (RecvSettings.bandwidth != NDIlib_recv_bandwidth_metadata_only) &&
+		(RecvSettings.bandwidth != NDIlib_recv_bandwidth_audio_only) &&
+		(Settings.VideoFrameRateN > 0) && (Settings.VideoFrameRateD > 0) &&
+		(Settings.VideoWidth > 1) && (Settings.VideoHeight > 1);
+
+	if (ReceiveVideo)
+	{
+		int32 Width = Settings.VideoWidth;
+		int32 Height = Settings.VideoHeight;
+
+		// low bandwidth receivers get a preview sized stream
+		if (RecvSettings.bandwidth == NDIlib_recv_bandwidth_lowest)
+		{
+			while (Width > 640)
+			{
+				Width /= 2;
+				Height /= 2;
+			}
+		}
+
+		const bool Fielded = (Settings.VideoFrameFormat == NDIlib_frame_format_type_field_0) ||
+			(Settings.VideoFrameFormat == NDIlib_frame_format_type_field_1);
+
+		Receiver->VideoFields = Fielded && RecvSettings.allow_video_fields;
+		Receiver->VideoFourCC = FourCC;
+
+		if (Receiver->VideoFields)
+		{
+			Receiver->VideoFrameFormat = NDIlib_frame_format_type_field_0;
+			Height /= 2;
+		}
+		else if (Fielded)
+		{
+			Receiver->VideoFrameFormat = NDIlib_frame_format_type_interleaved;
+		}
+		else
+		{
+			Receiver->VideoFrameFormat = Settings.VideoFrameFormat;
+		}
+
+		const bool Yuv = (FourCC == NDIlib_FourCC_type_UYVY) || (FourCC == NDIlib_FourCC_type_UYVA);
+
+		Receiver->VideoWidth = Yuv ? (Width & ~1) : Width;
+		Receiver->VideoHeight = FMath::Max(Height, 1);
+		Receiver->VideoStride = Receiver->VideoWidth * (Yuv ? 2 : 4);
+		Receiver->VideoBufferSize = Receiver->VideoStride * Receiver->VideoHeight;
+
+		if (FourCC == NDIlib_FourCC_type_UYVA)
+		{
+			Receiver->VideoBufferSize += Receiver->VideoWidth * Receiver->VideoHeight;
+		}
+
+		if (!Settings.VideoMetadata.IsEmpty())
+		{
+			NdiMediaLoopback::CopyUtf8(Settings.VideoMetadata, Receiver->VideoMetadata);
+		}
+
+		double IntervalTicks = (double)ETimespan::TicksPerSecond * Settings.VideoFrameRateD / Settings.VideoFrameRateN;
+
+		if (Receiver->VideoFields)
+		{
+			IntervalTicks *= 0.5;
+		}
+
+		Receiver->VideoStream.Start(IntervalTicks, Now);
+	}
+
+	// audio
+	const bool ReceiveAudio = (RecvSettings.bandwidth != NDIlib_recv_bandwidth_metadata_only) &&
+		(Settings.AudioChannels > 0) && (Settings.AudioSampleRate > 0) && (Settings.AudioSamplesPerFrame > 0);
+
+	if (ReceiveAudio)
+	{
+		// one period of the tone covers a whole number of cycles
+		int32 A = Settings.AudioSampleRate;
+		int32 B = NdiMediaLoopback::ToneFrequency;
+
+		while (B != 0)
+		{
+			const int32 R = A % B;
+			A = B;
+			B = R;
+		}
+
+		const int32 PeriodSamples = Settings.AudioSampleRate / A;
+		const int32 PeriodCycles = NdiMediaLoopback::ToneFrequency / A;
+
+		Receiver->ToneTable.SetNumUninitialized(PeriodSamples);
+
+		for (int32 SampleIndex = 0; SampleIndex < PeriodSamples; ++SampleIndex)
+		{
+			Receiver->ToneTable[SampleIndex] = NdiMediaLoopback::ToneAmplitude * FMath::Sin(2.0f * PI * PeriodCycles * SampleIndex / PeriodSamples);
+		}
+
+		Receiver->AudioStream.Start((double)ETimespan::TicksPerSecond * Settings.AudioSamplesPerFrame / Settings.AudioSampleRate, Now);
+	}
+
+	// metadata
+	if (Settings.MetadataRate > 0.0f)
+	{
+		Receiver->MetadataStream.Start((double)ETimespan::TicksPerSecond / Settings.MetadataRate, Now);
+	}
+
+	FScopeLock Lock(&CriticalSection);
+	{
+		Receiver->Random.Initialize(Settings.Seed + NumCreatedReceivers++);
+		Receivers.Add(Receiver);
+	}
+
+	return Receiver;
+}
+
+
+void FNdiMediaLoopbackBackend::RecvDestroy(NDIlib_recv_instance_t Instance)
+{
+	FReceiver* Receiver = (FReceiver*)Instance;
+	{
+		FScopeLock Lock(&CriticalSection);
+		Receivers.Remove(Receiver);
+	}
+
+	delete Receiver;
+}
+
+
+void FNdiMediaLoopbackBackend::RecvFreeAudio(NDIlib_recv_instance_t Instance, const NDIlib_audio_frame_v2_t& Audio)
+{
+	FReceiver* Receiver = (FReceiver*)Instance;
+
+	FScopeLock Lock(&Receiver->CriticalSection);
+	Receiver->AvailableAudioBuffers.Add(Audio.p_data);
+}
+
+
+void FNdiMediaLoopbackBackend::RecvFreeMetadata(NDIlib_recv_instance_t Instance, const NDIlib_metadata_frame_t& Metadata)
+{
+	FMemory::Free(Metadata.p_data);
+}
+
+
+void FNdiMediaLoopbackBackend::RecvFreeVideo(NDIlib_recv_instance_t Instance, const NDIlib_video_frame_v2_t& Video)
+{
+	FReceiver* Receiver = (FReceiver*)Instance;
+
+	FScopeLock Lock(&Receiver->CriticalSection);
+	Receiver->AvailableVideoBuffers.Add(Video.p_data);
+}
+
+
+int32 FNdiMediaLoopbackBackend::RecvGetNumConnections(NDIlib_recv_instance_t Instance)
+{
+	return 1; // synthetic sources are always online
+}
+
+
+void FNdiMediaLoopbackBackend::RecvGetPerformance(NDIlib_recv_instance_t Instance, NDIlib_recv_performance_t& OutTotal, NDIlib_recv_performance_t& OutDropped)
+{
+	FReceiver* Receiver = (FReceiver*)Instance;
+	const FTimespan Now = Clock->GetTime();
+
+	FScopeLock Lock(&Receiver->CriticalSection);
+
+	Receiver->AudioStream.Drop(Now, Settings.MaxQueueDepth, Receiver->Random, Settings.Jitter);
+	Receiver->MetadataStream.Drop(Now, Settings.MaxQueueDepth, Receiver->Random, Settings.Jitter);
+	Receiver->VideoStream.Drop(Now, Settings.MaxQueueDepth, Receiver->Random, Settings.Jitter);
+
+	OutTotal.m_audio_frames = Receiver->AudioStream.NumTotal;
+	OutTotal.m_metadata_frames = Receiver->MetadataStream.NumTotal;
+	OutTotal.m_video_frames = Receiver->VideoStream.NumTotal;
+
+	OutDropped.m_audio_frames = Receiver->AudioStream.NumDropped;
+	OutDropped.m_metadata_frames = Receiver->MetadataStream.NumDropped;
+	OutDropped.m_video_frames = Receiver->VideoStream.NumDropped;
+}
+
+
+void FNdiMediaLoopbackBackend::RecvGetQueue(NDIlib_recv_instance_t Instance, NDIlib_recv_queue_t& OutQueue)
+{
+	FReceiver* Receiver = (FReceiver*)Instance;
+	const FTimespan Now = Clock->GetTime();
+
+	FScopeLock Lock(&Receiver->CriticalSection);
+
+	OutQueue.m_audio_frames = (int)FMath::Min<int64>(Receiver->AudioStream.GetNumDue(Now), Settings.MaxQueueDepth);
+	OutQueue.m_metadata_frames = (int)FMath::Min<int64>(Receiver->MetadataStream.GetNumDue(Now), Settings.MaxQueueDepth);
+	OutQueue.m_video_frames = (int)FMath::Min<int64>(Receiver->VideoStream.GetNumDue(Now), Settings.MaxQueueDepth);
+}
+
+
+bool FNdiMediaLoopbackBackend::RecvSendMetadata(NDIlib_recv_instance_t Instance, const NDIlib_metadata_frame_t& Metadata)
+{
+	FReceiver* Receiver = (FReceiver*)Instance;
+
+	FScopeLock Lock(&CriticalSection);
+
+	for (FSender* Sender : Senders)
+	{
+		if (Sender->Name == Receiver->SourceName)
+		{
+			NdiMediaLoopback::CopyMetadata(Metadata, Sender->IncomingMetadata[Sender->IncomingMetadata.AddDefaulted()]);
+		}
+	}
+
+	return true;
+}
+
+
+bool FNdiMediaLoopbackBackend::RecvSetTally(NDIlib_recv_instance_t Instance, const NDIlib_tally_t& Tally)
+{
+	FReceiver* Receiver = (FReceiver*)Instance;
+
+	FScopeLock Lock(&Receiver->CriticalSection);
+	Receiver->Tally = Tally;
+
+	return true;
+}
+
+
+bool FNdiMediaLoopbackBackend::RecvSupportsColorFormat(int64 ColorFormat) const
+{
+	switch (ColorFormat)
+	{
+	case NDIlib_recv_color_format_e_BGRX_BGRA:
+	case NDIlib_recv_color_format_e_RGBX_RGBA:
+	case NDIlib_recv_color_format_e_UYVY_BGRA:
+	case NDIlib_recv_color_format_e_UYVY_RGBA:
+	case NdiMedia::RecvColorFormatFastest:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+
+void FNdiMediaLoopbackBackend::SendAddConnectionMetadata(NDIlib_send_instance_t Instance, const NDIlib_metadata_frame_t& Metadata)
+{
+	FSender* Sender = (FSender*)Instance;
+
+	FScopeLock Lock(&CriticalSection);
+	NdiMediaLoopback::CopyMetadata(Metadata, Sender->ConnectionMetadata[Sender->ConnectionMetadata.AddDefaulted()]);
+}
+
+
+void FNdiMediaLoopbackBackend::SendAudio(NDIlib_send_instance_t Instance, const NDIlib_audio_frame_v2_t& Audio)
+{
+	// frames are discarded
+}
+
+
+NDIlib_frame_type_e FNdiMediaLoopbackBackend::SendCapture(NDIlib_send_instance_t Instance, NDIlib_metadata_frame_t& OutMetadata, uint32 Timeout)
+{
+	FSender* Sender = (FSender*)Instance;
+
+	for (int32 Attempt = 0; Attempt < 2; ++Attempt)
+	{
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			if (Sender->IncomingMetadata.Num() > 0)
+			{
+				const TArray<ANSICHAR>& Incoming = Sender->IncomingMetadata[0];
+				char* Data = (char*)FMemory::Malloc(Incoming.Num());
+				FMemory::Memcpy(Data, Incoming.GetData(), Incoming.Num());
+
+				OutMetadata.length = Incoming.Num();
+				OutMetadata.timecode = Clock->GetTime().GetTicks();
+				OutMetadata.p_data = Data;
+
+				Sender->IncomingMetadata.RemoveAt(0);
+
+				return NDIlib_frame_type_metadata;
+			}
+		}
+
+		if ((Attempt == 0) && (Timeout > 0))
+		{
+			Clock->Wait(FTimespan::FromMilliseconds(Timeout));
+		}
+	}
+
+	return NDIlib_frame_type_none;
+}
+
+
+void FNdiMediaLoopbackBackend::SendClearConnectionMetadata(NDIlib_send_instance_t Instance)
+{
+	FSender* Sender = (FSender*)Instance;
+
+	FScopeLock Lock(&CriticalSection);
+	Sender->ConnectionMetadata.Empty();
+}
+
+
+NDIlib_send_instance_t FNdiMediaLoopbackBackend::SendCreate(const NDIlib_send_create_t& SendSettings)
+{
+	if ((SendSettings.p_ndi_name == nullptr) || (SendSettings.p_ndi_name[0] == '\0'))
+	{
+		return nullptr;
+	}
+
+	FSender* Sender = new FSender;
+	{
+		Sender->Groups = NdiMediaLoopback::ParseGroups(SendSettings.p_groups);
+		Sender->LastTally.on_preview = false;
+		Sender->LastTally.on_program = false;
+		Sender->Name = FString::Printf(TEXT("%s (%s)"), *MachineName, UTF8_TO_TCHAR(SendSettings.p_ndi_name));
+	}
+
+	FScopeLock Lock(&CriticalSection);
+	Senders.Add(Sender);
+
+	return Sender;
+}
+
+
+void FNdiMediaLoopbackBackend::SendDestroy(NDIlib_send_instance_t Instance)
+{
+	FSender* Sender = (FSender*)Instance;
+	{
+		FScopeLock Lock(&CriticalSection);
+		Senders.Remove(Sender);
+	}
+
+	delete Sender;
+}
+
+
+void FNdiMediaLoopbackBackend::SendFreeMetadata(NDIlib_send_instance_t Instance, const NDIlib_metadata_frame_t& Metadata)
+{
+	FMemory::Free(Metadata.p_data);
+}
+
+
+int32 FNdiMediaLoopbackBackend::SendGetNumConnections(NDIlib_send_instance_t Instance, uint32 Timeout)
+{
+	FSender* Sender = (FSender*)Instance;
+	int32 NumConnections = 0;
+
+	FScopeLock Lock(&CriticalSection);
+	GetSourceTally(Sender->Name, NumConnections);
+
+	return NumConnections;
+}
+
+
+bool FNdiMediaLoopbackBackend::SendGetTally(NDIlib_send_instance_t Instance, NDIlib_tally_t& OutTally, uint32 Timeout)
+{
+	FSender* Sender = (FSender*)Instance;
+
+	for (int32 Attempt = 0; Attempt < 2; ++Attempt)
+	{
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			int32 NumConnections = 0;
+			OutTally = GetSourceTally(Sender->Name, NumConnections);
+
+			if ((OutTally.on_preview != Sender->LastTally.on_preview) || (OutTally.on_program != Sender->LastTally.on_program))
+			{
+				Sender->LastTally = OutTally;
+
+				return true;
+			}
+		}
+
+		if ((Attempt == 0) && (Timeout > 0))
+		{
+			Clock->Wait(FTimespan::FromMilliseconds(Timeout));
+		}
+	}
+
+	return false;
+}
+
+
+void FNdiMediaLoopbackBackend::SendMetadata(NDIlib_send_instance_t Instance, const NDIlib_metadata_frame_t& Metadata)
+{
+	// frames are discarded
+}
+
+
+void FNdiMediaLoopbackBackend::SendVideo(NDIlib_send_instance_t Instance, const NDIlib_video_frame_v2_t& Video)
+{
+	// frames are discarded
+}
+
+
+void FNdiMediaLoopbackBackend::AudioToInterleaved16s(const NDIlib_audio_frame_v2_t& Source, NDIlib_audio_frame_interleaved_16s_t& Dest)
+{
+	NdiMediaAudio::ConvertToInterleaved16s(Source, Dest);
+}
+
+
+/* FNdiMediaLoopbackBackend implementation
+ *****************************************************************************/
+
+NDIlib_tally_t FNdiMediaLoopbackBackend::GetSourceTally(const FString& SourceName, int32& OutNumConnections) const
+{
+	NDIlib_tally_t Tally;
+	{
+		Tally.on_preview = false;
+		Tally.on_program = false;
+	}
+
+	OutNumConnections = 0;
+
+	for (FReceiver* Receiver : Receivers)
+	{
+		if (Receiver->SourceName != SourceName)
+		{
+			continue;
+		}
+
+		FScopeLock Lock(&Receiver->CriticalSection);
+
+		Tally.on_preview |= Receiver->Tally.on_preview;
+		Tally.on_program |= Receiver->Tally.on_program;
+
+		++OutNumConnections;
+	}
+
+	return Tally;
+}
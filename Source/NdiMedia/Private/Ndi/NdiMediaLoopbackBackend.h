@@ -0,0 +1,243 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "INdiMediaBackend.h"
+#include "INdiMediaClock.h"
+
+
+/**
+ * Describes the synthetic sources of a loopback backend.
+ */
+struct FNdiMediaLoopbackSettings
+{
+	/** Number of audio channels (0 = no audio). */
+	int32 AudioChannels;
+
+	/** Audio sample rate (in samples per second). */
+	int32 AudioSampleRate;
+
+	/** Number of samples per audio frame and channel. */
+	int32 AudioSamplesPerFrame;
+
+	/**
+	 * Maximum random delay of each frame relative to its nominal time.
+	 *
+	 * The delay is a fraction of the stream's frame interval (0.0 to 1.0). Delays
+	 * don't accumulate, so jitter doesn't change the average frame rate.
+	 */
+	float Jitter;
+
+	/** Maximum number of frames that are queued per stream before the oldest frames are dropped. */
+	int32 MaxQueueDepth;
+
+	/** Number of metadata frames per second (0 = no metadata). */
+	float MetadataRate;
+
+	/** Size of each metadata frame (in bytes, excluding the null terminator). */
+	int32 MetadataSize;
+
+	/** Number of synthetic sources that finders report. */
+	int32 NumSources;
+
+	/** Seed of the random streams that generate the jitter. */
+	int32 Seed;
+
+	/**
+	 * Whether the synthetic video carries an alpha channel.
+	 *
+	 * As with the NDI runtime, the FourCC of the received frames depends on
+	 * this setting and on the receiver's color format.
+	 */
+	bool VideoAlpha;
+
+	/** Frame format of the synthetic video (fielded formats send alternating fields). */
+	NDIlib_frame_format_type_e VideoFrameFormat;
+
+	/** Video frame rate denominator. */
+	int32 VideoFrameRateD;
+
+	/** Video frame rate numerator (0 = no video). */
+	int32 VideoFrameRateN;
+
+	/** Height of the video frames (in pixels). */
+	int32 VideoHeight;
+
+	/** Metadata that is attached to each video frame (empty = none). */
+	FString VideoMetadata;
+
+	/** Width of the video frames (in pixels). */
+	int32 VideoWidth;
+
+public:
+
+	/** Default constructor (1080p29.97 UYVY video with 2 channel 48 kHz audio). */
+	FNdiMediaLoopbackSettings()
+		: AudioChannels(2)
+		, AudioSampleRate(48000)
+		, AudioSamplesPerFrame(1602)
+		, Jitter(0.0f)
+		, MaxQueueDepth(4)
+		, MetadataRate(0.0f)
+		, MetadataSize(64)
+		, NumSources(1)
+		, Seed(0)
+		, VideoAlpha(false)
+		, VideoFrameFormat(NDIlib_frame_format_type_progressive)
+		, VideoFrameRateD(1001)
+		, VideoFrameRateN(30000)
+		, VideoHeight(1080)
+		, VideoWidth(1920)
+	{ }
+};
+
+
+/**
+ * Implements an NDI backend that generates synthetic frames in-process.
+ *
+ * Every receiver is connected to a synthetic source that produces color bar
+ * video, a 1 kHz test tone and fixed size metadata frames at the rates given
+ * in the settings. Each video frame has its frame number stamped into its first
+ * eight bytes. Frames are scheduled on an injected clock, and frames that aren't
+ * captured in time are dropped, just like the NDI runtime does.
+ *
+ * Finders report the synthetic sources and all senders created on this backend.
+ * Senders discard the frames they are given, but they receive the metadata and
+ * tally sent by receivers that are connected to them by name.
+ *
+ * @see FNdi::SetBackend, FNdiMediaManualClock
+ */
+class FNdiMediaLoopbackBackend
+	: public INdiMediaBackend
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InSettings The synthetic source settings.
+	 * @param InClock The clock that times the synthetic sources.
+	 */
+	FNdiMediaLoopbackBackend(const FNdiMediaLoopbackSettings& InSettings, const TSharedRef<INdiMediaClock, ESPMode::ThreadSafe>& InClock);
+
+	/** Virtual destructor. */
+	virtual ~FNdiMediaLoopbackBackend();
+
+public:
+
+	/**
+	 * Get the clock that times the synthetic sources.
+	 *
+	 * @return The clock.
+	 */
+	const TSharedRef<INdiMediaClock, ESPMode::ThreadSafe>& GetClock() const
+	{
+		return Clock;
+	}
+
+	/**
+	 * Get the frame counters of all receivers combined.
+	 *
+	 * @param OutTotal Will contain the number of frames that were delivered or dropped.
+	 * @param OutDropped Will contain the number of dropped frames.
+	 * @see RecvGetPerformance
+	 */
+	void GetPerformance(NDIlib_recv_performance_t& OutTotal, NDIlib_recv_performance_t& OutDropped);
+
+	/**
+	 * Get the synthetic source settings.
+	 *
+	 * @return Settings.
+	 */
+	const FNdiMediaLoopbackSettings& GetSettings() const
+	{
+		return Settings;
+	}
+
+public:
+
+	//~ INdiMediaBackend interface
+
+	virtual FName GetName() const override;
+
+	virtual NDIlib_find_instance_t FindCreate(const NDIlib_find_create_t& FindSettings) override;
+	virtual void FindDestroy(NDIlib_find_instance_t Instance) override;
+	virtual const NDIlib_source_t* FindGetCurrentSources(NDIlib_find_instance_t Instance, uint32& OutNumSources) override;
+
+	virtual void RecvAddConnectionMetadata(NDIlib_recv_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) override;
+	virtual NDIlib_frame_type_e RecvCapture(NDIlib_recv_instance_t Instance, NDIlib_video_frame_v2_t* OutVideo, NDIlib_audio_frame_v2_t* OutAudio, NDIlib_metadata_frame_t* OutMetadata, uint32 Timeout) override;
+	virtual void RecvClearConnectionMetadata(NDIlib_recv_instance_t Instance) override;
+	virtual NDIlib_recv_instance_t RecvCreate(const NDIlib_recv_create_t& RecvSettings) override;
+	virtual void RecvDestroy(NDIlib_recv_instance_t Instance) override;
+	virtual void RecvFreeAudio(NDIlib_recv_instance_t Instance, const NDIlib_audio_frame_v2_t& Audio) override;
+	virtual void RecvFreeMetadata(NDIlib_recv_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) override;
+	virtual void RecvFreeVideo(NDIlib_recv_instance_t Instance, const NDIlib_video_frame_v2_t& Video) override;
+	virtual int32 RecvGetNumConnections(NDIlib_recv_instance_t Instance) override;
+	virtual void RecvGetPerformance(NDIlib_recv_instance_t Instance, NDIlib_recv_performance_t& OutTotal, NDIlib_recv_performance_t& OutDropped) override;
+	virtual void RecvGetQueue(NDIlib_recv_instance_t Instance, NDIlib_recv_queue_t& OutQueue) override;
+	virtual bool RecvSendMetadata(NDIlib_recv_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) override;
+	virtual bool RecvSetTally(NDIlib_recv_instance_t Instance, const NDIlib_tally_t& Tally) override;
+	virtual bool RecvSupportsColorFormat(int64 ColorFormat) const override;
+
+	virtual void SendAddConnectionMetadata(NDIlib_send_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) override;
+	virtual void SendAudio(NDIlib_send_instance_t Instance, const NDIlib_audio_frame_v2_t& Audio) override;
+	virtual NDIlib_frame_type_e SendCapture(NDIlib_send_instance_t Instance, NDIlib_metadata_frame_t& OutMetadata, uint32 Timeout) override;
+	virtual void SendClearConnectionMetadata(NDIlib_send_instance_t Instance) override;
+	virtual NDIlib_send_instance_t SendCreate(const NDIlib_send_create_t& SendSettings) override;
+	virtual void SendDestroy(NDIlib_send_instance_t Instance) override;
+	virtual void SendFreeMetadata(NDIlib_send_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) override;
+	virtual int32 SendGetNumConnections(NDIlib_send_instance_t Instance, uint32 Timeout) override;
+	virtual bool SendGetTally(NDIlib_send_instance_t Instance, NDIlib_tally_t& OutTally, uint32 Timeout) override;
+	virtual void SendMetadata(NDIlib_send_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) override;
+	virtual void SendVideo(NDIlib_send_instance_t Instance, const NDIlib_video_frame_v2_t& Video) override;
+
+	virtual void AudioToInterleaved16s(const NDIlib_audio_frame_v2_t& Source, NDIlib_audio_frame_interleaved_16s_t& Dest) override;
+
+protected:
+
+	/** State of a finder instance. */
+	struct FFinder;
+
+	/** State of a receiver instance. */
+	struct FReceiver;
+
+	/** State of a sender instance. */
+	struct FSender;
+
+	/**
+	 * Get the aggregated tally state of all receivers that are connected to the given source.
+	 *
+	 * @param SourceName The name of the source.
+	 * @param OutNumConnections Will contain the number of connected receivers.
+	 * @return The tally state.
+	 */
+	NDIlib_tally_t GetSourceTally(const FString& SourceName, int32& OutNumConnections) const;
+
+private:
+
+	/** Critical section for synchronizing access to the instance lists. */
+	mutable FCriticalSection CriticalSection;
+
+	/** The clock that times the synthetic sources. */
+	TSharedRef<INdiMediaClock, ESPMode::ThreadSafe> Clock;
+
+	/** The finder instances. */
+	TArray<FFinder*> Finders;
+
+	/** The name of the machine that loopback sources appear to run on. */
+	FString MachineName;
+
+	/** Number of receivers created so far (used to seed their random streams). */
+	int32 NumCreatedReceivers;
+
+	/** The receiver instances. */
+	TArray<FReceiver*> Receivers;
+
+	/** The sender instances. */
+	TArray<FSender*> Senders;
+
+	/** The synthetic source settings. */
+	FNdiMediaLoopbackSettings Settings;
+};
@@ -0,0 +1,348 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaSdkBackend.h"
+#include "NdiMediaPrivate.h"
+
+#include "HAL/PlatformProcess.h"
+#include "NdiMediaAudioConversion.h"
+
+
+/* FNdiMediaSdkBackend structors
+ *****************************************************************************/
+
+FNdiMediaSdkBackend::FNdiMediaSdkBackend(const NDIlib_v2& InLib, void* InLibHandle, int32 InMajorVersion)
+	: Lib(&InLib)
+	, LibHandle(InLibHandle)
+	, MajorVersion(InMajorVersion)
+{
+	if (Lib->NDIlib_util_audio_to_interleaved_16s_v2 == nullptr)
+	{
+		UE_LOG(LogNdiMedia, Log, TEXT("NDI runtime has no audio conversion, using portable fallback"));
+	}
+}
+
+
+FNdiMediaSdkBackend::~FNdiMediaSdkBackend()
+{
+	// the last user of the runtime is gone
+	Lib->NDIlib_destroy();
+	Lib = nullptr;
+
+	if (LibHandle != nullptr)
+	{
+		FPlatformProcess::FreeDllHandle(LibHandle);
+		LibHandle = nullptr;
+	}
+
+	UE_LOG(LogNdiMedia, Log, TEXT("Destroyed NDI runtime"));
+}
+
+
+/* FNdiMediaSdkBackend static functions
+ *****************************************************************************/
+
+bool FNdiMediaSdkBackend::IsSupported(const NDIlib_v2& Lib, FString& OutMissing)
+{
+	#define NDIMEDIA_REQUIRE_ENTRY(Name) \
+		if (Lib.Name == nullptr) \
+		{ \
+			OutMissing = TEXT(#Name); \
+			return false; \
+		}
+
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_initialize)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_destroy)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_is_supported_CPU)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_find_destroy)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_find_get_sources)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_recv_destroy)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_recv_free_metadata)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_recv_get_performance)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_recv_get_queue)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_recv_add_connection_metadata)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_recv_clear_connection_metadata)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_send_create)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_send_destroy)
+
+	// all frames are received and sent in the v2 layout
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_recv_capture_v2)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_recv_free_audio_v2)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_recv_free_video_v2)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_send_send_audio_v2)
+	NDIMEDIA_REQUIRE_ENTRY(NDIlib_send_send_video_v2)
+
+	#undef NDIMEDIA_REQUIRE_ENTRY
+
+	if ((Lib.NDIlib_find_create_v2 == nullptr) && (Lib.NDIlib_find_create == nullptr))
+	{
+		OutMissing = TEXT("NDIlib_find_create_v2");
+		return false;
+	}
+
+	if ((Lib.NDIlib_recv_create_v2 == nullptr) && (Lib.NDIlib_recv_create == nullptr))
+	{
+		OutMissing = TEXT("NDIlib_recv_create_v2");
+		return false;
+	}
+
+	return true;
+}
+
+
+/* INdiMediaBackend interface
+ *****************************************************************************/
+
+FName FNdiMediaSdkBackend::GetName() const
+{
+	static FName SdkName(TEXT("Sdk"));
+	return SdkName;
+}
+
+
+NDIlib_find_instance_t FNdiMediaSdkBackend::FindCreate(const NDIlib_find_create_t& Settings)
+{
+	if (Lib->NDIlib_find_create_v2 != nullptr)
+	{
+		return Lib->NDIlib_find_create_v2(&Settings);
+	}
+
+	return Lib->NDIlib_find_create(&Settings);
+}
+
+
+void FNdiMediaSdkBackend::FindDestroy(NDIlib_find_instance_t Instance)
+{
+	Lib->NDIlib_find_destroy(Instance);
+}
+
+
+const NDIlib_source_t* FNdiMediaSdkBackend::FindGetCurrentSources(NDIlib_find_instance_t Instance, uint32& OutNumSources)
+{
+	uint32_t NumSources = 0;
+
+	// older runtimes return the current sources when called without timeout
+	const NDIlib_source_t* Sources = (Lib->NDIlib_find_get_current_sources != nullptr)
+		? Lib->NDIlib_find_get_current_sources(Instance, &NumSources)
+		: Lib->NDIlib_find_get_sources(Instance, &NumSources, 0);
+
+	OutNumSources = NumSources;
+
+	return Sources;
+}
+
+
+void FNdiMediaSdkBackend::RecvAddConnectionMetadata(NDIlib_recv_instance_t Instance, const NDIlib_metadata_frame_t& Metadata)
+{
+	Lib->NDIlib_recv_add_connection_metadata(Instance, &Metadata);
+}
+
+
+NDIlib_frame_type_e FNdiMediaSdkBackend::RecvCapture(NDIlib_recv_instance_t Instance, NDIlib_video_frame_v2_t* OutVideo, NDIlib_audio_frame_v2_t* OutAudio, NDIlib_metadata_frame_t* OutMetadata, uint32 Timeout)
+{
+	return Lib->NDIlib_recv_capture_v2(Instance, OutVideo, OutAudio, OutMetadata, Timeout);
+}
+
+
+void FNdiMediaSdkBackend::RecvClearConnectionMetadata(NDIlib_recv_instance_t Instance)
+{
+	Lib->NDIlib_recv_clear_connection_metadata(Instance);
+}
+
+
+NDIlib_recv_instance_t FNdiMediaSdkBackend::RecvCreate(const NDIlib_recv_create_t& Settings)
+{
+	if (Lib->NDIlib_recv_create_v2 != nullptr)
+	{
+		return Lib->NDIlib_recv_create_v2(&Settings);
+	}
+
+	return Lib->NDIlib_recv_create(&Settings);
+}
+
+
+void FNdiMediaSdkBackend::RecvDestroy(NDIlib_recv_instance_t Instance)
+{
+	Lib->NDIlib_recv_destroy(Instance);
+}
+
+
+void FNdiMediaSdkBackend::RecvFreeAudio(NDIlib_recv_instance_t Instance, const NDIlib_audio_frame_v2_t& Audio)
+{
+	Lib->NDIlib_recv_free_audio_v2(Instance, &Audio);
+}
+
+
+void FNdiMediaSdkBackend::RecvFreeMetadata(NDIlib_recv_instance_t Instance, const NDIlib_metadata_frame_t& Metadata)
+{
+	Lib->NDIlib_recv_free_metadata(Instance, &Metadata);
+}
+
+
+void FNdiMediaSdkBackend::RecvFreeVideo(NDIlib_recv_instance_t Instance, const NDIlib_video_frame_v2_t& Video)
+{
+	Lib->NDIlib_recv_free_video_v2(Instance, &Video);
+}
+
+
+int32 FNdiMediaSdkBackend::RecvGetNumConnections(NDIlib_recv_instance_t Instance)
+{
+	// without connection state, receivers are assumed to be connected
+	if (Lib->NDIlib_recv_get_no_connections == nullptr)
+	{
+		return 1;
+	}
+
+	return Lib->NDIlib_recv_get_no_connections(Instance);
+}
+
+
+void FNdiMediaSdkBackend::RecvGetPerformance(NDIlib_recv_instance_t Instance, NDIlib_recv_performance_t& OutTotal, NDIlib_recv_performance_t& OutDropped)
+{
+	Lib->NDIlib_recv_get_performance(Instance, &OutTotal, &OutDropped);
+}
+
+
+void FNdiMediaSdkBackend::RecvGetQueue(NDIlib_recv_instance_t Instance, NDIlib_recv_queue_t& OutQueue)
+{
+	Lib->NDIlib_recv_get_queue(Instance, &OutQueue);
+}
+
+
+bool FNdiMediaSdkBackend::RecvSendMetadata(NDIlib_recv_instance_t Instance, const NDIlib_metadata_frame_t& Metadata)
+{
+	if (Lib->NDIlib_recv_send_metadata == nullptr)
+	{
+		return false;
+	}
+
+	return Lib->NDIlib_recv_send_metadata(Instance, &Metadata);
+}
+
+
+bool FNdiMediaSdkBackend::RecvSetTally(NDIlib_recv_instance_t Instance, const NDIlib_tally_t& Tally)
+{
+	if (Lib->NDIlib_recv_set_tally == nullptr)
+	{
+		return false;
+	}
+
+	return Lib->NDIlib_recv_set_tally(Instance, &Tally);
+}
+
+
+bool FNdiMediaSdkBackend::RecvSupportsColorFormat(int64 ColorFormat) const
+{
+	if (ColorFormat == NdiMedia::RecvColorFormatFastest)
+	{
+		// older runtimes may accept the format, but what they deliver is undefined
+		return (MajorVersion != INDEX_NONE) && (MajorVersion >= NdiMedia::RecvColorFormatFastestMajorVersion);
+	}
+
+	return (ColorFormat >= NDIlib_recv_color_format_e_BGRX_BGRA) && (ColorFormat <= NDIlib_recv_color_format_e_UYVY_RGBA);
+}
+
+
+void FNdiMediaSdkBackend::SendAddConnectionMetadata(NDIlib_send_instance_t Instance, const NDIlib_metadata_frame_t& Metadata)
+{
+	if (Lib->NDIlib_send_add_connection_metadata != nullptr)
+	{
+		Lib->NDIlib_send_add_connection_metadata(Instance, &Metadata);
+	}
+}
+
+
+void FNdiMediaSdkBackend::SendAudio(NDIlib_send_instance_t Instance, const NDIlib_audio_frame_v2_t& Audio)
+{
+	Lib->NDIlib_send_send_audio_v2(Instance, &Audio);
+}
+
+
+NDIlib_frame_type_e FNdiMediaSdkBackend::SendCapture(NDIlib_send_instance_t Instance, NDIlib_metadata_frame_t& OutMetadata, uint32 Timeout)
+{
+	if (Lib->NDIlib_send_capture == nullptr)
+	{
+		return NDIlib_frame_type_none;
+	}
+
+	return Lib->NDIlib_send_capture(Instance, &OutMetadata, Timeout);
+}
+
+
+void FNdiMediaSdkBackend::SendClearConnectionMetadata(NDIlib_send_instance_t Instance)
+{
+	if (Lib->NDIlib_send_clear_connection_metadata != nullptr)
+	{
+		Lib->NDIlib_send_clear_connection_metadata(Instance);
+	}
+}
+
+
+NDIlib_send_instance_t FNdiMediaSdkBackend::SendCreate(const NDIlib_send_create_t& Settings)
+{
+	return Lib->NDIlib_send_create(&Settings);
+}
+
+
+void FNdiMediaSdkBackend::SendDestroy(NDIlib_send_instance_t Instance)
+{
+	Lib->NDIlib_send_destroy(Instance);
+}
+
+
+void FNdiMediaSdkBackend::SendFreeMetadata(NDIlib_send_instance_t Instance, const NDIlib_metadata_frame_t& Metadata)
+{
+	if (Lib->NDIlib_send_free_metadata != nullptr)
+	{
+		Lib->NDIlib_send_free_metadata(Instance, &Metadata);
+	}
+}
+
+
+int32 FNdiMediaSdkBackend::SendGetNumConnections(NDIlib_send_instance_t Instance, uint32 Timeout)
+{
+	if (Lib->NDIlib_send_get_no_connections == nullptr)
+	{
+		return 0;
+	}
+
+	return Lib->NDIlib_send_get_no_connections(Instance, Timeout);
+}
+
+
+bool FNdiMediaSdkBackend::SendGetTally(NDIlib_send_instance_t Instance, NDIlib_tally_t& OutTally, uint32 Timeout)
+{
+	if (Lib->NDIlib_send_get_tally == nullptr)
+	{
+		return false;
+	}
+
+	return Lib->NDIlib_send_get_tally(Instance, &OutTally, Timeout);
+}
+
+
+void FNdiMediaSdkBackend::SendMetadata(NDIlib_send_instance_t Instance, const NDIlib_metadata_frame_t& Metadata)
+{
+	if (Lib->NDIlib_send_send_metadata != nullptr)
+	{
+		Lib->NDIlib_send_send_metadata(Instance, &Metadata);
+	}
+}
+
+
+void FNdiMediaSdkBackend::SendVideo(NDIlib_send_instance_t Instance, const NDIlib_video_frame_v2_t& Video)
+{
+	Lib->NDIlib_send_send_video_v2(Instance, &Video);
+}
+
+
+void FNdiMediaSdkBackend::AudioToInterleaved16s(const NDIlib_audio_frame_v2_t& Source, NDIlib_audio_frame_interleaved_16s_t& Dest)
+{
+	if (Lib->NDIlib_util_audio_to_interleaved_16s_v2 != nullptr)
+	{
+		Lib->NDIlib_util_audio_to_interleaved_16s_v2(&Source, &Dest);
+	}
+	else
+	{
+		NdiMediaAudio::ConvertToInterleaved16s(Source, Dest);
+	}
+}
@@ -0,0 +1,113 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "INdiMediaBackend.h"
+
+
+struct NDIlib_v2;
+
+
+/**
+ * Implements an NDI backend that forwards all calls to the NDI runtime.
+ *
+ * Calls are made through the function table of the loaded runtime. Entry points
+ * that older runtimes don't export are detected when the backend is created;
+ * calls to them fall back to older entry points or portable implementations.
+ *
+ * The NDI runtime must have been loaded and initialized before this backend is
+ * created. The backend owns the initialized runtime and its library, which are
+ * destroyed and unloaded when the last reference to the backend is released, so
+ * that players, finders and background threads never call into an unloaded runtime.
+ *
+ * @see FNdi::Initialize
+ */
+class FNdiMediaSdkBackend
+	: public INdiMediaBackend
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InLib The function table of the initialized NDI runtime.
+	 * @param InLibHandle Handle to the runtime library, which is freed by the backend (nullptr if statically linked).
+	 * @param InMajorVersion The major version of the runtime (INDEX_NONE = unknown).
+	 */
+	FNdiMediaSdkBackend(const NDIlib_v2& InLib, void* InLibHandle, int32 InMajorVersion);
+
+	/** Virtual destructor. */
+	virtual ~FNdiMediaSdkBackend();
+
+	/**
+	 * Whether a runtime's function table has all entry points that the backend requires.
+	 *
+	 * @param Lib The function table to check.
+	 * @param OutMissing Will contain the name of the first missing entry point.
+	 * @return true if supported, false otherwise.
+	 */
+	static bool IsSupported(const NDIlib_v2& Lib, FString& OutMissing);
+
+public:
+
+	/**
+	 * Get the major version of the NDI runtime.
+	 *
+	 * @return Major version, or INDEX_NONE if unknown.
+	 */
+	int32 GetMajorVersion() const
+	{
+		return MajorVersion;
+	}
+
+public:
+
+	//~ INdiMediaBackend interface
+
+	virtual FName GetName() const override;
+
+	virtual NDIlib_find_instance_t FindCreate(const NDIlib_find_create_t& Settings) override;
+	virtual void FindDestroy(NDIlib_find_instance_t Instance) override;
+	virtual const NDIlib_source_t* FindGetCurrentSources(NDIlib_find_instance_t Instance, uint32& OutNumSources) override;
+
+	virtual void RecvAddConnectionMetadata(NDIlib_recv_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) override;
+	virtual NDIlib_frame_type_e RecvCapture(NDIlib_recv_instance_t Instance, NDIlib_video_frame_v2_t* OutVideo, NDIlib_audio_frame_v2_t* OutAudio, NDIlib_metadata_frame_t* OutMetadata, uint32 Timeout) override;
+	virtual void RecvClearConnectionMetadata(NDIlib_recv_instance_t Instance) override;
+	virtual NDIlib_recv_instance_t RecvCreate(const NDIlib_recv_create_t& Settings) override;
+	virtual void RecvDestroy(NDIlib_recv_instance_t Instance) override;
+	virtual void RecvFreeAudio(NDIlib_recv_instance_t Instance, const NDIlib_audio_frame_v2_t& Audio) override;
+	virtual void RecvFreeMetadata(NDIlib_recv_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) override;
+	virtual void RecvFreeVideo(NDIlib_recv_instance_t Instance, const NDIlib_video_frame_v2_t& Video) override;
+	virtual int32 RecvGetNumConnections(NDIlib_recv_instance_t Instance) override;
+	virtual void RecvGetPerformance(NDIlib_recv_instance_t Instance, NDIlib_recv_performance_t& OutTotal, NDIlib_recv_performance_t& OutDropped) override;
+	virtual void RecvGetQueue(NDIlib_recv_instance_t Instance, NDIlib_recv_queue_t& OutQueue) override;
+	virtual bool RecvSendMetadata(NDIlib_recv_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) override;
+	virtual bool RecvSetTally(NDIlib_recv_instance_t Instance, const NDIlib_tally_t& Tally) override;
+	virtual bool RecvSupportsColorFormat(int64 ColorFormat) const override;
+
+	virtual void SendAddConnectionMetadata(NDIlib_send_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) override;
+	virtual void SendAudio(NDIlib_send_instance_t Instance, const NDIlib_audio_frame_v2_t& Audio) override;
+	virtual NDIlib_frame_type_e SendCapture(NDIlib_send_instance_t Instance, NDIlib_metadata_frame_t& OutMetadata, uint32 Timeout) override;
+	virtual void SendClearConnectionMetadata(NDIlib_send_instance_t Instance) override;
+	virtual NDIlib_send_instance_t SendCreate(const NDIlib_send_create_t& Settings) override;
+	virtual void SendDestroy(NDIlib_send_instance_t Instance) override;
+	virtual void SendFreeMetadata(NDIlib_send_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) override;
+	virtual int32 SendGetNumConnections(NDIlib_send_instance_t Instance, uint32 Timeout) override;
+	virtual bool SendGetTally(NDIlib_send_instance_t Instance, NDIlib_tally_t& OutTally, uint32 Timeout) override;
+	virtual void SendMetadata(NDIlib_send_instance_t Instance, const NDIlib_metadata_frame_t& Metadata) override;
+	virtual void SendVideo(NDIlib_send_instance_t Instance, const NDIlib_video_frame_v2_t& Video) override;
+
+	virtual void AudioToInterleaved16s(const NDIlib_audio_frame_v2_t& Source, NDIlib_audio_frame_interleaved_16s_t& Dest) override;
+
+private:
+
+	/** The function table of the NDI runtime. */
+	const NDIlib_v2* Lib;
+
+	/** Handle to the NDI runtime library (nullptr if statically linked). */
+	void* LibHandle;
+
+	/** The major version of the NDI runtime (INDEX_NONE = unknown). */
+	int32 MajorVersion;
+};
@@ -5,8 +5,8 @@
 
 #include "ModuleManager.h"
 #include "Ndi.h"
-#include "NdiMediaFinder.h"
 #include "NdiMediaPlayer.h"
+#include "NdiMediaThumbnailService.h"
 
 
 DEFINE_LOG_CATEGORY(LogNdiMedia);
@@ -25,6 +25,7 @@ public:
 	/** Default constructor. */
 	FNdiMediaModule()
 		: Initialized(false)
+		, ThumbnailService(nullptr)
 	{ }
 
 public:
@@ -33,7 +34,8 @@ public:
 
 	virtual TSharedPtr<IMediaPlayer, ESPMode::ThreadSafe> CreatePlayer() override
 	{
-		if (!Initialized)
+		// the runtime is initialized on the connection monitor's thread when the player opens
+		if (!FNdi::IsAvailable())
 		{
 			return nullptr;
 		}
@@ -41,20 +43,24 @@ public:
 		return MakeShareable(new FNdiMediaPlayer());
 	}
 
+	virtual TSharedPtr<FNdiMediaThumbnail, ESPMode::ThreadSafe> GetThumbnail(const FString& Source) override
+	{
+		if (ThumbnailService == nullptr)
+		{
+			return nullptr;
+		}
+
+		return ThumbnailService->GetThumbnail(Source);
+	}
+
 public:
 
 	//~ IModuleInterface interface
 
 	virtual void StartupModule() override
 	{
-		if (!FNdi::Initialize())
-		{
-			UE_LOG(LogNdiMedia, Error, TEXT("Failed to initialize NDI"));
-			return;
-		}
-
-		GetMutableDefault<UNdiMediaFinder>()->Initialize();
-
+		// the NDI runtime and source discovery are initialized on first use
+		ThumbnailService = new FNdiMediaThumbnailService;
 		Initialized = true;
 	}
 
@@ -67,6 +73,10 @@ public:
 
 		Initialized = false;
 
+		// stop probing before NDI goes away
+		delete ThumbnailService;
+		ThumbnailService = nullptr;
+
 		// shut down NDI
 		FNdi::Shutdown();
 	}
@@ -75,6 +85,9 @@ private:
 
 	/** Whether the module has been initialized. */
 	bool Initialized;
+
+	/** Captures preview images of NDI sources. */
+	FNdiMediaThumbnailService* ThumbnailService;
 };
 
 
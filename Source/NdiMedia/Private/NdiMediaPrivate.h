@@ -10,12 +10,15 @@
 #include "NdiMediaHidePlatformTypes.h"
 
 #include "Runtime/Core/Public/CoreMinimal.h"
+#include "Runtime/Core/Public/Stats/Stats.h"
 
 #include "../../NdiMediaFactory/Public/NdiMediaSettings.h"
 
 
 DECLARE_LOG_CATEGORY_EXTERN(LogNdiMedia, Log, All);
 
+DECLARE_STATS_GROUP(TEXT("NdiMedia"), STATGROUP_NdiMedia, STATCAT_Advanced);
+
 
 namespace NdiMedia
 {
@@ -25,24 +28,81 @@ namespace NdiMedia
 	/** Name of the AudioSampleRate media option. */
 	static const FName AudioSampleRateOption("AudioSampleRate");
 
+	/** Name of the BackupSources media option. */
+	static const FName BackupSourcesOption("BackupSources");
+
 	/** Name of the Bandwidth media option. */
 	static const FName BandwidthOption("Bandwidth");
 
 	/** Name of the ColorFormat media option. */
 	static const FName ColorFormatOption("ColorFormat");
 
+	/** Name of the ConformVideoSize media option. */
+	static const FName ConformVideoSizeOption("ConformVideoSize");
+
+	/** Name of the DeinterlaceMode media option. */
+	static const FName DeinterlaceModeOption("DeinterlaceMode");
+
 	/** Name of the FrameRateDenominator media option. */
 	static const FName FrameRateDOption("FrameRateD");
 
 	/** Name of the FrameRateNumerator media option. */
 	static const FName FrameRateNOption("FrameRateN");
 
+	/** Name of the MultiviewColumns media option. */
+	static const FName MultiviewColumnsOption("MultiviewColumns");
+
+	/** Name of the MultiviewHeight media option. */
+	static const FName MultiviewHeightOption("MultiviewHeight");
+
+	/** Name of the MultiviewWidth media option. */
+	static const FName MultiviewWidthOption("MultiviewWidth");
+
 	/** Name of the Progressive media option. */
 	static const FName ProgressiveOption("Progressive");
 
+	/** Name of the RecordingDirectory media option. */
+	static const FName RecordingDirectoryOption("RecordingDirectory");
+
+	/** Name of the SyncGroup media option. */
+	static const FName SyncGroupOption("SyncGroup");
+
+	/** Name of the TallyMode media option. */
+	static const FName TallyModeOption("TallyMode");
+
+	/** Name of the TimeShiftDuration media option. */
+	static const FName TimeShiftDurationOption("TimeShiftDuration");
+
+	/** Name of the TimeShiftMemoryBudget media option. */
+	static const FName TimeShiftMemoryBudgetOption("TimeShiftMemoryBudget");
+
+	/** Name of the TimeShiftSpillDirectory media option. */
+	static const FName TimeShiftSpillDirectoryOption("TimeShiftSpillDirectory");
+
 	/** Name of the VideoHeight media option. */
 	static const FName VideoHeightOption("VideoHeight");
 
 	/** Name of the VideoWidth media option. */
 	static const FName VideoWidthOption("VideoWidth");
+
+	/** Name of the YuvConversion media option. */
+	static const FName YuvConversionOption("YuvConversion");
+
+	/** Name of the YuvRange media option. */
+	static const FName YuvRangeOption("YuvRange");
+
+	/**
+	 * Receiver color format that delivers UYVY, or UYVA for sources with alpha.
+	 *
+	 * This value is not declared in the bundled SDK headers; it is understood by
+	 * NDI runtime 3.0 and newer. Older runtimes don't necessarily reject it, so it
+	 * is only used if the backend reports support for it, and receivers fall back
+	 * to NDIlib_recv_color_format_e_UYVY_BGRA otherwise.
+	 *
+	 * @see RecvColorFormatFastestMajorVersion
+	 */
+	static const int64 RecvColorFormatFastest = 100;
+
+	/** Oldest major version of the NDI runtime that supports RecvColorFormatFastest. */
+	static const int32 RecvColorFormatFastestMajorVersion = 3;
 }
\ No newline at end of file
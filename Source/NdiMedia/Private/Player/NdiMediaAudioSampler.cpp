@@ -3,7 +3,9 @@
 #include "NdiMediaAudioSampler.h"
 #include "NdiMediaPrivate.h"
 
+#include "HAL/PlatformProcess.h"
 #include "HAL/RunnableThread.h"
+#include "INdiMediaBackend.h"
 #include "Misc/ScopeLock.h"
 
 
@@ -13,26 +15,36 @@
 FNdiMediaAudioSampler::FNdiMediaAudioSampler()
 	: ReceiverInstance(nullptr)
 	, Stopping(false)
-{
-	Thread = FRunnableThread::Create(this, TEXT("FNdiMediaAudioSampler"));
-}
+	, Thread(nullptr)
+{ }
 
 
 FNdiMediaAudioSampler::~FNdiMediaAudioSampler()
 {
-	Thread->Kill(true);
-	delete Thread;
-	Thread = nullptr;
+	if (Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
 }
 
 
 /* FNdiMediaAudioSampler interface
  *****************************************************************************/
 
-void FNdiMediaAudioSampler::SetReceiverInstance(void* InReceiverInstance)
+void FNdiMediaAudioSampler::SetReceiverInstance(const TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe>& InBackend, void* InReceiverInstance)
 {
-	FScopeLock Lock(&CriticalSection);
-	ReceiverInstance = InReceiverInstance;
+	{
+		FScopeLock Lock(&CriticalSection);
+		Backend = (InReceiverInstance != nullptr) ? InBackend : nullptr;
+		ReceiverInstance = InReceiverInstance;
+	}
+
+	if ((InReceiverInstance != nullptr) && (Thread == nullptr))
+	{
+		Thread = FRunnableThread::Create(this, TEXT("FNdiMediaAudioSampler"));
+	}
 }
 
 
@@ -49,7 +61,10 @@ uint32 FNdiMediaAudioSampler::Run()
 {
 	while (!Stopping)
 	{
-		SampleAudio(5);
+		if (!SampleAudio(5))
+		{
+			FPlatformProcess::Sleep(0.005f);
+		}
 	}
 	
 	return 0;
@@ -65,38 +80,37 @@ void FNdiMediaAudioSampler::Stop()
 /* FNdiMediaAudioSampler implementation
  *****************************************************************************/
 
-void FNdiMediaAudioSampler::SampleAudio(uint32 Timeout)
+bool FNdiMediaAudioSampler::SampleAudio(uint32 Timeout)
 {
-	void* CurrentReceiverInstance = ReceiverInstance;
+	// the lock is held while capturing, so that the receiver
+	// cannot be destroyed while the capture call is blocking
+	FScopeLock Lock(&CriticalSection);
 
-	if (CurrentReceiverInstance == nullptr)
+	if (ReceiverInstance == nullptr)
 	{
-		return;
+		return false;
 	}
 
 	// fetch audio frame
 	NDIlib_audio_frame_v2_t AudioFrame;
 	{
-		NDIlib_frame_type_e FrameType = NDIlib_recv_capture_v2(ReceiverInstance, nullptr, &AudioFrame, nullptr, Timeout);
+		NDIlib_frame_type_e FrameType = Backend->RecvCapture(ReceiverInstance, nullptr, &AudioFrame, nullptr, Timeout);
 
 		if (FrameType == NDIlib_frame_type_error)
 		{
 			UE_LOG(LogNdiMedia, Verbose, TEXT("Failed to receive audio frame"));
-			return;
+			return true;
 		}
 
 		if (FrameType != NDIlib_frame_type_audio)
 		{
-			return;
+			return true;
 		}
 	}
 
 	// forward frame to listener
-	FScopeLock Lock(&CriticalSection);
+	SamplesDelegate.ExecuteIfBound(AudioFrame);
+	Backend->RecvFreeAudio(ReceiverInstance, AudioFrame);
 
-	if (CurrentReceiverInstance == ReceiverInstance)
-	{
-		SamplesDelegate.ExecuteIfBound(AudioFrame);
-		NDIlib_recv_free_audio_v2(ReceiverInstance, &AudioFrame);
-	}
+	return true;
 }
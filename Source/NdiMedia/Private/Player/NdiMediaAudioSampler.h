@@ -6,6 +6,8 @@
 #include "HAL/Runnable.h"
 
 
+class INdiMediaBackend;
+
 struct NDIlib_audio_frame_v2_t;
 
 
@@ -39,9 +41,12 @@ public:
 	/**
 	 * Set the receiver instance.
 	 *
+	 * The sampler thread is created the first time a receiver is set.
+	 *
+	 * @param InBackend The backend that the receiver was created on.
 	 * @param InReceiverInstance The receiver instance to sample, or nullptr to suspend sampling.
 	 */
-	void SetReceiverInstance(void* InReceiverInstance);
+	void SetReceiverInstance(const TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe>& InBackend, void* InReceiverInstance);
 
 public:
 
@@ -58,11 +63,15 @@ protected:
 	 * Sample the current audio frame.
 	 *
 	 * @param Timeout How long to wait for samples (in milliseconds).
+	 * @return true if a receiver was available, false otherwise.
 	 */
-	void SampleAudio(uint32 Timeout);
+	bool SampleAudio(uint32 Timeout);
 
 private:
 
+	/** The backend that the current receiver was created on. */
+	TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> Backend;
+
 	/** Critical section for synchronizing access to receiver. */
 	FCriticalSection CriticalSection;
 
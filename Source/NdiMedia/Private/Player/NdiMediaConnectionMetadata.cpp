@@ -0,0 +1,222 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaConnectionMetadata.h"
+#include "NdiMediaPrivate.h"
+
+#include "IMediaOptions.h"
+#include "INdiMediaBackend.h"
+#include "NdiMediaSettings.h"
+#include "UObject/UObjectGlobals.h"
+
+
+namespace NdiMediaConnectionMetadata
+{
+	/** The format options that connection metadata is cached for. */
+	struct FFormat
+	{
+		/** Preferred number of audio channels (0 = any). */
+		int32 AudioChannels;
+
+		/** Preferred audio sample rate (0 = any). */
+		int32 AudioSampleRate;
+
+		/** Preferred frame rate denominator (0 = any). */
+		int32 FrameRateD;
+
+		/** Preferred frame rate numerator (0 = any). */
+		int32 FrameRateN;
+
+		/** Whether progressive video is preferred (empty = any). */
+		FString Progressive;
+
+		/** Preferred video height (0 = any). */
+		int32 VideoHeight;
+
+		/** Preferred video width (0 = any). */
+		int32 VideoWidth;
+
+	public:
+
+		/** Compare two formats for equality. */
+		bool operator==(const FFormat& Other) const
+		{
+			return (AudioChannels == Other.AudioChannels) &&
+				(AudioSampleRate == Other.AudioSampleRate) &&
+				(FrameRateD == Other.FrameRateD) &&
+				(FrameRateN == Other.FrameRateN) &&
+				(Progressive == Other.Progressive) &&
+				(VideoHeight == Other.VideoHeight) &&
+				(VideoWidth == Other.VideoWidth);
+		}
+
+		/** Get the hash code for a format. */
+		friend uint32 GetTypeHash(const FFormat& Format)
+		{
+			uint32 Hash = GetTypeHash(Format.AudioChannels);
+			Hash = HashCombine(Hash, GetTypeHash(Format.AudioSampleRate));
+			Hash = HashCombine(Hash, GetTypeHash(Format.FrameRateD));
+			Hash = HashCombine(Hash, GetTypeHash(Format.FrameRateN));
+			Hash = HashCombine(Hash, GetTypeHash(Format.Progressive));
+			Hash = HashCombine(Hash, GetTypeHash(Format.VideoHeight));
+
+			return HashCombine(Hash, GetTypeHash(Format.VideoWidth));
+		}
+	};
+
+	/** The encoded connection metadata, keyed by format options. */
+	static TMap<FFormat, TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe>> Cache;
+
+	/** Revision of the settings that the cached metadata was built from. */
+	static uint32 SettingsRevision = 0;
+}
+
+
+/* FNdiMediaConnectionMetadata structors
+ *****************************************************************************/
+
+FNdiMediaConnectionMetadata::FNdiMediaConnectionMetadata(const TArray<FString>& Metadata)
+{
+	for (const FString& Entry : Metadata)
+	{
+		FTCHARToUTF8 EntryUtf8(*Entry);
+
+		TArray<ANSICHAR>& Blob = Blobs[Blobs.AddDefaulted()];
+		Blob.Reserve(EntryUtf8.Length() + 1);
+		Blob.Append(EntryUtf8.Get(), EntryUtf8.Length());
+		Blob.Add('\0');
+	}
+}
+
+
+/* FNdiMediaConnectionMetadata static functions
+ *****************************************************************************/
+
+TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe> FNdiMediaConnectionMetadata::Get(const IMediaOptions& Options)
+{
+	using namespace NdiMediaConnectionMetadata;
+
+	check(IsInGameThread());
+
+	auto Settings = GetDefault<UNdiMediaSettings>();
+
+	if (Settings->GetRevision() != SettingsRevision)
+	{
+		Cache.Empty();
+		SettingsRevision = Settings->GetRevision();
+	}
+
+	FFormat Format;
+	{
+		Format.AudioChannels = (int32)Options.GetMediaOption(NdiMedia::AudioChannelsOption, (int64)0);
+		Format.AudioSampleRate = (int32)Options.GetMediaOption(NdiMedia::AudioSampleRateOption, (int64)0);
+		Format.FrameRateD = (int32)Options.GetMediaOption(NdiMedia::FrameRateDOption, (int64)0);
+		Format.FrameRateN = (int32)Options.GetMediaOption(NdiMedia::FrameRateNOption, (int64)0);
+		Format.Progressive = Options.GetMediaOption(NdiMedia::ProgressiveOption, FString());
+		Format.VideoHeight = (int32)Options.GetMediaOption(NdiMedia::VideoHeightOption, (int64)0);
+		Format.VideoWidth = (int32)Options.GetMediaOption(NdiMedia::VideoWidthOption, (int64)0);
+	}
+
+	const TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe>* CachedMetadata = Cache.Find(Format);
+
+	if (CachedMetadata != nullptr)
+	{
+		return *CachedMetadata;
+	}
+
+	// product metadata
+	TArray<FString> Metadata;
+
+	Metadata.Add(
+		FString::Printf(TEXT("<ndi_product short_name=\"%s\" long_name=\"%s\" manufacturer=\"%s\" version=\"%s\" serial_number=\"%s\" session_name=\"%s\" />"),
+			*Settings->ProductName,
+			*Settings->ProductDescription,
+			*Settings->Manufacturer,
+			*Settings->GetVersionName(),
+			*Settings->SerialNumber,
+			*Settings->SessionName
+	));
+
+	// format metadata
+	FString AudioFormatString;
+	FString VideoFormatString;
+
+	if (Format.AudioChannels > 0)
+	{
+		AudioFormatString += FString::Printf(TEXT(" no_channels=\"%i\""), Format.AudioChannels);
+	}
+
+	if (Format.AudioSampleRate > 0)
+	{
+		AudioFormatString += FString::Printf(TEXT(" sample_rate=\"%i\""), Format.AudioSampleRate);
+	}
+
+	if (Format.FrameRateD > 0)
+	{
+		VideoFormatString += FString::Printf(TEXT(" frame_rate_d=\"%i\""), Format.FrameRateD);
+	}
+
+	if (Format.FrameRateN > 0)
+	{
+		VideoFormatString += FString::Printf(TEXT(" frame_rate_n=\"%i\""), Format.FrameRateN);
+	}
+
+	if (!Format.Progressive.IsEmpty())
+	{
+		VideoFormatString += FString::Printf(TEXT(" progressive=\"%s\""), *Format.Progressive);
+	}
+
+	if (Format.VideoHeight > 0)
+	{
+		VideoFormatString += FString::Printf(TEXT(" yres=\"%i\""), Format.VideoHeight);
+	}
+
+	if (Format.VideoWidth > 0)
+	{
+		VideoFormatString += FString::Printf(TEXT(" xres=\"%i\""), Format.VideoWidth);
+	}
+
+	if (!AudioFormatString.IsEmpty() || !VideoFormatString.IsEmpty())
+	{
+		Metadata.Add(
+			FString::Printf(TEXT("<ndi_format><audio_format %s /><video_format %s /></ndi_format>"),
+				*AudioFormatString,
+				*VideoFormatString
+		));
+	}
+
+	// custom metadata
+	FString CustomMetadata = Settings->CustomMetaData;
+	{
+		CustomMetadata.Trim();
+		CustomMetadata.TrimTrailing();
+	}
+
+	if (!CustomMetadata.IsEmpty())
+	{
+		Metadata.Add(CustomMetadata);
+	}
+
+	TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe> ConnectionMetadata = MakeShareable(new FNdiMediaConnectionMetadata(Metadata));
+	Cache.Add(Format, ConnectionMetadata);
+
+	return ConnectionMetadata;
+}
+
+
+/* FNdiMediaConnectionMetadata interface
+ *****************************************************************************/
+
+void FNdiMediaConnectionMetadata::Send(INdiMediaBackend& Backend, void* ReceiverInstance) const
+{
+	for (const TArray<ANSICHAR>& Blob : Blobs)
+	{
+		NDIlib_metadata_frame_t MetadataFrame;
+		{
+			MetadataFrame.length = Blob.Num();
+			MetadataFrame.timecode = 0;
+			MetadataFrame.p_data = (char*)Blob.GetData();
+		}
+
+		Backend.RecvAddConnectionMetadata(ReceiverInstance, MetadataFrame);
+	}
+}
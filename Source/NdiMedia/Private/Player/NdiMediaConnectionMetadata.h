@@ -0,0 +1,59 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+class IMediaOptions;
+class INdiMediaBackend;
+
+
+/**
+ * UTF-8 encoded metadata that receivers send to their sources when they connect.
+ *
+ * The metadata consists of the product description and custom metadata from the
+ * plug-in settings, and of the preferred audio and video format from the media
+ * options. It is encoded once and shared by all receivers that are opened with
+ * the same format options. Cached metadata is discarded when the settings change.
+ *
+ * Instances are immutable, so that receivers can be created with them on any thread.
+ */
+class FNdiMediaConnectionMetadata
+{
+public:
+
+	/**
+	 * Get the connection metadata for the given media options.
+	 *
+	 * Must be called on the game thread.
+	 *
+	 * @param Options The media options.
+	 * @return The connection metadata.
+	 */
+	static TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe> Get(const IMediaOptions& Options);
+
+public:
+
+	/**
+	 * Send the metadata to a receiver's source.
+	 *
+	 * @param Backend The backend that the receiver was created on.
+	 * @param ReceiverInstance The receiver instance.
+	 */
+	void Send(INdiMediaBackend& Backend, void* ReceiverInstance) const;
+
+private:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param Metadata The XML metadata to encode.
+	 */
+	explicit FNdiMediaConnectionMetadata(const TArray<FString>& Metadata);
+
+private:
+
+	/** The null-terminated UTF-8 metadata strings. */
+	TArray<TArray<ANSICHAR>> Blobs;
+};
@@ -0,0 +1,475 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaConnectionMonitor.h"
+#include "NdiMediaPrivate.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "INdiMediaBackend.h"
+#include "Ndi.h"
+#include "NdiMediaConnectionMetadata.h"
+#include "Misc/ScopeLock.h"
+#include "NdiMediaSettings.h"
+#include "UObject/UObjectGlobals.h"
+
+
+namespace NdiMediaConnectionMonitor
+{
+	/** How long a receiver may stay disconnected before it is recreated the first time (in seconds). */
+	static const double InitialBackoff = 4.0;
+
+	/** Longest time between attempts to recreate a receiver (in seconds). */
+	static const double MaxBackoff = 64.0;
+
+	/** Maximum number of health samples that wait to be dequeued per probe. */
+	static const int32 MaxPendingSamples = 4;
+
+	/** Shortest time between polls (in seconds). */
+	static const float MinPollInterval = 0.01f;
+}
+
+
+/* FNdiMediaConnectionMonitor structors
+ *****************************************************************************/
+
+FNdiMediaConnectionMonitor::FNdiMediaConnectionMonitor(float InPollInterval)
+	: PollInterval(FMath::Max(InPollInterval, NdiMediaConnectionMonitor::MinPollInterval))
+	, Stopping(false)
+	, Thread(nullptr)
+	, WakeEvent(FPlatformProcess::GetSynchEventFromPool(false))
+{
+	Thread = FRunnableThread::Create(this, TEXT("FNdiMediaConnectionMonitor"), 0, TPri_BelowNormal);
+}
+
+
+FNdiMediaConnectionMonitor::~FNdiMediaConnectionMonitor()
+{
+	if (Thread != nullptr)
+	{
+		Stop();
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	// receivers should have been removed by their owners
+	check(HealthProbes.Num() == 0);
+	check(Watches.Num() == 0);
+
+	DestroyRetiredReceivers();
+
+	// requests should have been cancelled by their owners
+	TSharedRef<FNdiMediaReceiverRequest, ESPMode::ThreadSafe> Request = MakeShareable(new FNdiMediaReceiverRequest);
+
+	while (ReceiverRequests.Dequeue(Request))
+	{
+		check(Request->Cancelled);
+	}
+
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+}
+
+
+/* FNdiMediaConnectionMonitor interface
+ *****************************************************************************/
+
+TSharedRef<FNdiMediaHealthProbe, ESPMode::ThreadSafe> FNdiMediaConnectionMonitor::AddHealthProbe(const TSharedRef<INdiMediaBackend, ESPMode::ThreadSafe>& Backend, void* ReceiverInstance)
+{
+	TSharedRef<FNdiMediaHealthProbe, ESPMode::ThreadSafe> Probe = MakeShareable(new FNdiMediaHealthProbe);
+	{
+		Probe->Backend = Backend;
+		Probe->ReceiverInstance = ReceiverInstance;
+	}
+
+	FScopeLock Lock(&CriticalSection);
+	HealthProbes.Add(Probe);
+
+	// publish the initial sample right away
+	WakeEvent->Trigger();
+
+	return Probe;
+}
+
+
+TSharedRef<FNdiMediaConnectionWatch, ESPMode::ThreadSafe> FNdiMediaConnectionMonitor::AddReceiver(const TSharedRef<INdiMediaBackend, ESPMode::ThreadSafe>& Backend, void* ReceiverInstance, const FString& Source, const NDIlib_recv_create_t& RcvCreateDesc, const TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe>& ConnectionMetadata)
+{
+	TSharedRef<FNdiMediaConnectionWatch, ESPMode::ThreadSafe> Watch = MakeShareable(new FNdiMediaConnectionWatch);
+	{
+		Watch->AllowVideoFields = RcvCreateDesc.allow_video_fields;
+		Watch->Backend = Backend;
+		Watch->Backoff = NdiMediaConnectionMonitor::InitialBackoff;
+		Watch->Bandwidth = RcvCreateDesc.bandwidth;
+		Watch->ColorFormat = RcvCreateDesc.color_format;
+		Watch->Connected = false;
+		Watch->ConnectionMetadata = ConnectionMetadata;
+		Watch->DisconnectTime = FPlatformTime::Seconds();
+		Watch->ReceiverInstance = ReceiverInstance;
+		Watch->Source = Source;
+	}
+
+	FScopeLock Lock(&CriticalSection);
+	Watches.Add(Watch);
+
+	// publish the initial state right away
+	WakeEvent->Trigger();
+
+	return Watch;
+}
+
+
+void FNdiMediaConnectionMonitor::CancelReceiverRequest(const TSharedRef<FNdiMediaReceiverRequest, ESPMode::ThreadSafe>& Request)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	Request->Cancelled = true;
+
+	// the receiver was created, but its owner lost interest
+	if (Request->Complete && (Request->ReceiverInstance != nullptr))
+	{
+		RetireReceiver(Request->Backend.ToSharedRef(), Request->ReceiverInstance);
+		Request->ReceiverInstance = nullptr;
+	}
+}
+
+
+TSharedRef<FNdiMediaConnectionMonitor, ESPMode::ThreadSafe> FNdiMediaConnectionMonitor::Get()
+{
+	static FCriticalSection InstanceCriticalSection;
+	static TWeakPtr<FNdiMediaConnectionMonitor, ESPMode::ThreadSafe> WeakInstance;
+
+	FScopeLock Lock(&InstanceCriticalSection);
+
+	TSharedPtr<FNdiMediaConnectionMonitor, ESPMode::ThreadSafe> Instance = WeakInstance.Pin();
+
+	if (!Instance.IsValid())
+	{
+		Instance = MakeShareable(new FNdiMediaConnectionMonitor(GetDefault<UNdiMediaSettings>()->ConnectionPollInterval));
+		WeakInstance = Instance;
+	}
+
+	return Instance.ToSharedRef();
+}
+
+
+void FNdiMediaConnectionMonitor::RemoveHealthProbe(const TSharedRef<FNdiMediaHealthProbe, ESPMode::ThreadSafe>& Probe)
+{
+	// the receiver isn't sampled anymore once the lock is released, so its owner may destroy it
+	FScopeLock Lock(&CriticalSection);
+	HealthProbes.Remove(Probe);
+}
+
+
+void FNdiMediaConnectionMonitor::RemoveReceiver(const TSharedRef<FNdiMediaConnectionWatch, ESPMode::ThreadSafe>& Watch)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	Watches.Remove(Watch);
+
+	// the monitor no longer publishes events for this watch, and destroys unclaimed receivers on its thread
+	FNdiMediaConnectionEvent Event;
+
+	while (Watch->Events.Dequeue(Event))
+	{
+		if (Event.Type == ENdiMediaConnectionEventType::Reconnected)
+		{
+			RetireReceiver(Watch->Backend.ToSharedRef(), Event.ReceiverInstance);
+		}
+	}
+}
+
+
+TSharedRef<FNdiMediaReceiverRequest, ESPMode::ThreadSafe> FNdiMediaConnectionMonitor::RequestReceiver(const FString& Source, const NDIlib_recv_create_t& RcvCreateDesc, const TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe>& ConnectionMetadata, const TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe>& Backend)
+{
+	TSharedRef<FNdiMediaReceiverRequest, ESPMode::ThreadSafe> Request = MakeShareable(new FNdiMediaReceiverRequest);
+	{
+		Request->AllowVideoFields = RcvCreateDesc.allow_video_fields;
+		Request->Backend = Backend;
+		Request->Bandwidth = RcvCreateDesc.bandwidth;
+		Request->ColorFormat = RcvCreateDesc.color_format;
+		Request->ConnectionMetadata = ConnectionMetadata;
+		Request->Source = Source;
+	}
+
+	ReceiverRequests.Enqueue(Request);
+	WakeEvent->Trigger();
+
+	return Request;
+}
+
+
+void FNdiMediaConnectionMonitor::RetireReceiver(const TSharedRef<INdiMediaBackend, ESPMode::ThreadSafe>& Backend, void* ReceiverInstance)
+{
+	if (ReceiverInstance == nullptr)
+	{
+		return;
+	}
+
+	FRetiredReceiver RetiredReceiver;
+	{
+		RetiredReceiver.Backend = Backend;
+		RetiredReceiver.ReceiverInstance = ReceiverInstance;
+	}
+
+	RetiredReceivers.Enqueue(RetiredReceiver);
+	WakeEvent->Trigger();
+}
+
+
+/* FRunnable interface
+ *****************************************************************************/
+
+bool FNdiMediaConnectionMonitor::Init()
+{
+	return true;
+}
+
+
+uint32 FNdiMediaConnectionMonitor::Run()
+{
+	while (!Stopping)
+	{
+		DestroyRetiredReceivers();
+		ProcessReceiverRequests();
+		PollReceivers();
+
+		WakeEvent->Wait((uint32)(PollInterval * 1000.0f));
+	}
+
+	return 0;
+}
+
+
+void FNdiMediaConnectionMonitor::Stop()
+{
+	Stopping = true;
+	WakeEvent->Trigger();
+}
+
+
+/* FNdiMediaConnectionMonitor implementation
+ *****************************************************************************/
+
+void* FNdiMediaConnectionMonitor::CreateReceiver(INdiMediaBackend& Backend, const FString& Source, int32 ColorFormat, int32 Bandwidth, bool AllowVideoFields, const TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe>& ConnectionMetadata)
+{
+	// the converted strings must outlive the receiver's creation
+	FString SourceStr = Source;
+
+	if (SourceStr.StartsWith(TEXT("localhost ")))
+	{
+		SourceStr.ReplaceInline(TEXT("localhost"), FPlatformProcess::ComputerName());
+	}
+
+	FTCHARToUTF8 SourceUtf8(*SourceStr);
+
+	NDIlib_recv_create_t RcvCreateDesc;
+	{
+		const bool IsEndpoint = (SourceStr.Find(TEXT(":")) != INDEX_NONE);
+
+		RcvCreateDesc.source_to_connect_to.p_ip_address = IsEndpoint ? SourceUtf8.Get() : nullptr;
+		RcvCreateDesc.source_to_connect_to.p_ndi_name = IsEndpoint ? nullptr : SourceUtf8.Get();
+		RcvCreateDesc.color_format = (NDIlib_recv_color_format_e)ColorFormat;
+		RcvCreateDesc.bandwidth = (NDIlib_recv_bandwidth_e)Bandwidth;
+		RcvCreateDesc.allow_video_fields = AllowVideoFields;
+	}
+
+	void* ReceiverInstance = Backend.RecvCreate(RcvCreateDesc);
+
+	if (ReceiverInstance == nullptr)
+	{
+		return nullptr;
+	}
+
+	ConnectionMetadata->Send(Backend, ReceiverInstance);
+
+	return ReceiverInstance;
+}
+
+
+void FNdiMediaConnectionMonitor::DestroyRetiredReceivers()
+{
+	FRetiredReceiver RetiredReceiver;
+
+	while (RetiredReceivers.Dequeue(RetiredReceiver))
+	{
+		RetiredReceiver.Backend->RecvDestroy(RetiredReceiver.ReceiverInstance);
+	}
+}
+
+
+bool FNdiMediaConnectionMonitor::PollReceiver(FNdiMediaConnectionWatch& Watch, double Now)
+{
+	const bool Connected = (Watch.Backend->RecvGetNumConnections(Watch.ReceiverInstance) > 0);
+
+	if (Connected != Watch.Connected)
+	{
+		Watch.Connected = Connected;
+		Watch.Events.Enqueue(FNdiMediaConnectionEvent(Connected ? ENdiMediaConnectionEventType::Connected : ENdiMediaConnectionEventType::Disconnected));
+
+		if (Connected)
+		{
+			Watch.Backoff = NdiMediaConnectionMonitor::InitialBackoff;
+		}
+		else
+		{
+			Watch.DisconnectTime = Now;
+		}
+	}
+
+	if (Connected || (Now - Watch.DisconnectTime < Watch.Backoff))
+	{
+		return false;
+	}
+
+	// wait longer after each attempt, so that dead sources don't cost much
+	Watch.Backoff = FMath::Min(Watch.Backoff * 2.0, NdiMediaConnectionMonitor::MaxBackoff);
+	Watch.DisconnectTime = Now;
+
+	return true;
+}
+
+
+void FNdiMediaConnectionMonitor::PollReceivers()
+{
+	TArray<TSharedRef<FNdiMediaConnectionWatch, ESPMode::ThreadSafe>> ExpiredWatches;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		const double Now = FPlatformTime::Seconds();
+
+		for (const TSharedRef<FNdiMediaConnectionWatch, ESPMode::ThreadSafe>& Watch : Watches)
+		{
+			if (PollReceiver(*Watch, Now))
+			{
+				ExpiredWatches.Add(Watch);
+			}
+		}
+
+		for (const TSharedRef<FNdiMediaHealthProbe, ESPMode::ThreadSafe>& Probe : HealthProbes)
+		{
+			SampleHealth(*Probe, Now);
+		}
+	}
+
+	// receivers are recreated without holding the lock, so that their owners aren't blocked
+	for (const TSharedRef<FNdiMediaConnectionWatch, ESPMode::ThreadSafe>& Watch : ExpiredWatches)
+	{
+		void* ReceiverInstance = RecreateReceiver(*Watch);
+
+		FScopeLock Lock(&CriticalSection);
+
+		// the owner stopped watching in the meantime
+		if (!Watches.Contains(Watch))
+		{
+			RetireReceiver(Watch->Backend.ToSharedRef(), ReceiverInstance);
+
+			continue;
+		}
+
+		if (ReceiverInstance == nullptr)
+		{
+			UE_LOG(LogNdiMedia, Warning, TEXT("Failed to recreate receiver for NDI source %s, retrying in %.0f seconds"), *Watch->Source, Watch->Backoff);
+
+			continue;
+		}
+
+		Watch->NumReconnects.Increment();
+		Watch->ReceiverInstance = ReceiverInstance;
+		Watch->Events.Enqueue(FNdiMediaConnectionEvent(ENdiMediaConnectionEventType::Reconnected, ReceiverInstance));
+	}
+}
+
+
+void FNdiMediaConnectionMonitor::ProcessReceiverRequests()
+{
+	TSharedRef<FNdiMediaReceiverRequest, ESPMode::ThreadSafe> Request = MakeShareable(new FNdiMediaReceiverRequest);
+
+	while (ReceiverRequests.Dequeue(Request))
+	{
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			// superseded by a later request from the same owner
+			if (Request->Cancelled)
+			{
+				continue;
+			}
+		}
+
+		const double StartTime = FPlatformTime::Seconds();
+
+		// the runtime may be initialized here on first use
+		TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> Backend = Request->Backend.IsValid() ? Request->Backend : FNdi::GetBackend();
+		void* ReceiverInstance = nullptr;
+		int32 ColorFormat = Request->ColorFormat;
+
+		if (Backend.IsValid())
+		{
+			if ((ColorFormat == NdiMedia::RecvColorFormatFastest) && !Backend->RecvSupportsColorFormat(ColorFormat))
+			{
+				UE_LOG(LogNdiMedia, Warning, TEXT("NDI runtime doesn't support UYVA for media source %s. Falling back to UYVY."), *Request->Source);
+				ColorFormat = NDIlib_recv_color_format_e_UYVY_BGRA;
+			}
+
+			ReceiverInstance = CreateReceiver(*Backend, Request->Source, ColorFormat, Request->Bandwidth, Request->AllowVideoFields, Request->ConnectionMetadata.ToSharedRef());
+		}
+
+		FScopeLock Lock(&CriticalSection);
+
+		if (Request->Cancelled)
+		{
+			if (ReceiverInstance != nullptr)
+			{
+				Backend->RecvDestroy(ReceiverInstance);
+			}
+
+			continue;
+		}
+
+		Request->Backend = Backend;
+		Request->ColorFormat = ColorFormat;
+		Request->CreateTime = FPlatformTime::Seconds() - StartTime;
+		Request->ReceiverInstance = ReceiverInstance;
+
+		// publish the results before the request is seen as complete
+		FPlatformMisc::MemoryBarrier();
+		Request->Complete = true;
+	}
+}
+
+
+void* FNdiMediaConnectionMonitor::RecreateReceiver(const FNdiMediaConnectionWatch& Watch)
+{
+	return CreateReceiver(*Watch.Backend, Watch.Source, Watch.ColorFormat, Watch.Bandwidth, Watch.AllowVideoFields, Watch.ConnectionMetadata.ToSharedRef());
+}
+
+
+void FNdiMediaConnectionMonitor::SampleHealth(FNdiMediaHealthProbe& Probe, double Now)
+{
+	// frame counters are cumulative, so samples can be skipped while the owner falls behind
+	if (Probe.NumSamples.GetValue() >= NdiMediaConnectionMonitor::MaxPendingSamples)
+	{
+		return;
+	}
+
+	NDIlib_recv_performance_t PerfDropped = { 0 };
+	NDIlib_recv_performance_t PerfTotal = { 0 };
+	NDIlib_recv_queue_t Queue = { 0 };
+
+	Probe.Backend->RecvGetPerformance(Probe.ReceiverInstance, PerfTotal, PerfDropped);
+	Probe.Backend->RecvGetQueue(Probe.ReceiverInstance, Queue);
+
+	FNdiMediaHealthSample Sample;
+	{
+		Sample.Connected = (Probe.Backend->RecvGetNumConnections(Probe.ReceiverInstance) > 0);
+		Sample.DroppedFrames = PerfDropped.m_video_frames;
+		Sample.QueueDepth = Queue.m_video_frames;
+		Sample.SampleTime = Now;
+		Sample.TotalFrames = PerfTotal.m_video_frames;
+	}
+
+	Probe.NumSamples.Increment();
+	Probe.Samples.Enqueue(Sample);
+}
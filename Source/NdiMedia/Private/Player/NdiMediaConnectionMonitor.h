@@ -0,0 +1,602 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+
+
+class FEvent;
+class FNdiMediaConnectionMetadata;
+class FRunnableThread;
+class INdiMediaBackend;
+
+struct NDIlib_recv_create_t;
+
+
+/**
+ * Types of connection events.
+ */
+enum class ENdiMediaConnectionEventType : uint8
+{
+	/** The receiver connected to its source. */
+	Connected,
+
+	/** The receiver lost the connection to its source. */
+	Disconnected,
+
+	/** The receiver was recreated, because its source stayed disconnected. */
+	Reconnected
+};
+
+
+/**
+ * A change of a watched receiver's connection.
+ */
+struct FNdiMediaConnectionEvent
+{
+	/** The receiver that replaces the watched receiver (Reconnected events only). */
+	void* ReceiverInstance;
+
+	/** The type of event. */
+	ENdiMediaConnectionEventType Type;
+
+public:
+
+	/** Default constructor. */
+	FNdiMediaConnectionEvent()
+		: ReceiverInstance(nullptr)
+		, Type(ENdiMediaConnectionEventType::Disconnected)
+	{ }
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InType The type of event.
+	 * @param InReceiverInstance The receiver that replaces the watched receiver.
+	 */
+	FNdiMediaConnectionEvent(ENdiMediaConnectionEventType InType, void* InReceiverInstance = nullptr)
+		: ReceiverInstance(InReceiverInstance)
+		, Type(InType)
+	{ }
+};
+
+
+/**
+ * A receiver that is watched by the connection monitor.
+ *
+ * Events are published by the monitor thread and consumed by the receiver's
+ * owner through a lock-free queue. All other state is only accessed by the
+ * monitor while it holds its lock.
+ *
+ * @see FNdiMediaConnectionMonitor
+ */
+class FNdiMediaConnectionWatch
+{
+public:
+
+	/**
+	 * Get the next connection event.
+	 *
+	 * Reconnected events transfer ownership of the new receiver instance to
+	 * the caller, who must retire the previous receiver with the monitor.
+	 *
+	 * @param OutEvent Will contain the event.
+	 * @return true if an event was returned, false if there are no events.
+	 * @see FNdiMediaConnectionMonitor::RetireReceiver
+	 */
+	bool DequeueEvent(FNdiMediaConnectionEvent& OutEvent)
+	{
+		return Events.Dequeue(OutEvent);
+	}
+
+	/**
+	 * Get the number of times the receiver was recreated.
+	 *
+	 * @return Number of reconnects.
+	 */
+	int32 GetNumReconnects() const
+	{
+		return NumReconnects.GetValue();
+	}
+
+private:
+
+	friend class FNdiMediaConnectionMonitor;
+
+	/** Whether the receivers deliver fielded video. */
+	bool AllowVideoFields;
+
+	/** The backend that the receivers are created on. */
+	TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> Backend;
+
+	/** Time to wait before the receiver is recreated (in seconds). */
+	double Backoff;
+
+	/** Bandwidth of the receivers (see NDIlib_recv_bandwidth_e). */
+	int32 Bandwidth;
+
+	/** Color format of the receivers (see NDIlib_recv_color_format_e). */
+	int32 ColorFormat;
+
+	/** Whether the receiver was connected when it was last polled. */
+	bool Connected;
+
+	/** The metadata that is sent to the source. */
+	TSharedPtr<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe> ConnectionMetadata;
+
+	/** Time at which the receiver was created or lost its connection (in seconds). */
+	double DisconnectTime;
+
+	/** Events for the receiver's owner. */
+	TQueue<FNdiMediaConnectionEvent, EQueueMode::Spsc> Events;
+
+	/** Number of times the receiver was recreated. */
+	FThreadSafeCounter NumReconnects;
+
+	/** The newest receiver instance. */
+	void* ReceiverInstance;
+
+	/** The source's name or IP endpoint. */
+	FString Source;
+};
+
+
+/**
+ * Health statistics of a probed receiver.
+ */
+struct FNdiMediaHealthSample
+{
+	/** Whether the receiver was connected to its source. */
+	bool Connected;
+
+	/** Total number of video frames dropped by the receiver. */
+	int64 DroppedFrames;
+
+	/** Number of video frames waiting in the receiver's queue. */
+	int32 QueueDepth;
+
+	/** Time at which the receiver was sampled (in seconds). */
+	double SampleTime;
+
+	/** Total number of video frames received by the receiver. */
+	int64 TotalFrames;
+
+public:
+
+	/** Default constructor. */
+	FNdiMediaHealthSample()
+		: Connected(false)
+		, DroppedFrames(0)
+		, QueueDepth(0)
+		, SampleTime(0.0)
+		, TotalFrames(0)
+	{ }
+};
+
+
+/**
+ * A receiver whose health is sampled by the connection monitor.
+ *
+ * Samples are published by the monitor thread and consumed by the receiver's
+ * owner through a lock-free queue. The monitor stops publishing while the owner
+ * falls behind, so the queue stays short if the owner doesn't consume it.
+ *
+ * @see FNdiMediaConnectionMonitor
+ */
+class FNdiMediaHealthProbe
+{
+public:
+
+	/**
+	 * Get the next health sample.
+	 *
+	 * @param OutSample Will contain the sample.
+	 * @return true if a sample was returned, false if there are no samples.
+	 */
+	bool DequeueSample(FNdiMediaHealthSample& OutSample)
+	{
+		if (!Samples.Dequeue(OutSample))
+		{
+			return false;
+		}
+
+		NumSamples.Decrement();
+
+		return true;
+	}
+
+private:
+
+	friend class FNdiMediaConnectionMonitor;
+
+	/** The backend that the receiver was created on. */
+	TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> Backend;
+
+	/** Number of samples that weren't dequeued yet. */
+	FThreadSafeCounter NumSamples;
+
+	/** The probed receiver instance. */
+	void* ReceiverInstance;
+
+	/** Samples for the receiver's owner. */
+	TQueue<FNdiMediaHealthSample, EQueueMode::Spsc> Samples;
+};
+
+
+/**
+ * A receiver that is created on the monitor thread.
+ *
+ * The request's results are written by the monitor thread before it is marked
+ * complete, and must not be accessed before IsComplete returns true.
+ *
+ * @see FNdiMediaConnectionMonitor::RequestReceiver
+ */
+class FNdiMediaReceiverRequest
+{
+public:
+
+	/** Default constructor. */
+	FNdiMediaReceiverRequest()
+		: AllowVideoFields(false)
+		, Bandwidth(0)
+		, Cancelled(false)
+		, ColorFormat(0)
+		, Complete(false)
+		, CreateTime(0.0)
+		, ReceiverInstance(nullptr)
+	{ }
+
+public:
+
+	/**
+	 * Get the backend that the receiver was created on.
+	 *
+	 * @return The backend, or nullptr if NDI is not available.
+	 */
+	const TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe>& GetBackend() const
+	{
+		return Backend;
+	}
+
+	/**
+	 * Get the receiver's bandwidth.
+	 *
+	 * @return Bandwidth (see NDIlib_recv_bandwidth_e).
+	 */
+	int32 GetBandwidth() const
+	{
+		return Bandwidth;
+	}
+
+	/**
+	 * Get the receiver's color format, which may differ from the requested format.
+	 *
+	 * @return Color format (see NDIlib_recv_color_format_e).
+	 */
+	int32 GetColorFormat() const
+	{
+		return ColorFormat;
+	}
+
+	/**
+	 * Get the metadata that was sent to the source.
+	 *
+	 * @return Connection metadata.
+	 */
+	TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe> GetConnectionMetadata() const
+	{
+		return ConnectionMetadata.ToSharedRef();
+	}
+
+	/**
+	 * Get how long the monitor thread took to create the receiver.
+	 *
+	 * @return Creation time (in seconds).
+	 */
+	double GetCreateTime() const
+	{
+		return CreateTime;
+	}
+
+	/**
+	 * Get the created receiver, whose ownership transfers to the caller.
+	 *
+	 * @return The receiver instance, or nullptr if it couldn't be created.
+	 */
+	void* GetReceiverInstance() const
+	{
+		return ReceiverInstance;
+	}
+
+	/**
+	 * Whether the monitor thread processed the request.
+	 *
+	 * @return true if complete, false otherwise.
+	 */
+	bool IsComplete() const
+	{
+		if (!Complete)
+		{
+			return false;
+		}
+
+		// results were written before the request was marked complete
+		FPlatformMisc::MemoryBarrier();
+
+		return true;
+	}
+
+private:
+
+	friend class FNdiMediaConnectionMonitor;
+
+	/** Whether the receiver delivers fielded video. */
+	bool AllowVideoFields;
+
+	/** The backend that the receiver is created on (nullptr until resolved). */
+	TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> Backend;
+
+	/** Bandwidth of the receiver (see NDIlib_recv_bandwidth_e). */
+	int32 Bandwidth;
+
+	/** Whether the requester lost interest (guarded by the monitor's lock). */
+	bool Cancelled;
+
+	/** Color format of the receiver (see NDIlib_recv_color_format_e). */
+	int32 ColorFormat;
+
+	/** Whether the monitor thread processed the request. */
+	FThreadSafeBool Complete;
+
+	/** The metadata that is sent to the source. */
+	TSharedPtr<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe> ConnectionMetadata;
+
+	/** How long the monitor thread took to create the receiver (in seconds). */
+	double CreateTime;
+
+	/** The created receiver instance. */
+	void* ReceiverInstance;
+
+	/** The source's name or IP endpoint. */
+	FString Source;
+};
+
+
+/**
+ * Supervises the connections of NDI receivers on a background thread.
+ *
+ * All watched receivers are polled at the rate configured in the plug-in
+ * settings, so that players don't need to query their connection on every
+ * tick. Changes are published to each receiver's owner as events. Receivers
+ * whose source stays disconnected are recreated with the same settings, with
+ * exponentially growing delays between attempts. Replaced receivers are handed
+ * back to the monitor, which destroys them on its thread.
+ *
+ * The health of failover receivers is sampled at the same rate, so that
+ * players with backup sources don't query receiver statistics on every tick.
+ * Samples are published to each receiver's owner in the same way.
+ *
+ * Players also create their receivers through the monitor, so that neither
+ * opening nor closing a stream blocks the game thread. Requests that are
+ * cancelled before the monitor gets to them are dropped, so that a player
+ * that is opened and closed repeatedly only creates the last receiver.
+ *
+ * A single monitor is shared by all players while any of them has a receiver.
+ * All functions are thread-safe.
+ */
+class FNdiMediaConnectionMonitor
+	: public FRunnable
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InPollInterval How often receivers are polled (in seconds).
+	 */
+	FNdiMediaConnectionMonitor(float InPollInterval);
+
+	/** Destructor. */
+	virtual ~FNdiMediaConnectionMonitor();
+
+public:
+
+	/**
+	 * Start sampling the health of a receiver.
+	 *
+	 * The probe must be removed before the receiver is destroyed.
+	 *
+	 * @param Backend The backend that the receiver was created on.
+	 * @param ReceiverInstance The receiver instance (remains owned by the caller).
+	 * @return The probe, which receives the receiver's health samples.
+	 * @see RemoveHealthProbe
+	 */
+	TSharedRef<FNdiMediaHealthProbe, ESPMode::ThreadSafe> AddHealthProbe(const TSharedRef<INdiMediaBackend, ESPMode::ThreadSafe>& Backend, void* ReceiverInstance);
+
+	/**
+	 * Start watching a receiver.
+	 *
+	 * @param Backend The backend that the receiver was created on.
+	 * @param ReceiverInstance The receiver instance (remains owned by the caller).
+	 * @param Source The source's name or IP endpoint.
+	 * @param RcvCreateDesc The receiver's settings, which are used for recreating it.
+	 * @param ConnectionMetadata The metadata that was sent to the source, which is sent again after recreating it.
+	 * @return The watch, which receives the receiver's connection events.
+	 * @see RemoveReceiver
+	 */
+	TSharedRef<FNdiMediaConnectionWatch, ESPMode::ThreadSafe> AddReceiver(const TSharedRef<INdiMediaBackend, ESPMode::ThreadSafe>& Backend, void* ReceiverInstance, const FString& Source, const NDIlib_recv_create_t& RcvCreateDesc, const TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe>& ConnectionMetadata);
+
+	/**
+	 * Cancel a receiver request.
+	 *
+	 * If the receiver was already created, it is destroyed on the monitor thread.
+	 *
+	 * @param Request The request returned by RequestReceiver.
+	 * @see RequestReceiver
+	 */
+	void CancelReceiverRequest(const TSharedRef<FNdiMediaReceiverRequest, ESPMode::ThreadSafe>& Request);
+
+	/**
+	 * Get the shared connection monitor, and create it if needed.
+	 *
+	 * Must be called on the game thread, because it reads the plug-in settings.
+	 *
+	 * @return The connection monitor.
+	 */
+	static TSharedRef<FNdiMediaConnectionMonitor, ESPMode::ThreadSafe> Get();
+
+	/**
+	 * Get how often receivers are polled.
+	 *
+	 * @return Poll interval (in seconds).
+	 */
+	float GetPollInterval() const
+	{
+		return PollInterval;
+	}
+
+	/**
+	 * Stop sampling the health of a receiver.
+	 *
+	 * @param Probe The probe returned by AddHealthProbe.
+	 * @see AddHealthProbe
+	 */
+	void RemoveHealthProbe(const TSharedRef<FNdiMediaHealthProbe, ESPMode::ThreadSafe>& Probe);
+
+	/**
+	 * Stop watching a receiver.
+	 *
+	 * Receivers that replaced the watched receiver, but whose events weren't
+	 * dequeued yet, are retired and destroyed on the monitor's thread. The
+	 * receiver that was last dequeued remains owned by the caller.
+	 *
+	 * @param Watch The watch returned by AddReceiver.
+	 * @see AddReceiver
+	 */
+	void RemoveReceiver(const TSharedRef<FNdiMediaConnectionWatch, ESPMode::ThreadSafe>& Watch);
+
+	/**
+	 * Create a receiver and send connection metadata to its source on the monitor thread.
+	 *
+	 * If no backend is given, it is resolved on the monitor thread, which also
+	 * initializes the NDI runtime if needed. Receivers that request the fastest
+	 * color format fall back to UYVY if the runtime doesn't support it.
+	 *
+	 * @param Source The source's name or IP endpoint.
+	 * @param RcvCreateDesc The receiver's settings (its source is ignored).
+	 * @param ConnectionMetadata The metadata to send to the source.
+	 * @param Backend The backend to create the receiver on (nullptr = default backend).
+	 * @return The request, which completes when the receiver was created.
+	 * @see CancelReceiverRequest
+	 */
+	TSharedRef<FNdiMediaReceiverRequest, ESPMode::ThreadSafe> RequestReceiver(const FString& Source, const NDIlib_recv_create_t& RcvCreateDesc, const TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe>& ConnectionMetadata, const TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe>& Backend = nullptr);
+
+	/**
+	 * Destroy a receiver that was replaced on the monitor thread.
+	 *
+	 * @param Backend The backend that the receiver was created on.
+	 * @param ReceiverInstance The receiver instance.
+	 */
+	void RetireReceiver(const TSharedRef<INdiMediaBackend, ESPMode::ThreadSafe>& Backend, void* ReceiverInstance);
+
+public:
+
+	//~ FRunnable interface
+
+	virtual bool Init() override;
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	virtual void Exit() override { }
+
+protected:
+
+	/** A receiver that waits to be destroyed. */
+	struct FRetiredReceiver
+	{
+		/** The backend that the receiver was created on. */
+		TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> Backend;
+
+		/** The receiver instance. */
+		void* ReceiverInstance;
+	};
+
+	/**
+	 * Create a receiver and send connection metadata to its source.
+	 *
+	 * @param Backend The backend to create the receiver on.
+	 * @param Source The source's name or IP endpoint.
+	 * @param ColorFormat Color format of the receiver (see NDIlib_recv_color_format_e).
+	 * @param Bandwidth Bandwidth of the receiver (see NDIlib_recv_bandwidth_e).
+	 * @param AllowVideoFields Whether the receiver delivers fielded video.
+	 * @param ConnectionMetadata The metadata to send to the source.
+	 * @return The receiver instance, or nullptr if it couldn't be created.
+	 */
+	static void* CreateReceiver(INdiMediaBackend& Backend, const FString& Source, int32 ColorFormat, int32 Bandwidth, bool AllowVideoFields, const TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe>& ConnectionMetadata);
+
+	/** Destroy the receivers that were retired since the last poll. */
+	void DestroyRetiredReceivers();
+
+	/**
+	 * Poll the connection of a watched receiver (caller holds the lock).
+	 *
+	 * @param Watch The watched receiver.
+	 * @param Now The current time (in seconds).
+	 * @return true if the receiver should be recreated, false otherwise.
+	 */
+	bool PollReceiver(FNdiMediaConnectionWatch& Watch, double Now);
+
+	/** Poll the connections of all watched receivers, recreate the ones that stayed disconnected, and sample the probed receivers. */
+	void PollReceivers();
+
+	/** Create the receivers that were requested since the last poll. */
+	void ProcessReceiverRequests();
+
+	/**
+	 * Create a new receiver for a watched receiver's source.
+	 *
+	 * @param Watch The watched receiver.
+	 * @return The receiver instance, or nullptr if it couldn't be created.
+	 */
+	void* RecreateReceiver(const FNdiMediaConnectionWatch& Watch);
+
+	/**
+	 * Sample the health of a probed receiver (caller holds the lock).
+	 *
+	 * @param Probe The probed receiver.
+	 * @param Now The current time (in seconds).
+	 */
+	void SampleHealth(FNdiMediaHealthProbe& Probe, double Now);
+
+private:
+
+	/** Critical section for synchronizing access to the watched and probed receivers, and receiver requests. */
+	FCriticalSection CriticalSection;
+
+	/** The probed receivers. */
+	TArray<TSharedRef<FNdiMediaHealthProbe, ESPMode::ThreadSafe>> HealthProbes;
+
+	/** How often receivers are polled (in seconds). */
+	float PollInterval;
+
+	/** Receivers that wait to be created. */
+	TQueue<TSharedRef<FNdiMediaReceiverRequest, ESPMode::ThreadSafe>, EQueueMode::Mpsc> ReceiverRequests;
+
+	/** Receivers that wait to be destroyed. */
+	TQueue<FRetiredReceiver, EQueueMode::Mpsc> RetiredReceivers;
+
+	/** Whether the monitor thread should stop. */
+	FThreadSafeBool Stopping;
+
+	/** The monitor thread. */
+	FRunnableThread* Thread;
+
+	/** Event for waking up the monitor thread. */
+	FEvent* WakeEvent;
+
+	/** The watched receivers. */
+	TArray<TSharedRef<FNdiMediaConnectionWatch, ESPMode::ThreadSafe>> Watches;
+};
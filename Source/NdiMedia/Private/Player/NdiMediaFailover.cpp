@@ -0,0 +1,453 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaFailover.h"
+#include "NdiMediaPrivate.h"
+
+#include "HAL/PlatformTime.h"
+#include "INdiMediaBackend.h"
+#include "NdiMediaConnectionMetadata.h"
+#include "NdiMediaConnectionMonitor.h"
+
+
+namespace NdiMediaFailover
+{
+	/** How long a receiver may take to deliver its first video frame before it is considered stalled (in seconds). */
+	static const double ConnectTimeout = 3.0;
+
+	/** Weight of the most recent drop rate in the smoothed drop rate. */
+	static const float DropRateSmoothing = 0.25f;
+
+	/** Health score below which the active receiver has failed. */
+	static const float FailScore = 0.5f;
+
+	/** How long a higher priority source must stay healthy before playback returns to it (in seconds). */
+	static const double HoldTime = 5.0;
+
+	/** Maximum number of frames that are discarded from a receiver per tick. */
+	static const int32 MaxDrainedFrames = 16;
+
+	/** Number of queued video frames above which a receiver's score is reduced. */
+	static const int32 MaxQueueDepth = 8;
+
+	/** Shortest time without video frames after which a receiver is considered stalled (in seconds). */
+	static const double MinStallTime = 0.1;
+
+	/** How long the standby receiver may stay unhealthy before the next source is probed (in seconds). */
+	static const double ProbeTimeout = 3.0;
+
+	/** Health score at or above which a receiver has recovered. */
+	static const float RecoverScore = 0.9f;
+
+	/** Number of missed video frames after which a receiver is considered stalled. */
+	static const double StallFrames = 3.0;
+}
+
+
+/* FNdiMediaFailover structors
+ *****************************************************************************/
+
+FNdiMediaFailover::FNdiMediaFailover()
+	: AllowVideoFields(true)
+	, Bandwidth(NDIlib_recv_bandwidth_highest)
+	, ColorFormat(NDIlib_recv_color_format_e_UYVY_BGRA)
+	, NumSwitches(0)
+{ }
+
+
+FNdiMediaFailover::~FNdiMediaFailover()
+{
+	Close();
+}
+
+
+/* FNdiMediaFailover interface
+ *****************************************************************************/
+
+void FNdiMediaFailover::Close()
+{
+	DisconnectStandby();
+	UnprobeReceiver(Active);
+
+	Active = FReceiver();
+	Backend.Reset();
+	ConnectionMetadata.Reset();
+	Monitor.Reset();
+	NumSwitches = 0;
+	Sources.Empty();
+}
+
+
+FNdiMediaFailoverStats FNdiMediaFailover::GetStats() const
+{
+	FNdiMediaFailoverStats Stats;
+	{
+		Stats.ActiveHealth = Active.Health;
+		Stats.ActiveSource = Sources.IsValidIndex(Active.SourceIndex) ? Sources[Active.SourceIndex] : FString();
+		Stats.NumSwitches = NumSwitches;
+		Stats.StandbyHealth = Standby.Health;
+		Stats.StandbySource = Sources.IsValidIndex(Standby.SourceIndex) ? Sources[Standby.SourceIndex] : FString();
+	}
+
+	return Stats;
+}
+
+
+void FNdiMediaFailover::NotifyVideoFrame(const NDIlib_video_frame_v2_t& VideoFrame)
+{
+	Active.LastFrameTime = FPlatformTime::Seconds();
+
+	if ((VideoFrame.frame_rate_N > 0) && (VideoFrame.frame_rate_D > 0))
+	{
+		Active.FrameDuration = (double)VideoFrame.frame_rate_D / VideoFrame.frame_rate_N;
+	}
+}
+
+
+bool FNdiMediaFailover::Open(const TSharedRef<FNdiMediaConnectionMonitor, ESPMode::ThreadSafe>& InMonitor, const TSharedRef<INdiMediaBackend, ESPMode::ThreadSafe>& InBackend, const TArray<FString>& InSources, const NDIlib_recv_create_t& RcvCreateDesc, const TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe>& InConnectionMetadata, void* ActiveInstance)
+{
+	Close();
+
+	if (InSources.Num() < 2)
+	{
+		return false;
+	}
+
+	AllowVideoFields = RcvCreateDesc.allow_video_fields;
+	Backend = InBackend;
+	Bandwidth = RcvCreateDesc.bandwidth;
+	ColorFormat = RcvCreateDesc.color_format;
+	ConnectionMetadata = InConnectionMetadata;
+	Monitor = InMonitor;
+	Sources = InSources;
+
+	Active.Instance = ActiveInstance;
+	Active.OpenTime = FPlatformTime::Seconds();
+	Active.SourceIndex = 0;
+
+	ProbeReceiver(Active);
+
+	// the standby receiver is connected on the first tick
+	return true;
+}
+
+
+void* FNdiMediaFailover::SwitchToStandby()
+{
+	check(Standby.Instance != nullptr);
+
+	// health statistics and probes follow their receivers
+	Swap(Active, Standby);
+
+	const double Now = FPlatformTime::Seconds();
+
+	Active.OpenTime = Now;
+	Standby.HealthySince = 0.0;
+	Standby.OpenTime = Now;
+
+	++NumSwitches;
+
+	return Active.Instance;
+}
+
+
+bool FNdiMediaFailover::Tick(bool DrainActive)
+{
+	using namespace NdiMediaFailover;
+
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+
+	// other frames of the active receiver are still consumed by the player
+	if (DrainActive)
+	{
+		Drain(Active, true);
+	}
+
+	FinishConnectStandby();
+	Drain(Standby, false);
+	UpdateHealth(Active);
+	UpdateHealth(Standby);
+	UpdateStandby(Now);
+
+	if ((Standby.Instance == nullptr) || (Standby.HealthySince == 0.0))
+	{
+		return false;
+	}
+
+	// fail over as soon as the active receiver fails, unless it is still connecting
+	const bool Connecting = (Active.LastFrameTime == 0.0) && (Now - Active.OpenTime < ConnectTimeout);
+
+	if ((Active.Health.Score < FailScore) && !Connecting)
+	{
+		return true;
+	}
+
+	// return to a higher priority source only after it stayed healthy for a while
+	return ((Standby.SourceIndex < Active.SourceIndex) && (Now - Standby.HealthySince >= HoldTime));
+}
+
+
+/* FNdiMediaFailover implementation
+ *****************************************************************************/
+
+void FNdiMediaFailover::ConnectStandby(int32 SourceIndex)
+{
+	DisconnectStandby();
+
+	NDIlib_recv_create_t RcvCreateDesc;
+	{
+		RcvCreateDesc.color_format = (NDIlib_recv_color_format_e)ColorFormat;
+		RcvCreateDesc.bandwidth = (NDIlib_recv_bandwidth_e)Bandwidth;
+		RcvCreateDesc.allow_video_fields = AllowVideoFields;
+	}
+
+	// sources that take too long to connect are skipped after the probe timeout
+	Standby.OpenTime = FPlatformTime::Seconds();
+	Standby.Request = Monitor->RequestReceiver(Sources[SourceIndex], RcvCreateDesc, ConnectionMetadata.ToSharedRef(), Backend);
+	Standby.SourceIndex = SourceIndex;
+}
+
+
+void FNdiMediaFailover::DisconnectStandby()
+{
+	// receivers that are still being created are destroyed by the monitor
+	if (Standby.Request.IsValid())
+	{
+		Monitor->CancelReceiverRequest(Standby.Request.ToSharedRef());
+	}
+
+	// the receiver must not be sampled anymore when the monitor destroys it
+	UnprobeReceiver(Standby);
+
+	if (Standby.Instance != nullptr)
+	{
+		Monitor->RetireReceiver(Backend.ToSharedRef(), Standby.Instance);
+	}
+
+	Standby = FReceiver();
+}
+
+
+void FNdiMediaFailover::Drain(FReceiver& Receiver, bool VideoOnly)
+{
+	if (Receiver.Instance == nullptr)
+	{
+		return;
+	}
+
+	// drained frames are only needed to keep the queues short and to learn the frame rate
+	for (int32 FrameIndex = 0; FrameIndex < NdiMediaFailover::MaxDrainedFrames; ++FrameIndex)
+	{
+		NDIlib_audio_frame_v2_t AudioFrame;
+		NDIlib_metadata_frame_t MetadataFrame;
+		NDIlib_video_frame_v2_t VideoFrame;
+
+		const NDIlib_frame_type_e FrameType = Backend->RecvCapture(Receiver.Instance, &VideoFrame, VideoOnly ? nullptr : &AudioFrame, VideoOnly ? nullptr : &MetadataFrame, 0);
+
+		if (FrameType == NDIlib_frame_type_video)
+		{
+			if ((VideoFrame.frame_rate_N > 0) && (VideoFrame.frame_rate_D > 0))
+			{
+				Receiver.FrameDuration = (double)VideoFrame.frame_rate_D / VideoFrame.frame_rate_N;
+			}
+
+			Backend->RecvFreeVideo(Receiver.Instance, VideoFrame);
+		}
+		else if (FrameType == NDIlib_frame_type_audio)
+		{
+			Backend->RecvFreeAudio(Receiver.Instance, AudioFrame);
+		}
+		else if (FrameType == NDIlib_frame_type_metadata)
+		{
+			Backend->RecvFreeMetadata(Receiver.Instance, MetadataFrame);
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+
+void FNdiMediaFailover::FinishConnectStandby()
+{
+	if (!Standby.Request.IsValid() || !Standby.Request->IsComplete())
+	{
+		return;
+	}
+
+	Standby.Instance = Standby.Request->GetReceiverInstance();
+	Standby.Request.Reset();
+
+	if (Standby.Instance == nullptr)
+	{
+		UE_LOG(LogNdiMedia, Warning, TEXT("Failed to create receiver for backup source %s"), *Sources[Standby.SourceIndex]);
+	}
+	else
+	{
+		ProbeReceiver(Standby);
+	}
+}
+
+
+void FNdiMediaFailover::GetStandbyCandidates(TArray<int32>& OutCandidates) const
+{
+	OutCandidates.Reset();
+
+	if (Active.Health.Score >= NdiMediaFailover::FailScore)
+	{
+		// while healthy, probe the sources that playback would return to
+		if (Active.SourceIndex > 0)
+		{
+			for (int32 SourceIndex = 0; SourceIndex < Active.SourceIndex; ++SourceIndex)
+			{
+				OutCandidates.Add(SourceIndex);
+			}
+		}
+		else
+		{
+			for (int32 SourceIndex = 1; SourceIndex < Sources.Num(); ++SourceIndex)
+			{
+				OutCandidates.Add(SourceIndex);
+			}
+		}
+	}
+	else
+	{
+		// otherwise, probe any other source
+		for (int32 SourceIndex = 0; SourceIndex < Sources.Num(); ++SourceIndex)
+		{
+			if (SourceIndex != Active.SourceIndex)
+			{
+				OutCandidates.Add(SourceIndex);
+			}
+		}
+	}
+}
+
+
+void FNdiMediaFailover::ProbeReceiver(FReceiver& Receiver)
+{
+	Receiver.Probe = Monitor->AddHealthProbe(Backend.ToSharedRef(), Receiver.Instance);
+}
+
+
+void FNdiMediaFailover::UnprobeReceiver(FReceiver& Receiver)
+{
+	if (Receiver.Probe.IsValid())
+	{
+		Monitor->RemoveHealthProbe(Receiver.Probe.ToSharedRef());
+		Receiver.Probe.Reset();
+	}
+}
+
+
+void FNdiMediaFailover::UpdateHealth(FReceiver& Receiver)
+{
+	using namespace NdiMediaFailover;
+
+	FNdiMediaReceiverHealth& Health = Receiver.Health;
+
+	if (Receiver.Instance == nullptr)
+	{
+		Health = FNdiMediaReceiverHealth();
+		Receiver.HealthySince = 0.0;
+
+		return;
+	}
+
+	// statistics are queried on the monitor thread, and the score only changes when a new sample arrives
+	FNdiMediaHealthSample Sample;
+
+	while (Receiver.Probe->DequeueSample(Sample))
+	{
+		Health.Connected = Sample.Connected;
+		Health.QueueDepth = Sample.QueueDepth;
+
+		// frame counters keep advancing while the game thread hitches, so they are used to detect stalls
+		const int64 NewDroppedFrames = Sample.DroppedFrames - Receiver.DroppedFrames;
+		const int64 NewTotalFrames = Sample.TotalFrames - Receiver.TotalFrames;
+
+		Receiver.DroppedFrames = Sample.DroppedFrames;
+		Receiver.TotalFrames = Sample.TotalFrames;
+
+		if (NewTotalFrames > 0)
+		{
+			const float DropRate = FMath::Clamp((float)NewDroppedFrames / NewTotalFrames, 0.0f, 1.0f);
+
+			Health.DropRate = FMath::Lerp(Health.DropRate, DropRate, DropRateSmoothing);
+			Receiver.LastFrameTime = FMath::Max(Receiver.LastFrameTime, Sample.SampleTime);
+		}
+
+		// stalls are measured at the sample time, so that the poll interval isn't mistaken for one
+		const double StallTime = (Receiver.LastFrameTime > 0.0)
+			? FMath::Max(MinStallTime, StallFrames * Receiver.FrameDuration)
+			: ConnectTimeout;
+
+		Health.Stalled = (Sample.SampleTime - FMath::Max(Receiver.LastFrameTime, Receiver.OpenTime) > StallTime);
+
+		// compute score
+		if (!Health.Connected || Health.Stalled)
+		{
+			Health.Score = 0.0f;
+		}
+		else
+		{
+			Health.Score = 1.0f - Health.DropRate;
+
+			if (Health.QueueDepth > MaxQueueDepth)
+			{
+				Health.Score *= (float)MaxQueueDepth / Health.QueueDepth;
+			}
+		}
+
+		if (Health.Score >= RecoverScore)
+		{
+			if (Receiver.HealthySince == 0.0)
+			{
+				Receiver.HealthySince = Sample.SampleTime;
+			}
+
+			Receiver.LastHealthyTime = Sample.SampleTime;
+		}
+		else
+		{
+			Receiver.HealthySince = 0.0;
+		}
+	}
+}
+
+
+void FNdiMediaFailover::UpdateStandby(double Now)
+{
+	TArray<int32> Candidates;
+	GetStandbyCandidates(Candidates);
+
+	const int32 CandidateIndex = Candidates.Find(Standby.SourceIndex);
+
+	if (CandidateIndex == INDEX_NONE)
+	{
+		if (Candidates.Num() > 0)
+		{
+			ConnectStandby(Candidates[0]);
+		}
+		else
+		{
+			DisconnectStandby();
+		}
+
+		return;
+	}
+
+	// probe the next candidate if the standby doesn't become healthy
+	const double UnhealthyTime = Now - FMath::Max(Standby.OpenTime, Standby.LastHealthyTime);
+
+	if ((Candidates.Num() > 1) && (UnhealthyTime >= NdiMediaFailover::ProbeTimeout))
+	{
+		ConnectStandby(Candidates[(CandidateIndex + 1) % Candidates.Num()]);
+	}
+}
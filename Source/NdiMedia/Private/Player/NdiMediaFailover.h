@@ -0,0 +1,336 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+class FNdiMediaConnectionMetadata;
+class FNdiMediaConnectionMonitor;
+class FNdiMediaHealthProbe;
+class FNdiMediaReceiverRequest;
+class INdiMediaBackend;
+
+struct NDIlib_recv_create_t;
+struct NDIlib_video_frame_v2_t;
+
+
+/**
+ * Health of an NDI receiver.
+ */
+struct FNdiMediaReceiverHealth
+{
+	/** Whether the receiver is connected to its source. */
+	bool Connected;
+
+	/** Fraction of video frames that were dropped recently (smoothed). */
+	float DropRate;
+
+	/** Number of video frames waiting in the receiver's queue. */
+	int32 QueueDepth;
+
+	/** The health score (0.0 = failed, 1.0 = healthy). */
+	float Score;
+
+	/** Whether the receiver stopped delivering video frames. */
+	bool Stalled;
+
+public:
+
+	/** Default constructor. */
+	FNdiMediaReceiverHealth()
+		: Connected(false)
+		, DropRate(0.0f)
+		, QueueDepth(0)
+		, Score(0.0f)
+		, Stalled(false)
+	{ }
+};
+
+
+/**
+ * Statistics of a source failover.
+ */
+struct FNdiMediaFailoverStats
+{
+	/** Health of the playing receiver. */
+	FNdiMediaReceiverHealth ActiveHealth;
+
+	/** The playing source. */
+	FString ActiveSource;
+
+	/** Number of times playback switched sources. */
+	uint32 NumSwitches;
+
+	/** Health of the standby receiver. */
+	FNdiMediaReceiverHealth StandbyHealth;
+
+	/** The standby source (empty if none). */
+	FString StandbySource;
+};
+
+
+/**
+ * Monitors the health of a player's receiver and keeps a backup source connected.
+ *
+ * The sources are ordered by priority, with the originally opened source first.
+ * Besides the player's active receiver, exactly one standby receiver is kept
+ * connected with the same settings, so that switching to it is instant. The
+ * standby's frames are discarded until it becomes active. While the active source
+ * is healthy, the standby probes higher priority sources, or the first backup if
+ * the primary source is playing; otherwise it probes all other sources in order.
+ *
+ * Standby receivers are created and destroyed on the connection monitor thread,
+ * so that probing unreachable sources doesn't block the caller. While the player
+ * doesn't capture video, e.g. because it is paused, the failover drains the
+ * active receiver's video frames, so that its queue doesn't fill up and make it
+ * look unhealthy.
+ *
+ * The health score of a receiver is built from its connection state, its recent
+ * video drop rate, its queue depth and the time since its last video frame. The
+ * receivers' statistics are sampled on the connection monitor thread, so the
+ * scores are updated at the monitor's poll rate rather than on every tick. The
+ * player switches to the standby as soon as the active receiver's score falls
+ * below the failure threshold and the standby is healthy. Switching back to a
+ * higher priority source requires it to stay healthy for a while (hysteresis),
+ * so that flapping sources don't cause repeated switches.
+ *
+ * Functions must be called from the same thread.
+ */
+class FNdiMediaFailover
+{
+public:
+
+	/** Default constructor. */
+	FNdiMediaFailover();
+
+	/** Destructor. */
+	~FNdiMediaFailover();
+
+public:
+
+	/**
+	 * Disconnect the standby receiver and stop monitoring.
+	 *
+	 * The active receiver is owned by the player and not destroyed.
+	 *
+	 * @see IsOpen, Open
+	 */
+	void Close();
+
+	/**
+	 * Get the failover's statistics.
+	 *
+	 * @return Statistics.
+	 */
+	FNdiMediaFailoverStats GetStats() const;
+
+	/**
+	 * Whether the active receiver was connected when its health was last updated.
+	 *
+	 * @return true if connected, false otherwise.
+	 */
+	bool IsActiveConnected() const
+	{
+		return Active.Health.Connected;
+	}
+
+	/**
+	 * Whether backup sources are being monitored.
+	 *
+	 * @return true if open, false otherwise.
+	 * @see Close, Open
+	 */
+	bool IsOpen() const
+	{
+		return (Sources.Num() > 1);
+	}
+
+	/**
+	 * Notify the failover that the active receiver delivered a video frame.
+	 *
+	 * @param VideoFrame The received frame.
+	 */
+	void NotifyVideoFrame(const NDIlib_video_frame_v2_t& VideoFrame);
+
+	/**
+	 * Start monitoring a player's receiver.
+	 *
+	 * @param InMonitor The connection monitor that creates, destroys and samples the receivers.
+	 * @param InBackend The backend that the receivers are created on.
+	 * @param InSources The names or IP endpoints of the sources, in order of priority (the active source first).
+	 * @param RcvCreateDesc The settings of the active receiver, which are used for all receivers.
+	 * @param InConnectionMetadata The metadata that was sent to the active source, which is sent to all sources.
+	 * @param ActiveInstance The player's receiver instance.
+	 * @return true on success, false if there are no backup sources.
+	 * @see Close, IsOpen
+	 */
+	bool Open(const TSharedRef<FNdiMediaConnectionMonitor, ESPMode::ThreadSafe>& InMonitor, const TSharedRef<INdiMediaBackend, ESPMode::ThreadSafe>& InBackend, const TArray<FString>& InSources, const NDIlib_recv_create_t& RcvCreateDesc, const TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe>& InConnectionMetadata, void* ActiveInstance);
+
+	/**
+	 * Make the standby receiver the active receiver.
+	 *
+	 * The previously active receiver becomes the standby receiver, and is owned
+	 * by the failover from now on.
+	 *
+	 * @return The new active receiver instance.
+	 * @see Tick
+	 */
+	void* SwitchToStandby();
+
+	/**
+	 * Update the health scores and the standby receiver.
+	 *
+	 * @param DrainActive Whether to discard the active receiver's video frames, because the player doesn't capture them.
+	 * @return true if the player should switch to the standby receiver, false otherwise.
+	 * @see SwitchToStandby
+	 */
+	bool Tick(bool DrainActive);
+
+protected:
+
+	/** A monitored receiver. */
+	struct FReceiver
+	{
+		/** Video frames dropped by the receiver when its health was last updated. */
+		int64 DroppedFrames;
+
+		/** Duration of the receiver's last video frame (in seconds, 0.0 = unknown). */
+		double FrameDuration;
+
+		/** The receiver's current health. */
+		FNdiMediaReceiverHealth Health;
+
+		/** Time at which the receiver's score reached the recovery threshold (0.0 = not recovered). */
+		double HealthySince;
+
+		/** The receiver instance (nullptr if none). */
+		void* Instance;
+
+		/** Time at which the receiver last delivered a video frame (0.0 = never). */
+		double LastFrameTime;
+
+		/** Time at which the receiver's score was last at or above the recovery threshold (0.0 = never). */
+		double LastHealthyTime;
+
+		/** Time at which the receiver was connected or became active. */
+		double OpenTime;
+
+		/** Samples the receiver's health on the monitor thread (nullptr if none). */
+		TSharedPtr<FNdiMediaHealthProbe, ESPMode::ThreadSafe> Probe;
+
+		/** The pending creation of the receiver on the monitor thread (nullptr if none). */
+		TSharedPtr<FNdiMediaReceiverRequest, ESPMode::ThreadSafe> Request;
+
+		/** Index of the receiver's source. */
+		int32 SourceIndex;
+
+		/** Video frames received by the receiver when its health was last updated. */
+		int64 TotalFrames;
+
+	public:
+
+		/** Default constructor. */
+		FReceiver()
+			: DroppedFrames(0)
+			, FrameDuration(0.0)
+			, HealthySince(0.0)
+			, Instance(nullptr)
+			, LastFrameTime(0.0)
+			, LastHealthyTime(0.0)
+			, OpenTime(0.0)
+			, SourceIndex(INDEX_NONE)
+			, TotalFrames(0)
+		{ }
+	};
+
+	/**
+	 * Connect the standby receiver to a source.
+	 *
+	 * @param SourceIndex Index of the source to connect to.
+	 */
+	void ConnectStandby(int32 SourceIndex);
+
+	/** Disconnect the standby receiver. */
+	void DisconnectStandby();
+
+	/**
+	 * Discard the frames that a receiver delivered since the last tick.
+	 *
+	 * @param Receiver The receiver to drain.
+	 * @param VideoOnly Whether to discard only video frames.
+	 */
+	void Drain(FReceiver& Receiver, bool VideoOnly);
+
+	/** Take over the standby receiver once the monitor thread created it. */
+	void FinishConnectStandby();
+
+	/**
+	 * Get the sources that the standby receiver should probe.
+	 *
+	 * @param OutCandidates Will contain the indices of the sources, in order of priority.
+	 */
+	void GetStandbyCandidates(TArray<int32>& OutCandidates) const;
+
+	/**
+	 * Start sampling the health of a receiver on the monitor thread.
+	 *
+	 * @param Receiver The receiver to probe.
+	 * @see UnprobeReceiver
+	 */
+	void ProbeReceiver(FReceiver& Receiver);
+
+	/**
+	 * Stop sampling the health of a receiver.
+	 *
+	 * @param Receiver The receiver to stop probing.
+	 * @see ProbeReceiver
+	 */
+	void UnprobeReceiver(FReceiver& Receiver);
+
+	/**
+	 * Update the health score of a receiver from the samples that the monitor published since the last tick.
+	 *
+	 * @param Receiver The receiver to update.
+	 */
+	void UpdateHealth(FReceiver& Receiver);
+
+	/**
+	 * Choose the standby receiver's source, and reconnect it if needed.
+	 *
+	 * @param Now The current time (in seconds).
+	 */
+	void UpdateStandby(double Now);
+
+private:
+
+	/** The player's receiver. */
+	FReceiver Active;
+
+	/** Whether the receivers deliver fielded video. */
+	bool AllowVideoFields;
+
+	/** The backend that the receivers are created on. */
+	TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> Backend;
+
+	/** Bandwidth of the receivers (see NDIlib_recv_bandwidth_e). */
+	int32 Bandwidth;
+
+	/** Color format of the receivers (see NDIlib_recv_color_format_e). */
+	int32 ColorFormat;
+
+	/** The metadata that is sent to each source. */
+	TSharedPtr<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe> ConnectionMetadata;
+
+	/** The connection monitor that creates, destroys and samples the receivers. */
+	TSharedPtr<FNdiMediaConnectionMonitor, ESPMode::ThreadSafe> Monitor;
+
+	/** Number of times playback switched sources. */
+	uint32 NumSwitches;
+
+	/** The names or IP endpoints of the sources, in order of priority. */
+	TArray<FString> Sources;
+
+	/** The receiver that playback switches to if the active receiver fails. */
+	FReceiver Standby;
+};
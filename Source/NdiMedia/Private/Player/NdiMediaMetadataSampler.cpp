@@ -0,0 +1,116 @@
+// Copyright 1998-2016 Epic Games, Inc. All Rights Reserved.
+
+#include "NdiMediaMetadataSampler.h"
+#include "NdiMediaPrivate.h"
+
+#include "HAL/PlatformProcess.h"
+#include "HAL/RunnableThread.h"
+#include "INdiMediaBackend.h"
+#include "Misc/ScopeLock.h"
+
+
+/* FNdiMediaMetadataSampler structors
+ *****************************************************************************/
+
+FNdiMediaMetadataSampler::FNdiMediaMetadataSampler()
+	: ReceiverInstance(nullptr)
+	, Stopping(false)
+	, Thread(nullptr)
+{ }
+
+
+FNdiMediaMetadataSampler::~FNdiMediaMetadataSampler()
+{
+	if (Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+}
+
+
+/* FNdiMediaMetadataSampler interface
+ *****************************************************************************/
+
+void FNdiMediaMetadataSampler::SetReceiverInstance(const TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe>& InBackend, void* InReceiverInstance)
+{
+	{
+		FScopeLock Lock(&CriticalSection);
+		Backend = (InReceiverInstance != nullptr) ? InBackend : nullptr;
+		ReceiverInstance = InReceiverInstance;
+	}
+
+	if ((InReceiverInstance != nullptr) && (Thread == nullptr))
+	{
+		Thread = FRunnableThread::Create(this, TEXT("FNdiMediaMetadataSampler"), 0, TPri_AboveNormal);
+	}
+}
+
+
+/* FRunnable interface
+ *****************************************************************************/
+
+bool FNdiMediaMetadataSampler::Init()
+{
+	return true;
+}
+
+
+uint32 FNdiMediaMetadataSampler::Run()
+{
+	while (!Stopping)
+	{
+		if (!SampleMetadata(5))
+		{
+			FPlatformProcess::Sleep(0.005f);
+		}
+	}
+
+	return 0;
+}
+
+
+void FNdiMediaMetadataSampler::Stop()
+{
+	Stopping = true;
+}
+
+
+/* FNdiMediaMetadataSampler implementation
+ *****************************************************************************/
+
+bool FNdiMediaMetadataSampler::SampleMetadata(uint32 Timeout)
+{
+	// the lock is held while capturing, so that the receiver
+	// cannot be destroyed while the capture call is blocking
+	FScopeLock Lock(&CriticalSection);
+
+	if (ReceiverInstance == nullptr)
+	{
+		return false;
+	}
+
+	// fetch metadata frame
+	NDIlib_metadata_frame_t MetadataFrame;
+	{
+		NDIlib_frame_type_e FrameType = Backend->RecvCapture(ReceiverInstance, nullptr, nullptr, &MetadataFrame, Timeout);
+
+		if (FrameType == NDIlib_frame_type_error)
+		{
+			UE_LOG(LogNdiMedia, Verbose, TEXT("Failed to receive metadata frame"));
+			return true;
+		}
+
+		if (FrameType != NDIlib_frame_type_metadata)
+		{
+			return true;
+		}
+	}
+
+	// forward frame to listener
+	FrameDelegate.ExecuteIfBound(MetadataFrame);
+	Backend->RecvFreeMetadata(ReceiverInstance, MetadataFrame);
+
+	return true;
+}
@@ -0,0 +1,96 @@
+// Copyright 1998-2016 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+
+
+class INdiMediaBackend;
+
+struct NDIlib_metadata_frame_t;
+
+
+/** Delegate that is executed when a new metadata frame has been received. */
+DECLARE_DELEGATE_OneParam(FOnNdiMediaMetadataSamplerFrame, const NDIlib_metadata_frame_t& /*MetadataFrame*/);
+
+
+/**
+ * Low-latency thread that captures metadata frames from an NDI receiver.
+ *
+ * This sampler is used for metadata-only receivers, which may carry high-rate
+ * data, such as camera tracking, that should not be throttled to the engine's
+ * tick rate. Frames are forwarded as soon as they arrive.
+ */
+class FNdiMediaMetadataSampler
+	: public FRunnable
+{
+public:
+
+	/** Default constructor. */
+	FNdiMediaMetadataSampler();
+
+	/** Destructor. */
+	virtual ~FNdiMediaMetadataSampler();
+
+public:
+
+	/**
+	 * Get a delegate that is executed when a new metadata frame has been received.
+	 *
+	 * @return The delegate.
+	 */
+	FOnNdiMediaMetadataSamplerFrame& OnFrame()
+	{
+		return FrameDelegate;
+	}
+
+	/**
+	 * Set the receiver instance.
+	 *
+	 * The sampler thread is created the first time a receiver is set.
+	 *
+	 * @param InBackend The backend that the receiver was created on.
+	 * @param InReceiverInstance The receiver instance to sample, or nullptr to suspend sampling.
+	 */
+	void SetReceiverInstance(const TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe>& InBackend, void* InReceiverInstance);
+
+public:
+
+	//~ FRunnable interface
+
+	virtual bool Init() override;
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	virtual void Exit() override { }
+
+protected:
+
+	/**
+	 * Sample the next metadata frame.
+	 *
+	 * @param Timeout How long to wait for a frame (in milliseconds).
+	 * @return true if a receiver was available, false otherwise.
+	 */
+	bool SampleMetadata(uint32 Timeout);
+
+private:
+
+	/** The backend that the current receiver was created on. */
+	TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> Backend;
+
+	/** Critical section for synchronizing access to receiver. */
+	FCriticalSection CriticalSection;
+
+	/** Delegate that is executed when a new metadata frame has been received. */
+	FOnNdiMediaMetadataSamplerFrame FrameDelegate;
+
+	/** The current receiver instance. */
+	void* ReceiverInstance;
+
+	/** Holds a flag indicating that the thread is stopping. */
+	bool Stopping;
+
+	/** Holds the thread object. */
+	FRunnableThread* Thread;
+};
@@ -3,17 +3,33 @@
 #include "NdiMediaPlayer.h"
 #include "NdiMediaPrivate.h"
 
-#include "HAL/PlatformProcess.h"
 #include "IMediaAudioSink.h"
 #include "IMediaBinarySink.h"
 #include "IMediaOptions.h"
 #include "IMediaTextureSink.h"
+#include "INdiMediaBackend.h"
+#include "HAL/FileManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
 #include "Misc/ScopeLock.h"
+#include "Ndi.h"
 #include "NdiMediaAudioSampler.h"
-#include "NdiMediaSettings.h"
+#include "NdiMediaColorConverter.h"
+#include "NdiMediaConnectionMetadata.h"
+#include "NdiMediaConnectionMonitor.h"
+#include "NdiMediaDeinterlacer.h"
+#include "NdiMediaFailover.h"
+#include "NdiMediaMetadataSampler.h"
+#include "NdiMediaMultiviewCompositor.h"
+#include "NdiMediaRecorder.h"
+#include "NdiMediaRecordingFrames.h"
+#include "NdiMediaRecordingReader.h"
+#include "NdiMediaTimeShiftBuffer.h"
 #include "NdiMediaSource.h"
+#include "NdiMediaSyncGroup.h"
+#include "NdiMediaTally.h"
+#include "NdiMediaVideoResizer.h"
 #include "UObject/Class.h"
-#include "UObject/UObjectGlobals.h"
 #include "UObject/WeakObjectPtr.h"
 
 #include "NdiMediaAllowPlatformTypes.h"
@@ -22,6 +38,13 @@
 #define LOCTEXT_NAMESPACE "FNdiMediaPlayer"
 
 
+namespace NdiMediaPlayer
+{
+	/** Highest playback rate of recordings and time-shifted streams (in either direction). */
+	static const float MaxPlaybackRate = 16.0f;
+}
+
+
 /* FNdiVideoPlayer structors
  *****************************************************************************/
 
@@ -33,17 +56,45 @@ FNdiMediaPlayer::FNdiMediaPlayer()
 	, SelectedMetadataTrack(INDEX_NONE)
 	, SelectedVideoTrack(INDEX_NONE)
 	, AudioSampler(new FNdiMediaAudioSampler)
+	, ColorConverter(new FNdiMediaColorConverter)
+	, Connected(false)
 	, CurrentState(EMediaState::Closed)
+	, Deinterlacer(new FNdiMediaDeinterlacer)
+	, Failover(new FNdiMediaFailover)
 	, LastAudioChannels(0)
 	, LastAudioSampleRate(0)
-	, LastBufferDim(FIntPoint::ZeroValue)
-	, LastVideoDim(FIntPoint::ZeroValue)
+	, LastReplayVideoFrame(INDEX_NONE)
+	, LastTimeShiftVideoTime(INDEX_NONE)
 	, LastVideoFrameRate(0.0f)
+	, Looping(false)
+	, MetadataOnly(false)
+	, MetadataSampler(new FNdiMediaMetadataSampler)
+	, Multiview(new FNdiMediaMultiviewCompositor)
+	, OpenDuration(0.0)
 	, Paused(false)
+	, PendingTimeShiftSeek(false)
+	, PlaybackRate(1.0f)
+	, ReceiverCreateDuration(0.0)
 	, ReceiverInstance(nullptr)
-	, VideoSinkFormat(EMediaTextureSinkFormat::CharUYVY)
+	, Recorder(new FNdiMediaRecorder)
+	, ReplayCursor(0)
+	, ReplayEnded(false)
+	, Replaying(false)
+	, ReplayReader(new FNdiMediaRecordingReader)
+	, ReplayTime(FTimespan::Zero())
+	, Resizer(new FNdiMediaVideoResizer)
+	, SentTally(INDEX_NONE)
+	, SyncGroupMemberId(INDEX_NONE)
+	, TallyMode(ENdiMediaTallyMode::Automatic)
+	, TimeShiftBuffer(new FNdiMediaTimeShiftBuffer)
+	, TimeShifted(false)
+	, TimeShiftPosition(0)
+	, UnsupportedFourCC(0)
+	, VideoSinkInitialized(false)
+	, VideoSinkReinitializations(0)
 {
 	AudioSampler->OnSamples().BindRaw(this, &FNdiMediaPlayer::HandleAudioSamplerSample);
+	MetadataSampler->OnFrame().BindRaw(this, &FNdiMediaPlayer::HandleMetadataSamplerFrame);
 }
 
 
@@ -54,6 +105,34 @@ FNdiMediaPlayer::~FNdiMediaPlayer()
 	AudioSampler->OnSamples().Unbind();
 	delete AudioSampler;
 	AudioSampler = nullptr;
+
+	MetadataSampler->OnFrame().Unbind();
+	delete MetadataSampler;
+	MetadataSampler = nullptr;
+
+	delete ColorConverter;
+	ColorConverter = nullptr;
+
+	delete Deinterlacer;
+	Deinterlacer = nullptr;
+
+	delete Failover;
+	Failover = nullptr;
+
+	delete Multiview;
+	Multiview = nullptr;
+
+	delete Recorder;
+	Recorder = nullptr;
+
+	delete ReplayReader;
+	ReplayReader = nullptr;
+
+	delete Resizer;
+	Resizer = nullptr;
+
+	delete TimeShiftBuffer;
+	TimeShiftBuffer = nullptr;
 }
 
 
@@ -62,6 +141,16 @@ FNdiMediaPlayer::~FNdiMediaPlayer()
 
 FTimespan FNdiMediaPlayer::GetDuration() const
 {
+	if (Replaying)
+	{
+		return ReplayReader->GetDuration();
+	}
+
+	if (TimeShiftBuffer->IsOpen())
+	{
+		return FTimespan(TimeShiftBuffer->GetNewestTime() - TimeShiftBuffer->GetOldestTime());
+	}
+
 	return FTimespan::Zero();
 //	return (CurrentState == EMediaState::Playing) ? FTimespan::MaxValue() : FTimespan::Zero();
 }
@@ -69,7 +158,12 @@ FTimespan FNdiMediaPlayer::GetDuration() const
 
 float FNdiMediaPlayer::GetRate() const
 {
-	return (CurrentState == EMediaState::Playing) ? 1.0f : 0.0f;
+	if (CurrentState != EMediaState::Playing)
+	{
+		return 0.0f;
+	}
+
+	return IsSeekable() ? PlaybackRate : 1.0f;
 }
 
 
@@ -81,12 +175,34 @@ EMediaState FNdiMediaPlayer::GetState() const
 
 TRange<float> FNdiMediaPlayer::GetSupportedRates(EMediaPlaybackDirections Direction, bool Unthinned) const
 {
-	return TRange<float>(1.0f);
+	if (!IsSeekable() || Unthinned)
+	{
+		return (Direction == EMediaPlaybackDirections::Forward) ? TRange<float>(1.0f) : TRange<float>::Empty();
+	}
+
+	// recordings and time-shifted streams play at other rates by skipping video frames and audio
+	if (Direction == EMediaPlaybackDirections::Forward)
+	{
+		return TRange<float>::Inclusive(0.0f, NdiMediaPlayer::MaxPlaybackRate);
+	}
+
+	return TRange<float>::Inclusive(-NdiMediaPlayer::MaxPlaybackRate, 0.0f);
 }
 
 
 FTimespan FNdiMediaPlayer::GetTime() const
 {
+	if (Replaying)
+	{
+		return ReplayTime;
+	}
+
+	if (TimeShiftBuffer->IsOpen())
+	{
+		const int64 OldestTime = TimeShiftBuffer->GetOldestTime();
+		return FTimespan((TimeShifted ? FMath::Max(TimeShiftPosition, OldestTime) : TimeShiftBuffer->GetNewestTime()) - OldestTime);
+	}
+
 	return FTimespan::Zero();
 //	return (CurrentState == EMediaState::Playing) ? FTimespan::MaxValue() : FTimespan::Zero();
 }
@@ -94,19 +210,36 @@ FTimespan FNdiMediaPlayer::GetTime() const
 
 bool FNdiMediaPlayer::IsLooping() const
 {
-	return false; // not supported
+	return Replaying && Looping; // live streams don't loop
 }
 
 
 bool FNdiMediaPlayer::Seek(const FTimespan& Time)
 {
-	return false; // not supported
+	if (Replaying)
+	{
+		SeekReplay(Time);
+	}
+	else if (TimeShiftBuffer->IsOpen())
+	{
+		SeekTimeShift(TimeShiftBuffer->GetOldestTime() + Time.GetTicks());
+	}
+	else
+	{
+		return false; // not supported
+	}
+
+	MediaEvent.Broadcast(EMediaEvent::SeekCompleted);
+
+	return true;
 }
 
 
-bool FNdiMediaPlayer::SetLooping(bool Looping)
+bool FNdiMediaPlayer::SetLooping(bool InLooping)
 {
-	return false; // not supported
+	Looping = InLooping;
+
+	return true;
 }
 
 
@@ -114,36 +247,72 @@ bool FNdiMediaPlayer::SetRate(float Rate)
 {
 	if (Rate == 0.0f)
 	{
+		// live streams continue to be buffered while paused
+		if (TimeShiftBuffer->IsOpen() && !TimeShifted)
+		{
+			StartTimeShift();
+		}
+
 		Paused = true;
+
+		return true;
 	}
-	else if (Rate == 1.0f)
+
+	if (!SupportsRate(Rate, false))
 	{
-		Paused = false;
+		return false;
 	}
-	else
+
+	if (IsSeekable())
 	{
-		return false;
+		// resume from the end after a change of direction
+		if ((Rate > 0.0f) != (PlaybackRate > 0.0f))
+		{
+			ReplayEnded = false;
+		}
+
+		// audio is only played at normal speed
+		if ((Rate != 1.0f) && (AudioSink != nullptr))
+		{
+			FScopeLock Lock(&CriticalSection);
+			AudioSink->FlushAudioSink();
+		}
+
+		// other rates are played from the time-shift buffer, starting at the live edge
+		if ((Rate != 1.0f) && TimeShiftBuffer->IsOpen() && !TimeShifted)
+		{
+			StartTimeShift();
+		}
+
+		PlaybackRate = Rate;
 	}
 
+	Paused = false;
+
 	return true;
 }
 
 
 bool FNdiMediaPlayer::SupportsRate(float Rate, bool Unthinned) const
 {
+	if (IsSeekable() && !Unthinned)
+	{
+		return (FMath::Abs(Rate) <= NdiMediaPlayer::MaxPlaybackRate);
+	}
+
 	return (Rate == 1.0f);
 }
 
 
 bool FNdiMediaPlayer::SupportsScrubbing() const
 {
-	return false; // not supported
+	return IsSeekable(); // live streams can only be scrubbed within the time-shift buffer
 }
 
 
 bool FNdiMediaPlayer::SupportsSeeking() const
 {
-	return false; // not supported
+	return IsSeekable(); // live streams can only be seeked within the time-shift buffer
 }
 
 
@@ -152,23 +321,83 @@ bool FNdiMediaPlayer::SupportsSeeking() const
 
 void FNdiMediaPlayer::Close()
 {
+	// detach sampler threads before the receiver goes away
+	AudioSampler->SetReceiverInstance(nullptr, nullptr);
+	MetadataSampler->SetReceiverInstance(nullptr, nullptr);
+
+	Recorder->Close();
+	TimeShiftBuffer->Close();
+
 	{
 		FScopeLock Lock(&CriticalSection);
 
+		// the sync group holds frames of the receiver
+		if (SyncGroup.IsValid())
+		{
+			SyncGroup->RemoveMember(SyncGroupMemberId);
+			SyncGroup.Reset();
+			SyncGroupMemberId = INDEX_NONE;
+		}
+
+		Failover->Close();
+
+		// a receiver that is still being created is destroyed by the monitor
+		if (PendingOpen.Request.IsValid())
+		{
+			ConnectionMonitor->CancelReceiverRequest(PendingOpen.Request.ToSharedRef());
+		}
+
+		PendingOpen = FPendingOpen();
+
+		if (ConnectionWatch.IsValid())
+		{
+			ConnectionMonitor->RemoveReceiver(ConnectionWatch.ToSharedRef());
+			ConnectionWatch.Reset();
+		}
+
+		// tearing down the connection may block, so the receiver is destroyed on the monitor thread
 		if (ReceiverInstance != nullptr)
 		{
-			NDIlib_recv_destroy(ReceiverInstance);
+			ConnectionMonitor->RetireReceiver(Backend.ToSharedRef(), ReceiverInstance);
 			ReceiverInstance = nullptr;
 		}
 
+		ConnectionMonitor.Reset();
+
+		Multiview->Close();
+		Backend.Reset();
+
+		if (Replaying)
+		{
+			ReplayReader->Close();
+			Replaying = false;
+		}
+
+		LastReplayVideoFrame = INDEX_NONE;
+		LastTimeShiftVideoTime = INDEX_NONE;
+		PendingTimeShiftSeek = false;
+		ReplayCursor = 0;
+		ReplayEnded = false;
+		PlaybackRate = 1.0f;
+		ReplayTime = FTimespan::Zero();
+		TimeShifted = false;
+		TimeShiftPosition = 0;
+
+		Connected = false;
 		CurrentState = EMediaState::Closed;
 		CurrentUrl.Empty();
+		ColorConverter->Reset();
+		Deinterlacer->Reset();
+		Resizer->Reset();
 
 		LastAudioChannels = 0;
 		LastAudioSampleRate = 0;
-		LastBufferDim = FIntPoint::ZeroValue;
-		LastVideoDim = FIntPoint::ZeroValue;
+		LastVideoFormat = FNdiMediaVideoFormat();
 		LastVideoFrameRate = 0.0f;
+		MetadataOnly = false;
+		SentTally = INDEX_NONE;
+		TallyMode = ENdiMediaTallyMode::Automatic;
+		UnsupportedFourCC = 0;
 
 		SelectedAudioTrack = INDEX_NONE;
 		SelectedMetadataTrack = INDEX_NONE;
@@ -190,7 +419,33 @@ IMediaControls& FNdiMediaPlayer::GetControls()
 
 FString FNdiMediaPlayer::GetInfo() const
 {
-	return FString(); // @todo gmp: implement NDI info
+	if (!HasMedia())
+	{
+		return FString();
+	}
+
+	FString Info;
+	{
+		Info += FString::Printf(TEXT("Source: %s\n"), *CurrentUrl);
+		Info += TEXT("\n");
+
+		if (!MetadataOnly)
+		{
+			Info += TEXT("Video\n");
+			Info += FString::Printf(TEXT("    Dimensions: %i x %i\n"), LastVideoFormat.OutputDim.X, LastVideoFormat.OutputDim.Y);
+			Info += FString::Printf(TEXT("    Aspect Ratio: %.3f\n"), LastVideoFormat.AspectRatio);
+			Info += FString::Printf(TEXT("    Frame Rate: %.3f\n"), LastVideoFrameRate);
+			Info += FString::Printf(TEXT("    FourCC: %s\n"), *FNdiMediaVideoFormat::GetFourCCName(LastVideoFormat.FourCC));
+			Info += TEXT("\n");
+
+			Info += TEXT("Audio\n");
+			Info += FString::Printf(TEXT("    Channels: %i\n"), LastAudioChannels);
+			Info += FString::Printf(TEXT("    Sample Rate: %i Hz\n"), LastAudioSampleRate);
+			Info += TEXT("\n");
+		}
+	}
+
+	return Info;
 }
 
 
@@ -209,11 +464,15 @@ IMediaOutput& FNdiMediaPlayer::GetOutput()
 
 FString FNdiMediaPlayer::GetStats() const
 {
-	NDIlib_recv_performance_t PerfDropped, PerfTotal;
-	NDIlib_recv_get_performance(ReceiverInstance, &PerfTotal, &PerfDropped);
+	NDIlib_recv_performance_t PerfDropped = { 0 };
+	NDIlib_recv_performance_t PerfTotal = { 0 };
+	NDIlib_recv_queue_t Queue = { 0 };
 
-	NDIlib_recv_queue_t Queue;
-	NDIlib_recv_get_queue(ReceiverInstance, &Queue);
+	if (ReceiverInstance != nullptr)
+	{
+		Backend->RecvGetPerformance(ReceiverInstance, PerfTotal, PerfDropped);
+		Backend->RecvGetQueue(ReceiverInstance, Queue);
+	}
 
 	FString StatsString;
 	{
@@ -234,6 +493,193 @@ FString FNdiMediaPlayer::GetStats() const
 		StatsString += FString::Printf(TEXT("    Video: %i\n"), Queue.m_video_frames);
 		StatsString += FString::Printf(TEXT("    Metadata: %i\n"), Queue.m_metadata_frames);
 		StatsString += TEXT("\n");
+
+		const FNdiMediaStageStats& DeinterlaceStats = Deinterlacer->GetStats();
+
+		StatsString += TEXT("Deinterlacing\n");
+		StatsString += FString::Printf(TEXT("    Mode: %s\n"), *GetDeinterlaceModeName(Deinterlacer->GetMode()));
+		StatsString += FString::Printf(TEXT("    Frames: %llu\n"), DeinterlaceStats.Count);
+		StatsString += FString::Printf(TEXT("    Average: %.3f ms\n"), DeinterlaceStats.GetAverageMs());
+		StatsString += FString::Printf(TEXT("    Last: %.3f ms\n"), DeinterlaceStats.GetLastMs());
+		StatsString += TEXT("\n");
+
+		const FNdiMediaStageStats& ConversionStats = ColorConverter->GetStats();
+
+		StatsString += TEXT("Color Conversion\n");
+		StatsString += FString::Printf(TEXT("    Instruction Set: %s\n"), NdiMediaVideo::GetInstructionSetName(ColorConverter->GetInstructionSet()));
+		StatsString += FString::Printf(TEXT("    Matrix: %s\n"), *ColorConverter->GetMatrixName());
+		StatsString += FString::Printf(TEXT("    Frames: %llu\n"), ConversionStats.Count);
+		StatsString += FString::Printf(TEXT("    Average: %.3f ms\n"), ConversionStats.GetAverageMs());
+		StatsString += FString::Printf(TEXT("    Last: %.3f ms\n"), ConversionStats.GetLastMs());
+		StatsString += TEXT("\n");
+
+		const FNdiMediaStageStats& ResizeStats = Resizer->GetStats();
+
+		StatsString += TEXT("Resizing\n");
+		StatsString += FString::Printf(TEXT("    Max Size: %i x %i\n"), Resizer->GetMaxSize().X, Resizer->GetMaxSize().Y);
+		StatsString += FString::Printf(TEXT("    Frames: %llu\n"), ResizeStats.Count);
+		StatsString += FString::Printf(TEXT("    Average: %.3f ms\n"), ResizeStats.GetAverageMs());
+		StatsString += FString::Printf(TEXT("    Last: %.3f ms\n"), ResizeStats.GetLastMs());
+		StatsString += TEXT("\n");
+
+		StatsString += TEXT("Video Capture\n");
+		StatsString += FString::Printf(TEXT("    Frames: %llu\n"), VideoCaptureStats.Count);
+		StatsString += FString::Printf(TEXT("    Average: %.3f ms\n"), VideoCaptureStats.GetAverageMs());
+		StatsString += FString::Printf(TEXT("    Last: %.3f ms\n"), VideoCaptureStats.GetLastMs());
+		StatsString += TEXT("\n");
+
+		StatsString += TEXT("Audio Conversion\n");
+		StatsString += FString::Printf(TEXT("    Frames: %llu\n"), AudioConversionStats.Count);
+		StatsString += FString::Printf(TEXT("    Average: %.3f ms\n"), AudioConversionStats.GetAverageMs());
+		StatsString += FString::Printf(TEXT("    Last: %.3f ms\n"), AudioConversionStats.GetLastMs());
+		StatsString += TEXT("\n");
+
+		StatsString += TEXT("Video Sink\n");
+		StatsString += FString::Printf(TEXT("    Buffer: %i x %i\n"), VideoSinkFormat.BufferDim.X, VideoSinkFormat.BufferDim.Y);
+		StatsString += FString::Printf(TEXT("    Output: %i x %i\n"), VideoSinkFormat.OutputDim.X, VideoSinkFormat.OutputDim.Y);
+		StatsString += FString::Printf(TEXT("    Reinitializations: %u\n"), VideoSinkReinitializations);
+		StatsString += FString::Printf(TEXT("    Average Upload: %.3f ms\n"), VideoUploadStats.GetAverageMs());
+		StatsString += TEXT("\n");
+
+		if (Replaying)
+		{
+			StatsString += TEXT("Replay\n");
+			StatsString += FString::Printf(TEXT("    Source: %s\n"), *ReplayReader->GetSourceName());
+			StatsString += FString::Printf(TEXT("    Access: %s\n"), ReplayReader->IsMapped() ? TEXT("Memory Mapped") : TEXT("Loaded"));
+			StatsString += FString::Printf(TEXT("    Frames: %i\n"), ReplayReader->GetNumFrames());
+			StatsString += FString::Printf(TEXT("    Position: %s / %s\n"), *ReplayTime.ToString(), *ReplayReader->GetDuration().ToString());
+			StatsString += FString::Printf(TEXT("    Rate: %.2f\n"), PlaybackRate);
+			StatsString += TEXT("\n");
+		}
+
+		if (SyncGroup.IsValid())
+		{
+			StatsString += FString::Printf(TEXT("Sync Group: %s\n"), *SyncGroup->GetName());
+
+			for (const FNdiMediaSyncMemberStats& MemberStats : SyncGroup->GetStats())
+			{
+				StatsString += FString::Printf(TEXT("    %s: %+.2f ms%s, %llu presented, %llu repeated, %llu dropped\n"),
+					*MemberStats.Name,
+					MemberStats.Offset / (double)ETimespan::TicksPerMillisecond,
+					MemberStats.Lagging ? TEXT(" (lagging)") : TEXT(""),
+					MemberStats.NumPresented,
+					MemberStats.NumRepeated,
+					MemberStats.NumDropped
+				);
+			}
+
+			StatsString += TEXT("\n");
+		}
+
+		if (ReceiverInstance != nullptr)
+		{
+			StatsString += TEXT("Open\n");
+			StatsString += FString::Printf(TEXT("    Time to Open: %.1f ms\n"), OpenDuration * 1000.0);
+			StatsString += FString::Printf(TEXT("    Receiver Creation: %.1f ms\n"), ReceiverCreateDuration * 1000.0);
+			StatsString += TEXT("\n");
+		}
+		else if (PendingOpen.Request.IsValid())
+		{
+			StatsString += TEXT("Open\n");
+			StatsString += FString::Printf(TEXT("    Pending: %.1f ms\n"), (FPlatformTime::Seconds() - PendingOpen.RequestTime) * 1000.0);
+			StatsString += TEXT("\n");
+		}
+
+		if (ReceiverInstance != nullptr)
+		{
+			StatsString += TEXT("Tally\n");
+			StatsString += FString::Printf(TEXT("    Mode: %s\n"), *GetTallyModeName(TallyMode));
+			StatsString += FString::Printf(TEXT("    Preview: %s\n"), ((SentTally != INDEX_NONE) && ((SentTally & 1) != 0)) ? TEXT("Yes") : TEXT("No"));
+			StatsString += FString::Printf(TEXT("    Program: %s\n"), ((SentTally != INDEX_NONE) && ((SentTally & 2) != 0)) ? TEXT("Yes") : TEXT("No"));
+			StatsString += TEXT("\n");
+		}
+
+		if (ConnectionWatch.IsValid())
+		{
+			StatsString += TEXT("Connection\n");
+			StatsString += FString::Printf(TEXT("    Connected: %s\n"), Connected ? TEXT("Yes") : TEXT("No"));
+			StatsString += FString::Printf(TEXT("    Reconnects: %i\n"), ConnectionWatch->GetNumReconnects());
+			StatsString += FString::Printf(TEXT("    Poll Interval: %.2f s\n"), ConnectionMonitor->GetPollInterval());
+			StatsString += TEXT("\n");
+		}
+
+		if (Failover->IsOpen())
+		{
+			const FNdiMediaFailoverStats FailoverStats = Failover->GetStats();
+
+			StatsString += TEXT("Failover\n");
+			StatsString += FString::Printf(TEXT("    Active: %s (score %.2f, %.1f%% dropped, %i queued%s)\n"),
+				*FailoverStats.ActiveSource,
+				FailoverStats.ActiveHealth.Score,
+				FailoverStats.ActiveHealth.DropRate * 100.0f,
+				FailoverStats.ActiveHealth.QueueDepth,
+				FailoverStats.ActiveHealth.Stalled ? TEXT(", stalled") : TEXT("")
+			);
+
+			if (FailoverStats.StandbySource.IsEmpty())
+			{
+				StatsString += TEXT("    Standby: None\n");
+			}
+			else
+			{
+				StatsString += FString::Printf(TEXT("    Standby: %s (score %.2f, %.1f%% dropped, %i queued%s)\n"),
+					*FailoverStats.StandbySource,
+					FailoverStats.StandbyHealth.Score,
+					FailoverStats.StandbyHealth.DropRate * 100.0f,
+					FailoverStats.StandbyHealth.QueueDepth,
+					FailoverStats.StandbyHealth.Stalled ? TEXT(", stalled") : TEXT("")
+				);
+			}
+
+			StatsString += FString::Printf(TEXT("    Switches: %u\n"), FailoverStats.NumSwitches);
+			StatsString += TEXT("\n");
+		}
+
+		if (IsMultiview())
+		{
+			const FNdiMediaMultiviewStats MultiviewStats = Multiview->GetStats();
+			const FIntRect& DirtyRect = Multiview->GetDirtyRect();
+
+			StatsString += TEXT("Multiview\n");
+			StatsString += FString::Printf(TEXT("    Tiles: %i (%i connected)\n"), MultiviewStats.NumTiles, MultiviewStats.NumConnectedTiles);
+			StatsString += FString::Printf(TEXT("    Updated Tiles: %i\n"), MultiviewStats.NumUpdatedTiles);
+			StatsString += FString::Printf(TEXT("    Dirty Rect: %i x %i at %i, %i\n"), DirtyRect.Width(), DirtyRect.Height(), DirtyRect.Min.X, DirtyRect.Min.Y);
+			StatsString += FString::Printf(TEXT("    Tile Frames: %llu\n"), MultiviewStats.NumTileFrames);
+			StatsString += FString::Printf(TEXT("    Composites: %llu\n"), MultiviewStats.Composites.Count);
+			StatsString += FString::Printf(TEXT("    Average: %.3f ms\n"), MultiviewStats.Composites.GetAverageMs());
+			StatsString += FString::Printf(TEXT("    Last: %.3f ms\n"), MultiviewStats.Composites.GetLastMs());
+			StatsString += TEXT("\n");
+		}
+
+		if (TimeShiftBuffer->IsOpen())
+		{
+			const FNdiMediaTimeShiftStats TimeShiftStats = TimeShiftBuffer->GetStats();
+
+			StatsString += TEXT("Time Shift\n");
+			StatsString += FString::Printf(TEXT("    Buffered: %s (%i frames)\n"), *TimeShiftStats.Duration.ToString(), TimeShiftStats.NumFrames);
+			StatsString += FString::Printf(TEXT("    Delay: %s\n"), TimeShifted ? *FTimespan(TimeShiftBuffer->GetNewestTime() - TimeShiftPosition).ToString() : TEXT("Live"));
+			StatsString += FString::Printf(TEXT("    Memory: %.1f MB\n"), TimeShiftStats.MemoryUsed / (1024.0 * 1024.0));
+			StatsString += FString::Printf(TEXT("    Slabs: %i in memory, %i spilled, %i pending\n"), TimeShiftStats.NumSlabs, TimeShiftStats.NumSpilledSlabs, TimeShiftStats.NumPendingSpills);
+			StatsString += FString::Printf(TEXT("    Discarded Frames: %llu\n"), TimeShiftStats.NumDiscardedFrames);
+			StatsString += FString::Printf(TEXT("    Average Spill Write: %.3f ms\n"), TimeShiftStats.SpillWrites.GetAverageMs());
+			StatsString += FString::Printf(TEXT("    Average Spill Read: %.3f ms\n"), TimeShiftStats.SpillReads.GetAverageMs());
+			StatsString += TEXT("\n");
+		}
+
+		if (Recorder->IsOpen())
+		{
+			const FNdiMediaRecorderStats RecorderStats = Recorder->GetStats();
+
+			StatsString += TEXT("Recording\n");
+			StatsString += FString::Printf(TEXT("    File: %s\n"), *Recorder->GetFilePath());
+			StatsString += FString::Printf(TEXT("    I/O: %s\n"), RecorderStats.Unbuffered ? TEXT("Unbuffered") : TEXT("Buffered"));
+			StatsString += FString::Printf(TEXT("    Frames: %llu\n"), RecorderStats.NumFrames);
+			StatsString += FString::Printf(TEXT("    Dropped: %llu\n"), RecorderStats.NumDroppedFrames);
+			StatsString += FString::Printf(TEXT("    Written: %.1f MB\n"), RecorderStats.BytesWritten / (1024.0 * 1024.0));
+			StatsString += FString::Printf(TEXT("    Pending Chunks: %i\n"), RecorderStats.NumPendingChunks);
+			StatsString += FString::Printf(TEXT("    Average Write: %.3f ms\n"), RecorderStats.Writes.GetAverageMs());
+			StatsString += TEXT("\n");
+		}
 	}
 
 	return StatsString;
@@ -256,191 +702,187 @@ bool FNdiMediaPlayer::Open(const FString& Url, const IMediaOptions& Options)
 {
 	Close();
 
+	if (Url.StartsWith(TEXT("file://")))
+	{
+		return OpenReplay(Url, nullptr, Options);
+	}
+
+	if (Url.StartsWith(TEXT("ndimv://")))
+	{
+		return OpenMultiview(Url, Options);
+	}
+
 	if (Url.IsEmpty() || !Url.StartsWith(TEXT("ndi://")))
 	{
 		return false;
 	}
 
-	FString SourceStr = Url.RightChop(6);
+	const FString SourceStr = Url.RightChop(6);
 
-	// determine sink format
-	auto ColorFormat = (NDIlib_recv_color_format_e)Options.GetMediaOption(NdiMedia::ColorFormatOption, 0LL);
+	// determine initial sink format (the actual format is negotiated per frame)
+	int64 ColorFormat = Options.GetMediaOption(NdiMedia::ColorFormatOption, (int64)NDIlib_recv_color_format_e_UYVY_BGRA);
 
-	if (ColorFormat == NDIlib_recv_color_format_e_BGRX_BGRA)
+	if ((ColorFormat == NDIlib_recv_color_format_e_BGRX_BGRA) || (ColorFormat == NDIlib_recv_color_format_e_RGBX_RGBA))
 	{
-		VideoSinkFormat = EMediaTextureSinkFormat::CharBGRA;
+		LastVideoFormat.SinkFormat = EMediaTextureSinkFormat::CharBGRA;
 	}
-	else if (ColorFormat == NDIlib_recv_color_format_e_UYVY_BGRA)
+	else if ((ColorFormat == NDIlib_recv_color_format_e_UYVY_BGRA) ||
+		(ColorFormat == NDIlib_recv_color_format_e_UYVY_RGBA) ||
+		(ColorFormat == NdiMedia::RecvColorFormatFastest))
 	{
-		VideoSinkFormat = EMediaTextureSinkFormat::CharUYVY;
+		LastVideoFormat.SinkFormat = EMediaTextureSinkFormat::CharUYVY;
 	}
 	else
 	{
 		UE_LOG(LogNdiMedia, Warning, TEXT("Unsupported ColorFormat option in media source %s. Falling back to UYVY."), *SourceStr);
 
 		ColorFormat = NDIlib_recv_color_format_e_UYVY_BGRA;
-		VideoSinkFormat = EMediaTextureSinkFormat::CharUYVY;
+		LastVideoFormat.SinkFormat = EMediaTextureSinkFormat::CharUYVY;
 	}
 
-	// create receiver
+	// request receiver
 	int64 Bandwidth = Options.GetMediaOption(NdiMedia::BandwidthOption, (int64)NDIlib_recv_bandwidth_highest);
-
-	NDIlib_source_t Source;
-	{
-		if (SourceStr.Find(TEXT(":")) != INDEX_NONE)
-		{
-			Source.p_ip_address = TCHAR_TO_ANSI(*SourceStr);
-			Source.p_ndi_name = nullptr;
-		}
-		else
-		{
-			if (SourceStr.StartsWith(TEXT("localhost ")))
-			{
-				SourceStr.ReplaceInline(TEXT("localhost"), FPlatformProcess::ComputerName());
-			}
-
-			Source.p_ip_address = nullptr;
-			Source.p_ndi_name = TCHAR_TO_ANSI(*SourceStr);
-		}
-	}
+	MetadataOnly = (Bandwidth == NDIlib_recv_bandwidth_metadata_only);
 
 	NDIlib_recv_create_t RcvCreateDesc;
 	{
-		RcvCreateDesc.source_to_connect_to = Source;
-		RcvCreateDesc.color_format = ColorFormat;
+		RcvCreateDesc.color_format = (NDIlib_recv_color_format_e)ColorFormat;
 		RcvCreateDesc.bandwidth = (NDIlib_recv_bandwidth_e)Bandwidth;
 		RcvCreateDesc.allow_video_fields = true;
 	};
 
 	FScopeLock Lock(&CriticalSection);
 
-	ReceiverInstance = NDIlib_recv_create_v2(&RcvCreateDesc);
-
-	if (ReceiverInstance == nullptr)
-	{
-		UE_LOG(LogNdiMedia, Error, TEXT("Failed to open NDI media source %s: couldn't create receiver"), *SourceStr);
-
-		return false;
-	}
+	InitializeProcessing(Options);
 
-	// send product metadata
-	auto Settings = GetDefault<UNdiMediaSettings>();
+	// connection metadata is encoded once per settings revision and format
+	const TSharedRef<const FNdiMediaConnectionMetadata, ESPMode::ThreadSafe> ConnectionMetadata = FNdiMediaConnectionMetadata::Get(Options);
 
-	SendMetadata(
-		FString::Printf(TEXT("<ndi_product short_name=\"%s\" long_name=\"%s\" manufacturer=\"%s\" version=\"%s\" serial_number=\"%s\" session_name=\"%s\" />"),
-			*Settings->ProductName,
-			*Settings->ProductDescription,
-			*Settings->Manufacturer,
-			*Settings->GetVersionName(),
-			*Settings->SerialNumber,
-			*Settings->SessionName
-	));
+	// finalize
+	CurrentState = EMediaState::Preparing;
+	CurrentUrl = Url;
 
-	// send format metadata
-	FString AudioFormatString;
-	FString VideoFormatString;
+	const int64 TimeShiftDuration = Options.GetMediaOption(NdiMedia::TimeShiftDurationOption, (int64)0);
 
-	const int64 AudioChannels = Options.GetMediaOption(NdiMedia::AudioChannelsOption, (int64)0);
-	
-	if (AudioChannels > 0)
+	if (TimeShiftDuration > 0)
 	{
-		AudioFormatString += FString::Printf(TEXT(" no_channels=\"%i\""), AudioChannels);
+		FNdiMediaTimeShiftSettings TimeShiftSettings;
+		{
+			TimeShiftSettings.Duration = FTimespan::FromSeconds(TimeShiftDuration);
+			TimeShiftSettings.MemoryBudget = (uint64)Options.GetMediaOption(NdiMedia::TimeShiftMemoryBudgetOption, (int64)512) * 1024 * 1024;
+			TimeShiftSettings.SpillDirectory = Options.GetMediaOption(NdiMedia::TimeShiftSpillDirectoryOption, FString());
+		}
+
+		TimeShiftBuffer->Open(TimeShiftSettings);
 	}
 
-	const int64 AudioSampleRate = Options.GetMediaOption(NdiMedia::AudioSampleRateOption, (int64)0);
+	const FString SyncGroupName = Options.GetMediaOption(NdiMedia::SyncGroupOption, FString());
 
-	if (AudioSampleRate > 0)
+	if (!SyncGroupName.IsEmpty() && !MetadataOnly)
 	{
-		AudioFormatString += FString::Printf(TEXT(" sample_rate=\"%i\""), AudioSampleRate);
+		SyncGroup = FNdiMediaSyncGroup::FindOrAdd(SyncGroupName);
 	}
 
-	const int64 FrameRateD = Options.GetMediaOption(NdiMedia::FrameRateDOption, (int64)0);
+	TallyMode = (ENdiMediaTallyMode)Options.GetMediaOption(NdiMedia::TallyModeOption, (int64)ENdiMediaTallyMode::Automatic);
 
-	if (FrameRateD > 0)
+	const FString BackupSources = Options.GetMediaOption(NdiMedia::BackupSourcesOption, FString());
+
+	if (!BackupSources.IsEmpty() && !MetadataOnly)
 	{
-		VideoFormatString += FString::Printf(TEXT(" frame_rate_d=\"%i\""), FrameRateD);
+		BackupSources.ParseIntoArray(PendingOpen.FailoverSources, TEXT("|"), true);
+		PendingOpen.FailoverSources.Insert(SourceStr, 0);
 	}
 
-	const int64 FrameRateN = Options.GetMediaOption(NdiMedia::FrameRateDOption, (int64)0);
+	// creating the receiver and sending metadata may block, so the remaining work is done in FinishOpen
+	ConnectionMonitor = FNdiMediaConnectionMonitor::Get();
 
-	if (FrameRateN > 0)
-	{
-		VideoFormatString += FString::Printf(TEXT(" frame_rate_n=\"%i\""), FrameRateN);
-	}
+	PendingOpen.RecordingDirectory = Options.GetMediaOption(NdiMedia::RecordingDirectoryOption, FString());
+	PendingOpen.Request = ConnectionMonitor->RequestReceiver(SourceStr, RcvCreateDesc, ConnectionMetadata);
+	PendingOpen.RequestTime = FPlatformTime::Seconds();
 
-	const FString Progressive = Options.GetMediaOption(NdiMedia::ProgressiveOption, FString());
+	return true;
+}
 
-	if (!Progressive.IsEmpty())
-	{
-		VideoFormatString += FString::Printf(TEXT(" progressive=\"%s\""), *Progressive);
-	}
 
-	const int64 VideoHeight = Options.GetMediaOption(NdiMedia::VideoHeightOption, (int64)0);
+bool FNdiMediaPlayer::Open(const TSharedRef<FArchive, ESPMode::ThreadSafe>& Archive, const FString& OriginalUrl, const IMediaOptions& Options)
+{
+	Close();
+
+	return OpenReplay(OriginalUrl, &Archive.Get(), Options);
+}
+
 
-	if (VideoHeight > 0)
+void FNdiMediaPlayer::TickPlayer(float DeltaTime)
+{
+	if (PendingOpen.Request.IsValid())
 	{
-		VideoFormatString += FString::Printf(TEXT(" yres=\"%i\""), VideoHeight);
+		if (!PendingOpen.Request->IsComplete())
+		{
+			return;
+		}
+
+		FinishOpen();
 	}
+	else if (Multiview->IsOpening())
+	{
+		Multiview->TakeReceivers();
 
-	const int64 VideoWidth = Options.GetMediaOption(NdiMedia::VideoWidthOption, (int64)0);
+		if (Multiview->IsOpening())
+		{
+			return;
+		}
 
-	if (VideoWidth > 0)
-	{
-		VideoFormatString += FString::Printf(TEXT(" xres=\"%i\""), VideoWidth);
+		FinishOpenMultiview();
 	}
 
-	if (!AudioFormatString.IsEmpty() || !VideoFormatString.IsEmpty())
+	if (!HasMedia())
 	{
-		SendMetadata(
-			FString::Printf(TEXT("<ndi_format><audio_format %s /><video_format %s /></ndi_format>"),
-				*AudioFormatString,
-				*VideoFormatString
-		));
+		return;
 	}
 
-	// send custom metadata
-	FString CustomMetadata = Settings->CustomMetaData;
+	// switch to a backup source or a recreated receiver before the state is updated;
+	// video that isn't captured is drained, so that it doesn't make the receiver look unhealthy
+	if (Failover->Tick(!IsCapturingVideo()))
 	{
-		CustomMetadata.Trim();
-		CustomMetadata.TrimTrailing();
+		SwitchToStandby();
 	}
 
-	if (!CustomMetadata.IsEmpty())
+	if (ConnectionWatch.IsValid())
 	{
-		SendMetadata(CustomMetadata);
+		TickConnection();
 	}
 
-	// finalize
-	CurrentUrl = Url;
-
-	MediaEvent.Broadcast(EMediaEvent::TracksChanged);
-	MediaEvent.Broadcast(EMediaEvent::MediaOpened);
-
-	return true;
-}
-
-
-bool FNdiMediaPlayer::Open(const TSharedRef<FArchive, ESPMode::ThreadSafe>& Archive, const FString& OriginalUrl, const IMediaOptions& Options)
-{
-	return false; // not supported
-}
-
+	// update player state
+	EMediaState State = EMediaState::Paused;
 
-void FNdiMediaPlayer::TickPlayer(float DeltaTime)
-{
-	if (ReceiverInstance == nullptr)
+	if (Replaying)
 	{
-		return;
+		if (!Paused)
+		{
+			State = ReplayEnded ? EMediaState::Stopped : EMediaState::Playing;
+		}
 	}
+	else if (!Paused)
+	{
+		bool IsConnected = Connected;
 
-	// update player state
-	const bool IsConnected = (NDIlib_recv_get_no_connections(ReceiverInstance) > 0);
-	const EMediaState State = Paused ? EMediaState::Paused : (IsConnected ? EMediaState::Playing : EMediaState::Preparing);
+		if (IsMultiview())
+		{
+			IsConnected = (Multiview->GetNumConnectedTiles() > 0);
+		}
+		else if (Failover->IsOpen())
+		{
+			IsConnected = Failover->IsActiveConnected();
+		}
+
+		State = (IsConnected || TimeShifted) ? EMediaState::Playing : EMediaState::Preparing;
+	}
 
-	if ((State != CurrentState) && (AudioSink != nullptr))
+	if (State != CurrentState)
 	{
 		CurrentState = State;
 		UpdateAudioSampler();
+		UpdateMetadataSampler();
 
 		if (State == EMediaState::Playing)
 		{
@@ -463,46 +905,84 @@ void FNdiMediaPlayer::TickPlayer(float DeltaTime)
 		}
 	}
 
-	if (MetadataSink != nullptr)
+	// recordings and multiviews have no receiver of their own
+	if (ReceiverInstance != nullptr)
 	{
-		CaptureMetadataFrame();
+		UpdateTally();
 	}
-}
-
 
-void FNdiMediaPlayer::TickVideo(float DeltaTime)
-{
-	if (!Paused)
+	// recordings deliver all frames from TickVideo, metadata-only receivers are sampled on their own thread, and multiviews have no metadata
+	if (((MetadataSink != nullptr) || Recorder->IsOpen() || TimeShiftBuffer->IsOpen()) && !MetadataOnly && !Replaying && !IsMultiview())
 	{
-		CaptureVideoFrame();
+		CaptureMetadataFrame();
 	}
 }
 
 
-/* IMediaOutput interface
- *****************************************************************************/
-
-void FNdiMediaPlayer::SetAudioSink(IMediaAudioSink* Sink)
+void FNdiMediaPlayer::TickVideo(float DeltaTime)
 {
-	if (Sink == AudioSink)
+	if (Replaying)
 	{
+		TickReplay(DeltaTime);
 		return;
 	}
 
-	FScopeLock Lock(&CriticalSection);
-
-	if (AudioSink != nullptr)
+	if (IsMultiview())
 	{
-		AudioSink->ShutdownAudioSink();
+		TickMultiview();
+		return;
 	}
 
-	if (Sink != nullptr)
+	// the receiver may still be created on the connection monitor thread
+	if (ReceiverInstance == nullptr)
+	{
+		return;
+	}
+
+	if (IsCapturingVideo())
+	{
+		CaptureVideoFrame();
+	}
+
+	if (SyncGroup.IsValid())
+	{
+		TickSyncGroup();
+	}
+
+	if (TimeShifted)
+	{
+		TickTimeShift(DeltaTime);
+	}
+}
+
+
+/* IMediaOutput interface
+ *****************************************************************************/
+
+void FNdiMediaPlayer::SetAudioSink(IMediaAudioSink* Sink)
+{
+	if (Sink == AudioSink)
 	{
-		Sink->InitializeAudioSink(LastAudioChannels, LastAudioSampleRate);
+		return;
 	}
 
-	AudioSink = Sink;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (AudioSink != nullptr)
+		{
+			AudioSink->ShutdownAudioSink();
+		}
+
+		if (Sink != nullptr)
+		{
+			Sink->InitializeAudioSink(LastAudioChannels, LastAudioSampleRate);
+		}
+
+		AudioSink = Sink;
+	}
 
+	// the sampler thread takes the player's lock while holding its own
 	UpdateAudioSampler();
 }
 
@@ -514,17 +994,23 @@ void FNdiMediaPlayer::SetMetadataSink(IMediaBinarySink* Sink)
 		return;
 	}
 
-	if (MetadataSink != nullptr)
 	{
-		MetadataSink->ShutdownBinarySink();
-	}
+		FScopeLock Lock(&CriticalSection);
 
-	if (Sink != nullptr)
-	{
-		Sink->InitializeBinarySink();
+		if (MetadataSink != nullptr)
+		{
+			MetadataSink->ShutdownBinarySink();
+		}
+
+		if (Sink != nullptr)
+		{
+			Sink->InitializeBinarySink();
+		}
+
+		MetadataSink = Sink;
 	}
 
-	MetadataSink = Sink;
+	UpdateMetadataSampler();
 }
 
 
@@ -549,10 +1035,12 @@ void FNdiMediaPlayer::SetVideoSink(IMediaTextureSink* Sink)
 	}
 
 	VideoSink = Sink;
+	VideoSinkInitialized = false;
 
 	if (Sink != nullptr)
 	{
-		Sink->InitializeTextureSink(LastVideoDim, LastBufferDim, VideoSinkFormat, EMediaTextureSinkMode::Unbuffered);
+		VideoSinkInitialized = Sink->InitializeTextureSink(LastVideoFormat.OutputDim, LastVideoFormat.BufferDim, LastVideoFormat.SinkFormat, EMediaTextureSinkMode::Unbuffered);
+		VideoSinkFormat = LastVideoFormat;
 	}
 }
 
@@ -562,7 +1050,7 @@ void FNdiMediaPlayer::SetVideoSink(IMediaTextureSink* Sink)
 
 uint32 FNdiMediaPlayer::GetAudioTrackChannels(int32 TrackIndex) const
 {
-	if ((ReceiverInstance == nullptr) || (TrackIndex != 0))
+	if (!HasMedia() || (TrackIndex != 0))
 	{
 		return 0;
 	}
@@ -573,7 +1061,7 @@ uint32 FNdiMediaPlayer::GetAudioTrackChannels(int32 TrackIndex) const
 
 uint32 FNdiMediaPlayer::GetAudioTrackSampleRate(int32 TrackIndex) const
 {
-	if ((ReceiverInstance == nullptr) || (TrackIndex != 0))
+	if (!HasMedia() || (TrackIndex != 0))
 	{
 		return 0;
 	}
@@ -584,8 +1072,13 @@ uint32 FNdiMediaPlayer::GetAudioTrackSampleRate(int32 TrackIndex) const
 
 int32 FNdiMediaPlayer::GetNumTracks(EMediaTrackType TrackType) const
 {
-	if (ReceiverInstance != nullptr)
+	if (HasMedia())
 	{
+		if (MetadataOnly)
+		{
+			return (TrackType == EMediaTrackType::Metadata) ? 1 : 0;
+		}
+
 		if ((TrackType == EMediaTrackType::Audio) ||
 			(TrackType == EMediaTrackType::Metadata) ||
 			(TrackType == EMediaTrackType::Video))
@@ -600,7 +1093,7 @@ int32 FNdiMediaPlayer::GetNumTracks(EMediaTrackType TrackType) const
 
 int32 FNdiMediaPlayer::GetSelectedTrack(EMediaTrackType TrackType) const
 {
-	if (ReceiverInstance == nullptr)
+	if (!HasMedia())
 	{
 		return INDEX_NONE;
 	}
@@ -608,8 +1101,10 @@ int32 FNdiMediaPlayer::GetSelectedTrack(EMediaTrackType TrackType) const
 	switch (TrackType)
 	{
 	case EMediaTrackType::Audio:
-	case EMediaTrackType::Metadata:
 	case EMediaTrackType::Video:
+		return MetadataOnly ? INDEX_NONE : 0;
+
+	case EMediaTrackType::Metadata:
 		return 0;
 
 	default:
@@ -620,7 +1115,7 @@ int32 FNdiMediaPlayer::GetSelectedTrack(EMediaTrackType TrackType) const
 
 FText FNdiMediaPlayer::GetTrackDisplayName(EMediaTrackType TrackType, int32 TrackIndex) const
 {
-	if ((ReceiverInstance == nullptr) || (TrackIndex != 0))
+	if (!HasMedia() || (TrackIndex != 0))
 	{
 		return FText::GetEmpty();
 	}
@@ -644,7 +1139,7 @@ FText FNdiMediaPlayer::GetTrackDisplayName(EMediaTrackType TrackType, int32 Trac
 
 FString FNdiMediaPlayer::GetTrackLanguage(EMediaTrackType TrackType, int32 TrackIndex) const
 {
-	if ((ReceiverInstance == nullptr) || (TrackIndex != 0))
+	if (!HasMedia() || (TrackIndex != 0))
 	{
 		return FString();
 	}
@@ -667,18 +1162,18 @@ uint32 FNdiMediaPlayer::GetVideoTrackBitRate(int32 TrackIndex) const
 
 FIntPoint FNdiMediaPlayer::GetVideoTrackDimensions(int32 TrackIndex) const
 {
-	if ((ReceiverInstance == nullptr) || (TrackIndex != 0))
+	if (!HasMedia() || (TrackIndex != 0))
 	{
 		return FIntPoint::ZeroValue;
 	}
 
-	return LastVideoDim;
+	return LastVideoFormat.OutputDim;
 }
 
 
 float FNdiMediaPlayer::GetVideoTrackFrameRate(int32 TrackIndex) const
 {
-	if ((ReceiverInstance == nullptr) || (TrackIndex != 0))
+	if (!HasMedia() || (TrackIndex != 0))
 	{
 		return 0;
 	}
@@ -716,150 +1211,1157 @@ bool FNdiMediaPlayer::SelectTrack(EMediaTrackType TrackType, int32 TrackIndex)
 }
 
 
-/* FNdiMediaPlayer implementation
+/* FNdiMediaPlayer interface
  *****************************************************************************/
 
-void FNdiMediaPlayer::CaptureMetadataFrame()
+FNdiMediaPlayerStageStats FNdiMediaPlayer::GetStageStats() const
 {
-	NDIlib_metadata_frame_t MetadataFrame;
-	NDIlib_frame_type_e FrameType = NDIlib_recv_capture_v2(ReceiverInstance, nullptr, nullptr, &MetadataFrame, 0);
-
-	if (FrameType == NDIlib_frame_type_error)
+	FNdiMediaPlayerStageStats StageStats;
 	{
-		UE_LOG(LogNdiMedia, Verbose, TEXT("Failed to receive metadata frame"));
-		return;
+		StageStats.AudioConversion = AudioConversionStats;
+		StageStats.ColorConversion = ColorConverter->GetStats();
+		StageStats.Deinterlace = Deinterlacer->GetStats();
+		StageStats.Resize = Resizer->GetStats();
+		StageStats.VideoCapture = VideoCaptureStats;
+		StageStats.VideoUpload = VideoUploadStats;
 	}
 
-	if (FrameType != NDIlib_frame_type_metadata)
+	return StageStats;
+}
+
+
+float FNdiMediaPlayer::GetVideoTrackAspectRatio(int32 TrackIndex) const
+{
+	if (!HasMedia() || (TrackIndex != 0))
 	{
-		return;
+		return 0.0f;
 	}
 
-	MetadataSink->ProcessBinarySinkData((const uint8*)MetadataFrame.p_data, MetadataFrame.length, FTimespan(MetadataFrame.timecode), FTimespan::Zero());
+	return LastVideoFormat.AspectRatio;
+}
+
 
-	NDIlib_recv_free_metadata(ReceiverInstance, &MetadataFrame);
+bool FNdiMediaPlayer::IsRecording() const
+{
+	return Recorder->IsOpen();
 }
 
 
-void FNdiMediaPlayer::CaptureVideoFrame()
+bool FNdiMediaPlayer::IsTimeShifted() const
 {
-	NDIlib_video_frame_v2_t VideoFrame;
-	NDIlib_frame_type_e FrameType = NDIlib_recv_capture_v2(ReceiverInstance, &VideoFrame, nullptr, nullptr, 0);
+	return TimeShifted;
+}
 
-	if (FrameType == NDIlib_frame_type_error)
+
+void FNdiMediaPlayer::ReturnToLive()
+{
+	if (!TimeShifted)
 	{
-		UE_LOG(LogNdiMedia, Verbose, TEXT("Failed to receive video frame"));
 		return;
 	}
 
-	if (FrameType != NDIlib_frame_type_video)
+	TimeShifted = false;
+	PlaybackRate = 1.0f;
+	Paused = false;
+	PendingTimeShiftSeek = false;
+
+	FScopeLock Lock(&CriticalSection);
+
+	Deinterlacer->Reset();
+
+	if (AudioSink != nullptr)
 	{
-		return;
+		AudioSink->FlushAudioSink();
 	}
+}
 
-	// re-initialize sink if format changed
-	FScopeLock Lock(&CriticalSection);
-	ProcessVideoFrame(VideoFrame);
 
-	NDIlib_recv_free_video_v2(ReceiverInstance, &VideoFrame);
+bool FNdiMediaPlayer::StartRecording(const FString& FilePath)
+{
+	if (ReceiverInstance == nullptr)
+	{
+		return false;
+	}
+
+	if (!Recorder->Open(FilePath, CurrentUrl.RightChop(6)))
+	{
+		return false;
+	}
+
+	// recordings include the frames that aren't played
+	UpdateAudioSampler();
+	UpdateMetadataSampler();
+
+	return true;
 }
 
 
-void FNdiMediaPlayer::ProcessAudioFrame(const NDIlib_audio_frame_v2_t& AudioFrame)
+void FNdiMediaPlayer::StopRecording()
 {
-	LastAudioChannels = AudioFrame.no_channels;
-	LastAudioSampleRate = AudioFrame.sample_rate;
+	Recorder->Close();
 
-	if (AudioSink == nullptr)
+	UpdateAudioSampler();
+	UpdateMetadataSampler();
+}
+
+
+/* FNdiMediaPlayer implementation
+ *****************************************************************************/
+
+void FNdiMediaPlayer::FinishOpen()
+{
+	const TSharedRef<FNdiMediaReceiverRequest, ESPMode::ThreadSafe> Request = PendingOpen.Request.ToSharedRef();
+	const FString SourceStr = CurrentUrl.RightChop(6);
+
+	if (Request->GetReceiverInstance() == nullptr)
 	{
+		if (Request->GetBackend().IsValid())
+		{
+			UE_LOG(LogNdiMedia, Error, TEXT("Failed to open NDI media source %s: couldn't create receiver"), *SourceStr);
+		}
+		else
+		{
+			UE_LOG(LogNdiMedia, Error, TEXT("Failed to open NDI media source %s: NDI is not available"), *SourceStr);
+		}
+
+		Close();
+		MediaEvent.Broadcast(EMediaEvent::MediaOpenFailed);
+
 		return;
 	}
 
-	// re-initialize sink if format changed
-	if ((AudioSink->GetAudioSinkChannels() != AudioFrame.no_channels) ||
-		(AudioSink->GetAudioSinkSampleRate() != AudioFrame.sample_rate))
+	NDIlib_recv_create_t RcvCreateDesc;
 	{
-		if (!AudioSink->InitializeAudioSink(AudioFrame.no_channels, AudioFrame.sample_rate))
+		RcvCreateDesc.color_format = (NDIlib_recv_color_format_e)Request->GetColorFormat();
+		RcvCreateDesc.bandwidth = (NDIlib_recv_bandwidth_e)Request->GetBandwidth();
+		RcvCreateDesc.allow_video_fields = true;
+	}
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		Backend = Request->GetBackend();
+		ReceiverInstance = Request->GetReceiverInstance();
+
+		if (SyncGroup.IsValid())
 		{
-			return;
+			SyncGroupMemberId = SyncGroup->AddMember(SourceStr, Backend.ToSharedRef(), ReceiverInstance);
+		}
+
+		if (PendingOpen.FailoverSources.Num() > 0)
+		{
+			Failover->Open(ConnectionMonitor.ToSharedRef(), Backend.ToSharedRef(), PendingOpen.FailoverSources, RcvCreateDesc, Request->GetConnectionMetadata(), ReceiverInstance);
+		}
+
+		// the failover supervises its own receivers
+		if (!Failover->IsOpen())
+		{
+			ConnectionWatch = ConnectionMonitor->AddReceiver(Backend.ToSharedRef(), ReceiverInstance, SourceStr, RcvCreateDesc, Request->GetConnectionMetadata());
 		}
+
+		OpenDuration = FPlatformTime::Seconds() - PendingOpen.RequestTime;
+		ReceiverCreateDuration = Request->GetCreateTime();
 	}
 
-	// convert float samples to interleaved 16-bit samples
-	uint32 TotalSamples = AudioFrame.no_samples * AudioFrame.no_channels;
+	if (!PendingOpen.RecordingDirectory.IsEmpty())
+	{
+		const FString FileName = FPaths::MakeValidFileName(SourceStr) + FDateTime::Now().ToString(TEXT("-%Y%m%d-%H%M%S")) + NdiMediaRecording::FileExtension;
+		StartRecording(FPaths::Combine(PendingOpen.RecordingDirectory, FileName));
+	}
 
-	NDIlib_audio_frame_interleaved_16s_t AudioFrameInterleaved = { 0 };
+	PendingOpen = FPendingOpen();
+
+	UE_LOG(LogNdiMedia, Verbose, TEXT("Opened NDI media source %s in %.1f ms (receiver creation %.1f ms)"), *SourceStr, OpenDuration * 1000.0, ReceiverCreateDuration * 1000.0);
+
+	UpdateAudioSampler();
+	UpdateMetadataSampler();
+
+	MediaEvent.Broadcast(EMediaEvent::TracksChanged);
+	MediaEvent.Broadcast(EMediaEvent::MediaOpened);
+}
+
+
+void FNdiMediaPlayer::FinishOpenMultiview()
+{
+	// tiles whose receivers couldn't be created stay black
+	if (!Multiview->HasReceivers())
 	{
-		AudioFrameInterleaved.reference_level = 20;
-		AudioFrameInterleaved.p_data = new short[TotalSamples];
+		UE_LOG(LogNdiMedia, Error, TEXT("Failed to open NDI multiview %s: couldn't create any receivers"), *CurrentUrl);
+
+		Close();
+		MediaEvent.Broadcast(EMediaEvent::MediaOpenFailed);
+
+		return;
 	}
 
-	NDIlib_util_audio_to_interleaved_16s_v2(&AudioFrame, &AudioFrameInterleaved);
+	OpenDuration = FPlatformTime::Seconds() - PendingOpen.RequestTime;
+	PendingOpen = FPendingOpen();
 
-	// forward to sink
-	static int64 SamplesReceived = 0;
-	SamplesReceived += TotalSamples;
-	AudioSink->PlayAudioSink((const uint8*)AudioFrameInterleaved.p_data, TotalSamples * sizeof(int16), FTimespan(AudioFrame.timecode));
+	UE_LOG(LogNdiMedia, Verbose, TEXT("Opened NDI multiview %s in %.1f ms"), *CurrentUrl, OpenDuration * 1000.0);
 
-	delete[] AudioFrameInterleaved.p_data;
+	MediaEvent.Broadcast(EMediaEvent::TracksChanged);
+	MediaEvent.Broadcast(EMediaEvent::MediaOpened);
 }
 
 
-void FNdiMediaPlayer::ProcessVideoFrame(const NDIlib_video_frame_v2_t& VideoFrame)
+void FNdiMediaPlayer::InitializeProcessing(const IMediaOptions& Options)
 {
-	LastBufferDim = FIntPoint(VideoFrame.line_stride_in_bytes / 4, VideoFrame.yres);
-	LastVideoDim = FIntPoint(VideoFrame.xres, VideoFrame.yres);
+	Deinterlacer->SetMode((ENdiMediaDeinterlaceMode)Options.GetMediaOption(NdiMedia::DeinterlaceModeOption, (int64)ENdiMediaDeinterlaceMode::Weave));
 
-	if (VideoSink == nullptr)
+	ColorConverter->SetYuvConversion(
+		(ENdiMediaYuvConversion)Options.GetMediaOption(NdiMedia::YuvConversionOption, (int64)ENdiMediaYuvConversion::Sink),
+		(ENdiMediaYuvRange)Options.GetMediaOption(NdiMedia::YuvRangeOption, (int64)ENdiMediaYuvRange::Limited)
+	);
+
+	if (ColorConverter->ConvertsYuv())
 	{
-		return;
+		LastVideoFormat.SinkFormat = EMediaTextureSinkFormat::CharBGRA;
 	}
 
-	// re-initialize sink if format changed
-	if ((VideoSink->GetTextureSinkFormat() != VideoSinkFormat) ||
-		(VideoSink->GetTextureSinkDimensions() != LastVideoDim))
+	// senders may ignore the preferred size, which is only sent as a hint
+	if (Options.GetMediaOption(NdiMedia::ConformVideoSizeOption, (int64)0) != 0)
 	{
-		if (!VideoSink->InitializeTextureSink(LastVideoDim, LastBufferDim, VideoSinkFormat, EMediaTextureSinkMode::Unbuffered))
-		{
-			return;
-		}
+		Resizer->SetMaxSize(FIntPoint(
+			(int32)Options.GetMediaOption(NdiMedia::VideoWidthOption, (int64)0),
+			(int32)Options.GetMediaOption(NdiMedia::VideoHeightOption, (int64)0)
+		));
 	}
+	else
+	{
+		Resizer->SetMaxSize(FIntPoint::ZeroValue);
+	}
+}
 
-	// forward to sink
-	VideoSink->UpdateTextureSinkBuffer(VideoFrame.p_data, VideoFrame.line_stride_in_bytes);
-	VideoSink->DisplayTextureSinkBuffer(FTimespan(VideoFrame.timecode));
+
+bool FNdiMediaPlayer::IsCapturingVideo() const
+{
+	// recorded and time-shifted streams are captured while paused
+	return !MetadataOnly && (!Paused || Recorder->IsOpen() || TimeShiftBuffer->IsOpen());
 }
 
 
-void FNdiMediaPlayer::SendMetadata(const FString& Metadata, int64 Timecode)
+bool FNdiMediaPlayer::IsMultiview() const
 {
-	check(ReceiverInstance != nullptr);
+	return Multiview->IsOpen() && !Multiview->IsOpening();
+}
 
-	NDIlib_metadata_frame_t MetadataFrame;
+
+bool FNdiMediaPlayer::IsSeekable() const
+{
+	return Replaying || TimeShiftBuffer->IsOpen();
+}
+
+
+bool FNdiMediaPlayer::OpenMultiview(const FString& Url, const IMediaOptions& Options)
+{
+	TArray<FString> Sources;
+	Url.RightChop(8).ParseIntoArray(Sources, TEXT("|"), true);
+
+	if (Sources.Num() == 0)
+	{
+		return false;
+	}
+
+	FNdiMediaMultiviewSettings Settings;
+	{
+		Settings.Columns = Options.GetMediaOption(NdiMedia::MultiviewColumnsOption, (int64)Settings.Columns);
+		Settings.Height = Options.GetMediaOption(NdiMedia::MultiviewHeightOption, (int64)Settings.Height);
+		Settings.LowBandwidth = (Options.GetMediaOption(NdiMedia::BandwidthOption, (int64)NDIlib_recv_bandwidth_lowest) != NDIlib_recv_bandwidth_highest);
+		Settings.Width = Options.GetMediaOption(NdiMedia::MultiviewWidthOption, (int64)Settings.Width);
+	}
+
+	FScopeLock Lock(&CriticalSection);
+
+	InitializeProcessing(Options);
+
+	// creating the receivers may block, so the remaining work is done in FinishOpenMultiview
+	ConnectionMonitor = FNdiMediaConnectionMonitor::Get();
+
+	if (!Multiview->Open(ConnectionMonitor.ToSharedRef(), Sources, Settings, FNdiMediaConnectionMetadata::Get(Options)))
 	{
-		MetadataFrame.length = Metadata.Len() + 1;
-		MetadataFrame.timecode = Timecode;
-		MetadataFrame.p_data = TCHAR_TO_ANSI(*Metadata);
+		UE_LOG(LogNdiMedia, Error, TEXT("Failed to open NDI multiview %s"), *Url);
+		ConnectionMonitor.Reset();
+
+		return false;
 	}
 
-	NDIlib_recv_add_connection_metadata(ReceiverInstance, &MetadataFrame);
+	// the composited output is always BGRA
+	LastVideoFormat.SinkFormat = EMediaTextureSinkFormat::CharBGRA;
+	CurrentState = EMediaState::Preparing;
+	CurrentUrl = Url;
+	PendingOpen.RequestTime = FPlatformTime::Seconds();
+
+	return true;
 }
 
 
-void FNdiMediaPlayer::UpdateAudioSampler()
+bool FNdiMediaPlayer::OpenReplay(const FString& Url, FArchive* Archive, const IMediaOptions& Options)
 {
-	const bool SampleAudio = !Paused && (AudioSink != nullptr) && (SelectedAudioTrack == 0);
-	AudioSampler->SetReceiverInstance(SampleAudio ? ReceiverInstance : nullptr);
-}
+	FString FilePath = Url;
 
+	if (FilePath.StartsWith(TEXT("file://")))
+	{
+		FilePath = FilePath.RightChop(7);
+	}
 
-/* FNdiMediaPlayer implementation
- *****************************************************************************/
+	// prefer mapping the file over loading a (precached) archive into memory
+	const bool Opened = (!FilePath.IsEmpty() && IFileManager::Get().FileExists(*FilePath))
+		? ReplayReader->Open(FilePath)
+		: ((Archive != nullptr) && ReplayReader->Open(*Archive));
 
-void FNdiMediaPlayer::HandleAudioSamplerSample(const NDIlib_audio_frame_v2_t& AudioFrame)
+	if (!Opened)
+	{
+		return false;
+	}
+
+	FScopeLock Lock(&CriticalSection);
+
+	InitializeProcessing(Options);
+
+	// audio conversion is provided by the NDI backend
+	Backend = FNdi::GetBackend();
+
+	if (!Backend.IsValid())
+	{
+		UE_LOG(LogNdiMedia, Warning, TEXT("NDI is not available. Audio in NDI recording %s will not be played."), *FilePath);
+	}
+
+	for (int32 FrameIndex = 0; FrameIndex < ReplayReader->GetNumFrames(); ++FrameIndex)
+	{
+		NDIlib_audio_frame_v2_t AudioFrame;
+
+		if (ReplayReader->GetAudioFrame(FrameIndex, AudioFrame))
+		{
+			LastAudioChannels = AudioFrame.no_channels;
+			LastAudioSampleRate = AudioFrame.sample_rate;
+
+			break;
+		}
+	}
+
+	CurrentUrl = Url;
+	Replaying = true;
+
+	SeekReplay(FTimespan::Zero());
+
+	MediaEvent.Broadcast(EMediaEvent::TracksChanged);
+	MediaEvent.Broadcast(EMediaEvent::MediaOpened);
+
+	return true;
+}
+
+
+void FNdiMediaPlayer::ProcessReplayVideoFrame(int32 FrameIndex)
 {
+	NDIlib_video_frame_v2_t VideoFrame;
+
+	if ((FrameIndex == LastReplayVideoFrame) || !ReplayReader->GetVideoFrame(FrameIndex, VideoFrame))
+	{
+		return;
+	}
+
 	FScopeLock Lock(&CriticalSection);
-	ProcessAudioFrame(AudioFrame);
+
+	ProcessVideoFrame(VideoFrame);
+	LastReplayVideoFrame = FrameIndex;
+}
+
+
+bool FNdiMediaPlayer::ProcessTimeShiftVideoFrame(int64 Time)
+{
+	return TimeShiftBuffer->VisitVideoFrame(Time, [this](int64 FrameTime, const FNdiMediaRecordingFrameHeader& Header) {
+		NDIlib_video_frame_v2_t VideoFrame;
+
+		if ((FrameTime != LastTimeShiftVideoTime) && NdiMediaRecording::GetVideoFrame(Header, VideoFrame))
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			ProcessVideoFrame(VideoFrame);
+			LastTimeShiftVideoTime = FrameTime;
+		}
+	});
+}
+
+
+void FNdiMediaPlayer::ReplaceReceiver(void* NewReceiverInstance, const FString& SourceName)
+{
+	// detach sampler threads before the receiver changes
+	AudioSampler->SetReceiverInstance(nullptr, nullptr);
+	MetadataSampler->SetReceiverInstance(nullptr, nullptr);
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		// the sync group holds frames of the previous receiver
+		if (SyncGroup.IsValid())
+		{
+			SyncGroup->RemoveMember(SyncGroupMemberId);
+		}
+
+		// the previous receiver may live on as a standby, which must not appear on air
+		if (SentTally > 0)
+		{
+			NDIlib_tally_t Tally;
+			{
+				Tally.on_program = false;
+				Tally.on_preview = false;
+			}
+
+			Backend->RecvSetTally(ReceiverInstance, Tally);
+		}
+
+		ReceiverInstance = NewReceiverInstance;
+		SentTally = INDEX_NONE;
+
+		if (SyncGroup.IsValid())
+		{
+			SyncGroupMemberId = SyncGroup->AddMember(SourceName, Backend.ToSharedRef(), ReceiverInstance);
+		}
+
+		// fields of the previous source must not be woven into frames of the new one
+		Deinterlacer->Reset();
+	}
+
+	UpdateAudioSampler();
+	UpdateMetadataSampler();
+}
+
+
+void FNdiMediaPlayer::SeekReplay(FTimespan Time)
+{
+	const FTimespan Duration = ReplayReader->GetDuration();
+
+	ReplayTime = (Time < FTimespan::Zero()) ? FTimespan::Zero() : ((Time > Duration) ? Duration : Time);
+	ReplayEnded = false;
+
+	// show the frame at the new position right away, so that scrubbing works while paused
+	const int64 Timecode = ReplayReader->GetFirstTimecode() + ReplayTime.GetTicks();
+
+	ReplayCursor = ReplayReader->FindFrame(Timecode);
+	LastReplayVideoFrame = INDEX_NONE;
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		Deinterlacer->Reset();
+
+		if (AudioSink != nullptr)
+		{
+			AudioSink->FlushAudioSink();
+		}
+	}
+
+	const int32 VideoFrameIndex = ReplayReader->FindVideoFrame(Timecode);
+
+	if (VideoFrameIndex != INDEX_NONE)
+	{
+		ProcessReplayVideoFrame(VideoFrameIndex);
+	}
+}
+
+
+void FNdiMediaPlayer::SeekTimeShift(int64 Position)
+{
+	const int64 NewestTime = TimeShiftBuffer->GetNewestTime();
+
+	if (!Paused && (Position >= NewestTime))
+	{
+		ReturnToLive();
+		return;
+	}
+
+	TimeShifted = true;
+	TimeShiftPosition = FMath::Clamp(Position, TimeShiftBuffer->GetOldestTime(), NewestTime);
+	LastTimeShiftVideoTime = INDEX_NONE;
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		Deinterlacer->Reset();
+
+		if (AudioSink != nullptr)
+		{
+			AudioSink->FlushAudioSink();
+		}
+	}
+
+	// show the frame at the new position right away, so that scrubbing works while paused;
+	// frames in spilled slabs are shown by TickTimeShift once they were read
+	PendingTimeShiftSeek = !ProcessTimeShiftVideoFrame(TimeShiftPosition);
+}
+
+
+void FNdiMediaPlayer::StartTimeShift()
+{
+	// the sink keeps showing the last live frame until playback resumes
+	TimeShifted = true;
+	TimeShiftPosition = TimeShiftBuffer->GetNewestTime();
+	LastTimeShiftVideoTime = INDEX_NONE;
+}
+
+
+void FNdiMediaPlayer::SwitchToStandby()
+{
+	void* NewReceiverInstance = Failover->SwitchToStandby();
+	const FString SourceName = Failover->GetStats().ActiveSource;
+
+	// the failover keeps the previous receiver as its standby
+	ReplaceReceiver(NewReceiverInstance, SourceName);
+
+	UE_LOG(LogNdiMedia, Log, TEXT("NDI media source %s switched to %s"), *CurrentUrl, *SourceName);
+}
+
+
+void FNdiMediaPlayer::TickConnection()
+{
+	FNdiMediaConnectionEvent Event;
+
+	while (ConnectionWatch->DequeueEvent(Event))
+	{
+		if (Event.Type == ENdiMediaConnectionEventType::Reconnected)
+		{
+			void* OldReceiverInstance = ReceiverInstance;
+			ReplaceReceiver(Event.ReceiverInstance, CurrentUrl.RightChop(6));
+			ConnectionMonitor->RetireReceiver(Backend.ToSharedRef(), OldReceiverInstance);
+
+			UE_LOG(LogNdiMedia, Log, TEXT("Recreated the receiver of NDI media source %s"), *CurrentUrl);
+		}
+		else
+		{
+			Connected = (Event.Type == ENdiMediaConnectionEventType::Connected);
+		}
+	}
+}
+
+
+void FNdiMediaPlayer::TickMultiview()
+{
+	// unchanged tiles are neither redrawn nor uploaded
+	if (Paused || !Multiview->Update())
+	{
+		return;
+	}
+
+	NDIlib_video_frame_v2_t VideoFrame;
+	Multiview->GetFrame(VideoFrame);
+
+	FScopeLock Lock(&CriticalSection);
+	ProcessVideoFrame(VideoFrame);
+}
+
+
+void FNdiMediaPlayer::TickReplay(float DeltaTime)
+{
+	if (Paused || ReplayEnded)
+	{
+		return;
+	}
+
+	ReplayTime += FTimespan::FromSeconds(DeltaTime * PlaybackRate);
+
+	const int64 Timecode = ReplayReader->GetFirstTimecode() + ReplayTime.GetTicks();
+	int32 VideoFrameIndex = INDEX_NONE;
+
+	if (PlaybackRate > 0.0f)
+	{
+		// audio and metadata are delivered in order, but only the latest video frame is shown
+		const bool PlayAudio = (PlaybackRate == 1.0f) && (AudioSink != nullptr) && (SelectedAudioTrack == 0) && Backend.IsValid();
+
+		for (; (ReplayCursor < ReplayReader->GetNumFrames()) && (ReplayReader->GetFrameEntry(ReplayCursor).Timecode <= Timecode); ++ReplayCursor)
+		{
+			switch ((ENdiMediaRecordType)ReplayReader->GetFrameEntry(ReplayCursor).Type)
+			{
+			case ENdiMediaRecordType::Audio:
+				if (PlayAudio)
+				{
+					NDIlib_audio_frame_v2_t AudioFrame;
+
+					if (ReplayReader->GetAudioFrame(ReplayCursor, AudioFrame))
+					{
+						FScopeLock Lock(&CriticalSection);
+						ProcessAudioFrame(AudioFrame);
+					}
+				}
+				break;
+
+			case ENdiMediaRecordType::Metadata:
+				{
+					NDIlib_metadata_frame_t MetadataFrame;
+
+					if (ReplayReader->GetMetadataFrame(ReplayCursor, MetadataFrame))
+					{
+						FScopeLock Lock(&CriticalSection);
+						ProcessMetadataFrame(MetadataFrame);
+					}
+				}
+				break;
+
+			case ENdiMediaRecordType::Video:
+				VideoFrameIndex = ReplayCursor;
+				break;
+
+			default:
+				break;
+			}
+		}
+	}
+	else
+	{
+		// audio and metadata are skipped when playing in reverse
+		ReplayCursor = ReplayReader->FindFrame(Timecode);
+		VideoFrameIndex = ReplayReader->FindVideoFrame(Timecode);
+	}
+
+	if (VideoFrameIndex != INDEX_NONE)
+	{
+		ProcessReplayVideoFrame(VideoFrameIndex);
+	}
+
+	// handle end of recording
+	const FTimespan Duration = ReplayReader->GetDuration();
+
+	if ((ReplayTime > Duration) || (ReplayTime < FTimespan::Zero()))
+	{
+		MediaEvent.Broadcast(EMediaEvent::PlaybackEndReached);
+
+		if (Looping)
+		{
+			SeekReplay((PlaybackRate > 0.0f) ? FTimespan::Zero() : Duration);
+		}
+		else
+		{
+			ReplayTime = (PlaybackRate > 0.0f) ? Duration : FTimespan::Zero();
+			ReplayEnded = true;
+		}
+	}
+}
+
+
+void FNdiMediaPlayer::TickSyncGroup()
+{
+	NDIlib_video_frame_v2_t VideoFrame;
+
+	// frames are also picked up while paused, so the group doesn't hold them
+	if (!SyncGroup->PopFrame(SyncGroupMemberId, VideoFrame))
+	{
+		return;
+	}
+
+	if (!Paused && !TimeShifted)
+	{
+		FScopeLock Lock(&CriticalSection);
+		ProcessVideoFrame(VideoFrame);
+	}
+
+	Backend->RecvFreeVideo(ReceiverInstance, VideoFrame);
+}
+
+
+void FNdiMediaPlayer::TickTimeShift(float DeltaTime)
+{
+	const int64 OldestTime = TimeShiftBuffer->GetOldestTime();
+
+	// frames that left the window while paused are skipped
+	if (TimeShiftPosition < OldestTime)
+	{
+		TimeShiftPosition = OldestTime;
+	}
+
+	if (PendingTimeShiftSeek)
+	{
+		PendingTimeShiftSeek = !ProcessTimeShiftVideoFrame(TimeShiftPosition);
+	}
+
+	if (Paused)
+	{
+		return;
+	}
+
+	const int64 Position = TimeShiftPosition + (int64)(DeltaTime * PlaybackRate * ETimespan::TicksPerSecond);
+
+	if (PlaybackRate < 0.0f)
+	{
+		// audio and metadata are skipped when playing in reverse, which stops at the oldest frame
+		TimeShiftPosition = FMath::Max(Position, OldestTime);
+		ProcessTimeShiftVideoFrame(TimeShiftPosition);
+
+		if (Position <= OldestTime)
+		{
+			Paused = true;
+			MediaEvent.Broadcast(EMediaEvent::PlaybackEndReached);
+		}
+
+		return;
+	}
+
+	// playback caught up with the live stream
+	if (Position >= TimeShiftBuffer->GetNewestTime())
+	{
+		ReturnToLive();
+		return;
+	}
+
+	// audio and metadata are delivered in order, but only the latest video frame is shown
+	const bool PlayAudio = (PlaybackRate == 1.0f) && (AudioSink != nullptr) && (SelectedAudioTrack == 0);
+
+	bool HasVideo = false;
+	int64 VideoTime = 0;
+
+	// playback waits for slabs that are still being read from the spill file
+	const int64 VisitedPosition = TimeShiftBuffer->VisitFrames(TimeShiftPosition, Position, [&](int64 FrameTime, const FNdiMediaRecordingFrameHeader& Header) {
+		switch ((ENdiMediaRecordType)Header.Type)
+		{
+		case ENdiMediaRecordType::Audio:
+			if (PlayAudio)
+			{
+				NDIlib_audio_frame_v2_t AudioFrame;
+
+				if (NdiMediaRecording::GetAudioFrame(Header, AudioFrame))
+				{
+					FScopeLock Lock(&CriticalSection);
+					ProcessAudioFrame(AudioFrame);
+				}
+			}
+			break;
+
+		case ENdiMediaRecordType::Metadata:
+			{
+				NDIlib_metadata_frame_t MetadataFrame;
+
+				if (NdiMediaRecording::GetMetadataFrame(Header, MetadataFrame))
+				{
+					FScopeLock Lock(&CriticalSection);
+					ProcessMetadataFrame(MetadataFrame);
+				}
+			}
+			break;
+
+		case ENdiMediaRecordType::Video:
+			HasVideo = true;
+			VideoTime = FrameTime;
+			break;
+
+		default:
+			break;
+		}
+	});
+
+	TimeShiftPosition = VisitedPosition;
+
+	if (HasVideo)
+	{
+		ProcessTimeShiftVideoFrame(VideoTime);
+	}
+}
+
+
+void FNdiMediaPlayer::CaptureMetadataFrame()
+{
+	NDIlib_metadata_frame_t MetadataFrame;
+	NDIlib_frame_type_e FrameType = Backend->RecvCapture(ReceiverInstance, nullptr, nullptr, &MetadataFrame, 0);
+
+	if (FrameType == NDIlib_frame_type_error)
+	{
+		UE_LOG(LogNdiMedia, Verbose, TEXT("Failed to receive metadata frame"));
+		return;
+	}
+
+	if (FrameType != NDIlib_frame_type_metadata)
+	{
+		return;
+	}
+
+	Recorder->WriteMetadataFrame(MetadataFrame);
+	TimeShiftBuffer->WriteMetadataFrame(MetadataFrame);
+
+	// the sink also receives frame metadata from the audio sampler thread
+	if (!TimeShifted)
+	{
+		FScopeLock Lock(&CriticalSection);
+		ProcessMetadataFrame(MetadataFrame);
+	}
+
+	Backend->RecvFreeMetadata(ReceiverInstance, MetadataFrame);
+}
+
+
+void FNdiMediaPlayer::CaptureVideoFrame()
+{
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	NDIlib_video_frame_v2_t VideoFrame;
+	NDIlib_frame_type_e FrameType = Backend->RecvCapture(ReceiverInstance, &VideoFrame, nullptr, nullptr, 0);
+
+	if (FrameType == NDIlib_frame_type_error)
+	{
+		UE_LOG(LogNdiMedia, Verbose, TEXT("Failed to receive video frame"));
+		return;
+	}
+
+	if (FrameType != NDIlib_frame_type_video)
+	{
+		return;
+	}
+
+	// polls that returned no frame are not counted
+	VideoCaptureStats.Add(FPlatformTime::Cycles64() - StartCycles);
+
+	if (Failover->IsOpen())
+	{
+		Failover->NotifyVideoFrame(VideoFrame);
+	}
+
+	Recorder->WriteVideoFrame(VideoFrame);
+	TimeShiftBuffer->WriteVideoFrame(VideoFrame);
+
+	// time-shifted frames are played from the buffer
+	if (!Paused && !TimeShifted)
+	{
+		// synchronized frames are presented when the sync group selects them
+		if (SyncGroup.IsValid())
+		{
+			SyncGroup->PushFrame(SyncGroupMemberId, VideoFrame);
+
+			return;
+		}
+
+		FScopeLock Lock(&CriticalSection);
+		ProcessVideoFrame(VideoFrame);
+	}
+
+	Backend->RecvFreeVideo(ReceiverInstance, VideoFrame);
+}
+
+
+void FNdiMediaPlayer::ProcessAudioFrame(const NDIlib_audio_frame_v2_t& AudioFrame)
+{
+	LastAudioChannels = AudioFrame.no_channels;
+	LastAudioSampleRate = AudioFrame.sample_rate;
+
+	if (AudioFrame.p_metadata != nullptr)
+	{
+		const FTimespan Duration = (AudioFrame.sample_rate > 0)
+			? FTimespan(((int64)AudioFrame.no_samples * ETimespan::TicksPerSecond) / AudioFrame.sample_rate)
+			: FTimespan::Zero();
+
+		ProcessFrameMetadata(AudioFrame.p_metadata, AudioFrame.timecode, Duration);
+	}
+
+	if (AudioSink == nullptr)
+	{
+		return;
+	}
+
+	// re-initialize sink if format changed
+	if ((AudioSink->GetAudioSinkChannels() != AudioFrame.no_channels) ||
+		(AudioSink->GetAudioSinkSampleRate() != AudioFrame.sample_rate))
+	{
+		if (!AudioSink->InitializeAudioSink(AudioFrame.no_channels, AudioFrame.sample_rate))
+		{
+			return;
+		}
+	}
+
+	// convert float samples to interleaved 16-bit samples
+	uint32 TotalSamples = AudioFrame.no_samples * AudioFrame.no_channels;
+
+	NDIlib_audio_frame_interleaved_16s_t AudioFrameInterleaved = { 0 };
+	{
+		FNdiMediaStageScope StageScope(AudioConversionStats);
+
+		AudioFrameInterleaved.reference_level = 20;
+		AudioFrameInterleaved.p_data = new short[TotalSamples];
+
+		Backend->AudioToInterleaved16s(AudioFrame, AudioFrameInterleaved);
+	}
+
+	// forward to sink
+	static int64 SamplesReceived = 0;
+	SamplesReceived += TotalSamples;
+	AudioSink->PlayAudioSink((const uint8*)AudioFrameInterleaved.p_data, TotalSamples * sizeof(int16), FTimespan(AudioFrame.timecode));
+
+	delete[] AudioFrameInterleaved.p_data;
+}
+
+
+void FNdiMediaPlayer::ProcessMetadataFrame(const NDIlib_metadata_frame_t& MetadataFrame)
+{
+	if (MetadataSink != nullptr)
+	{
+		MetadataSink->ProcessBinarySinkData((const uint8*)MetadataFrame.p_data, MetadataFrame.length, FTimespan(MetadataFrame.timecode), FTimespan::Zero());
+	}
+}
+
+
+void FNdiMediaPlayer::ProcessFrameMetadata(const char* Metadata, int64 Timecode, FTimespan Duration)
+{
+	if ((MetadataSink == nullptr) || (Metadata[0] == '\0'))
+	{
+		return;
+	}
+
+	const uint32 Length = FCStringAnsi::Strlen(Metadata) + 1;
+	MetadataSink->ProcessBinarySinkData((const uint8*)Metadata, Length, FTimespan(Timecode), Duration);
+}
+
+
+void FNdiMediaPlayer::ProcessVideoFrame(const NDIlib_video_frame_v2_t& InVideoFrame)
+{
+	if (InVideoFrame.p_metadata != nullptr)
+	{
+		const FTimespan Duration = (InVideoFrame.frame_rate_N > 0)
+			? FTimespan(((int64)InVideoFrame.frame_rate_D * ETimespan::TicksPerSecond) / InVideoFrame.frame_rate_N)
+			: FTimespan::Zero();
+
+		ProcessFrameMetadata(InVideoFrame.p_metadata, InVideoFrame.timecode, Duration);
+	}
+
+	// determine upload format
+	FNdiMediaVideoFormat VideoFormat;
+
+	if (!VideoFormat.Initialize(InVideoFrame, FNdiMediaDeinterlacer::GetOutputHeight(InVideoFrame), ColorConverter->ConvertsYuv()))
+	{
+		if (InVideoFrame.FourCC != UnsupportedFourCC)
+		{
+			UE_LOG(LogNdiMedia, Warning, TEXT("Unsupported video FourCC %s in media source %s"), *FNdiMediaVideoFormat::GetFourCCName(InVideoFrame.FourCC), *CurrentUrl);
+			UnsupportedFourCC = InVideoFrame.FourCC;
+		}
+
+		return;
+	}
+
+	// frames that exceed the preferred size are resized before they are uploaded
+	VideoFormat.SetOutputDim(Resizer->GetOutputSize(VideoFormat.OutputDim, VideoFormat.SinkFormat == EMediaTextureSinkFormat::CharUYVY));
+
+	LastVideoFormat = VideoFormat;
+	LastVideoFrameRate = (InVideoFrame.frame_rate_D > 0) ? ((float)InVideoFrame.frame_rate_N / InVideoFrame.frame_rate_D) : 0.0f;
+
+	if (VideoSink == nullptr)
+	{
+		return;
+	}
+
+	NDIlib_video_frame_v2_t VideoFrame = InVideoFrame;
+
+	// unpack formats that the sink can't accept
+	if (ColorConverter->NeedsConversion(InVideoFrame))
+	{
+		if (!ColorConverter->Process(InVideoFrame, VideoFrame))
+		{
+			return;
+		}
+	}
+
+	// convert fields and interleaved frames to progressive frames
+	if (VideoFrame.frame_format_type != NDIlib_frame_format_type_progressive)
+	{
+		const NDIlib_video_frame_v2_t FieldFrame = VideoFrame;
+
+		if (!Deinterlacer->Process(FieldFrame, VideoFrame))
+		{
+			return; // waiting for the next field
+		}
+	}
+
+	// downscale frames that exceed the preferred size
+	if (Resizer->NeedsResize(VideoFrame))
+	{
+		const NDIlib_video_frame_v2_t LargeFrame = VideoFrame;
+
+		if (!Resizer->Process(LargeFrame, VideoFrame))
+		{
+			return;
+		}
+	}
+
+	if (VideoFrame.line_stride_in_bytes < VideoFormat.GetMinStride())
+	{
+		return;
+	}
+
+	// re-initialize sink only if the frame doesn't fit its current allocation;
+	// line stride, FourCC variants and aspect ratio changes don't require it
+	if (!VideoSinkInitialized || !VideoFormat.IsSinkCompatible(VideoSinkFormat))
+	{
+		VideoSinkFormat = VideoFormat;
+		VideoSinkInitialized = VideoSink->InitializeTextureSink(VideoFormat.OutputDim, VideoFormat.BufferDim, VideoFormat.SinkFormat, EMediaTextureSinkMode::Unbuffered);
+
+		if (!VideoSinkInitialized)
+		{
+			return;
+		}
+
+		++VideoSinkReinitializations;
+	}
+
+	// forward to sink
+	FNdiMediaStageScope StageScope(VideoUploadStats);
+
+	VideoSink->UpdateTextureSinkBuffer(VideoFrame.p_data, VideoFrame.line_stride_in_bytes);
+	VideoSink->DisplayTextureSinkBuffer(FTimespan(VideoFrame.timecode));
+}
+
+
+void FNdiMediaPlayer::UpdateAudioSampler()
+{
+	// recorded and time-shifted streams are sampled even while paused or without a sink
+	const bool SampleAudio = !MetadataOnly && (Recorder->IsOpen() || TimeShiftBuffer->IsOpen() || (!Paused && (AudioSink != nullptr) && (SelectedAudioTrack == 0)));
+	AudioSampler->SetReceiverInstance(Backend, SampleAudio ? ReceiverInstance : nullptr);
+}
+
+
+void FNdiMediaPlayer::UpdateMetadataSampler()
+{
+	const bool SampleMetadata = MetadataOnly && (Recorder->IsOpen() || TimeShiftBuffer->IsOpen() || (!Paused && (MetadataSink != nullptr)));
+	MetadataSampler->SetReceiverInstance(Backend, SampleMetadata ? ReceiverInstance : nullptr);
+}
+
+
+void FNdiMediaPlayer::UpdateTally()
+{
+	ENdiMediaTallyMode Mode = TallyMode;
+	FNdiMediaTally::GetOverride(CurrentUrl, Mode);
+
+	bool OnPreview = false;
+	bool OnProgram = false;
+
+	switch (Mode)
+	{
+	case ENdiMediaTallyMode::Automatic:
+		if (!Paused && !MetadataOnly)
+		{
+			// bound textures that aren't drawn are on preview
+			if ((VideoSink != nullptr) && (SelectedVideoTrack == 0))
+			{
+				OnProgram = FNdiMediaTally::IsRendered(CurrentUrl);
+				OnPreview = !OnProgram;
+			}
+
+			if ((AudioSink != nullptr) && (SelectedAudioTrack == 0))
+			{
+				OnProgram = true;
+			}
+		}
+		break;
+
+	case ENdiMediaTallyMode::Preview:
+		OnPreview = true;
+		break;
+
+	case ENdiMediaTallyMode::Program:
+		OnProgram = true;
+		break;
+
+	case ENdiMediaTallyMode::PreviewAndProgram:
+		OnPreview = true;
+		OnProgram = true;
+		break;
+
+	default:
+		break;
+	}
+
+	const int32 NewTally = (OnPreview ? 1 : 0) | (OnProgram ? 2 : 0);
+
+	if (NewTally == SentTally)
+	{
+		return;
+	}
+
+	NDIlib_tally_t Tally;
+	{
+		Tally.on_program = OnProgram;
+		Tally.on_preview = OnPreview;
+	}
+
+	// retry on the next tick if the source couldn't be notified
+	if (Backend->RecvSetTally(ReceiverInstance, Tally))
+	{
+		SentTally = NewTally;
+	}
+}
+
+
+/* FNdiMediaPlayer static functions
+ *****************************************************************************/
+
+FString FNdiMediaPlayer::GetDeinterlaceModeName(ENdiMediaDeinterlaceMode Mode)
+{
+	switch (Mode)
+	{
+	case ENdiMediaDeinterlaceMode::Blend:
+		return TEXT("Blend");
+
+	case ENdiMediaDeinterlaceMode::Bob:
+		return TEXT("Bob");
+
+	case ENdiMediaDeinterlaceMode::Weave:
+		return TEXT("Weave");
+
+	default:
+		return TEXT("Unknown");
+	}
+}
+
+
+FString FNdiMediaPlayer::GetTallyModeName(ENdiMediaTallyMode Mode)
+{
+	switch (Mode)
+	{
+	case ENdiMediaTallyMode::Automatic:
+		return TEXT("Automatic");
+
+	case ENdiMediaTallyMode::Off:
+		return TEXT("Off");
+
+	case ENdiMediaTallyMode::Preview:
+		return TEXT("Preview");
+
+	case ENdiMediaTallyMode::Program:
+		return TEXT("Program");
+
+	case ENdiMediaTallyMode::PreviewAndProgram:
+		return TEXT("Preview and Program");
+
+	default:
+		return TEXT("Unknown");
+	}
+}
+
+
+/* FNdiMediaPlayer callbacks
+ *****************************************************************************/
+
+void FNdiMediaPlayer::HandleAudioSamplerSample(const NDIlib_audio_frame_v2_t& AudioFrame)
+{
+	Recorder->WriteAudioFrame(AudioFrame);
+	TimeShiftBuffer->WriteAudioFrame(AudioFrame);
+
+	FScopeLock Lock(&CriticalSection);
+
+	// time-shifted streams are sampled while paused, but played from the buffer
+	if (Paused || TimeShifted || (SelectedAudioTrack != 0))
+	{
+		return;
+	}
+
+	ProcessAudioFrame(AudioFrame);
+}
+
+
+void FNdiMediaPlayer::HandleMetadataSamplerFrame(const NDIlib_metadata_frame_t& MetadataFrame)
+{
+	Recorder->WriteMetadataFrame(MetadataFrame);
+	TimeShiftBuffer->WriteMetadataFrame(MetadataFrame);
+
+	FScopeLock Lock(&CriticalSection);
+
+	if (TimeShifted)
+	{
+		return;
+	}
+
+	ProcessMetadataFrame(MetadataFrame);
 }
 
 
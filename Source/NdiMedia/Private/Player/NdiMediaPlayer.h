@@ -7,16 +7,59 @@
 #include "IMediaPlayer.h"
 #include "IMediaOutput.h"
 #include "IMediaTracks.h"
+#include "NdiMediaStageStats.h"
+#include "NdiMediaVideoFormat.h"
 
 
 class FNdiMediaAudioSampler;
-
-enum class EMediaTextureSinkFormat;
+class FNdiMediaColorConverter;
+class FNdiMediaConnectionMonitor;
+class FNdiMediaConnectionWatch;
+class FNdiMediaDeinterlacer;
+class FNdiMediaFailover;
+class FNdiMediaMetadataSampler;
+class FNdiMediaMultiviewCompositor;
+class FNdiMediaReceiverRequest;
+class FNdiMediaRecorder;
+class FNdiMediaRecordingReader;
+class FNdiMediaSyncGroup;
+class FNdiMediaTimeShiftBuffer;
+class FNdiMediaVideoResizer;
+class INdiMediaBackend;
+
+enum class ENdiMediaDeinterlaceMode : uint8;
+enum class ENdiMediaTallyMode : uint8;
 
 struct NDIlib_audio_frame_v2_t;
+struct NDIlib_metadata_frame_t;
 struct NDIlib_video_frame_v2_t;
 
 
+/**
+ * CPU cost of the processing stages of a media player.
+ */
+struct FNdiMediaPlayerStageStats
+{
+	/** Conversion of audio frames to interleaved 16-bit samples. */
+	FNdiMediaStageStats AudioConversion;
+
+	/** Conversion of video frames that texture sinks can't accept. */
+	FNdiMediaStageStats ColorConversion;
+
+	/** Conversion of fielded and interleaved video frames to progressive frames. */
+	FNdiMediaStageStats Deinterlace;
+
+	/** Downscaling of video frames that exceed the preferred size. */
+	FNdiMediaStageStats Resize;
+
+	/** Capturing of video frames from the receiver. */
+	FNdiMediaStageStats VideoCapture;
+
+	/** Forwarding of video frames to the texture sink. */
+	FNdiMediaStageStats VideoUpload;
+};
+
+
 /**
  * Implements a media player using the Windows Media Foundation framework.
  */
@@ -99,6 +142,77 @@ public:
 	virtual float GetVideoTrackFrameRate(int32 TrackIndex) const override;
 	virtual bool SelectTrack(EMediaTrackType TrackType, int32 TrackIndex) override;
 
+public:
+
+	/**
+	 * Get the CPU cost of the player's processing stages.
+	 *
+	 * The statistics accumulate until the player is destroyed; they are not
+	 * reset when a different source is opened.
+	 *
+	 * @return Stage statistics.
+	 * @see GetStats
+	 */
+	FNdiMediaPlayerStageStats GetStageStats() const;
+
+	/**
+	 * Get the picture aspect ratio of a video track.
+	 *
+	 * This is the aspect ratio that the source specified for its frames, which
+	 * differs from the ratio of the video dimensions for anamorphic video.
+	 *
+	 * @param TrackIndex The index of the track.
+	 * @return Aspect ratio, or 0.0 if not available.
+	 * @see GetVideoTrackDimensions
+	 */
+	float GetVideoTrackAspectRatio(int32 TrackIndex) const;
+
+	/**
+	 * Whether the received stream is being recorded.
+	 *
+	 * @return true if recording, false otherwise.
+	 * @see StartRecording, StopRecording
+	 */
+	bool IsRecording() const;
+
+	/**
+	 * Whether a live stream is played from the time-shift buffer.
+	 *
+	 * Live streams are time-shifted when they are paused, seeked or played at
+	 * rates other than 1.0, if the media source enabled time shifting.
+	 *
+	 * @return true if time-shifted, false if playing live.
+	 * @see ReturnToLive
+	 */
+	bool IsTimeShifted() const;
+
+	/**
+	 * Resume playing the live stream after it was time-shifted.
+	 *
+	 * @see IsTimeShifted
+	 */
+	void ReturnToLive();
+
+	/**
+	 * Start recording the received stream.
+	 *
+	 * Frames are recorded as they are received, before any conversion, including
+	 * tracks that aren't played and frames received while the player is paused.
+	 * The recording stops when the player is closed or opens a different source.
+	 *
+	 * @param FilePath Path to the file to record into (will be replaced if it exists).
+	 * @return true if the recording started, false otherwise.
+	 * @see IsRecording, StopRecording
+	 */
+	bool StartRecording(const FString& FilePath);
+
+	/**
+	 * Stop recording the received stream.
+	 *
+	 * @see IsRecording, StartRecording
+	 */
+	void StopRecording();
+
 protected:
 
 	/** Capture the latest metdata frame and forward it to the sink. */
@@ -107,6 +221,83 @@ protected:
 	/** Capture the latest video frame data and forward it to the sink. */
 	void CaptureVideoFrame();
 
+	/**
+	 * Complete opening a live stream after its receiver was created.
+	 *
+	 * @see Open
+	 */
+	void FinishOpen();
+
+	/**
+	 * Complete opening a multiview after the receivers of its tiles were created.
+	 *
+	 * @see OpenMultiview
+	 */
+	void FinishOpenMultiview();
+
+	/**
+	 * Whether a stream or recording is open.
+	 *
+	 * @return true if media is open, false otherwise.
+	 */
+	bool HasMedia() const
+	{
+		return (ReceiverInstance != nullptr) || Replaying || IsMultiview();
+	}
+
+	/**
+	 * Apply the video processing options of a media source.
+	 *
+	 * @param Options The media options.
+	 */
+	void InitializeProcessing(const IMediaOptions& Options);
+
+	/**
+	 * Whether the live stream's video frames are captured.
+	 *
+	 * @return true if captured, false if the receiver's video is left in its queue.
+	 */
+	bool IsCapturingVideo() const;
+
+	/**
+	 * Whether a multiview of several streams is open.
+	 *
+	 * @return true if a multiview is open, false otherwise.
+	 */
+	bool IsMultiview() const;
+
+	/**
+	 * Whether the current media supports seeking and rates other than 1.0.
+	 *
+	 * @return true for recordings and time-shifted live streams, false otherwise.
+	 */
+	bool IsSeekable() const;
+
+	/**
+	 * Open a multiview of several NDI streams.
+	 *
+	 * The tiles' receivers are created on the connection monitor thread, and the
+	 * multiview is opened once all of them were created.
+	 *
+	 * @param Url The multiview URL, i.e. "ndimv://Source1|Source2|Source3".
+	 * @param Options The media options.
+	 * @return true if opening started, false otherwise.
+	 * @see FinishOpenMultiview
+	 */
+	bool OpenMultiview(const FString& Url, const IMediaOptions& Options);
+
+	/**
+	 * Open an NDI recording for playback.
+	 *
+	 * The recording file is memory mapped if it exists, otherwise the archive is read.
+	 *
+	 * @param Url The URL of the recording file.
+	 * @param Archive Optional archive to read the recording from.
+	 * @param Options The media options.
+	 * @return true on success, false otherwise.
+	 */
+	bool OpenReplay(const FString& Url, FArchive* Archive, const IMediaOptions& Options);
+
 	/**
 	 * Process a received audio frame.
 	 *
@@ -116,29 +307,184 @@ protected:
 	void ProcessAudioFrame(const NDIlib_audio_frame_v2_t& AudioFrame);
 
 	/**
-	 * Process a received audio frame.
+	 * Forward the metadata attached to an audio or video frame to the metadata sink.
 	 *
-	 * @param AudioFrame The audio frame to process.
+	 * Frame metadata is delivered with the timecode of the frame it was attached to,
+	 * and with the frame's duration, which distinguishes it from metadata frames
+	 * received on the metadata channel (those have a duration of zero).
+	 *
+	 * @param Metadata The frame's null-terminated metadata string.
+	 * @param Timecode The frame's timecode.
+	 * @param Duration The frame's duration.
+	 * @see ProcessAudioFrame, ProcessVideoFrame
+	 */
+	void ProcessFrameMetadata(const char* Metadata, int64 Timecode, FTimespan Duration);
+
+	/**
+	 * Process a received metadata frame.
+	 *
+	 * The caller must hold the critical section.
+	 *
+	 * @param MetadataFrame The metadata frame to process.
+	 */
+	void ProcessMetadataFrame(const NDIlib_metadata_frame_t& MetadataFrame);
+
+	/**
+	 * Forward a video frame of the current recording to the sink.
+	 *
+	 * @param FrameIndex Index of the frame in the recording.
+	 * @see ProcessVideoFrame
+	 */
+	void ProcessReplayVideoFrame(int32 FrameIndex);
+
+	/**
+	 * Forward the time-shifted video frame that is visible at the given time to the sink.
+	 *
+	 * @param Time The arrival time of the frame (in 100ns ticks).
+	 * @return true if the frame was available, false if there is none or it is still being read.
 	 * @see ProcessVideoFrame
 	 */
-	void ProcessVideoFrame(const NDIlib_video_frame_v2_t& VideoFrame);
+	bool ProcessTimeShiftVideoFrame(int64 Time);
+
+	/**
+	 * Process a received video frame.
+	 *
+	 * @param InVideoFrame The video frame to process.
+	 * @see ProcessAudioFrame
+	 */
+	void ProcessVideoFrame(const NDIlib_video_frame_v2_t& InVideoFrame);
+
+	/**
+	 * Continue playback on a different receiver.
+	 *
+	 * The previous receiver remains owned by the caller.
+	 *
+	 * @param NewReceiverInstance The new receiver instance.
+	 * @param SourceName The name or IP endpoint of the new receiver's source.
+	 */
+	void ReplaceReceiver(void* NewReceiverInstance, const FString& SourceName);
+
+	/**
+	 * Move the playback position of the current recording.
+	 *
+	 * @param Time The new position (clamped to the recording's duration).
+	 * @see TickReplay
+	 */
+	void SeekReplay(FTimespan Time);
+
+	/**
+	 * Move the playback position within the time-shift buffer.
+	 *
+	 * Seeking to the end of the buffer returns to the live stream, unless the player is paused.
+	 *
+	 * @param Position The new position (as arrival time in 100ns ticks).
+	 * @see TickTimeShift
+	 */
+	void SeekTimeShift(int64 Position);
+
+	/** Start playing the live stream from the time-shift buffer at its newest frame. */
+	void StartTimeShift();
+
+	/**
+	 * Continue playback on the failover's standby receiver.
+	 *
+	 * @see Failover
+	 */
+	void SwitchToStandby();
+
+	/** Apply the connection changes that the connection monitor published. */
+	void TickConnection();
+
+	/** Composite the newest frames of a multiview and forward the output to the sink if it changed. */
+	void TickMultiview();
 
 	/**
-	 * Send the given metadata to the connection.
+	 * Deliver the frames of the current recording up to the playback position.
 	 *
-	 * @param Metadata The metadata to send.
-	 * @param Timecode Optional timecode (default = 0).
+	 * @param DeltaTime Time since the last tick.
+	 * @see SeekReplay
 	 */
-	void SendMetadata(const FString& Metadata, int64 Timecode = 0);
+	void TickReplay(float DeltaTime);
 
-	/** Update the audio sampler's receiver instance. */
+	/** Present the video frame that the sync group selected for this player, if any. */
+	void TickSyncGroup();
+
+	/**
+	 * Deliver the frames of the time-shift buffer up to the playback position.
+	 *
+	 * @param DeltaTime Time since the last tick.
+	 * @see SeekTimeShift
+	 */
+	void TickTimeShift(float DeltaTime);
+
+	/**
+	 * Update the audio sampler's receiver instance.
+	 *
+	 * The caller must not hold the critical section.
+	 */
 	void UpdateAudioSampler();
 
+	/**
+	 * Update the metadata sampler's receiver instance.
+	 *
+	 * The caller must not hold the critical section.
+	 */
+	void UpdateMetadataSampler();
+
+	/** Report to the source whether the player's stream is on preview or program output. */
+	void UpdateTally();
+
+protected:
+
+	/**
+	 * Get the display name of a deinterlacing mode.
+	 *
+	 * @param Mode The deinterlacing mode.
+	 * @return Display name.
+	 */
+	static FString GetDeinterlaceModeName(ENdiMediaDeinterlaceMode Mode);
+
+	/**
+	 * Get the display name of a tally mode.
+	 *
+	 * @param Mode The tally mode.
+	 * @return Display name.
+	 */
+	static FString GetTallyModeName(ENdiMediaTallyMode Mode);
+
 private:
 
 	/** Callback for new samples from the audio sampler thread. */
 	void HandleAudioSamplerSample(const NDIlib_audio_frame_v2_t& AudioFrame);
 
+	/** Callback for new frames from the metadata sampler thread. */
+	void HandleMetadataSamplerFrame(const NDIlib_metadata_frame_t& MetadataFrame);
+
+protected:
+
+	/** A live stream whose receiver is being created on the connection monitor thread. */
+	struct FPendingOpen
+	{
+		/** The names or IP endpoints of the failover's sources (empty if no failover). */
+		TArray<FString> FailoverSources;
+
+		/** The directory that the stream is recorded to (empty if not recording). */
+		FString RecordingDirectory;
+
+		/** The receiver request (nullptr if no open is pending). */
+		TSharedPtr<FNdiMediaReceiverRequest, ESPMode::ThreadSafe> Request;
+
+		/** Time at which the stream was opened (in seconds). */
+		double RequestTime;
+
+	public:
+
+		/** Default constructor. */
+		FPendingOpen()
+			: RequestTime(0.0)
+		{ }
+	};
+
 private:
 
 	/** The currently used audio sink. */
@@ -163,9 +509,27 @@ private:
 
 private:
 
+	/** CPU cost of converting audio frames. */
+	FNdiMediaStageStats AudioConversionStats;
+
 	/** The audio sampler thread. */
 	FNdiMediaAudioSampler* AudioSampler;
 
+	/** The backend that the current receiver was created on. */
+	TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> Backend;
+
+	/** Converts video formats that texture sinks can't accept. */
+	FNdiMediaColorConverter* ColorConverter;
+
+	/** Whether the receiver is connected, as last reported by the connection monitor. */
+	bool Connected;
+
+	/** The monitor that creates, supervises and destroys the receiver (nullptr if no live stream is open). */
+	TSharedPtr<FNdiMediaConnectionMonitor, ESPMode::ThreadSafe> ConnectionMonitor;
+
+	/** The receiver's connection events (nullptr if not monitored). */
+	TSharedPtr<FNdiMediaConnectionWatch, ESPMode::ThreadSafe> ConnectionWatch;
+
 	/** Critical section for synchronizing access to receiver and sinks. */
 	FCriticalSection CriticalSection;
 
@@ -175,30 +539,123 @@ private:
 	/** The currently opened URL. */
 	FString CurrentUrl;
 
+	/** Converts fielded and interleaved video to progressive frames. */
+	FNdiMediaDeinterlacer* Deinterlacer;
+
+	/** Switches to backup sources when the receiver's health drops. */
+	FNdiMediaFailover* Failover;
+
 	/** Number of audio channels in the last received sample. */
 	int32 LastAudioChannels;
 
 	/** Audio sample rate in the last received sample. */
 	int32 LastAudioSampleRate;
 
-	/** Buffer dimensions in the last received sample. */
-	FIntPoint LastBufferDim;
+	/** Index of the recording's video frame that was last sent to the sink. */
+	int32 LastReplayVideoFrame;
 
-	/** Video dimensions in the last received sample. */
-	FIntPoint LastVideoDim;
+	/** Arrival time of the time-shifted video frame that was last sent to the sink. */
+	int64 LastTimeShiftVideoTime;
 
 	/** Video frame rate in the last received sample. */
 	float LastVideoFrameRate;
 
+	/** Video format of the last received sample. */
+	FNdiMediaVideoFormat LastVideoFormat;
+
+	/** Whether recordings loop when their end is reached. */
+	bool Looping;
+
 	/** Event delegate that is invoked when a media event occurred. */
 	FOnMediaEvent MediaEvent;
 
+	/** Whether the receiver only receives metadata (no audio or video). */
+	bool MetadataOnly;
+
+	/** The metadata sampler thread (used for metadata-only receivers). */
+	FNdiMediaMetadataSampler* MetadataSampler;
+
+	/** Composites the streams of a multiview. */
+	FNdiMediaMultiviewCompositor* Multiview;
+
+	/** How long it took to open the current live stream (in seconds). */
+	double OpenDuration;
+
 	/** Whether the player is paused. */
 	bool Paused;
 
+	/** The live stream that is being opened. */
+	FPendingOpen PendingOpen;
+
+	/** Whether the video frame at the time-shift position is still being read from the spill file. */
+	bool PendingTimeShiftSeek;
+
+	/** Playback rate of recordings and time-shifted streams. */
+	float PlaybackRate;
+
+	/** How long the connection monitor took to create the current receiver (in seconds). */
+	double ReceiverCreateDuration;
+
 	/** The current receiver instance. */
 	void* ReceiverInstance;
 
-	/** The current video sink format. */
-	EMediaTextureSinkFormat VideoSinkFormat;
+	/** Records the received stream to disk. */
+	FNdiMediaRecorder* Recorder;
+
+	/** Index of the next recording frame to be delivered. */
+	int32 ReplayCursor;
+
+	/** Whether playback reached the end of the recording. */
+	bool ReplayEnded;
+
+	/** Whether a recording is being played back (as opposed to a live stream). */
+	bool Replaying;
+
+	/** Reads frames from the current recording. */
+	FNdiMediaRecordingReader* ReplayReader;
+
+	/** Playback position in the current recording. */
+	FTimespan ReplayTime;
+
+	/** Downscales video frames that exceed the preferred size. */
+	FNdiMediaVideoResizer* Resizer;
+
+	/** The tally that was last reported to the source (bit 0 = preview, bit 1 = program, INDEX_NONE = not reported). */
+	int32 SentTally;
+
+	/** The sync group that the player's video is presented with (nullptr if not synchronized). */
+	TSharedPtr<FNdiMediaSyncGroup, ESPMode::ThreadSafe> SyncGroup;
+
+	/** The player's identifier in its sync group. */
+	int32 SyncGroupMemberId;
+
+	/** How tally is reported to the source. */
+	ENdiMediaTallyMode TallyMode;
+
+	/** Buffers the live stream for pausing, rewinding and instant replay. */
+	FNdiMediaTimeShiftBuffer* TimeShiftBuffer;
+
+	/** Whether the live stream is played from the time-shift buffer. */
+	bool TimeShifted;
+
+	/** Playback position in the time-shift buffer (as arrival time in 100ns ticks). */
+	int64 TimeShiftPosition;
+
+	/** The last FourCC code that was rejected as unsupported. */
+	uint32 UnsupportedFourCC;
+
+	/** CPU cost of capturing video frames. */
+	FNdiMediaStageStats VideoCaptureStats;
+
+	/** Whether the current video sink has been initialized with VideoSinkFormat. */
+	bool VideoSinkInitialized;
+
+	/** Number of times the video sink had to be reinitialized due to format changes. */
+	uint32 VideoSinkReinitializations;
+
+	/** The video format that the current video sink was initialized with. */
+	FNdiMediaVideoFormat VideoSinkFormat;
+
+	/** CPU cost of forwarding video frames to the sink. */
+	FNdiMediaStageStats VideoUploadStats;
 };
@@ -0,0 +1,108 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaTally.h"
+#include "NdiMediaPrivate.h"
+
+#include "HAL/PlatformTime.h"
+#include "MediaPlayer.h"
+#include "MediaTexture.h"
+#include "Misc/App.h"
+#include "NdiMediaSource.h"
+#include "TextureResource.h"
+#include "UObject/UObjectIterator.h"
+
+
+namespace NdiMediaTally
+{
+	/** The tally mode overrides, keyed by media URL. */
+	static TMap<FString, ENdiMediaTallyMode> Overrides;
+
+	/** How long a texture counts as drawn after it was last rendered (in seconds). */
+	static const double RenderedTimeout = 1.0;
+
+	/** The media URLs whose textures were drawn when the textures were last scanned. */
+	static TSet<FString> RenderedUrls;
+
+	/** Time at which the textures were last scanned (in seconds). */
+	static double ScanTime = 0.0;
+
+	/** Shortest time between texture scans (in seconds). */
+	static const double ScanInterval = 0.25;
+}
+
+
+/* FNdiMediaTally interface
+ *****************************************************************************/
+
+bool FNdiMediaTally::GetOverride(const FString& Url, ENdiMediaTallyMode& OutMode)
+{
+	check(IsInGameThread());
+
+	const ENdiMediaTallyMode* Mode = NdiMediaTally::Overrides.Find(Url);
+
+	if (Mode == nullptr)
+	{
+		return false;
+	}
+
+	OutMode = *Mode;
+
+	return true;
+}
+
+
+bool FNdiMediaTally::IsRendered(const FString& Url)
+{
+	using namespace NdiMediaTally;
+
+	check(IsInGameThread());
+
+	const double Now = FPlatformTime::Seconds();
+
+	if (Now - ScanTime >= ScanInterval)
+	{
+		ScanTime = Now;
+		RenderedUrls.Reset();
+
+		// render times are set by the renderer from the application clock
+		const double CurrentTime = FApp::GetCurrentTime();
+
+		for (TObjectIterator<UMediaTexture> It; It; ++It)
+		{
+			UMediaTexture* MediaTexture = *It;
+
+			if ((MediaTexture->MediaPlayer == nullptr) || (MediaTexture->Resource == nullptr))
+			{
+				continue;
+			}
+
+			if (CurrentTime - MediaTexture->Resource->LastRenderTime <= RenderedTimeout)
+			{
+				RenderedUrls.Add(MediaTexture->MediaPlayer->GetUrl());
+			}
+		}
+	}
+
+	return RenderedUrls.Contains(Url);
+}
+
+
+void FNdiMediaTally::SetOverride(const FString& Url, ENdiMediaTallyMode Mode)
+{
+	check(IsInGameThread());
+
+	if (Url.IsEmpty())
+	{
+		return;
+	}
+
+	// automatic mode falls back to the media source's setting
+	if (Mode == ENdiMediaTallyMode::Automatic)
+	{
+		NdiMediaTally::Overrides.Remove(Url);
+	}
+	else
+	{
+		NdiMediaTally::Overrides.Add(Url, Mode);
+	}
+}
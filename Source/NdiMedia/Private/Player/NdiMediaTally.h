@@ -0,0 +1,51 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+enum class ENdiMediaTallyMode : uint8;
+
+
+/**
+ * Tracks the information that players need for reporting tally to their sources.
+ *
+ * Tally modes can be overridden per media URL at runtime, which affects all
+ * players of that URL. Whether a URL is drawn is determined from the media
+ * textures of all media players: a texture that was rendered recently counts
+ * as drawn. Media textures are scanned a few times per second at most.
+ *
+ * All functions must be called on the game thread.
+ */
+class FNdiMediaTally
+{
+public:
+
+	/**
+	 * Get the tally mode override of a media URL.
+	 *
+	 * @param Url The media URL.
+	 * @param OutMode Will contain the tally mode.
+	 * @return true if the URL's tally mode is overridden, false otherwise.
+	 * @see SetOverride
+	 */
+	static bool GetOverride(const FString& Url, ENdiMediaTallyMode& OutMode);
+
+	/**
+	 * Whether the video of a media URL is drawn by a media texture.
+	 *
+	 * @param Url The media URL.
+	 * @return true if drawn, false otherwise.
+	 */
+	static bool IsRendered(const FString& Url);
+
+	/**
+	 * Override the tally mode of a media URL.
+	 *
+	 * @param Url The media URL.
+	 * @param Mode The tally mode.
+	 * @see GetOverride
+	 */
+	static void SetOverride(const FString& Url, ENdiMediaTallyMode Mode);
+};
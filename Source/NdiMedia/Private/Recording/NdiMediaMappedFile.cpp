@@ -0,0 +1,147 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaMappedFile.h"
+#include "NdiMediaPrivate.h"
+
+#include "Misc/Paths.h"
+
+#if PLATFORM_WINDOWS
+	#include "Windows/WindowsHWrapper.h"
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#else
+	#include "Misc/FileHelper.h"
+#endif
+
+
+/* FNdiMediaMappedFile structors
+ *****************************************************************************/
+
+FNdiMediaMappedFile::FNdiMediaMappedFile()
+#if PLATFORM_WINDOWS
+	: FileHandle(INVALID_HANDLE_VALUE)
+	, MappingHandle(nullptr)
+	, Data(nullptr)
+#else
+	: Data(nullptr)
+#endif
+	, Size(0)
+{ }
+
+
+FNdiMediaMappedFile::~FNdiMediaMappedFile()
+{
+	Close();
+}
+
+
+/* FNdiMediaMappedFile interface
+ *****************************************************************************/
+
+void FNdiMediaMappedFile::Close()
+{
+#if PLATFORM_WINDOWS
+	if (Data != nullptr)
+	{
+		::UnmapViewOfFile(Data);
+	}
+
+	if (MappingHandle != nullptr)
+	{
+		::CloseHandle(MappingHandle);
+		MappingHandle = nullptr;
+	}
+
+	if (FileHandle != INVALID_HANDLE_VALUE)
+	{
+		::CloseHandle(FileHandle);
+		FileHandle = INVALID_HANDLE_VALUE;
+	}
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	if (Data != nullptr)
+	{
+		munmap((void*)Data, Size);
+	}
+#else
+	Buffer.Empty();
+#endif
+
+	Data = nullptr;
+	Size = 0;
+}
+
+
+bool FNdiMediaMappedFile::Open(const FString& FilePath)
+{
+	Close();
+
+	const FString FullPath = FPaths::ConvertRelativePathToFull(FilePath);
+
+#if PLATFORM_WINDOWS
+	FileHandle = ::CreateFileW(*FullPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+
+	if (FileHandle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER FileSize;
+
+	if (!::GetFileSizeEx(FileHandle, &FileSize) || (FileSize.QuadPart <= 0))
+	{
+		Close();
+		return false;
+	}
+
+	MappingHandle = ::CreateFileMappingW(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (MappingHandle == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	Data = (const uint8*)::MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0);
+	Size = (uint64)FileSize.QuadPart;
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	const int Descriptor = open(TCHAR_TO_UTF8(*FullPath), O_RDONLY | O_CLOEXEC);
+
+	if (Descriptor == -1)
+	{
+		return false;
+	}
+
+	struct stat FileStat;
+
+	if ((fstat(Descriptor, &FileStat) == 0) && (FileStat.st_size > 0))
+	{
+		void* Mapping = mmap(nullptr, (size_t)FileStat.st_size, PROT_READ, MAP_SHARED, Descriptor, 0);
+
+		if (Mapping != MAP_FAILED)
+		{
+			Data = (const uint8*)Mapping;
+			Size = (uint64)FileStat.st_size;
+		}
+	}
+
+	// the mapping keeps the file alive
+	close(Descriptor);
+#else
+	if (FFileHelper::LoadFileToArray(Buffer, *FullPath) && (Buffer.Num() > 0))
+	{
+		Data = Buffer.GetData();
+		Size = Buffer.Num();
+	}
+#endif
+
+	if (Data == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
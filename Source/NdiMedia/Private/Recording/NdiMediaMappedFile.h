@@ -0,0 +1,95 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/**
+ * Implements a read-only view of a file that is mapped into memory.
+ *
+ * The file's pages are loaded on demand by the operating system, so opening
+ * even very large recordings is instant and frames can be accessed in place
+ * without copying them. Platforms without memory mapping support load the
+ * entire file instead.
+ */
+class FNdiMediaMappedFile
+{
+public:
+
+	/** Default constructor. */
+	FNdiMediaMappedFile();
+
+	/** Destructor. */
+	~FNdiMediaMappedFile();
+
+public:
+
+	/**
+	 * Unmap the file.
+	 *
+	 * @see IsOpen, Open
+	 */
+	void Close();
+
+	/**
+	 * Get the mapped file data.
+	 *
+	 * @return The data, or nullptr if the file is not open.
+	 * @see GetSize
+	 */
+	const uint8* GetData() const
+	{
+		return Data;
+	}
+
+	/**
+	 * Get the size of the mapped file.
+	 *
+	 * @return Size (in bytes).
+	 * @see GetData
+	 */
+	uint64 GetSize() const
+	{
+		return Size;
+	}
+
+	/**
+	 * Whether a file is mapped.
+	 *
+	 * @return true if mapped, false otherwise.
+	 * @see Close, Open
+	 */
+	bool IsOpen() const
+	{
+		return (Data != nullptr);
+	}
+
+	/**
+	 * Map a file into memory.
+	 *
+	 * @param FilePath Path to the file to map.
+	 * @return true on success, false otherwise.
+	 * @see Close, IsOpen
+	 */
+	bool Open(const FString& FilePath);
+
+private:
+
+#if PLATFORM_WINDOWS
+	/** The file handle (INVALID_HANDLE_VALUE if closed). */
+	void* FileHandle;
+
+	/** The file mapping handle (nullptr if closed). */
+	void* MappingHandle;
+#elif !PLATFORM_LINUX && !PLATFORM_MAC
+	/** The file contents (on platforms without memory mapping). */
+	TArray<uint8> Buffer;
+#endif
+
+	/** The mapped file data. */
+	const uint8* Data;
+
+	/** Size of the mapped file (in bytes). */
+	uint64 Size;
+};
@@ -0,0 +1,535 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaRecorder.h"
+#include "NdiMediaPrivate.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/DateTime.h"
+#include "Misc/ScopeLock.h"
+#include "NdiMediaRecordingFile.h"
+#include "NdiMediaRecordingFrames.h"
+
+
+/* FNdiMediaRecorder structors
+ *****************************************************************************/
+
+FNdiMediaRecorder::FNdiMediaRecorder()
+	: BytesWritten(0)
+	, CurrentChunk(nullptr)
+	, File(new FNdiMediaRecordingFile)
+	, Failed(false)
+	, FirstChunkEntry(0)
+	, FirstTimecode(0)
+	, LastTimecode(0)
+	, NextChunkOffset(0)
+	, NumAllocatedChunks(0)
+	, NumChunks(0)
+	, NumDroppedFrames(0)
+	, NumPendingChunks(0)
+	, PreallocatedSize(0)
+	, Recording(false)
+	, Stopping(false)
+	, Thread(nullptr)
+	, WorkEvent(FPlatformProcess::GetSynchEventFromPool(false))
+{ }
+
+
+FNdiMediaRecorder::~FNdiMediaRecorder()
+{
+	Close();
+
+	delete File;
+	File = nullptr;
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	WorkEvent = nullptr;
+}
+
+
+/* FNdiMediaRecorder interface
+ *****************************************************************************/
+
+void FNdiMediaRecorder::Close()
+{
+	if (!Recording)
+	{
+		return;
+	}
+
+	// stop accepting frames and flush the partial chunk
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		Recording = false;
+
+		if (CurrentChunk != nullptr)
+		{
+			if (CurrentChunk->Size > sizeof(FNdiMediaRecordingChunkHeader))
+			{
+				SubmitChunk();
+			}
+			else
+			{
+				FreeChunks.Push(CurrentChunk);
+				CurrentChunk = nullptr;
+			}
+		}
+	}
+
+	// wait for the I/O thread to drain the queue
+	if (Thread != nullptr)
+	{
+		Stopping = true;
+		WorkEvent->Trigger();
+
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	if (!Failed && !WriteIndex())
+	{
+		UE_LOG(LogNdiMedia, Error, TEXT("Failed to write the index of NDI recording %s"), *FilePath);
+		Failed = true;
+	}
+
+	File->Close();
+
+	UE_LOG(LogNdiMedia, Log, TEXT("Finished NDI recording %s: %i frames, %llu dropped, %.1f MB%s"),
+		*FilePath,
+		Index.Num(),
+		NumDroppedFrames,
+		BytesWritten / (1024.0 * 1024.0),
+		Failed ? TEXT(" (incomplete)") : TEXT("")
+	);
+
+	// release chunk buffers
+	for (FChunk* Chunk : FreeChunks)
+	{
+		FMemory::Free(Chunk->Data);
+		delete Chunk;
+	}
+
+	FreeChunks.Empty();
+	Index.Empty();
+	FilePath.Empty();
+	NumAllocatedChunks = 0;
+}
+
+
+FNdiMediaRecorderStats FNdiMediaRecorder::GetStats() const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FNdiMediaRecorderStats Stats;
+	{
+		Stats.BytesWritten = BytesWritten;
+		Stats.NumDroppedFrames = NumDroppedFrames;
+		Stats.NumFrames = Index.Num();
+		Stats.NumPendingChunks = NumPendingChunks;
+		Stats.Unbuffered = File->IsUnbuffered();
+		Stats.Writes = WriteStats;
+	}
+
+	return Stats;
+}
+
+
+bool FNdiMediaRecorder::Open(const FString& InFilePath, const FString& SourceName, const FNdiMediaRecorderSettings& InSettings)
+{
+	Close();
+
+	if (!File->OpenWrite(InFilePath))
+	{
+		UE_LOG(LogNdiMedia, Error, TEXT("Failed to create NDI recording %s"), *InFilePath);
+		return false;
+	}
+
+	Settings = InSettings;
+	Settings.ChunkSize = (uint32)NdiMediaRecording::AlignSize(FMath::Max<uint32>(Settings.ChunkSize, NdiMediaRecording::Alignment), NdiMediaRecording::Alignment);
+	Settings.MaxPendingChunks = FMath::Max(Settings.MaxPendingChunks, 1);
+
+	// the file header occupies the first alignment unit
+	uint8* HeaderBuffer = (uint8*)FMemory::Malloc(NdiMediaRecording::Alignment, NdiMediaRecording::Alignment);
+	FMemory::Memzero(HeaderBuffer, NdiMediaRecording::Alignment);
+
+	FNdiMediaRecordingFileHeader& FileHeader = *(FNdiMediaRecordingFileHeader*)HeaderBuffer;
+	{
+		FileHeader.Magic = NdiMediaRecording::FileMagic;
+		FileHeader.Version = NdiMediaRecording::Version;
+		FileHeader.Alignment = NdiMediaRecording::Alignment;
+		FileHeader.CreationTime = FDateTime::UtcNow().GetTicks();
+
+		FTCHARToUTF8 SourceNameUtf8(*SourceName);
+		FMemory::Memcpy(FileHeader.SourceName, SourceNameUtf8.Get(), FMath::Min<int32>(SourceNameUtf8.Length(), sizeof(FileHeader.SourceName) - 1));
+	}
+
+	const bool HeaderWritten = File->Write(HeaderBuffer, NdiMediaRecording::Alignment, 0);
+	FMemory::Free(HeaderBuffer);
+
+	if (!HeaderWritten)
+	{
+		UE_LOG(LogNdiMedia, Error, TEXT("Failed to write NDI recording %s"), *InFilePath);
+		File->Close();
+
+		return false;
+	}
+
+	PreallocatedSize = 0;
+
+	if ((Settings.PreallocationSize > 0) && File->Preallocate(Settings.PreallocationSize))
+	{
+		PreallocatedSize = Settings.PreallocationSize;
+	}
+
+	BytesWritten = NdiMediaRecording::Alignment;
+	Failed = false;
+	FilePath = InFilePath;
+	FirstChunkEntry = 0;
+	FirstTimecode = 0;
+	LastTimecode = 0;
+	NextChunkOffset = NdiMediaRecording::Alignment;
+	NumChunks = 0;
+	NumDroppedFrames = 0;
+	NumPendingChunks = 0;
+	Stopping = false;
+	WriteStats.Reset();
+
+	Recording = true;
+	Thread = FRunnableThread::Create(this, TEXT("FNdiMediaRecorder"), 0, TPri_AboveNormal);
+
+	UE_LOG(LogNdiMedia, Log, TEXT("Started NDI recording %s (%s I/O)"), *FilePath, File->IsUnbuffered() ? TEXT("unbuffered") : TEXT("buffered"));
+
+	return true;
+}
+
+
+void FNdiMediaRecorder::WriteAudioFrame(const NDIlib_audio_frame_v2_t& AudioFrame)
+{
+	if (!Recording || (AudioFrame.p_data == nullptr))
+	{
+		return;
+	}
+
+	FNdiMediaRecordingFrameHeader Header;
+	NdiMediaRecording::MakeAudioHeader(AudioFrame, Header);
+
+	FScopeLock Lock(&CriticalSection);
+
+	uint8* Dest = BeginRecord(Header);
+
+	if (Dest != nullptr)
+	{
+		NdiMediaRecording::CopyAudioData(AudioFrame, Header, Dest);
+	}
+}
+
+
+void FNdiMediaRecorder::WriteMetadataFrame(const NDIlib_metadata_frame_t& MetadataFrame)
+{
+	if (!Recording || (MetadataFrame.p_data == nullptr) || (MetadataFrame.length <= 0))
+	{
+		return;
+	}
+
+	FNdiMediaRecordingFrameHeader Header;
+	NdiMediaRecording::MakeMetadataHeader(MetadataFrame, Header);
+
+	FScopeLock Lock(&CriticalSection);
+
+	uint8* Dest = BeginRecord(Header);
+
+	if (Dest != nullptr)
+	{
+		NdiMediaRecording::CopyMetadataData(MetadataFrame, Header, Dest);
+	}
+}
+
+
+void FNdiMediaRecorder::WriteVideoFrame(const NDIlib_video_frame_v2_t& VideoFrame)
+{
+	if (!Recording || (VideoFrame.p_data == nullptr))
+	{
+		return;
+	}
+
+	FNdiMediaRecordingFrameHeader Header;
+	NdiMediaRecording::MakeVideoHeader(VideoFrame, Header);
+
+	FScopeLock Lock(&CriticalSection);
+
+	uint8* Dest = BeginRecord(Header);
+
+	if (Dest != nullptr)
+	{
+		NdiMediaRecording::CopyVideoData(VideoFrame, Header, Dest);
+	}
+}
+
+
+/* FRunnable interface
+ *****************************************************************************/
+
+bool FNdiMediaRecorder::Init()
+{
+	return true;
+}
+
+
+uint32 FNdiMediaRecorder::Run()
+{
+	while (true)
+	{
+		// chunks submitted before the stop request are still written
+		const bool StopRequested = Stopping;
+
+		FChunk* Chunk = nullptr;
+
+		while (PendingChunks.Dequeue(Chunk))
+		{
+			if (!Failed && !WriteChunk(*Chunk))
+			{
+				UE_LOG(LogNdiMedia, Error, TEXT("Failed to write NDI recording %s. Recording stopped."), *FilePath);
+				Failed = true;
+			}
+
+			FScopeLock Lock(&CriticalSection);
+
+			FreeChunks.Push(Chunk);
+			--NumPendingChunks;
+		}
+
+		if (StopRequested)
+		{
+			break;
+		}
+
+		WorkEvent->Wait(100);
+	}
+
+	return 0;
+}
+
+
+void FNdiMediaRecorder::Stop()
+{
+	Stopping = true;
+	WorkEvent->Trigger();
+}
+
+
+/* FNdiMediaRecorder implementation
+ *****************************************************************************/
+
+FNdiMediaRecorder::FChunk* FNdiMediaRecorder::AcquireChunk(uint64 MinCapacity)
+{
+	FChunk* Chunk = nullptr;
+
+	if (FreeChunks.Num() > 0)
+	{
+		Chunk = FreeChunks.Pop(false);
+	}
+	else if (NumAllocatedChunks <= Settings.MaxPendingChunks)
+	{
+		Chunk = new FChunk;
+		{
+			Chunk->Capacity = 0;
+			Chunk->Data = nullptr;
+		}
+
+		++NumAllocatedChunks;
+	}
+	else
+	{
+		return nullptr;
+	}
+
+	// frames that are larger than a chunk get a chunk of their own
+	if (Chunk->Capacity < MinCapacity)
+	{
+		FMemory::Free(Chunk->Data);
+
+		Chunk->Capacity = NdiMediaRecording::AlignSize(FMath::Max<uint64>(Settings.ChunkSize, MinCapacity), NdiMediaRecording::Alignment);
+		Chunk->Data = (uint8*)FMemory::Malloc(Chunk->Capacity, NdiMediaRecording::Alignment);
+	}
+
+	Chunk->Offset = 0;
+	Chunk->Size = sizeof(FNdiMediaRecordingChunkHeader);
+
+	FNdiMediaRecordingChunkHeader& ChunkHeader = *(FNdiMediaRecordingChunkHeader*)Chunk->Data;
+	{
+		FMemory::Memzero(ChunkHeader);
+		ChunkHeader.Magic = NdiMediaRecording::ChunkMagic;
+	}
+
+	return Chunk;
+}
+
+
+uint8* FNdiMediaRecorder::BeginRecord(const FNdiMediaRecordingFrameHeader& Header)
+{
+	if (!Recording || Failed)
+	{
+		return nullptr;
+	}
+
+	const uint64 PayloadSize = sizeof(FNdiMediaRecordingFrameHeader) + Header.DataSize + Header.MetadataSize;
+	const uint64 RecordSize = NdiMediaRecording::AlignSize(PayloadSize, NdiMediaRecording::RecordAlignment);
+
+	if ((CurrentChunk != nullptr) && (CurrentChunk->Size + RecordSize > CurrentChunk->Capacity))
+	{
+		SubmitChunk();
+	}
+
+	if (CurrentChunk == nullptr)
+	{
+		CurrentChunk = AcquireChunk(sizeof(FNdiMediaRecordingChunkHeader) + RecordSize);
+
+		if (CurrentChunk == nullptr)
+		{
+			++NumDroppedFrames;
+			return nullptr;
+		}
+	}
+
+	uint8* Record = CurrentChunk->Data + CurrentChunk->Size;
+
+	FMemory::Memcpy(Record, &Header, sizeof(FNdiMediaRecordingFrameHeader));
+	FMemory::Memzero(Record + PayloadSize, RecordSize - PayloadSize);
+
+	// file offsets are relative to the chunk until the chunk is submitted
+	FNdiMediaRecordingIndexEntry& Entry = Index[Index.AddUninitialized()];
+	{
+		Entry.Timecode = Header.Timecode;
+		Entry.Offset = CurrentChunk->Size;
+		Entry.Size = (uint32)RecordSize;
+		Entry.Type = Header.Type;
+	}
+
+	FNdiMediaRecordingChunkHeader& ChunkHeader = *(FNdiMediaRecordingChunkHeader*)CurrentChunk->Data;
+	{
+		if (ChunkHeader.NumRecords == 0)
+		{
+			ChunkHeader.FirstTimecode = Header.Timecode;
+		}
+
+		ChunkHeader.LastTimecode = Header.Timecode;
+		++ChunkHeader.NumRecords;
+	}
+
+	if (Index.Num() == 1)
+	{
+		FirstTimecode = Header.Timecode;
+	}
+
+	LastTimecode = Header.Timecode;
+	CurrentChunk->Size += RecordSize;
+
+	return Record + sizeof(FNdiMediaRecordingFrameHeader);
+}
+
+
+void FNdiMediaRecorder::SubmitChunk()
+{
+	check(CurrentChunk != nullptr);
+
+	const uint64 AlignedSize = NdiMediaRecording::AlignSize(CurrentChunk->Size, NdiMediaRecording::Alignment);
+	FMemory::Memzero(CurrentChunk->Data + CurrentChunk->Size, AlignedSize - CurrentChunk->Size);
+
+	FNdiMediaRecordingChunkHeader& ChunkHeader = *(FNdiMediaRecordingChunkHeader*)CurrentChunk->Data;
+	{
+		ChunkHeader.Size = AlignedSize;
+		ChunkHeader.Sequence = NumChunks;
+	}
+
+	CurrentChunk->Offset = NextChunkOffset;
+	CurrentChunk->Size = AlignedSize;
+
+	for (int32 EntryIndex = FirstChunkEntry; EntryIndex < Index.Num(); ++EntryIndex)
+	{
+		Index[EntryIndex].Offset += NextChunkOffset;
+	}
+
+	FirstChunkEntry = Index.Num();
+	NextChunkOffset += AlignedSize;
+	++NumChunks;
+	++NumPendingChunks;
+
+	PendingChunks.Enqueue(CurrentChunk);
+	CurrentChunk = nullptr;
+
+	WorkEvent->Trigger();
+}
+
+
+bool FNdiMediaRecorder::WriteChunk(FChunk& Chunk)
+{
+	const uint64 EndOffset = Chunk.Offset + Chunk.Size;
+
+	// reserve space well ahead of the writes; if the file system
+	// doesn't support preallocation, the file just grows as usual
+	if ((PreallocatedSize > 0) && (EndOffset > PreallocatedSize))
+	{
+		const uint64 NewSize = EndOffset + Settings.PreallocationSize;
+		PreallocatedSize = File->Preallocate(NewSize) ? NewSize : 0;
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	if (!File->Write(Chunk.Data, Chunk.Size, Chunk.Offset))
+	{
+		return false;
+	}
+
+	FScopeLock Lock(&CriticalSection);
+
+	BytesWritten += Chunk.Size;
+	WriteStats.Add(FPlatformTime::Cycles64() - StartCycles);
+
+	return true;
+}
+
+
+bool FNdiMediaRecorder::WriteIndex()
+{
+	const uint64 IndexSize = Index.Num() * sizeof(FNdiMediaRecordingIndexEntry);
+	const uint64 BufferSize = NdiMediaRecording::AlignSize(IndexSize + sizeof(FNdiMediaRecordingFooter), NdiMediaRecording::Alignment);
+
+	uint8* Buffer = (uint8*)FMemory::Malloc(BufferSize, NdiMediaRecording::Alignment);
+	FMemory::Memzero(Buffer, BufferSize);
+	FMemory::Memcpy(Buffer, Index.GetData(), IndexSize);
+
+	// the footer occupies the last bytes of the file
+	FNdiMediaRecordingFooter& Footer = *(FNdiMediaRecordingFooter*)(Buffer + BufferSize - sizeof(FNdiMediaRecordingFooter));
+	{
+		Footer.Magic = NdiMediaRecording::FooterMagic;
+		Footer.Version = NdiMediaRecording::Version;
+		Footer.IndexOffset = NextChunkOffset;
+		Footer.NumEntries = Index.Num();
+		Footer.NumChunks = NumChunks;
+		Footer.FirstTimecode = FirstTimecode;
+		Footer.LastTimecode = LastTimecode;
+		Footer.NumDroppedFrames = NumDroppedFrames;
+	}
+
+	const bool Written = File->Write(Buffer, BufferSize, NextChunkOffset);
+	FMemory::Free(Buffer);
+
+	if (!Written)
+	{
+		return false;
+	}
+
+	BytesWritten += BufferSize;
+
+	// release the space that was preallocated beyond the footer
+	if (PreallocatedSize > 0)
+	{
+		return File->Truncate(NextChunkOffset + BufferSize);
+	}
+
+	return true;
+}
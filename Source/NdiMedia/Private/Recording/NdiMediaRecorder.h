@@ -0,0 +1,309 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "NdiMediaRecordingFormat.h"
+#include "NdiMediaStageStats.h"
+
+
+class FEvent;
+class FNdiMediaRecordingFile;
+class FRunnableThread;
+
+struct NDIlib_audio_frame_v2_t;
+struct NDIlib_metadata_frame_t;
+struct NDIlib_video_frame_v2_t;
+
+
+/**
+ * Settings of a recorder.
+ */
+struct FNdiMediaRecorderSettings
+{
+	/** Minimum size of the chunks that are written to disk (in bytes, multiple of NdiMediaRecording::Alignment). */
+	uint32 ChunkSize;
+
+	/** Number of chunks that may be waiting for the disk before frames are dropped. */
+	int32 MaxPendingChunks;
+
+	/** How much disk space is reserved ahead of the writes (in bytes, 0 = none). */
+	uint64 PreallocationSize;
+
+public:
+
+	/** Default constructor (16 MiB chunks, 128 MiB of write-behind, 1 GiB preallocation steps). */
+	FNdiMediaRecorderSettings()
+		: ChunkSize(16 * 1024 * 1024)
+		, MaxPendingChunks(8)
+		, PreallocationSize(1024 * 1024 * 1024)
+	{ }
+};
+
+
+/**
+ * Statistics of a recorder.
+ */
+struct FNdiMediaRecorderStats
+{
+	/** Number of bytes written to disk. */
+	uint64 BytesWritten;
+
+	/** Number of frames that were dropped because the disk couldn't keep up. */
+	uint64 NumDroppedFrames;
+
+	/** Number of frames that were recorded. */
+	uint64 NumFrames;
+
+	/** Number of chunks waiting to be written. */
+	int32 NumPendingChunks;
+
+	/** Whether writes bypass the operating system's page cache. */
+	bool Unbuffered;
+
+	/** Time spent writing chunks to disk. */
+	FNdiMediaStageStats Writes;
+};
+
+
+/**
+ * Records received NDI frames into a chunked, indexed file.
+ *
+ * Frames are copied into the current chunk on the thread that captured them,
+ * with line and channel padding removed. Full chunks are handed to a dedicated
+ * I/O thread that writes them with large, aligned writes into a preallocated
+ * file. Chunk buffers are recycled; if all of them are waiting for the disk,
+ * incoming frames are dropped rather than stalling the capture threads.
+ *
+ * The frame index is kept in memory and written to the end of the file along
+ * with the footer when the recording is closed.
+ *
+ * @see NdiMediaRecording
+ */
+class FNdiMediaRecorder
+	: public FRunnable
+{
+public:
+
+	/** Default constructor. */
+	FNdiMediaRecorder();
+
+	/** Destructor. */
+	virtual ~FNdiMediaRecorder();
+
+public:
+
+	/**
+	 * Finish the current recording.
+	 *
+	 * Blocks until all pending chunks, the index and the footer have been written.
+	 *
+	 * @see IsOpen, Open
+	 */
+	void Close();
+
+	/**
+	 * Get the path of the current recording.
+	 *
+	 * @return File path, or empty string if not recording.
+	 */
+	const FString& GetFilePath() const
+	{
+		return FilePath;
+	}
+
+	/**
+	 * Get the recorder's statistics.
+	 *
+	 * @return Statistics.
+	 */
+	FNdiMediaRecorderStats GetStats() const;
+
+	/**
+	 * Whether a recording is in progress.
+	 *
+	 * @return true if recording, false otherwise.
+	 * @see Close, Open
+	 */
+	bool IsOpen() const
+	{
+		return Recording;
+	}
+
+	/**
+	 * Start a new recording.
+	 *
+	 * @param InFilePath Path to the file to record into (will be replaced if it exists).
+	 * @param SourceName Name of the recorded source.
+	 * @param InSettings The recorder settings.
+	 * @return true on success, false otherwise.
+	 * @see Close, IsOpen
+	 */
+	bool Open(const FString& InFilePath, const FString& SourceName, const FNdiMediaRecorderSettings& InSettings = FNdiMediaRecorderSettings());
+
+	/**
+	 * Record an audio frame.
+	 *
+	 * @param AudioFrame The frame to record.
+	 * @see WriteMetadataFrame, WriteVideoFrame
+	 */
+	void WriteAudioFrame(const NDIlib_audio_frame_v2_t& AudioFrame);
+
+	/**
+	 * Record a frame received on the metadata channel.
+	 *
+	 * @param MetadataFrame The frame to record.
+	 * @see WriteAudioFrame, WriteVideoFrame
+	 */
+	void WriteMetadataFrame(const NDIlib_metadata_frame_t& MetadataFrame);
+
+	/**
+	 * Record a video frame.
+	 *
+	 * @param VideoFrame The frame to record.
+	 * @see WriteAudioFrame, WriteMetadataFrame
+	 */
+	void WriteVideoFrame(const NDIlib_video_frame_v2_t& VideoFrame);
+
+public:
+
+	//~ FRunnable interface
+
+	virtual bool Init() override;
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	virtual void Exit() override { }
+
+protected:
+
+	/** A chunk of frame records. */
+	struct FChunk
+	{
+		/** Size of the allocated buffer (in bytes). */
+		uint64 Capacity;
+
+		/** The chunk buffer (aligned to NdiMediaRecording::Alignment). */
+		uint8* Data;
+
+		/** File offset that the chunk is written at. */
+		uint64 Offset;
+
+		/** Number of used bytes, including the chunk header. */
+		uint64 Size;
+	};
+
+	/**
+	 * Get an unused chunk buffer.
+	 *
+	 * @param MinCapacity The minimum size of the buffer (in bytes).
+	 * @return The chunk, or nullptr if all chunks are waiting for the disk.
+	 */
+	FChunk* AcquireChunk(uint64 MinCapacity);
+
+	/**
+	 * Allocate a record in the current chunk.
+	 *
+	 * @param Header The record's frame header (Type, DataSize, MetadataSize and Timecode must be set).
+	 * @return Pointer to the record's frame data, or nullptr if the frame must be dropped.
+	 */
+	uint8* BeginRecord(const FNdiMediaRecordingFrameHeader& Header);
+
+	/**
+	 * Hand the current chunk to the I/O thread.
+	 *
+	 * @see WriteChunk
+	 */
+	void SubmitChunk();
+
+	/**
+	 * Write a chunk to disk (on the I/O thread).
+	 *
+	 * @param Chunk The chunk to write.
+	 * @return true on success, false otherwise.
+	 */
+	bool WriteChunk(FChunk& Chunk);
+
+	/**
+	 * Write the index and footer, and trim the file (after the I/O thread finished).
+	 *
+	 * @return true on success, false otherwise.
+	 */
+	bool WriteIndex();
+
+private:
+
+	/** Number of bytes written to disk. */
+	uint64 BytesWritten;
+
+	/** Chunk buffers that are currently unused. */
+	TArray<FChunk*> FreeChunks;
+
+	/** The chunk that records are currently added to. */
+	FChunk* CurrentChunk;
+
+	/** Critical section for synchronizing access to the current chunk and index. */
+	mutable FCriticalSection CriticalSection;
+
+	/** The file being written. */
+	FNdiMediaRecordingFile* File;
+
+	/** Path of the current recording. */
+	FString FilePath;
+
+	/** Whether a write failed (all further frames are dropped). */
+	FThreadSafeBool Failed;
+
+	/** Index of the first entry that belongs to the current chunk. */
+	int32 FirstChunkEntry;
+
+	/** Timecode of the first recorded frame. */
+	int64 FirstTimecode;
+
+	/** The frame index. */
+	TArray<FNdiMediaRecordingIndexEntry> Index;
+
+	/** Timecode of the most recently recorded frame. */
+	int64 LastTimecode;
+
+	/** File offset of the next chunk. */
+	uint64 NextChunkOffset;
+
+	/** Number of chunk buffers that were allocated. */
+	int32 NumAllocatedChunks;
+
+	/** Number of chunks that were submitted. */
+	uint64 NumChunks;
+
+	/** Number of dropped frames. */
+	uint64 NumDroppedFrames;
+
+	/** Number of chunks that are waiting for the I/O thread. */
+	int32 NumPendingChunks;
+
+	/** Chunks that are waiting for the I/O thread. */
+	TQueue<FChunk*, EQueueMode::Mpsc> PendingChunks;
+
+	/** How much disk space has been reserved (in bytes). */
+	uint64 PreallocatedSize;
+
+	/** Whether a recording is in progress. */
+	FThreadSafeBool Recording;
+
+	/** The recorder settings. */
+	FNdiMediaRecorderSettings Settings;
+
+	/** Holds a flag indicating that the thread is stopping. */
+	FThreadSafeBool Stopping;
+
+	/** Holds the thread object. */
+	FRunnableThread* Thread;
+
+	/** Event that wakes up the I/O thread. */
+	FEvent* WorkEvent;
+
+	/** Time spent writing chunks to disk. */
+	FNdiMediaStageStats WriteStats;
+};
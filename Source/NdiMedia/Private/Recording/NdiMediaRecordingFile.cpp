@@ -0,0 +1,227 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaRecordingFile.h"
+#include "NdiMediaPrivate.h"
+
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/Paths.h"
+
+#if PLATFORM_WINDOWS
+	#include "Windows/WindowsHWrapper.h"
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	#include <errno.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+
+/* FNdiMediaRecordingFile structors
+ *****************************************************************************/
+
+FNdiMediaRecordingFile::FNdiMediaRecordingFile()
+#if PLATFORM_WINDOWS
+	: Handle(INVALID_HANDLE_VALUE)
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	: Descriptor(-1)
+#else
+	: Handle(nullptr)
+#endif
+	, Unbuffered(false)
+{ }
+
+
+FNdiMediaRecordingFile::~FNdiMediaRecordingFile()
+{
+	Close();
+}
+
+
+/* FNdiMediaRecordingFile interface
+ *****************************************************************************/
+
+void FNdiMediaRecordingFile::Close()
+{
+#if PLATFORM_WINDOWS
+	if (Handle != INVALID_HANDLE_VALUE)
+	{
+		::CloseHandle(Handle);
+		Handle = INVALID_HANDLE_VALUE;
+	}
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	if (Descriptor != -1)
+	{
+		close(Descriptor);
+		Descriptor = -1;
+	}
+#else
+	delete Handle;
+	Handle = nullptr;
+#endif
+
+	Unbuffered = false;
+}
+
+
+bool FNdiMediaRecordingFile::IsOpen() const
+{
+#if PLATFORM_WINDOWS
+	return (Handle != INVALID_HANDLE_VALUE);
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	return (Descriptor != -1);
+#else
+	return (Handle != nullptr);
+#endif
+}
+
+
+bool FNdiMediaRecordingFile::OpenWrite(const FString& FilePath)
+{
+	Close();
+
+	const FString FullPath = FPaths::ConvertRelativePathToFull(FilePath);
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	if (!PlatformFile.CreateDirectoryTree(*FPaths::GetPath(FullPath)))
+	{
+		return false;
+	}
+
+#if PLATFORM_WINDOWS
+	Handle = ::CreateFileW(*FullPath, GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	Unbuffered = (Handle != INVALID_HANDLE_VALUE);
+#elif PLATFORM_LINUX
+	// some file systems (i.e. tmpfs) don't support direct I/O
+	Descriptor = open(TCHAR_TO_UTF8(*FullPath), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_DIRECT, 0644);
+	Unbuffered = (Descriptor != -1);
+
+	if (Descriptor == -1)
+	{
+		Descriptor = open(TCHAR_TO_UTF8(*FullPath), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	}
+#elif PLATFORM_MAC
+	Descriptor = open(TCHAR_TO_UTF8(*FullPath), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	Unbuffered = (Descriptor != -1) && (fcntl(Descriptor, F_NOCACHE, 1) != -1);
+#else
+	Handle = PlatformFile.OpenWrite(*FullPath);
+#endif
+
+	return IsOpen();
+}
+
+
+bool FNdiMediaRecordingFile::Preallocate(uint64 Size)
+{
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+#if PLATFORM_WINDOWS
+	// sets the allocation size without changing the end of file
+	FILE_ALLOCATION_INFO AllocationInfo;
+	AllocationInfo.AllocationSize.QuadPart = (LONGLONG)Size;
+
+	return (::SetFileInformationByHandle(Handle, FileAllocationInfo, &AllocationInfo, sizeof(AllocationInfo)) != 0);
+#elif PLATFORM_LINUX
+	return (fallocate(Descriptor, FALLOC_FL_KEEP_SIZE, 0, (off_t)Size) == 0);
+#elif PLATFORM_MAC
+	const off_t CurrentSize = lseek(Descriptor, 0, SEEK_END);
+
+	if ((CurrentSize == -1) || ((uint64)CurrentSize >= Size))
+	{
+		return (CurrentSize != -1);
+	}
+
+	// try contiguous space first, then any space
+	fstore_t Store = { F_ALLOCATECONTIG | F_ALLOCATEALL, F_PEOFPOSMODE, 0, (off_t)(Size - CurrentSize), 0 };
+
+	if (fcntl(Descriptor, F_PREALLOCATE, &Store) == -1)
+	{
+		Store.fst_flags = F_ALLOCATEALL;
+
+		return (fcntl(Descriptor, F_PREALLOCATE, &Store) != -1);
+	}
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+bool FNdiMediaRecordingFile::Truncate(uint64 Size)
+{
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+#if PLATFORM_WINDOWS
+	LARGE_INTEGER Position;
+	Position.QuadPart = (LONGLONG)Size;
+
+	return (::SetFilePointerEx(Handle, Position, nullptr, FILE_BEGIN) != 0) && (::SetEndOfFile(Handle) != 0);
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	return (ftruncate(Descriptor, (off_t)Size) == 0);
+#else
+	return false;
+#endif
+}
+
+
+bool FNdiMediaRecordingFile::Write(const void* Data, uint64 Size, uint64 Offset)
+{
+	if (!IsOpen())
+	{
+		return false;
+	}
+
+	const uint8* Bytes = (const uint8*)Data;
+
+	while (Size > 0)
+	{
+		// large writes are split to stay within the platforms' 32-bit size limits
+		const uint32 WriteSize = (uint32)FMath::Min<uint64>(Size, 1024 * 1024 * 1024);
+
+#if PLATFORM_WINDOWS
+		OVERLAPPED Overlapped = { 0 };
+		{
+			Overlapped.Offset = (DWORD)(Offset & 0xffffffff);
+			Overlapped.OffsetHigh = (DWORD)(Offset >> 32);
+		}
+
+		::DWORD Written = 0;
+
+		if (!::WriteFile(Handle, Bytes, WriteSize, &Written, &Overlapped) || (Written == 0))
+		{
+			return false;
+		}
+#elif PLATFORM_LINUX || PLATFORM_MAC
+		const ssize_t Written = pwrite(Descriptor, Bytes, WriteSize, (off_t)Offset);
+
+		if (Written <= 0)
+		{
+			if ((Written == -1) && (errno == EINTR))
+			{
+				continue;
+			}
+
+			return false;
+		}
+#else
+		const int64 Written = WriteSize;
+
+		if (!Handle->Seek((int64)Offset) || !Handle->Write(Bytes, WriteSize))
+		{
+			return false;
+		}
+#endif
+
+		Bytes += Written;
+		Offset += Written;
+		Size -= Written;
+	}
+
+	return true;
+}
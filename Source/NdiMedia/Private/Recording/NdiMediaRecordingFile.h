@@ -0,0 +1,111 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+class IFileHandle;
+
+
+/**
+ * Implements a write-only file for streaming recordings to disk.
+ *
+ * Where the platform supports it, the file bypasses the operating system's
+ * page cache, so that sustained recording doesn't evict other data from memory
+ * or stall when the cache is flushed. Unbuffered writes require the data, size
+ * and file offset to be multiples of NdiMediaRecording::Alignment.
+ *
+ * The file can also be preallocated ahead of the writes, which keeps it from
+ * fragmenting and avoids file system metadata updates on every write.
+ */
+class FNdiMediaRecordingFile
+{
+public:
+
+	/** Default constructor. */
+	FNdiMediaRecordingFile();
+
+	/** Destructor. */
+	~FNdiMediaRecordingFile();
+
+public:
+
+	/**
+	 * Close the file.
+	 *
+	 * @see IsOpen, OpenWrite
+	 */
+	void Close();
+
+	/**
+	 * Whether the file is open.
+	 *
+	 * @return true if open, false otherwise.
+	 * @see Close, OpenWrite
+	 */
+	bool IsOpen() const;
+
+	/**
+	 * Whether writes bypass the operating system's page cache.
+	 *
+	 * @return true if unbuffered, false otherwise.
+	 */
+	bool IsUnbuffered() const
+	{
+		return Unbuffered;
+	}
+
+	/**
+	 * Create a file for writing, replacing any existing file.
+	 *
+	 * @param FilePath Path to the file to create.
+	 * @return true on success, false otherwise.
+	 * @see Close
+	 */
+	bool OpenWrite(const FString& FilePath);
+
+	/**
+	 * Reserve disk space for the file.
+	 *
+	 * @param Size The number of bytes to reserve.
+	 * @return true on success, false if not supported or out of disk space.
+	 * @see Truncate
+	 */
+	bool Preallocate(uint64 Size);
+
+	/**
+	 * Set the size of the file, releasing any space reserved beyond it.
+	 *
+	 * @param Size The new file size (in bytes).
+	 * @return true on success, false otherwise.
+	 * @see Preallocate
+	 */
+	bool Truncate(uint64 Size);
+
+	/**
+	 * Write data to the file.
+	 *
+	 * @param Data The data to write (must be aligned if the file is unbuffered).
+	 * @param Size Number of bytes to write (must be aligned if the file is unbuffered).
+	 * @param Offset File offset to write at (must be aligned if the file is unbuffered).
+	 * @return true on success, false otherwise.
+	 */
+	bool Write(const void* Data, uint64 Size, uint64 Offset);
+
+private:
+
+#if PLATFORM_WINDOWS
+	/** The file handle (INVALID_HANDLE_VALUE if closed). */
+	void* Handle;
+#elif PLATFORM_LINUX || PLATFORM_MAC
+	/** The file descriptor (-1 if closed). */
+	int Descriptor;
+#else
+	/** The engine's file handle (nullptr if closed). */
+	IFileHandle* Handle;
+#endif
+
+	/** Whether writes bypass the operating system's page cache. */
+	bool Unbuffered;
+};
@@ -0,0 +1,251 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/*
+ * NDI recordings store received frames as they came out of the receiver, before
+ * any conversion, so that they can be fed back into the player unchanged.
+ *
+ * File layout (all offsets and sizes are multiples of the file's alignment):
+ *
+ *   File header           one alignment unit
+ *   Chunk 0..N            chunk header followed by tightly packed frame records
+ *   Index                 one index entry per frame record
+ *   Footer                last bytes of the file, points at the index
+ *
+ * Each frame record consists of a frame header, the frame's data with line or
+ * channel padding removed, and the frame's null-terminated metadata (if any).
+ * Records are padded to RecordAlignment bytes. Recordings that were not closed
+ * properly have no index and footer, but can be recovered by walking the chunk
+ * headers, which store their own size.
+ */
+namespace NdiMediaRecording
+{
+	/** File and I/O alignment (in bytes); covers the sector and page sizes of common file systems. */
+	static const uint32 Alignment = 4096;
+
+	/** Magic number at the start of each chunk ('NDRC'). */
+	static const uint32 ChunkMagic = 0x4352444e;
+
+	/** Default file extension of recordings. */
+	static const TCHAR* const FileExtension = TEXT(".ndirec");
+
+	/** Magic number at the start of the file ('NDRF'). */
+	static const uint32 FileMagic = 0x4652444e;
+
+	/** Magic number at the start of the footer ('NDRI'). */
+	static const uint32 FooterMagic = 0x4952444e;
+
+	/** Alignment of frame records within a chunk (in bytes). */
+	static const uint32 RecordAlignment = 16;
+
+	/** Current version of the file format. */
+	static const uint32 Version = 1;
+
+	/**
+	 * Round a size up to a multiple of a power-of-two alignment.
+	 *
+	 * @param Size The size to round up.
+	 * @param InAlignment The alignment.
+	 * @return The aligned size.
+	 */
+	static FORCEINLINE uint64 AlignSize(uint64 Size, uint64 InAlignment)
+	{
+		return (Size + InAlignment - 1) & ~(InAlignment - 1);
+	}
+}
+
+
+/**
+ * Types of frame records.
+ */
+enum class ENdiMediaRecordType : uint32
+{
+	/** Planar 32-bit float audio samples. */
+	Audio = 1,
+
+	/** Null-terminated UTF-8 metadata received on the metadata channel. */
+	Metadata = 2,
+
+	/** Video frame in the FourCC it was received in. */
+	Video = 3
+};
+
+
+/**
+ * Header at the start of a recording file (padded to the file's alignment).
+ */
+struct FNdiMediaRecordingFileHeader
+{
+	/** Magic number (NdiMediaRecording::FileMagic). */
+	uint32 Magic;
+
+	/** Version of the file format. */
+	uint32 Version;
+
+	/** Alignment of chunks, index and footer (in bytes). */
+	uint32 Alignment;
+
+	/** Reserved for future use. */
+	uint32 Reserved;
+
+	/** Time at which the recording started (in FDateTime UTC ticks). */
+	int64 CreationTime;
+
+	/** Null-terminated UTF-8 name of the recorded source. */
+	ANSICHAR SourceName[256];
+};
+
+
+/**
+ * Header at the start of each chunk.
+ */
+struct FNdiMediaRecordingChunkHeader
+{
+	/** Magic number (NdiMediaRecording::ChunkMagic). */
+	uint32 Magic;
+
+	/** Number of frame records in the chunk. */
+	uint32 NumRecords;
+
+	/** Size of the chunk on disk, including this header and padding (in bytes). */
+	uint64 Size;
+
+	/** Timecode of the first record (in 100ns ticks). */
+	int64 FirstTimecode;
+
+	/** Timecode of the last record (in 100ns ticks). */
+	int64 LastTimecode;
+
+	/** Zero-based sequence number of the chunk. */
+	uint64 Sequence;
+
+	/** Reserved for future use. */
+	uint8 Reserved[24];
+};
+
+
+/**
+ * Header of a frame record.
+ *
+ * Fields that don't apply to the record's type are zero.
+ */
+struct FNdiMediaRecordingFrameHeader
+{
+	/** The record type (ENdiMediaRecordType). */
+	uint32 Type;
+
+	/** Size of the frame data that follows the header (in bytes). */
+	uint32 DataSize;
+
+	/** Size of the metadata that follows the frame data, including the null terminator (in bytes). */
+	uint32 MetadataSize;
+
+	/** The video frame's FourCC code. */
+	uint32 FourCC;
+
+	/** The frame's timecode (in 100ns ticks). */
+	int64 Timecode;
+
+	/** The time at which the sender submitted the frame (in 100ns ticks). */
+	int64 Timestamp;
+
+	/** Video frame width (in pixels). */
+	int32 Width;
+
+	/** Video frame height (in lines). */
+	int32 Height;
+
+	/** Line stride of the recorded video data (in bytes). */
+	int32 LineStride;
+
+	/** The video frame's format type (NDIlib_frame_format_type_e). */
+	int32 FrameFormat;
+
+	/** Numerator of the video frame rate. */
+	int32 FrameRateN;
+
+	/** Denominator of the video frame rate. */
+	int32 FrameRateD;
+
+	/** Picture aspect ratio of the video frame. */
+	float AspectRatio;
+
+	/** Audio sample rate (in samples per second). */
+	int32 SampleRate;
+
+	/** Number of audio channels. */
+	int32 NumChannels;
+
+	/** Number of audio samples per channel. */
+	int32 NumSamples;
+
+	/** Channel stride of the recorded audio data (in bytes). */
+	int32 ChannelStride;
+
+	/** Reserved for future use. */
+	uint32 Reserved;
+};
+
+
+/**
+ * Index entry of a frame record.
+ */
+struct FNdiMediaRecordingIndexEntry
+{
+	/** The frame's timecode (in 100ns ticks). */
+	int64 Timecode;
+
+	/** File offset of the record's frame header (in bytes). */
+	uint64 Offset;
+
+	/** Size of the record, including its header and padding (in bytes). */
+	uint32 Size;
+
+	/** The record type (ENdiMediaRecordType). */
+	uint32 Type;
+};
+
+
+/**
+ * Footer at the end of a recording file.
+ */
+struct FNdiMediaRecordingFooter
+{
+	/** Magic number (NdiMediaRecording::FooterMagic). */
+	uint32 Magic;
+
+	/** Version of the file format. */
+	uint32 Version;
+
+	/** File offset of the index (in bytes). */
+	uint64 IndexOffset;
+
+	/** Number of index entries. */
+	uint64 NumEntries;
+
+	/** Number of chunks. */
+	uint64 NumChunks;
+
+	/** Timecode of the first record (in 100ns ticks). */
+	int64 FirstTimecode;
+
+	/** Timecode of the last record (in 100ns ticks). */
+	int64 LastTimecode;
+
+	/** Number of frames that were dropped because the disk couldn't keep up. */
+	uint64 NumDroppedFrames;
+
+	/** Reserved for future use. */
+	uint64 Reserved;
+};
+
+
+static_assert(sizeof(FNdiMediaRecordingFileHeader) <= NdiMediaRecording::Alignment, "File header must fit into one alignment unit.");
+static_assert(sizeof(FNdiMediaRecordingChunkHeader) % NdiMediaRecording::RecordAlignment == 0, "Chunk header must preserve record alignment.");
+static_assert(sizeof(FNdiMediaRecordingFrameHeader) % NdiMediaRecording::RecordAlignment == 0, "Frame header must preserve record alignment.");
+static_assert(sizeof(FNdiMediaRecordingIndexEntry) == 24, "Index entries must not contain padding.");
+static_assert(sizeof(FNdiMediaRecordingFooter) == 64, "Footer must not contain padding.");
@@ -0,0 +1,184 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaRecordingFrames.h"
+#include "NdiMediaPrivate.h"
+
+
+namespace NdiMediaRecording
+{
+	void CopyAudioData(const NDIlib_audio_frame_v2_t& AudioFrame, const FNdiMediaRecordingFrameHeader& Header, uint8* Dest)
+	{
+		// channels are packed without padding
+		const uint8* Source = (const uint8*)AudioFrame.p_data;
+
+		for (int32 Channel = 0; Channel < AudioFrame.no_channels; ++Channel)
+		{
+			FMemory::Memcpy(Dest, Source + Channel * AudioFrame.channel_stride_in_bytes, Header.ChannelStride);
+			Dest += Header.ChannelStride;
+		}
+
+		if (Header.MetadataSize > 0)
+		{
+			FMemory::Memcpy(Dest, AudioFrame.p_metadata, Header.MetadataSize);
+		}
+	}
+
+
+	void CopyMetadataData(const NDIlib_metadata_frame_t& MetadataFrame, const FNdiMediaRecordingFrameHeader& Header, uint8* Dest)
+	{
+		FMemory::Memcpy(Dest, MetadataFrame.p_data, Header.DataSize);
+	}
+
+
+	void CopyVideoData(const NDIlib_video_frame_v2_t& VideoFrame, const FNdiMediaRecordingFrameHeader& Header, uint8* Dest)
+	{
+		// rows are packed without padding
+		const uint8* Source = VideoFrame.p_data;
+		const uint32 RowSize = Header.LineStride;
+
+		if (RowSize == VideoFrame.line_stride_in_bytes)
+		{
+			FMemory::Memcpy(Dest, Source, RowSize * VideoFrame.yres);
+		}
+		else
+		{
+			for (int32 Row = 0; Row < VideoFrame.yres; ++Row)
+			{
+				FMemory::Memcpy(Dest + Row * RowSize, Source + Row * VideoFrame.line_stride_in_bytes, RowSize);
+			}
+		}
+
+		Dest += RowSize * VideoFrame.yres;
+
+		// the alpha plane of UYVA frames follows the UYVY plane
+		const uint32 AlphaSize = Header.DataSize - RowSize * VideoFrame.yres;
+
+		if (AlphaSize > 0)
+		{
+			FMemory::Memcpy(Dest, Source + VideoFrame.line_stride_in_bytes * VideoFrame.yres, AlphaSize);
+			Dest += AlphaSize;
+		}
+
+		if (Header.MetadataSize > 0)
+		{
+			FMemory::Memcpy(Dest, VideoFrame.p_metadata, Header.MetadataSize);
+		}
+	}
+
+
+	bool GetAudioFrame(const FNdiMediaRecordingFrameHeader& Header, NDIlib_audio_frame_v2_t& OutFrame)
+	{
+		if ((Header.Type != (uint32)ENdiMediaRecordType::Audio) || (Header.DataSize < (uint64)Header.ChannelStride * Header.NumChannels))
+		{
+			return false;
+		}
+
+		const uint8* Payload = (const uint8*)(&Header + 1);
+
+		// the NDI structures aren't const correct; the player doesn't write to frames
+		OutFrame.sample_rate = Header.SampleRate;
+		OutFrame.no_channels = Header.NumChannels;
+		OutFrame.no_samples = Header.NumSamples;
+		OutFrame.timecode = Header.Timecode;
+		OutFrame.p_data = (float*)Payload;
+		OutFrame.channel_stride_in_bytes = Header.ChannelStride;
+		OutFrame.p_metadata = (Header.MetadataSize > 0) ? (const char*)(Payload + Header.DataSize) : nullptr;
+		OutFrame.timestamp = Header.Timestamp;
+
+		return true;
+	}
+
+
+	bool GetMetadataFrame(const FNdiMediaRecordingFrameHeader& Header, NDIlib_metadata_frame_t& OutFrame)
+	{
+		if ((Header.Type != (uint32)ENdiMediaRecordType::Metadata) || (Header.DataSize == 0))
+		{
+			return false;
+		}
+
+		OutFrame.length = Header.DataSize;
+		OutFrame.timecode = Header.Timecode;
+		OutFrame.p_data = (char*)(&Header + 1);
+
+		return true;
+	}
+
+
+	bool GetVideoFrame(const FNdiMediaRecordingFrameHeader& Header, NDIlib_video_frame_v2_t& OutFrame)
+	{
+		if ((Header.Type != (uint32)ENdiMediaRecordType::Video) || (Header.DataSize < (uint64)Header.LineStride * Header.Height))
+		{
+			return false;
+		}
+
+		const uint8* Payload = (const uint8*)(&Header + 1);
+
+		OutFrame.xres = Header.Width;
+		OutFrame.yres = Header.Height;
+		OutFrame.FourCC = (NDIlib_FourCC_type_e)Header.FourCC;
+		OutFrame.frame_rate_N = Header.FrameRateN;
+		OutFrame.frame_rate_D = Header.FrameRateD;
+		OutFrame.picture_aspect_ratio = Header.AspectRatio;
+		OutFrame.frame_format_type = (NDIlib_frame_format_type_e)Header.FrameFormat;
+		OutFrame.timecode = Header.Timecode;
+		OutFrame.p_data = (uint8_t*)Payload;
+		OutFrame.line_stride_in_bytes = Header.LineStride;
+		OutFrame.p_metadata = (Header.MetadataSize > 0) ? (const char*)(Payload + Header.DataSize) : nullptr;
+		OutFrame.timestamp = Header.Timestamp;
+
+		return true;
+	}
+
+
+	void MakeAudioHeader(const NDIlib_audio_frame_v2_t& AudioFrame, FNdiMediaRecordingFrameHeader& OutHeader)
+	{
+		const uint32 ChannelSize = AudioFrame.no_samples * sizeof(float);
+
+		FMemory::Memzero(OutHeader);
+
+		OutHeader.Type = (uint32)ENdiMediaRecordType::Audio;
+		OutHeader.DataSize = ChannelSize * AudioFrame.no_channels;
+		OutHeader.MetadataSize = (AudioFrame.p_metadata != nullptr) ? FCStringAnsi::Strlen(AudioFrame.p_metadata) + 1 : 0;
+		OutHeader.Timecode = AudioFrame.timecode;
+		OutHeader.Timestamp = AudioFrame.timestamp;
+		OutHeader.SampleRate = AudioFrame.sample_rate;
+		OutHeader.NumChannels = AudioFrame.no_channels;
+		OutHeader.NumSamples = AudioFrame.no_samples;
+		OutHeader.ChannelStride = ChannelSize;
+	}
+
+
+	void MakeMetadataHeader(const NDIlib_metadata_frame_t& MetadataFrame, FNdiMediaRecordingFrameHeader& OutHeader)
+	{
+		FMemory::Memzero(OutHeader);
+
+		OutHeader.Type = (uint32)ENdiMediaRecordType::Metadata;
+		OutHeader.DataSize = MetadataFrame.length;
+		OutHeader.Timecode = MetadataFrame.timecode;
+	}
+
+
+	void MakeVideoHeader(const NDIlib_video_frame_v2_t& VideoFrame, FNdiMediaRecordingFrameHeader& OutHeader)
+	{
+		// the alpha plane of UYVA frames has one byte per pixel
+		const bool Yuv = (VideoFrame.FourCC == NDIlib_FourCC_type_UYVY) || (VideoFrame.FourCC == NDIlib_FourCC_type_UYVA);
+		const uint32 RowSize = FMath::Min(VideoFrame.xres * (Yuv ? 2 : 4), VideoFrame.line_stride_in_bytes);
+		const uint32 AlphaSize = (VideoFrame.FourCC == NDIlib_FourCC_type_UYVA) ? VideoFrame.xres * VideoFrame.yres : 0;
+
+		FMemory::Memzero(OutHeader);
+
+		OutHeader.Type = (uint32)ENdiMediaRecordType::Video;
+		OutHeader.DataSize = RowSize * VideoFrame.yres + AlphaSize;
+		OutHeader.MetadataSize = (VideoFrame.p_metadata != nullptr) ? FCStringAnsi::Strlen(VideoFrame.p_metadata) + 1 : 0;
+		OutHeader.FourCC = VideoFrame.FourCC;
+		OutHeader.Timecode = VideoFrame.timecode;
+		OutHeader.Timestamp = VideoFrame.timestamp;
+		OutHeader.Width = VideoFrame.xres;
+		OutHeader.Height = VideoFrame.yres;
+		OutHeader.LineStride = RowSize;
+		OutHeader.FrameFormat = VideoFrame.frame_format_type;
+		OutHeader.FrameRateN = VideoFrame.frame_rate_N;
+		OutHeader.FrameRateD = VideoFrame.frame_rate_D;
+		OutHeader.AspectRatio = VideoFrame.picture_aspect_ratio;
+	}
+}
@@ -0,0 +1,110 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NdiMediaRecordingFormat.h"
+
+
+struct NDIlib_audio_frame_v2_t;
+struct NDIlib_metadata_frame_t;
+struct NDIlib_video_frame_v2_t;
+
+
+/*
+ * Conversions between NDI frames and frame records.
+ *
+ * Writing a record is split into two steps, so that the caller can allocate
+ * space for the record after its size is known: the Make*Header functions
+ * describe the frame, and the Copy*Data functions copy the frame's data and
+ * metadata into the space that follows the header.
+ *
+ * The Get*Frame functions fill NDI frame structures that point directly into
+ * a record, which must be followed by its data in memory.
+ */
+namespace NdiMediaRecording
+{
+	/**
+	 * Copy the samples and metadata of an audio frame into a record.
+	 *
+	 * @param AudioFrame The audio frame.
+	 * @param Header The record header created by MakeAudioHeader.
+	 * @param Dest Will contain the record data (Header.DataSize + Header.MetadataSize bytes).
+	 * @see MakeAudioHeader
+	 */
+	void CopyAudioData(const NDIlib_audio_frame_v2_t& AudioFrame, const FNdiMediaRecordingFrameHeader& Header, uint8* Dest);
+
+	/**
+	 * Copy the data of a metadata frame into a record.
+	 *
+	 * @param MetadataFrame The metadata frame.
+	 * @param Header The record header created by MakeMetadataHeader.
+	 * @param Dest Will contain the record data (Header.DataSize bytes).
+	 * @see MakeMetadataHeader
+	 */
+	void CopyMetadataData(const NDIlib_metadata_frame_t& MetadataFrame, const FNdiMediaRecordingFrameHeader& Header, uint8* Dest);
+
+	/**
+	 * Copy the pixels and metadata of a video frame into a record.
+	 *
+	 * @param VideoFrame The video frame.
+	 * @param Header The record header created by MakeVideoHeader.
+	 * @param Dest Will contain the record data (Header.DataSize + Header.MetadataSize bytes).
+	 * @see MakeVideoHeader
+	 */
+	void CopyVideoData(const NDIlib_video_frame_v2_t& VideoFrame, const FNdiMediaRecordingFrameHeader& Header, uint8* Dest);
+
+	/**
+	 * Get the audio frame stored in a record.
+	 *
+	 * @param Header The record header (followed by its data).
+	 * @param OutFrame Will contain the frame.
+	 * @return true on success, false if the record is not a valid audio record.
+	 */
+	bool GetAudioFrame(const FNdiMediaRecordingFrameHeader& Header, NDIlib_audio_frame_v2_t& OutFrame);
+
+	/**
+	 * Get the metadata frame stored in a record.
+	 *
+	 * @param Header The record header (followed by its data).
+	 * @param OutFrame Will contain the frame.
+	 * @return true on success, false if the record is not a valid metadata record.
+	 */
+	bool GetMetadataFrame(const FNdiMediaRecordingFrameHeader& Header, NDIlib_metadata_frame_t& OutFrame);
+
+	/**
+	 * Get the video frame stored in a record.
+	 *
+	 * @param Header The record header (followed by its data).
+	 * @param OutFrame Will contain the frame.
+	 * @return true on success, false if the record is not a valid video record.
+	 */
+	bool GetVideoFrame(const FNdiMediaRecordingFrameHeader& Header, NDIlib_video_frame_v2_t& OutFrame);
+
+	/**
+	 * Create the record header of an audio frame.
+	 *
+	 * @param AudioFrame The audio frame.
+	 * @param OutHeader Will contain the header.
+	 * @see CopyAudioData
+	 */
+	void MakeAudioHeader(const NDIlib_audio_frame_v2_t& AudioFrame, FNdiMediaRecordingFrameHeader& OutHeader);
+
+	/**
+	 * Create the record header of a metadata frame.
+	 *
+	 * @param MetadataFrame The metadata frame.
+	 * @param OutHeader Will contain the header.
+	 * @see CopyMetadataData
+	 */
+	void MakeMetadataHeader(const NDIlib_metadata_frame_t& MetadataFrame, FNdiMediaRecordingFrameHeader& OutHeader);
+
+	/**
+	 * Create the record header of a video frame.
+	 *
+	 * @param VideoFrame The video frame.
+	 * @param OutHeader Will contain the header.
+	 * @see CopyVideoData
+	 */
+	void MakeVideoHeader(const NDIlib_video_frame_v2_t& VideoFrame, FNdiMediaRecordingFrameHeader& OutHeader);
+}
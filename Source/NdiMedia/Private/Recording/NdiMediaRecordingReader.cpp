@@ -0,0 +1,343 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaRecordingReader.h"
+#include "NdiMediaPrivate.h"
+
+#include "NdiMediaMappedFile.h"
+#include "NdiMediaRecordingFrames.h"
+#include "Serialization/Archive.h"
+
+
+/* FNdiMediaRecordingReader structors
+ *****************************************************************************/
+
+FNdiMediaRecordingReader::FNdiMediaRecordingReader()
+	: Data(nullptr)
+	, Entries(nullptr)
+	, FirstTimecode(0)
+	, LastTimecode(0)
+	, MappedFile(new FNdiMediaMappedFile)
+	, NumFrames(0)
+	, Size(0)
+{ }
+
+
+FNdiMediaRecordingReader::~FNdiMediaRecordingReader()
+{
+	Close();
+
+	delete MappedFile;
+	MappedFile = nullptr;
+}
+
+
+/* FNdiMediaRecordingReader interface
+ *****************************************************************************/
+
+void FNdiMediaRecordingReader::Close()
+{
+	Buffer.Empty();
+	MappedFile->Close();
+	OwnedEntries.Empty();
+	SourceName.Empty();
+
+	Data = nullptr;
+	Entries = nullptr;
+	FirstTimecode = 0;
+	LastTimecode = 0;
+	NumFrames = 0;
+	Size = 0;
+}
+
+
+int32 FNdiMediaRecordingReader::FindFrame(int64 Timecode) const
+{
+	int32 First = 0;
+	int32 Count = NumFrames;
+
+	// lower bound
+	while (Count > 0)
+	{
+		const int32 Step = Count / 2;
+		const int32 Middle = First + Step;
+
+		if (Entries[Middle].Timecode < Timecode)
+		{
+			First = Middle + 1;
+			Count -= Step + 1;
+		}
+		else
+		{
+			Count = Step;
+		}
+	}
+
+	return First;
+}
+
+
+int32 FNdiMediaRecordingReader::FindVideoFrame(int64 Timecode) const
+{
+	// frames at exactly the given time are visible
+	const int32 FrameIndex = FindFrame(Timecode);
+
+	if ((FrameIndex < NumFrames) && (Entries[FrameIndex].Timecode == Timecode) && (Entries[FrameIndex].Type == (uint32)ENdiMediaRecordType::Video))
+	{
+		return FrameIndex;
+	}
+
+	for (int32 Index = FrameIndex - 1; Index >= 0; --Index)
+	{
+		if (Entries[Index].Type == (uint32)ENdiMediaRecordType::Video)
+		{
+			return Index;
+		}
+	}
+
+	for (int32 Index = FrameIndex; Index < NumFrames; ++Index)
+	{
+		if (Entries[Index].Type == (uint32)ENdiMediaRecordType::Video)
+		{
+			return Index;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+
+bool FNdiMediaRecordingReader::GetAudioFrame(int32 FrameIndex, NDIlib_audio_frame_v2_t& OutFrame) const
+{
+	const FNdiMediaRecordingFrameHeader* Header = GetFrameHeader(FrameIndex, ENdiMediaRecordType::Audio);
+	return (Header != nullptr) && NdiMediaRecording::GetAudioFrame(*Header, OutFrame);
+}
+
+
+bool FNdiMediaRecordingReader::GetMetadataFrame(int32 FrameIndex, NDIlib_metadata_frame_t& OutFrame) const
+{
+	const FNdiMediaRecordingFrameHeader* Header = GetFrameHeader(FrameIndex, ENdiMediaRecordType::Metadata);
+	return (Header != nullptr) && NdiMediaRecording::GetMetadataFrame(*Header, OutFrame);
+}
+
+
+bool FNdiMediaRecordingReader::GetVideoFrame(int32 FrameIndex, NDIlib_video_frame_v2_t& OutFrame) const
+{
+	const FNdiMediaRecordingFrameHeader* Header = GetFrameHeader(FrameIndex, ENdiMediaRecordType::Video);
+	return (Header != nullptr) && NdiMediaRecording::GetVideoFrame(*Header, OutFrame);
+}
+
+
+bool FNdiMediaRecordingReader::IsMapped() const
+{
+	return MappedFile->IsOpen();
+}
+
+
+bool FNdiMediaRecordingReader::Open(const FString& FilePath)
+{
+	Close();
+
+	if (!MappedFile->Open(FilePath))
+	{
+		UE_LOG(LogNdiMedia, Error, TEXT("Failed to open NDI recording %s"), *FilePath);
+		return false;
+	}
+
+	Data = MappedFile->GetData();
+	Size = MappedFile->GetSize();
+
+	if (!Initialize())
+	{
+		UE_LOG(LogNdiMedia, Error, TEXT("File %s is not a valid NDI recording"), *FilePath);
+		Close();
+
+		return false;
+	}
+
+	return true;
+}
+
+
+bool FNdiMediaRecordingReader::Open(FArchive& Archive)
+{
+	Close();
+
+	// archives are loaded into memory; large recordings should be opened from a file
+	const int64 TotalSize = Archive.TotalSize();
+
+	if ((TotalSize <= 0) || (TotalSize > MAX_int32))
+	{
+		return false;
+	}
+
+	Buffer.AddUninitialized((int32)TotalSize);
+	Archive.Seek(0);
+	Archive.Serialize(Buffer.GetData(), TotalSize);
+
+	if (Archive.IsError())
+	{
+		Close();
+		return false;
+	}
+
+	Data = Buffer.GetData();
+	Size = Buffer.Num();
+
+	if (!Initialize())
+	{
+		UE_LOG(LogNdiMedia, Error, TEXT("Archive is not a valid NDI recording"));
+		Close();
+
+		return false;
+	}
+
+	return true;
+}
+
+
+/* FNdiMediaRecordingReader implementation
+ *****************************************************************************/
+
+const FNdiMediaRecordingFrameHeader* FNdiMediaRecordingReader::GetFrameHeader(int32 FrameIndex, ENdiMediaRecordType Type) const
+{
+	if ((FrameIndex < 0) || (FrameIndex >= NumFrames))
+	{
+		return nullptr;
+	}
+
+	const FNdiMediaRecordingIndexEntry& Entry = Entries[FrameIndex];
+
+	if ((Entry.Type != (uint32)Type) || (Entry.Offset + sizeof(FNdiMediaRecordingFrameHeader) > Size))
+	{
+		return nullptr;
+	}
+
+	const FNdiMediaRecordingFrameHeader* Header = (const FNdiMediaRecordingFrameHeader*)(Data + Entry.Offset);
+
+	if ((Header->Type != (uint32)Type) || (Entry.Offset + sizeof(FNdiMediaRecordingFrameHeader) + Header->DataSize + Header->MetadataSize > Size))
+	{
+		return nullptr;
+	}
+
+	return Header;
+}
+
+
+bool FNdiMediaRecordingReader::Initialize()
+{
+	if (Size < NdiMediaRecording::Alignment)
+	{
+		return false;
+	}
+
+	const FNdiMediaRecordingFileHeader& FileHeader = *(const FNdiMediaRecordingFileHeader*)Data;
+
+	if ((FileHeader.Magic != NdiMediaRecording::FileMagic) || (FileHeader.Version > NdiMediaRecording::Version))
+	{
+		return false;
+	}
+
+	ANSICHAR SourceNameUtf8[sizeof(FileHeader.SourceName) + 1] = { 0 };
+	FMemory::Memcpy(SourceNameUtf8, FileHeader.SourceName, sizeof(FileHeader.SourceName));
+	SourceName = UTF8_TO_TCHAR(SourceNameUtf8);
+
+	// use the index in place if the recording was closed properly
+	const FNdiMediaRecordingFooter& Footer = *(const FNdiMediaRecordingFooter*)(Data + Size - sizeof(FNdiMediaRecordingFooter));
+
+	if ((Footer.Magic == NdiMediaRecording::FooterMagic) &&
+		(Footer.NumEntries <= MAX_int32) &&
+		(Footer.IndexOffset % sizeof(int64) == 0) &&
+		(Footer.IndexOffset + Footer.NumEntries * sizeof(FNdiMediaRecordingIndexEntry) <= Size - sizeof(FNdiMediaRecordingFooter)))
+	{
+		Entries = (const FNdiMediaRecordingIndexEntry*)(Data + Footer.IndexOffset);
+		NumFrames = (int32)Footer.NumEntries;
+	}
+	else if (RebuildIndex())
+	{
+		UE_LOG(LogNdiMedia, Warning, TEXT("NDI recording of %s was not closed properly. Recovered %i frames."), *SourceName, NumFrames);
+	}
+	else
+	{
+		return false;
+	}
+
+	// audio and video frames may arrive slightly out of timecode order
+	for (int32 FrameIndex = 1; FrameIndex < NumFrames; ++FrameIndex)
+	{
+		if (Entries[FrameIndex].Timecode < Entries[FrameIndex - 1].Timecode)
+		{
+			if (OwnedEntries.Num() == 0)
+			{
+				OwnedEntries.Append(Entries, NumFrames);
+			}
+
+			OwnedEntries.StableSort([](const FNdiMediaRecordingIndexEntry& A, const FNdiMediaRecordingIndexEntry& B) {
+				return A.Timecode < B.Timecode;
+			});
+
+			Entries = OwnedEntries.GetData();
+
+			break;
+		}
+	}
+
+	if (NumFrames > 0)
+	{
+		FirstTimecode = Entries[0].Timecode;
+		LastTimecode = Entries[NumFrames - 1].Timecode;
+	}
+
+	return true;
+}
+
+
+bool FNdiMediaRecordingReader::RebuildIndex()
+{
+	uint64 ChunkOffset = NdiMediaRecording::Alignment;
+
+	while (ChunkOffset + sizeof(FNdiMediaRecordingChunkHeader) <= Size)
+	{
+		const FNdiMediaRecordingChunkHeader& ChunkHeader = *(const FNdiMediaRecordingChunkHeader*)(Data + ChunkOffset);
+
+		// the last chunk may not have been written completely
+		if ((ChunkHeader.Magic != NdiMediaRecording::ChunkMagic) || (ChunkHeader.Size == 0) || (ChunkOffset + ChunkHeader.Size > Size))
+		{
+			break;
+		}
+
+		uint64 RecordOffset = ChunkOffset + sizeof(FNdiMediaRecordingChunkHeader);
+
+		for (uint32 RecordIndex = 0; RecordIndex < ChunkHeader.NumRecords; ++RecordIndex)
+		{
+			if (RecordOffset + sizeof(FNdiMediaRecordingFrameHeader) > ChunkOffset + ChunkHeader.Size)
+			{
+				break;
+			}
+
+			const FNdiMediaRecordingFrameHeader& Header = *(const FNdiMediaRecordingFrameHeader*)(Data + RecordOffset);
+			const uint64 RecordSize = NdiMediaRecording::AlignSize(sizeof(FNdiMediaRecordingFrameHeader) + Header.DataSize + Header.MetadataSize, NdiMediaRecording::RecordAlignment);
+
+			if (RecordOffset + RecordSize > ChunkOffset + ChunkHeader.Size)
+			{
+				break;
+			}
+
+			FNdiMediaRecordingIndexEntry& Entry = OwnedEntries[OwnedEntries.AddUninitialized()];
+			{
+				Entry.Timecode = Header.Timecode;
+				Entry.Offset = RecordOffset;
+				Entry.Size = (uint32)RecordSize;
+				Entry.Type = Header.Type;
+			}
+
+			RecordOffset += RecordSize;
+		}
+
+		ChunkOffset += ChunkHeader.Size;
+	}
+
+	Entries = OwnedEntries.GetData();
+	NumFrames = OwnedEntries.Num();
+
+	return (NumFrames > 0);
+}
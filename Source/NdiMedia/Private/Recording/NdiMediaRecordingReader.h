@@ -0,0 +1,229 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NdiMediaRecordingFormat.h"
+
+
+class FArchive;
+class FNdiMediaMappedFile;
+
+struct NDIlib_audio_frame_v2_t;
+struct NDIlib_metadata_frame_t;
+struct NDIlib_video_frame_v2_t;
+
+
+/**
+ * Reads frames from an NDI recording.
+ *
+ * Recordings are mapped into memory, and the frames returned by this class
+ * point directly into the mapping, so they remain valid until the reader is
+ * closed. The frame index is used in place if it is sorted by timecode, which
+ * allows finding the frame at any time with a binary search.
+ *
+ * Recordings that were not closed properly (i.e. because the application
+ * crashed) have no index; it is rebuilt from the chunk headers instead.
+ *
+ * @see FNdiMediaRecorder
+ */
+class FNdiMediaRecordingReader
+{
+public:
+
+	/** Default constructor. */
+	FNdiMediaRecordingReader();
+
+	/** Destructor. */
+	~FNdiMediaRecordingReader();
+
+public:
+
+	/**
+	 * Close the recording.
+	 *
+	 * @see Open
+	 */
+	void Close();
+
+	/**
+	 * Find the first frame at or after the given time.
+	 *
+	 * @param Timecode The time to search for (in 100ns ticks).
+	 * @return Index of the frame, or the number of frames if all frames are earlier.
+	 * @see FindVideoFrame
+	 */
+	int32 FindFrame(int64 Timecode) const;
+
+	/**
+	 * Find the video frame that is visible at the given time.
+	 *
+	 * @param Timecode The time to search for (in 100ns ticks).
+	 * @return Index of the last video frame at or before the time, the first video frame if there is none, or INDEX_NONE if the recording has no video.
+	 * @see FindFrame
+	 */
+	int32 FindVideoFrame(int64 Timecode) const;
+
+	/**
+	 * Get an audio frame.
+	 *
+	 * @param FrameIndex Index of the frame.
+	 * @param OutFrame Will contain the frame.
+	 * @return true on success, false if the frame is not a valid audio frame.
+	 */
+	bool GetAudioFrame(int32 FrameIndex, NDIlib_audio_frame_v2_t& OutFrame) const;
+
+	/**
+	 * Get the duration of the recording.
+	 *
+	 * @return Time between the first and last frame.
+	 */
+	FTimespan GetDuration() const
+	{
+		return FTimespan(LastTimecode - FirstTimecode);
+	}
+
+	/**
+	 * Get the timecode of the first frame.
+	 *
+	 * @return Timecode (in 100ns ticks).
+	 */
+	int64 GetFirstTimecode() const
+	{
+		return FirstTimecode;
+	}
+
+	/**
+	 * Get the index entry of a frame.
+	 *
+	 * @param FrameIndex Index of the frame.
+	 * @return The index entry.
+	 */
+	const FNdiMediaRecordingIndexEntry& GetFrameEntry(int32 FrameIndex) const
+	{
+		check((FrameIndex >= 0) && (FrameIndex < NumFrames));
+		return Entries[FrameIndex];
+	}
+
+	/**
+	 * Get a metadata frame.
+	 *
+	 * @param FrameIndex Index of the frame.
+	 * @param OutFrame Will contain the frame.
+	 * @return true on success, false if the frame is not a valid metadata frame.
+	 */
+	bool GetMetadataFrame(int32 FrameIndex, NDIlib_metadata_frame_t& OutFrame) const;
+
+	/**
+	 * Get the number of frames in the recording.
+	 *
+	 * @return Number of frames.
+	 */
+	int32 GetNumFrames() const
+	{
+		return NumFrames;
+	}
+
+	/**
+	 * Get the name of the recorded source.
+	 *
+	 * @return Source name.
+	 */
+	const FString& GetSourceName() const
+	{
+		return SourceName;
+	}
+
+	/**
+	 * Get a video frame.
+	 *
+	 * @param FrameIndex Index of the frame.
+	 * @param OutFrame Will contain the frame.
+	 * @return true on success, false if the frame is not a valid video frame.
+	 */
+	bool GetVideoFrame(int32 FrameIndex, NDIlib_video_frame_v2_t& OutFrame) const;
+
+	/**
+	 * Whether the recording is memory mapped (as opposed to loaded from an archive).
+	 *
+	 * @return true if mapped, false otherwise.
+	 */
+	bool IsMapped() const;
+
+	/**
+	 * Open a recording file.
+	 *
+	 * @param FilePath Path to the file to open.
+	 * @return true on success, false otherwise.
+	 * @see Close
+	 */
+	bool Open(const FString& FilePath);
+
+	/**
+	 * Open a recording from an archive.
+	 *
+	 * The archive is loaded into memory.
+	 *
+	 * @param Archive The archive to read.
+	 * @return true on success, false otherwise.
+	 * @see Close
+	 */
+	bool Open(FArchive& Archive);
+
+protected:
+
+	/**
+	 * Get the header of a frame record after validating it.
+	 *
+	 * @param FrameIndex Index of the frame.
+	 * @param Type The expected record type.
+	 * @return The frame header, or nullptr if the record is invalid.
+	 */
+	const FNdiMediaRecordingFrameHeader* GetFrameHeader(int32 FrameIndex, ENdiMediaRecordType Type) const;
+
+	/**
+	 * Parse the file header and load the index.
+	 *
+	 * @return true on success, false if the data is not a valid recording.
+	 */
+	bool Initialize();
+
+	/**
+	 * Rebuild the index from the chunk headers.
+	 *
+	 * @return true if any frames were found, false otherwise.
+	 */
+	bool RebuildIndex();
+
+private:
+
+	/** The recording data (if loaded from an archive). */
+	TArray<uint8> Buffer;
+
+	/** The recording data. */
+	const uint8* Data;
+
+	/** The frame index (either in the mapped data or in OwnedEntries). */
+	const FNdiMediaRecordingIndexEntry* Entries;
+
+	/** Timecode of the first frame. */
+	int64 FirstTimecode;
+
+	/** Timecode of the last frame. */
+	int64 LastTimecode;
+
+	/** The mapped recording file. */
+	FNdiMediaMappedFile* MappedFile;
+
+	/** Number of frames in the index. */
+	int32 NumFrames;
+
+	/** Frame index that was rebuilt or sorted. */
+	TArray<FNdiMediaRecordingIndexEntry> OwnedEntries;
+
+	/** Size of the recording data (in bytes). */
+	uint64 Size;
+
+	/** Name of the recorded source. */
+	FString SourceName;
+};
@@ -0,0 +1,935 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaTimeShiftBuffer.h"
+#include "NdiMediaPrivate.h"
+
+#include "GenericPlatform/GenericPlatformFile.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "NdiMediaRecordingFrames.h"
+
+
+namespace NdiMediaTimeShiftBuffer
+{
+	/** Maximum number of slabs that may be waiting for the I/O thread before frames are dropped. */
+	static const int32 MaxPendingSpills = 4;
+
+	/** Number of buffers for slabs that are read from the spill file (the visited slab and its neighbors). */
+	static const int32 NumReadBuffers = 3;
+
+	/** Smallest supported slab size (in bytes). */
+	static const uint32 MinSlabSize = 64 * 1024;
+
+	/**
+	 * Find the first entry that arrived after the given time.
+	 *
+	 * @param Entries The entries to search (sorted by time).
+	 * @param Time The time to search for (in 100ns ticks).
+	 * @return Index of the entry, or the number of entries if all entries are earlier.
+	 */
+	template<typename EntryType>
+	int32 UpperBound(const TArray<EntryType>& Entries, int64 Time)
+	{
+		int32 First = 0;
+		int32 Count = Entries.Num();
+
+		while (Count > 0)
+		{
+			const int32 Step = Count / 2;
+			const int32 Middle = First + Step;
+
+			if (Entries[Middle].Time <= Time)
+			{
+				First = Middle + 1;
+				Count -= Step + 1;
+			}
+			else
+			{
+				Count = Step;
+			}
+		}
+
+		return First;
+	}
+}
+
+
+/* FNdiMediaTimeShiftBuffer structors
+ *****************************************************************************/
+
+FNdiMediaTimeShiftBuffer::FNdiMediaTimeShiftBuffer()
+	: Enabled(false)
+	, MemoryUsed(0)
+	, NextSpillOffset(0)
+	, NumDiscardedFrames(0)
+	, NumPendingSpills(0)
+	, NumSpilledSlabs(0)
+	, NumVideoFrames(0)
+	, SpillFailed(false)
+	, SpillFile(nullptr)
+	, SpillWriteMemory(0)
+	, Stopping(false)
+	, Thread(nullptr)
+	, WorkEvent(FPlatformProcess::GetSynchEventFromPool(false))
+{ }
+
+
+FNdiMediaTimeShiftBuffer::~FNdiMediaTimeShiftBuffer()
+{
+	Close();
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	WorkEvent = nullptr;
+}
+
+
+/* FNdiMediaTimeShiftBuffer interface
+ *****************************************************************************/
+
+void FNdiMediaTimeShiftBuffer::Close()
+{
+	Enabled = false;
+
+	// the I/O thread takes the lock, so it is stopped first; pending requests are discarded below
+	if (Thread != nullptr)
+	{
+		Stopping = true;
+		WorkEvent->Trigger();
+
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	FScopeLock Lock(&CriticalSection);
+
+	FSpillRead SpillRead;
+
+	while (SpillReads.Dequeue(SpillRead));
+
+	FSpillWrite* SpillWrite = nullptr;
+
+	while (SpillWrites.Dequeue(SpillWrite))
+	{
+		// the buffers of slabs that weren't evicted are released with their slabs
+		if (SpillWrite->Slab == nullptr)
+		{
+			FMemory::Free(SpillWrite->Data);
+		}
+
+		delete SpillWrite;
+	}
+
+	for (FSlab* Slab : Slabs)
+	{
+		FMemory::Free(Slab->Data);
+		delete Slab;
+	}
+
+	Slabs.Empty();
+
+	for (uint8* Data : FreeSlabData)
+	{
+		FMemory::Free(Data);
+	}
+
+	FreeSlabData.Empty();
+
+	for (FReadBuffer& ReadBuffer : ReadBuffers)
+	{
+		FMemory::Free(ReadBuffer.Data);
+	}
+
+	ReadBuffers.Empty();
+
+	if (SpillFile != nullptr)
+	{
+		delete SpillFile;
+		SpillFile = nullptr;
+
+		FPlatformFileManager::Get().GetPlatformFile().DeleteFile(*SpillFilePath);
+	}
+
+	SpillFilePath.Empty();
+
+	MemoryUsed = 0;
+	NextSpillOffset = 0;
+	NumDiscardedFrames = 0;
+	NumPendingSpills = 0;
+	NumSpilledSlabs = 0;
+	NumVideoFrames = 0;
+	SpillFailed = false;
+	SpillWriteMemory = 0;
+
+	SpillReadStats.Reset();
+	SpillWriteStats.Reset();
+}
+
+
+int64 FNdiMediaTimeShiftBuffer::GetTime()
+{
+	return FTimespan::FromSeconds(FPlatformTime::Seconds()).GetTicks();
+}
+
+
+int64 FNdiMediaTimeShiftBuffer::GetNewestTime() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return (Slabs.Num() > 0) ? Slabs.Last()->Entries.Last().Time : 0;
+}
+
+
+int64 FNdiMediaTimeShiftBuffer::GetOldestTime() const
+{
+	FScopeLock Lock(&CriticalSection);
+	return (Slabs.Num() > 0) ? Slabs[0]->Entries[0].Time : 0;
+}
+
+
+FNdiMediaTimeShiftStats FNdiMediaTimeShiftBuffer::GetStats() const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FNdiMediaTimeShiftStats Stats;
+	{
+		Stats.Duration = (Slabs.Num() > 0) ? FTimespan(Slabs.Last()->Entries.Last().Time - Slabs[0]->Entries[0].Time) : FTimespan::Zero();
+		Stats.MemoryUsed = MemoryUsed;
+		Stats.NumDiscardedFrames = NumDiscardedFrames;
+		Stats.NumFrames = 0;
+		Stats.NumPendingSpills = NumPendingSpills;
+		Stats.NumSlabs = Slabs.Num() - NumSpilledSlabs;
+		Stats.NumSpilledSlabs = NumSpilledSlabs;
+		Stats.SpillReads = SpillReadStats;
+		Stats.SpillWrites = SpillWriteStats;
+
+		for (const FSlab* Slab : Slabs)
+		{
+			Stats.NumFrames += Slab->Entries.Num();
+		}
+	}
+
+	return Stats;
+}
+
+
+bool FNdiMediaTimeShiftBuffer::Open(const FNdiMediaTimeShiftSettings& InSettings)
+{
+	Close();
+
+	if (InSettings.Duration <= FTimespan::Zero())
+	{
+		return false;
+	}
+
+	FScopeLock Lock(&CriticalSection);
+
+	Settings = InSettings;
+	Settings.SlabSize = (uint32)NdiMediaRecording::AlignSize(FMath::Max(Settings.SlabSize, NdiMediaTimeShiftBuffer::MinSlabSize), NdiMediaRecording::Alignment);
+	Settings.MemoryBudget = FMath::Max<uint64>(Settings.MemoryBudget, 2 * Settings.SlabSize);
+
+	if (!Settings.SpillDirectory.IsEmpty() && (Settings.SpillBudget >= Settings.SlabSize))
+	{
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+		PlatformFile.CreateDirectoryTree(*Settings.SpillDirectory);
+		SpillFilePath = FPaths::CreateTempFilename(*Settings.SpillDirectory, TEXT("NdiTimeShift-"), TEXT(".tmp"));
+		SpillFile = PlatformFile.OpenWrite(*SpillFilePath, false, true);
+
+		if (SpillFile == nullptr)
+		{
+			UE_LOG(LogNdiMedia, Warning, TEXT("Failed to create time-shift spill file %s. Frames beyond the memory budget will be discarded."), *SpillFilePath);
+			SpillFilePath.Empty();
+		}
+		else
+		{
+			FReadBuffer ReadBuffer;
+			{
+				ReadBuffer.Capacity = 0;
+				ReadBuffer.Data = nullptr;
+				ReadBuffer.Loaded = false;
+				ReadBuffer.Pending = false;
+				ReadBuffer.Slab = nullptr;
+			}
+
+			ReadBuffers.Init(ReadBuffer, NdiMediaTimeShiftBuffer::NumReadBuffers);
+
+			Stopping = false;
+			Thread = FRunnableThread::Create(this, TEXT("FNdiMediaTimeShiftBuffer"), 0, TPri_AboveNormal);
+		}
+	}
+
+	Enabled = true;
+
+	return true;
+}
+
+
+int64 FNdiMediaTimeShiftBuffer::VisitFrames(int64 StartTime, int64 EndTime, FVisitor Visitor)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	int32 NextSlabIndex = INDEX_NONE;
+	int64 VisitedTime = StartTime;
+	bool Waiting = false;
+
+	for (int32 SlabIndex = FMath::Max(FindSlab(StartTime), 0); SlabIndex < Slabs.Num(); ++SlabIndex)
+	{
+		const FSlab& Slab = *Slabs[SlabIndex];
+
+		if (Slab.Entries[0].Time > EndTime)
+		{
+			NextSlabIndex = SlabIndex;
+			break;
+		}
+
+		if (Slab.Entries.Last().Time <= StartTime)
+		{
+			continue;
+		}
+
+		NextSlabIndex = SlabIndex + 1;
+
+		const uint8* Data = LoadSlab(Slab);
+
+		// the caller continues from here once the slab was read, rather than skipping its frames
+		if (Data == nullptr)
+		{
+			Waiting = true;
+			break;
+		}
+
+		for (int32 EntryIndex = NdiMediaTimeShiftBuffer::UpperBound(Slab.Entries, StartTime); EntryIndex < Slab.Entries.Num(); ++EntryIndex)
+		{
+			const FEntry& Entry = Slab.Entries[EntryIndex];
+
+			if (Entry.Time > EndTime)
+			{
+				PrefetchSlab(NextSlabIndex);
+
+				return EndTime;
+			}
+
+			Visitor(Entry.Time, *(const FNdiMediaRecordingFrameHeader*)(Data + Entry.Offset));
+			VisitedTime = Entry.Time;
+		}
+	}
+
+	// the visited slabs' buffers are no longer in use, so playback's next slab can be read into them
+	PrefetchSlab(NextSlabIndex);
+
+	return Waiting ? VisitedTime : EndTime;
+}
+
+
+bool FNdiMediaTimeShiftBuffer::VisitVideoFrame(int64 Time, FVisitor Visitor)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (NumVideoFrames == 0)
+	{
+		return false;
+	}
+
+	// entries stay in memory when their slab is spilled, so only the slab with the frame is loaded;
+	// its neighbors are prefetched afterwards, so that scrubbing and reverse playback don't wait for them
+	auto VisitEntry = [this, &Visitor](int32 SlabIndex, const FEntry& Entry) -> bool
+	{
+		const FSlab& Slab = *Slabs[SlabIndex];
+		const uint8* Data = LoadSlab(Slab);
+
+		if (Data != nullptr)
+		{
+			Visitor(Entry.Time, *(const FNdiMediaRecordingFrameHeader*)(Data + Entry.Offset));
+		}
+
+		PrefetchSlab(SlabIndex - 1);
+		PrefetchSlab(SlabIndex + 1);
+
+		return (Data != nullptr);
+	};
+
+	const int32 FirstSlab = FindSlab(Time);
+
+	// last video frame at or before the time
+	for (int32 SlabIndex = FirstSlab; SlabIndex >= 0; --SlabIndex)
+	{
+		const FSlab& Slab = *Slabs[SlabIndex];
+		int32 EntryIndex = (SlabIndex == FirstSlab) ? NdiMediaTimeShiftBuffer::UpperBound(Slab.Entries, Time) : Slab.Entries.Num();
+
+		while (--EntryIndex >= 0)
+		{
+			if (Slab.Entries[EntryIndex].Type == (uint32)ENdiMediaRecordType::Video)
+			{
+				return VisitEntry(SlabIndex, Slab.Entries[EntryIndex]);
+			}
+		}
+	}
+
+	// first video frame after the time
+	for (int32 SlabIndex = FMath::Max(FirstSlab, 0); SlabIndex < Slabs.Num(); ++SlabIndex)
+	{
+		const FSlab& Slab = *Slabs[SlabIndex];
+
+		for (int32 EntryIndex = (SlabIndex == FirstSlab) ? NdiMediaTimeShiftBuffer::UpperBound(Slab.Entries, Time) : 0; EntryIndex < Slab.Entries.Num(); ++EntryIndex)
+		{
+			if (Slab.Entries[EntryIndex].Type == (uint32)ENdiMediaRecordType::Video)
+			{
+				return VisitEntry(SlabIndex, Slab.Entries[EntryIndex]);
+			}
+		}
+	}
+
+	return false;
+}
+
+
+void FNdiMediaTimeShiftBuffer::WriteAudioFrame(const NDIlib_audio_frame_v2_t& AudioFrame)
+{
+	if (!Enabled || (AudioFrame.p_data == nullptr))
+	{
+		return;
+	}
+
+	FNdiMediaRecordingFrameHeader Header;
+	NdiMediaRecording::MakeAudioHeader(AudioFrame, Header);
+
+	FScopeLock Lock(&CriticalSection);
+
+	uint8* Dest = BeginRecord(Header);
+
+	if (Dest != nullptr)
+	{
+		NdiMediaRecording::CopyAudioData(AudioFrame, Header, Dest);
+	}
+}
+
+
+void FNdiMediaTimeShiftBuffer::WriteMetadataFrame(const NDIlib_metadata_frame_t& MetadataFrame)
+{
+	if (!Enabled || (MetadataFrame.p_data == nullptr) || (MetadataFrame.length <= 0))
+	{
+		return;
+	}
+
+	FNdiMediaRecordingFrameHeader Header;
+	NdiMediaRecording::MakeMetadataHeader(MetadataFrame, Header);
+
+	FScopeLock Lock(&CriticalSection);
+
+	uint8* Dest = BeginRecord(Header);
+
+	if (Dest != nullptr)
+	{
+		NdiMediaRecording::CopyMetadataData(MetadataFrame, Header, Dest);
+	}
+}
+
+
+void FNdiMediaTimeShiftBuffer::WriteVideoFrame(const NDIlib_video_frame_v2_t& VideoFrame)
+{
+	if (!Enabled || (VideoFrame.p_data == nullptr))
+	{
+		return;
+	}
+
+	FNdiMediaRecordingFrameHeader Header;
+	NdiMediaRecording::MakeVideoHeader(VideoFrame, Header);
+
+	FScopeLock Lock(&CriticalSection);
+
+	uint8* Dest = BeginRecord(Header);
+
+	if (Dest != nullptr)
+	{
+		NdiMediaRecording::CopyVideoData(VideoFrame, Header, Dest);
+	}
+}
+
+
+/* FRunnable interface
+ *****************************************************************************/
+
+bool FNdiMediaTimeShiftBuffer::Init()
+{
+	return true;
+}
+
+
+uint32 FNdiMediaTimeShiftBuffer::Run()
+{
+	while (!Stopping)
+	{
+		// reads are served between writes, so that seeks don't wait for the write-behind
+		ProcessSpillReads();
+
+		if (!ProcessSpillWrite())
+		{
+			WorkEvent->Wait(100);
+		}
+	}
+
+	return 0;
+}
+
+
+void FNdiMediaTimeShiftBuffer::Stop()
+{
+	Stopping = true;
+	WorkEvent->Trigger();
+}
+
+
+/* FNdiMediaTimeShiftBuffer implementation
+ *****************************************************************************/
+
+uint8* FNdiMediaTimeShiftBuffer::BeginRecord(const FNdiMediaRecordingFrameHeader& Header)
+{
+	if (!Enabled)
+	{
+		return nullptr;
+	}
+
+	const int64 Time = GetTime();
+	const uint64 PayloadSize = sizeof(FNdiMediaRecordingFrameHeader) + Header.DataSize + Header.MetadataSize;
+	const uint64 RecordSize = NdiMediaRecording::AlignSize(PayloadSize, NdiMediaRecording::RecordAlignment);
+
+	// recycle slabs that left the window
+	const int64 WindowStart = Time - Settings.Duration.GetTicks();
+
+	while ((Slabs.Num() > 1) && (Slabs[0]->Entries.Last().Time < WindowStart))
+	{
+		EvictOldestSlab(false);
+	}
+
+	FSlab* Slab = (Slabs.Num() > 0) ? Slabs.Last() : nullptr;
+
+	if ((Slab == nullptr) || (Slab->Data == nullptr) || (Slab->SpillWrite != nullptr) || (Slab->Size + RecordSize > Slab->Capacity))
+	{
+		Slab = NewSlab(RecordSize);
+
+		if (Slab == nullptr)
+		{
+			++NumDiscardedFrames;
+			return nullptr;
+		}
+	}
+
+	uint8* Record = Slab->Data + Slab->Size;
+
+	FMemory::Memcpy(Record, &Header, sizeof(FNdiMediaRecordingFrameHeader));
+	FMemory::Memzero(Record + PayloadSize, RecordSize - PayloadSize);
+
+	FEntry& Entry = Slab->Entries[Slab->Entries.AddUninitialized()];
+	{
+		Entry.Time = Time;
+		Entry.Offset = (uint32)Slab->Size;
+		Entry.Type = Header.Type;
+	}
+
+	if (Header.Type == (uint32)ENdiMediaRecordType::Video)
+	{
+		++NumVideoFrames;
+	}
+
+	Slab->Size += RecordSize;
+
+	return Record + sizeof(FNdiMediaRecordingFrameHeader);
+}
+
+
+void FNdiMediaTimeShiftBuffer::EvictOldestSlab(bool Discarded)
+{
+	FSlab* Slab = Slabs[0];
+
+	if (Discarded)
+	{
+		NumDiscardedFrames += Slab->Entries.Num();
+	}
+
+	for (const FEntry& Entry : Slab->Entries)
+	{
+		if (Entry.Type == (uint32)ENdiMediaRecordType::Video)
+		{
+			--NumVideoFrames;
+		}
+	}
+
+	if (Slab->SpillWrite != nullptr)
+	{
+		// the buffer is released once the I/O thread wrote it
+		Slab->SpillWrite->Slab = nullptr;
+	}
+	else if (Slab->Data != nullptr)
+	{
+		ReleaseSlabData(Slab->Data, Slab->Capacity);
+	}
+	else
+	{
+		--NumSpilledSlabs;
+	}
+
+	// reads that are still pending are discarded when they complete
+	for (FReadBuffer& ReadBuffer : ReadBuffers)
+	{
+		if (ReadBuffer.Slab == Slab)
+		{
+			ReadBuffer.Loaded = false;
+			ReadBuffer.Slab = nullptr;
+		}
+	}
+
+	delete Slab;
+	Slabs.RemoveAt(0, 1, false);
+}
+
+
+int32 FNdiMediaTimeShiftBuffer::FindSlab(int64 Time) const
+{
+	int32 First = 0;
+	int32 Count = Slabs.Num();
+
+	// upper bound of the slabs' first entries
+	while (Count > 0)
+	{
+		const int32 Step = Count / 2;
+		const int32 Middle = First + Step;
+
+		if (Slabs[Middle]->Entries[0].Time <= Time)
+		{
+			First = Middle + 1;
+			Count -= Step + 1;
+		}
+		else
+		{
+			Count = Step;
+		}
+	}
+
+	return First - 1;
+}
+
+
+const uint8* FNdiMediaTimeShiftBuffer::LoadSlab(const FSlab& Slab)
+{
+	if (Slab.Data != nullptr)
+	{
+		return Slab.Data;
+	}
+
+	const FReadBuffer* ReadBuffer = RequestSlab(Slab);
+
+	return ((ReadBuffer != nullptr) && ReadBuffer->Loaded) ? ReadBuffer->Data : nullptr;
+}
+
+
+FNdiMediaTimeShiftBuffer::FSlab* FNdiMediaTimeShiftBuffer::NewSlab(uint64 MinCapacity)
+{
+	// frames that are larger than a slab get a slab of their own
+	const uint64 Capacity = FMath::Max<uint64>(Settings.SlabSize, NdiMediaRecording::AlignSize(MinCapacity, NdiMediaRecording::Alignment));
+	const bool Recycle = (Capacity == Settings.SlabSize);
+
+	// stay within the memory budget by spilling or discarding the oldest slabs
+	while (MemoryUsed - SpillWriteMemory + Capacity > Settings.MemoryBudget)
+	{
+		if (FreeSlabData.Num() > 0)
+		{
+			if (Recycle)
+			{
+				break;
+			}
+
+			FMemory::Free(FreeSlabData.Pop(false));
+			MemoryUsed -= Settings.SlabSize;
+		}
+		else if ((SpillFile != nullptr) && !SpillFailed && (NumPendingSpills >= NdiMediaTimeShiftBuffer::MaxPendingSpills))
+		{
+			// the disk can't keep up; dropping frames keeps the capture threads from stalling
+			return nullptr;
+		}
+		else if (!SpillOldestSlab())
+		{
+			if (Slabs.Num() == 0)
+			{
+				break;
+			}
+
+			EvictOldestSlab(true);
+		}
+	}
+
+	FSlab* Slab = new FSlab;
+	{
+		if (Recycle && (FreeSlabData.Num() > 0))
+		{
+			Slab->Data = FreeSlabData.Pop(false);
+		}
+		else
+		{
+			Slab->Data = (uint8*)FMemory::Malloc(Capacity, NdiMediaRecording::RecordAlignment);
+			MemoryUsed += Capacity;
+		}
+
+		Slab->Capacity = Capacity;
+		Slab->Size = 0;
+		Slab->SpillOffset = INDEX_NONE;
+		Slab->SpillWrite = nullptr;
+	}
+
+	Slabs.Add(Slab);
+
+	return Slab;
+}
+
+
+void FNdiMediaTimeShiftBuffer::PrefetchSlab(int32 SlabIndex)
+{
+	if (Slabs.IsValidIndex(SlabIndex) && (Slabs[SlabIndex]->Data == nullptr))
+	{
+		RequestSlab(*Slabs[SlabIndex]);
+	}
+}
+
+
+void FNdiMediaTimeShiftBuffer::ProcessSpillReads()
+{
+	FSpillRead SpillRead;
+
+	while (SpillReads.Dequeue(SpillRead))
+	{
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		const bool Read = !SpillFailed && SpillFile->Seek(SpillRead.Offset) && SpillFile->Read(SpillRead.Data, SpillRead.Size);
+
+		FScopeLock Lock(&CriticalSection);
+
+		FReadBuffer& ReadBuffer = ReadBuffers[SpillRead.ReadBufferIndex];
+
+		ReadBuffer.Loaded = Read && (ReadBuffer.Slab != nullptr);
+		ReadBuffer.Pending = false;
+
+		if (Read)
+		{
+			SpillReadStats.Add(FPlatformTime::Cycles64() - StartCycles);
+		}
+		else if (!SpillFailed)
+		{
+			UE_LOG(LogNdiMedia, Warning, TEXT("Failed to read time-shift spill file %s. Frames beyond the memory budget will be discarded."), *SpillFilePath);
+			ResetSpill();
+		}
+	}
+}
+
+
+bool FNdiMediaTimeShiftBuffer::ProcessSpillWrite()
+{
+	FSpillWrite* SpillWrite = nullptr;
+
+	if (!SpillWrites.Dequeue(SpillWrite))
+	{
+		return false;
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const bool Written = !SpillFailed && SpillFile->Seek(SpillWrite->Offset) && SpillFile->Write(SpillWrite->Data, SpillWrite->Size);
+
+	FScopeLock Lock(&CriticalSection);
+
+	FSlab* Slab = SpillWrite->Slab;
+
+	--NumPendingSpills;
+	SpillWriteMemory -= SpillWrite->Capacity;
+
+	if (Written)
+	{
+		SpillWriteStats.Add(FPlatformTime::Cycles64() - StartCycles);
+	}
+	else if (!SpillFailed)
+	{
+		UE_LOG(LogNdiMedia, Warning, TEXT("Failed to write time-shift spill file %s. Frames beyond the memory budget will be discarded."), *SpillFilePath);
+		ResetSpill();
+	}
+
+	if (Slab == nullptr)
+	{
+		ReleaseSlabData(SpillWrite->Data, SpillWrite->Capacity);
+	}
+	else if (Written)
+	{
+		ReleaseSlabData(Slab->Data, Slab->Capacity);
+
+		Slab->Data = nullptr;
+		Slab->SpillWrite = nullptr;
+		++NumSpilledSlabs;
+	}
+	else
+	{
+		// slabs that couldn't be spilled stay in memory
+		Slab->SpillOffset = INDEX_NONE;
+		Slab->SpillWrite = nullptr;
+	}
+
+	delete SpillWrite;
+
+	return true;
+}
+
+
+void FNdiMediaTimeShiftBuffer::ReleaseSlabData(uint8* Data, uint64 Capacity)
+{
+	// buffers of the default size are kept for the next slabs
+	if ((Capacity == Settings.SlabSize) && (FreeSlabData.Num() < NdiMediaTimeShiftBuffer::MaxPendingSpills))
+	{
+		FreeSlabData.Push(Data);
+	}
+	else
+	{
+		FMemory::Free(Data);
+		MemoryUsed -= Capacity;
+	}
+}
+
+
+FNdiMediaTimeShiftBuffer::FReadBuffer* FNdiMediaTimeShiftBuffer::RequestSlab(const FSlab& Slab)
+{
+	FReadBuffer* FreeBuffer = nullptr;
+	int64 FreeDistance = -1;
+
+	for (FReadBuffer& ReadBuffer : ReadBuffers)
+	{
+		if (ReadBuffer.Slab == &Slab)
+		{
+			return &ReadBuffer;
+		}
+
+		if (ReadBuffer.Pending)
+		{
+			continue;
+		}
+
+		// reuse the buffer of the slab that is farthest away, so that the neighbors of visited slabs stay loaded
+		const int64 Distance = (ReadBuffer.Slab == nullptr) ? MAX_int64 : FMath::Abs(ReadBuffer.Slab->Entries[0].Time - Slab.Entries[0].Time);
+
+		if (Distance > FreeDistance)
+		{
+			FreeBuffer = &ReadBuffer;
+			FreeDistance = Distance;
+		}
+	}
+
+	if ((FreeBuffer == nullptr) || SpillFailed)
+	{
+		return nullptr;
+	}
+
+	if (FreeBuffer->Capacity < Slab.Size)
+	{
+		FMemory::Free(FreeBuffer->Data);
+
+		FreeBuffer->Capacity = Slab.Capacity;
+		FreeBuffer->Data = (uint8*)FMemory::Malloc(FreeBuffer->Capacity, NdiMediaRecording::RecordAlignment);
+	}
+
+	FreeBuffer->Loaded = false;
+	FreeBuffer->Pending = true;
+	FreeBuffer->Slab = &Slab;
+
+	FSpillRead SpillRead;
+	{
+		SpillRead.Data = FreeBuffer->Data;
+		SpillRead.Offset = (uint64)Slab.SpillOffset;
+		SpillRead.ReadBufferIndex = (int32)(FreeBuffer - ReadBuffers.GetData());
+		SpillRead.Size = Slab.Size;
+	}
+
+	SpillReads.Enqueue(SpillRead);
+	WorkEvent->Trigger();
+
+	return FreeBuffer;
+}
+
+
+void FNdiMediaTimeShiftBuffer::ResetSpill()
+{
+	SpillFailed = true;
+
+	// spilled slabs can't be read anymore
+	while ((Slabs.Num() > 0) && (Slabs[0]->Data == nullptr))
+	{
+		EvictOldestSlab(true);
+	}
+}
+
+
+bool FNdiMediaTimeShiftBuffer::SpillOldestSlab()
+{
+	if ((SpillFile == nullptr) || SpillFailed)
+	{
+		return false;
+	}
+
+	// slabs that are being spilled are skipped as well
+	int32 SlabIndex = 0;
+
+	while ((SlabIndex < Slabs.Num()) && ((Slabs[SlabIndex]->Data == nullptr) || (Slabs[SlabIndex]->SpillWrite != nullptr)))
+	{
+		++SlabIndex;
+	}
+
+	if ((SlabIndex == Slabs.Num()) || (Slabs[SlabIndex]->Size > Settings.SpillBudget))
+	{
+		return false;
+	}
+
+	FSlab* Slab = Slabs[SlabIndex];
+
+	// the spill file is a ring; the slabs that are overwritten are the oldest ones
+	uint64 Offset = NextSpillOffset;
+
+	if (Offset + Slab->Size > Settings.SpillBudget)
+	{
+		Offset = 0;
+	}
+
+	int32 NumOverwritten = 0;
+
+	for (int32 Index = 0; Index < SlabIndex; ++Index)
+	{
+		const uint64 SpilledOffset = (uint64)Slabs[Index]->SpillOffset;
+
+		if ((SpilledOffset < Offset + Slab->Size) && (Offset < SpilledOffset + Slabs[Index]->Size))
+		{
+			NumOverwritten = Index + 1;
+		}
+	}
+
+	while (NumOverwritten-- > 0)
+	{
+		EvictOldestSlab(true);
+	}
+
+	// the slab keeps its buffer, which remains readable, until the I/O thread wrote it
+	FSpillWrite* SpillWrite = new FSpillWrite;
+	{
+		SpillWrite->Capacity = Slab->Capacity;
+		SpillWrite->Data = Slab->Data;
+		SpillWrite->Offset = Offset;
+		SpillWrite->Size = Slab->Size;
+		SpillWrite->Slab = Slab;
+	}
+
+	Slab->SpillOffset = Offset;
+	Slab->SpillWrite = SpillWrite;
+
+	NextSpillOffset = Offset + NdiMediaRecording::AlignSize(Slab->Size, NdiMediaRecording::Alignment);
+	SpillWriteMemory += Slab->Capacity;
+	++NumPendingSpills;
+
+	SpillWrites.Enqueue(SpillWrite);
+	WorkEvent->Trigger();
+
+	return true;
+}
@@ -0,0 +1,511 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "NdiMediaRecordingFormat.h"
+#include "NdiMediaStageStats.h"
+#include "Templates/Function.h"
+
+
+class FEvent;
+class FRunnableThread;
+class IFileHandle;
+
+struct NDIlib_audio_frame_v2_t;
+struct NDIlib_metadata_frame_t;
+struct NDIlib_video_frame_v2_t;
+
+
+/**
+ * Settings of a time-shift buffer.
+ */
+struct FNdiMediaTimeShiftSettings
+{
+	/** How much of the stream is kept. */
+	FTimespan Duration;
+
+	/** Maximum amount of memory used for frame slabs, excluding slabs that are being spilled (in bytes). */
+	uint64 MemoryBudget;
+
+	/** Size of the slabs that frames are stored in (in bytes). */
+	uint32 SlabSize;
+
+	/** Maximum size of the spill file (in bytes). */
+	uint64 SpillBudget;
+
+	/** Directory for the spill file (empty = don't spill; frames beyond the memory budget are discarded). */
+	FString SpillDirectory;
+
+public:
+
+	/** Default constructor (30 seconds, 512 MiB of 8 MiB slabs, 4 GiB spill file). */
+	FNdiMediaTimeShiftSettings()
+		: Duration(FTimespan::FromSeconds(30.0))
+		, MemoryBudget(512 * 1024 * 1024)
+		, SlabSize(8 * 1024 * 1024)
+		, SpillBudget(4ull * 1024 * 1024 * 1024)
+	{ }
+};
+
+
+/**
+ * Statistics of a time-shift buffer.
+ */
+struct FNdiMediaTimeShiftStats
+{
+	/** Length of the buffered stream. */
+	FTimespan Duration;
+
+	/** Memory used by frame slabs (in bytes). */
+	uint64 MemoryUsed;
+
+	/** Number of frames that were discarded before they left the window. */
+	uint64 NumDiscardedFrames;
+
+	/** Number of buffered frames. */
+	int32 NumFrames;
+
+	/** Number of slabs in memory. */
+	int32 NumSlabs;
+
+	/** Number of slabs waiting to be written to the spill file. */
+	int32 NumPendingSpills;
+
+	/** Number of slabs in the spill file. */
+	int32 NumSpilledSlabs;
+
+	/** Time spent reading slabs from the spill file. */
+	FNdiMediaStageStats SpillReads;
+
+	/** Time spent writing slabs to the spill file. */
+	FNdiMediaStageStats SpillWrites;
+};
+
+
+/**
+ * Keeps the most recently received NDI frames for time-shifted playback.
+ *
+ * Frames are stored as recording frame records in large slabs, which are
+ * recycled when they leave the window. Each frame is tagged with its arrival
+ * time, so that frames can be found with a binary search even if the sender's
+ * timecodes are irregular.
+ *
+ * When the memory budget is exhausted, the oldest slabs are handed to a
+ * dedicated I/O thread, which writes them to a spill file that is used as a
+ * ring. Their buffers are recycled for new frames once they were written; if
+ * the disk can't keep up, incoming frames are dropped rather than stalling the
+ * capture threads. Without a spill directory the oldest frames are discarded
+ * instead.
+ *
+ * Spilled slabs are read back on the I/O thread as well. Visiting a slab that
+ * isn't loaded yet requests it and skips its frames until it arrives, and the
+ * neighbors of visited slabs are prefetched, so that neither seeking nor
+ * playback blocks on the disk.
+ *
+ * All functions are thread-safe. Frames are written on the threads that
+ * capture them.
+ *
+ * @see FNdiMediaRecorder
+ */
+class FNdiMediaTimeShiftBuffer
+	: public FRunnable
+{
+public:
+
+	/**
+	 * Callback for visiting buffered frames.
+	 *
+	 * The frame header is followed by the frame's data, which remains valid
+	 * only until the callback returns. The buffer is locked while the callback
+	 * executes, so it must not write frames.
+	 *
+	 * @param Time The frame's arrival time (in 100ns ticks).
+	 * @param Header The frame record.
+	 */
+	typedef TFunctionRef<void(int64 Time, const FNdiMediaRecordingFrameHeader& Header)> FVisitor;
+
+public:
+
+	/** Default constructor. */
+	FNdiMediaTimeShiftBuffer();
+
+	/** Destructor. */
+	virtual ~FNdiMediaTimeShiftBuffer();
+
+public:
+
+	/**
+	 * Discard all frames and release the buffer's memory and spill file.
+	 *
+	 * @see IsOpen, Open
+	 */
+	void Close();
+
+	/**
+	 * Get the current time of the buffer's clock.
+	 *
+	 * @return Time (in 100ns ticks).
+	 */
+	static int64 GetTime();
+
+	/**
+	 * Get the arrival time of the newest frame.
+	 *
+	 * @return Time (in 100ns ticks), or zero if the buffer is empty.
+	 * @see GetOldestTime
+	 */
+	int64 GetNewestTime() const;
+
+	/**
+	 * Get the arrival time of the oldest frame.
+	 *
+	 * @return Time (in 100ns ticks), or zero if the buffer is empty.
+	 * @see GetNewestTime
+	 */
+	int64 GetOldestTime() const;
+
+	/**
+	 * Get the buffer's statistics.
+	 *
+	 * @return Statistics.
+	 */
+	FNdiMediaTimeShiftStats GetStats() const;
+
+	/**
+	 * Whether the buffer accepts frames.
+	 *
+	 * @return true if open, false otherwise.
+	 * @see Close, Open
+	 */
+	bool IsOpen() const
+	{
+		return Enabled;
+	}
+
+	/**
+	 * Start buffering frames.
+	 *
+	 * @param InSettings The buffer settings.
+	 * @return true on success, false otherwise.
+	 * @see Close, IsOpen
+	 */
+	bool Open(const FNdiMediaTimeShiftSettings& InSettings);
+
+	/**
+	 * Visit the frames that arrived in a time range.
+	 *
+	 * Visiting stops at the first spilled slab that is still being read, so
+	 * that the caller can continue from there once it was loaded.
+	 *
+	 * @param StartTime Frames must have arrived after this time (in 100ns ticks).
+	 * @param EndTime Frames must have arrived at or before this time (in 100ns ticks).
+	 * @param Visitor The callback that is invoked for each frame, in order of arrival.
+	 * @return The time up to which frames were visited (EndTime, unless a slab is still being read).
+	 * @see VisitVideoFrame
+	 */
+	int64 VisitFrames(int64 StartTime, int64 EndTime, FVisitor Visitor);
+
+	/**
+	 * Visit the video frame that is visible at the given time.
+	 *
+	 * @param Time The time (in 100ns ticks).
+	 * @param Visitor The callback that is invoked for the last video frame at or before the time, or the first one after it.
+	 * @return true if a video frame was visited, false if the buffer has no video or its slab is still being read.
+	 * @see VisitFrames
+	 */
+	bool VisitVideoFrame(int64 Time, FVisitor Visitor);
+
+	/**
+	 * Buffer an audio frame.
+	 *
+	 * @param AudioFrame The frame to buffer.
+	 * @see WriteMetadataFrame, WriteVideoFrame
+	 */
+	void WriteAudioFrame(const NDIlib_audio_frame_v2_t& AudioFrame);
+
+	/**
+	 * Buffer a frame received on the metadata channel.
+	 *
+	 * @param MetadataFrame The frame to buffer.
+	 * @see WriteAudioFrame, WriteVideoFrame
+	 */
+	void WriteMetadataFrame(const NDIlib_metadata_frame_t& MetadataFrame);
+
+	/**
+	 * Buffer a video frame.
+	 *
+	 * @param VideoFrame The frame to buffer.
+	 * @see WriteAudioFrame, WriteMetadataFrame
+	 */
+	void WriteVideoFrame(const NDIlib_video_frame_v2_t& VideoFrame);
+
+public:
+
+	//~ FRunnable interface
+
+	virtual bool Init() override;
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	virtual void Exit() override { }
+
+protected:
+
+	/** A buffered frame. */
+	struct FEntry
+	{
+		/** Arrival time of the frame (in 100ns ticks). */
+		int64 Time;
+
+		/** Offset of the frame record within its slab (in bytes). */
+		uint32 Offset;
+
+		/** The record type (see ENdiMediaRecordType). */
+		uint32 Type;
+	};
+
+	struct FSlab;
+
+	/** A buffer for slabs that are read from the spill file. */
+	struct FReadBuffer
+	{
+		/** Size of the allocated buffer (in bytes). */
+		uint64 Capacity;
+
+		/** The buffer. */
+		uint8* Data;
+
+		/** Whether the slab's data was read. */
+		bool Loaded;
+
+		/** Whether the I/O thread is reading into the buffer. */
+		bool Pending;
+
+		/** The slab whose data is read into the buffer (nullptr if none). */
+		const FSlab* Slab;
+	};
+
+	/** A request to read a slab from the spill file. */
+	struct FSpillRead
+	{
+		/** The buffer to read into. */
+		uint8* Data;
+
+		/** Offset of the slab in the spill file. */
+		uint64 Offset;
+
+		/** Index of the read buffer. */
+		int32 ReadBufferIndex;
+
+		/** Number of bytes to read. */
+		uint64 Size;
+	};
+
+	/** A request to write a slab to the spill file. */
+	struct FSpillWrite
+	{
+		/** Size of the slab buffer (in bytes). */
+		uint64 Capacity;
+
+		/** The slab buffer, which is released once it was written. */
+		uint8* Data;
+
+		/** Offset of the slab in the spill file. */
+		uint64 Offset;
+
+		/** Number of bytes to write. */
+		uint64 Size;
+
+		/** The slab that is spilled (nullptr if it was evicted in the meantime). */
+		FSlab* Slab;
+	};
+
+	/** A slab of frame records. */
+	struct FSlab
+	{
+		/** Size of the allocated buffer (in bytes). */
+		uint64 Capacity;
+
+		/** The slab buffer (nullptr if spilled). */
+		uint8* Data;
+
+		/** The slab's frames. */
+		TArray<FEntry> Entries;
+
+		/** Number of used bytes. */
+		uint64 Size;
+
+		/** Offset of the slab in the spill file (INDEX_NONE if in memory). */
+		int64 SpillOffset;
+
+		/** The pending write of the slab to the spill file (nullptr if none). */
+		FSpillWrite* SpillWrite;
+	};
+
+	/**
+	 * Allocate a record in the newest slab.
+	 *
+	 * @param Header The record's frame header.
+	 * @return Pointer to the record's frame data, or nullptr if the frame must be dropped.
+	 */
+	uint8* BeginRecord(const FNdiMediaRecordingFrameHeader& Header);
+
+	/**
+	 * Remove the oldest slab.
+	 *
+	 * @param Discarded Whether the slab's frames are discarded before they left the window.
+	 */
+	void EvictOldestSlab(bool Discarded);
+
+	/**
+	 * Find the slab that contains the last frame at or before the given time.
+	 *
+	 * @param Time The time to search for (in 100ns ticks).
+	 * @return Index of the slab, or INDEX_NONE if all frames are later.
+	 */
+	int32 FindSlab(int64 Time) const;
+
+	/**
+	 * Get the data of a slab, and request it from the spill file if needed.
+	 *
+	 * @param Slab The slab.
+	 * @return The slab data, or nullptr if it is still being read.
+	 * @see PrefetchSlab
+	 */
+	const uint8* LoadSlab(const FSlab& Slab);
+
+	/**
+	 * Make room for a new slab within the memory budget.
+	 *
+	 * @param MinCapacity The minimum size of the slab (in bytes).
+	 * @return The new slab, or nullptr if the spill file can't keep up.
+	 */
+	FSlab* NewSlab(uint64 MinCapacity);
+
+	/**
+	 * Request a spilled slab from the spill file before it is visited.
+	 *
+	 * @param SlabIndex Index of the slab (may be out of range).
+	 * @see LoadSlab
+	 */
+	void PrefetchSlab(int32 SlabIndex);
+
+	/**
+	 * Read the slabs that were requested since the last call (on the I/O thread).
+	 *
+	 * @see RequestSlab
+	 */
+	void ProcessSpillReads();
+
+	/**
+	 * Write the oldest pending slab to the spill file (on the I/O thread).
+	 *
+	 * @return true if a slab was processed, false if none is pending.
+	 * @see SpillOldestSlab
+	 */
+	bool ProcessSpillWrite();
+
+	/**
+	 * Release the buffer of a slab.
+	 *
+	 * @param Data The slab buffer.
+	 * @param Capacity Size of the buffer (in bytes).
+	 */
+	void ReleaseSlabData(uint8* Data, uint64 Capacity);
+
+	/**
+	 * Get the read buffer of a spilled slab, and request the slab from the I/O thread if needed.
+	 *
+	 * @param Slab The slab.
+	 * @return The read buffer, or nullptr if all read buffers are busy.
+	 */
+	FReadBuffer* RequestSlab(const FSlab& Slab);
+
+	/**
+	 * Discard all spilled slabs after the spill file failed.
+	 *
+	 * @see SpillFailed
+	 */
+	void ResetSpill();
+
+	/**
+	 * Hand the oldest slab that is in memory to the I/O thread for spilling.
+	 *
+	 * @return true on success, false if the slab couldn't be spilled.
+	 */
+	bool SpillOldestSlab();
+
+private:
+
+	/** Critical section for synchronizing access to all slabs. */
+	mutable FCriticalSection CriticalSection;
+
+	/** Whether the buffer accepts frames. */
+	FThreadSafeBool Enabled;
+
+	/** Recycled slab buffers of the default size. */
+	TArray<uint8*> FreeSlabData;
+
+	/** Memory used by slab buffers (in bytes). */
+	uint64 MemoryUsed;
+
+	/** Offset of the next slab in the spill file. */
+	uint64 NextSpillOffset;
+
+	/** Number of frames that were discarded before they left the window. */
+	uint64 NumDiscardedFrames;
+
+	/** Number of slabs that are waiting for the I/O thread. */
+	int32 NumPendingSpills;
+
+	/** Number of slabs in the spill file. */
+	int32 NumSpilledSlabs;
+
+	/** Number of buffered video frames. */
+	int32 NumVideoFrames;
+
+	/** Buffers for slabs that are read from the spill file. */
+	TArray<FReadBuffer> ReadBuffers;
+
+	/** The buffer settings. */
+	FNdiMediaTimeShiftSettings Settings;
+
+	/** The buffered slabs (oldest first). */
+	TArray<FSlab*> Slabs;
+
+	/** Whether reading or writing the spill file failed (no further slabs are spilled). */
+	FThreadSafeBool SpillFailed;
+
+	/** The spill file (nullptr if not spilling; only accessed by the I/O thread while it runs). */
+	IFileHandle* SpillFile;
+
+	/** Path of the spill file. */
+	FString SpillFilePath;
+
+	/** Time spent reading slabs from the spill file. */
+	FNdiMediaStageStats SpillReadStats;
+
+	/** Slabs that are waiting to be read by the I/O thread. */
+	TQueue<FSpillRead, EQueueMode::Mpsc> SpillReads;
+
+	/** Memory used by slab buffers that are waiting to be written (in bytes). */
+	uint64 SpillWriteMemory;
+
+	/** Time spent writing slabs to the spill file. */
+	FNdiMediaStageStats SpillWriteStats;
+
+	/** Slabs that are waiting to be written by the I/O thread. */
+	TQueue<FSpillWrite*, EQueueMode::Mpsc> SpillWrites;
+
+	/** Holds a flag indicating that the thread is stopping. */
+	FThreadSafeBool Stopping;
+
+	/** Holds the thread object. */
+	FRunnableThread* Thread;
+
+	/** Event that wakes up the I/O thread. */
+	FEvent* WorkEvent;
+};
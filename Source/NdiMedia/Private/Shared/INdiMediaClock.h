@@ -0,0 +1,40 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/Timespan.h"
+
+
+/**
+ * Interface for clocks that time synthetic sources and measurements.
+ *
+ * Clocks are injected into components that generate or time frames, so that
+ * throughput and latency can be measured against either wall clock time or
+ * a deterministic virtual time. All functions may be called from any thread.
+ *
+ * @see FNdiMediaManualClock, FNdiMediaPlatformClock
+ */
+class INdiMediaClock
+{
+public:
+
+	/**
+	 * Get the current time.
+	 *
+	 * @return Time since an arbitrary, clock specific epoch.
+	 */
+	virtual FTimespan GetTime() const = 0;
+
+	/**
+	 * Block the calling thread for the given amount of time.
+	 *
+	 * @param Duration How long to wait.
+	 */
+	virtual void Wait(FTimespan Duration) = 0;
+
+public:
+
+	/** Virtual destructor. */
+	virtual ~INdiMediaClock() { }
+};
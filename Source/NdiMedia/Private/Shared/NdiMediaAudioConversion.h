@@ -0,0 +1,44 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+namespace NdiMediaAudio
+{
+	/**
+	 * Convert a planar floating point audio frame to interleaved 16-bit samples.
+	 *
+	 * Portable replacement for NDIlib_util_audio_to_interleaved_16s_v2, which
+	 * produces the same output. The destination's sample buffer and reference
+	 * level must be set by the caller.
+	 *
+	 * @param Source The audio frame to convert.
+	 * @param Dest The interleaved audio frame.
+	 */
+	inline void ConvertToInterleaved16s(const NDIlib_audio_frame_v2_t& Source, NDIlib_audio_frame_interleaved_16s_t& Dest)
+	{
+		// full scale 16-bit samples are ReferenceLevel dB above the NDI reference level
+		const float Scale = 32767.0f * FMath::Pow(10.0f, -Dest.reference_level / 20.0f);
+		const int32 NumChannels = Source.no_channels;
+		const int32 NumSamples = Source.no_samples;
+
+		for (int32 ChannelIndex = 0; ChannelIndex < NumChannels; ++ChannelIndex)
+		{
+			const float* Channel = (const float*)((const uint8*)Source.p_data + ChannelIndex * Source.channel_stride_in_bytes);
+			short* Output = Dest.p_data + ChannelIndex;
+
+			for (int32 SampleIndex = 0; SampleIndex < NumSamples; ++SampleIndex)
+			{
+				*Output = (short)FMath::Clamp(FMath::RoundToInt(Channel[SampleIndex] * Scale), -32768, 32767);
+				Output += NumChannels;
+			}
+		}
+
+		Dest.sample_rate = Source.sample_rate;
+		Dest.no_channels = Source.no_channels;
+		Dest.no_samples = Source.no_samples;
+		Dest.timecode = Source.timecode;
+	}
+}
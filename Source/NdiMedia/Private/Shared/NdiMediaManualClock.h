@@ -0,0 +1,80 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "INdiMediaClock.h"
+#include "Misc/ScopeLock.h"
+
+
+/**
+ * Implements a clock whose time only moves when it is advanced or waited on.
+ *
+ * Waiting on this clock returns immediately and advances the time by the
+ * requested duration, so that code driven by it produces the same sequence
+ * of frames and timestamps on every run, regardless of machine load. This
+ * only holds as long as a single thread at a time advances or waits on it.
+ */
+class FNdiMediaManualClock
+	: public INdiMediaClock
+{
+public:
+
+	/** Default constructor. */
+	FNdiMediaManualClock()
+		: Time(FTimespan::Zero())
+	{ }
+
+public:
+
+	/**
+	 * Advance the clock.
+	 *
+	 * @param Delta The amount of time to advance by.
+	 * @see SetTime
+	 */
+	void Advance(FTimespan Delta)
+	{
+		FScopeLock Lock(&CriticalSection);
+		Time += Delta;
+	}
+
+	/**
+	 * Set the clock's time.
+	 *
+	 * @param NewTime The time to set.
+	 * @see Advance
+	 */
+	void SetTime(FTimespan NewTime)
+	{
+		FScopeLock Lock(&CriticalSection);
+		Time = NewTime;
+	}
+
+public:
+
+	//~ INdiMediaClock interface
+
+	virtual FTimespan GetTime() const override
+	{
+		FScopeLock Lock(&CriticalSection);
+		return Time;
+	}
+
+	virtual void Wait(FTimespan Duration) override
+	{
+		if (Duration > FTimespan::Zero())
+		{
+			Advance(Duration);
+		}
+	}
+
+private:
+
+	/** Critical section for synchronizing access to the time. */
+	mutable FCriticalSection CriticalSection;
+
+	/** The current time. */
+	FTimespan Time;
+};
@@ -0,0 +1,33 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "INdiMediaClock.h"
+
+
+/**
+ * Implements a clock that follows the platform's high resolution timer.
+ */
+class FNdiMediaPlatformClock
+	: public INdiMediaClock
+{
+public:
+
+	//~ INdiMediaClock interface
+
+	virtual FTimespan GetTime() const override
+	{
+		return FTimespan::FromSeconds(FPlatformTime::Seconds());
+	}
+
+	virtual void Wait(FTimespan Duration) override
+	{
+		if (Duration > FTimespan::Zero())
+		{
+			FPlatformProcess::Sleep((float)Duration.GetTotalSeconds());
+		}
+	}
+};
@@ -0,0 +1,34 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+	#define NDIMEDIA_SIMD_NEON 1
+	#define NDIMEDIA_SIMD_SSE2 0
+	#include <arm_neon.h>
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+	#define NDIMEDIA_SIMD_NEON 0
+	#define NDIMEDIA_SIMD_SSE2 1
+	#include <emmintrin.h>
+#else
+	#define NDIMEDIA_SIMD_NEON 0
+	#define NDIMEDIA_SIMD_SSE2 0
+#endif
+
+
+// AVX2 kernels are compiled alongside the SSE2 kernels and selected at run-time
+#if NDIMEDIA_SIMD_SSE2 && (PLATFORM_WINDOWS || PLATFORM_LINUX || PLATFORM_MAC)
+	#define NDIMEDIA_SIMD_AVX2 1
+	#include <immintrin.h>
+	#if defined(__clang__) || defined(__GNUC__)
+		#define NDIMEDIA_TARGET_AVX2 __attribute__((target("avx2")))
+	#else
+		#define NDIMEDIA_TARGET_AVX2
+	#endif
+#else
+	#define NDIMEDIA_SIMD_AVX2 0
+	#define NDIMEDIA_TARGET_AVX2
+#endif
@@ -0,0 +1,109 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+
+
+/**
+ * Accumulates the CPU cost of a processing stage.
+ *
+ * Stage statistics are updated by the thread that runs the stage and may be
+ * read from other threads for diagnostic purposes only.
+ */
+struct FNdiMediaStageStats
+{
+	/** Number of times the stage ran. */
+	uint64 Count;
+
+	/** Cycles spent in the most recent run. */
+	uint64 LastCycles;
+
+	/** Cycles spent in all runs. */
+	uint64 TotalCycles;
+
+public:
+
+	/** Default constructor. */
+	FNdiMediaStageStats()
+		: Count(0)
+		, LastCycles(0)
+		, TotalCycles(0)
+	{ }
+
+public:
+
+	/**
+	 * Add a run of the stage.
+	 *
+	 * @param Cycles Number of cycles spent in the run.
+	 */
+	void Add(uint64 Cycles)
+	{
+		++Count;
+		LastCycles = Cycles;
+		TotalCycles += Cycles;
+	}
+
+	/**
+	 * Get the average time spent per run.
+	 *
+	 * @return Time (in milliseconds).
+	 */
+	double GetAverageMs() const
+	{
+		return (Count > 0) ? (FPlatformTime::GetSecondsPerCycle64() * TotalCycles * 1000.0 / Count) : 0.0;
+	}
+
+	/**
+	 * Get the time spent in the most recent run.
+	 *
+	 * @return Time (in milliseconds).
+	 */
+	double GetLastMs() const
+	{
+		return FPlatformTime::GetSecondsPerCycle64() * LastCycles * 1000.0;
+	}
+
+	/** Reset the statistics. */
+	void Reset()
+	{
+		Count = 0;
+		LastCycles = 0;
+		TotalCycles = 0;
+	}
+};
+
+
+/**
+ * Adds the cycles spent in the current scope to a stage's statistics.
+ */
+class FNdiMediaStageScope
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InStats The statistics to add to.
+	 */
+	explicit FNdiMediaStageScope(FNdiMediaStageStats& InStats)
+		: StartCycles(FPlatformTime::Cycles64())
+		, Stats(InStats)
+	{ }
+
+	/** Destructor. */
+	~FNdiMediaStageScope()
+	{
+		Stats.Add(FPlatformTime::Cycles64() - StartCycles);
+	}
+
+private:
+
+	/** Cycle counter at the beginning of the scope. */
+	uint64 StartCycles;
+
+	/** The statistics to add to. */
+	FNdiMediaStageStats& Stats;
+};
@@ -0,0 +1,295 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaSyncGroup.h"
+#include "NdiMediaPrivate.h"
+
+#include "CoreGlobals.h"
+#include "INdiMediaBackend.h"
+#include "Misc/ScopeLock.h"
+
+
+namespace NdiMediaSyncGroup
+{
+	/** How far a member's newest frame may be behind the group's newest frame before the member is considered lagging (in 100ns ticks). */
+	static const int64 MaxLag = 5000000;
+
+	/** Maximum number of frames held per member (older frames are dropped). */
+	static const int32 MaxQueuedFrames = 8;
+}
+
+
+/* FNdiMediaSyncGroup structors
+ *****************************************************************************/
+
+FNdiMediaSyncGroup::FNdiMediaSyncGroup(const FString& InName)
+	: LastSelectionFrame(MAX_uint64)
+	, Name(InName)
+	, NextMemberId(0)
+{ }
+
+
+FNdiMediaSyncGroup::~FNdiMediaSyncGroup()
+{
+	// members should have been removed before their receivers were destroyed
+	check(Members.Num() == 0);
+}
+
+
+/* FNdiMediaSyncGroup interface
+ *****************************************************************************/
+
+int32 FNdiMediaSyncGroup::AddMember(const FString& MemberName, const TSharedRef<INdiMediaBackend, ESPMode::ThreadSafe>& Backend, void* ReceiverInstance)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FMember& Member = Members[Members.AddDefaulted()];
+	{
+		Member.Backend = Backend;
+		Member.Id = NextMemberId++;
+		Member.ReceiverInstance = ReceiverInstance;
+		Member.Selected = false;
+		Member.Stats.Name = MemberName;
+	}
+
+	return Member.Id;
+}
+
+
+TArray<FNdiMediaSyncMemberStats> FNdiMediaSyncGroup::GetStats() const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	TArray<FNdiMediaSyncMemberStats> Stats;
+
+	for (const FMember& Member : Members)
+	{
+		Stats.Add(Member.Stats);
+	}
+
+	return Stats;
+}
+
+
+bool FNdiMediaSyncGroup::PopFrame(int32 MemberId, NDIlib_video_frame_v2_t& OutFrame)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	// all members are aligned to the same instant in each engine frame
+	if (LastSelectionFrame != GFrameCounter)
+	{
+		LastSelectionFrame = GFrameCounter;
+		SelectFrames();
+	}
+
+	FMember* Member = FindMember(MemberId);
+
+	if ((Member == nullptr) || !Member->Selected)
+	{
+		return false;
+	}
+
+	OutFrame = Member->Frames[0];
+	Member->Frames.RemoveAt(0, 1, false);
+	Member->Selected = false;
+	++Member->Stats.NumPresented;
+
+	return true;
+}
+
+
+void FNdiMediaSyncGroup::PushFrame(int32 MemberId, const NDIlib_video_frame_v2_t& Frame)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FMember* Member = FindMember(MemberId);
+
+	if (Member == nullptr)
+	{
+		return;
+	}
+
+	Member->Frames.Add(Frame);
+
+	const int32 NumExcess = Member->Frames.Num() - NdiMediaSyncGroup::MaxQueuedFrames;
+
+	if (NumExcess > 0)
+	{
+		// a selected frame is kept until its member picks it up
+		FreeFrames(*Member, Member->Selected ? 1 : 0, NumExcess);
+		Member->Stats.NumDropped += NumExcess;
+	}
+}
+
+
+void FNdiMediaSyncGroup::RemoveMember(int32 MemberId)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	for (int32 MemberIndex = 0; MemberIndex < Members.Num(); ++MemberIndex)
+	{
+		if (Members[MemberIndex].Id == MemberId)
+		{
+			FreeFrames(Members[MemberIndex], 0, Members[MemberIndex].Frames.Num());
+			Members.RemoveAt(MemberIndex);
+
+			break;
+		}
+	}
+}
+
+
+/* FNdiMediaSyncGroup static functions
+ *****************************************************************************/
+
+TSharedRef<FNdiMediaSyncGroup, ESPMode::ThreadSafe> FNdiMediaSyncGroup::FindOrAdd(const FString& Name)
+{
+	static FCriticalSection RegistryCriticalSection;
+	static TMap<FString, TWeakPtr<FNdiMediaSyncGroup, ESPMode::ThreadSafe>> Registry;
+
+	FScopeLock Lock(&RegistryCriticalSection);
+
+	TSharedPtr<FNdiMediaSyncGroup, ESPMode::ThreadSafe> Group = Registry.FindRef(Name).Pin();
+
+	if (!Group.IsValid())
+	{
+		Group = MakeShareable(new FNdiMediaSyncGroup(Name));
+		Registry.Add(Name, Group);
+
+		// forget groups that are no longer referenced
+		for (auto It = Registry.CreateIterator(); It; ++It)
+		{
+			if (!It.Value().IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	return Group.ToSharedRef();
+}
+
+
+/* FNdiMediaSyncGroup implementation
+ *****************************************************************************/
+
+FNdiMediaSyncGroup::FMember* FNdiMediaSyncGroup::FindMember(int32 MemberId)
+{
+	for (FMember& Member : Members)
+	{
+		if (Member.Id == MemberId)
+		{
+			return &Member;
+		}
+	}
+
+	return nullptr;
+}
+
+
+void FNdiMediaSyncGroup::FreeFrames(FMember& Member, int32 Index, int32 Count)
+{
+	for (int32 FrameIndex = Index; FrameIndex < Index + Count; ++FrameIndex)
+	{
+		Member.Backend->RecvFreeVideo(Member.ReceiverInstance, Member.Frames[FrameIndex]);
+	}
+
+	Member.Frames.RemoveAt(Index, Count, false);
+}
+
+
+int64 FNdiMediaSyncGroup::GetFrameTime(const NDIlib_video_frame_v2_t& Frame, bool UseTimestamps)
+{
+	return UseTimestamps ? Frame.timestamp : Frame.timecode;
+}
+
+
+void FNdiMediaSyncGroup::SelectFrames()
+{
+	// align by sender timestamps only if all members provide them
+	bool UseTimestamps = true;
+
+	for (FMember& Member : Members)
+	{
+		// frames that weren't picked up since the last selection are dropped
+		if (Member.Selected)
+		{
+			FreeFrames(Member, 0, 1);
+			++Member.Stats.NumDropped;
+			Member.Selected = false;
+		}
+
+		if ((Member.Frames.Num() > 0) && (Member.Frames.Last().timestamp == NDIlib_recv_timestamp_undefined))
+		{
+			UseTimestamps = false;
+		}
+	}
+
+	// find the group's newest frame
+	int64 GroupNewest = MIN_int64;
+
+	for (const FMember& Member : Members)
+	{
+		if (Member.Frames.Num() > 0)
+		{
+			GroupNewest = FMath::Max(GroupNewest, GetFrameTime(Member.Frames.Last(), UseTimestamps));
+		}
+	}
+
+	if (GroupNewest == MIN_int64)
+	{
+		return; // no member has frames
+	}
+
+	// the presentation instant is the newest time for which all members that keep up have a frame
+	int64 PresentationTime = GroupNewest;
+
+	for (FMember& Member : Members)
+	{
+		if (Member.Frames.Num() == 0)
+		{
+			continue;
+		}
+
+		const int64 Newest = GetFrameTime(Member.Frames.Last(), UseTimestamps);
+		Member.Stats.Lagging = (Newest < GroupNewest - NdiMediaSyncGroup::MaxLag);
+
+		if (!Member.Stats.Lagging)
+		{
+			PresentationTime = FMath::Min(PresentationTime, Newest);
+		}
+	}
+
+	// select each member's last frame at or before the instant
+	for (FMember& Member : Members)
+	{
+		if (Member.Frames.Num() == 0)
+		{
+			++Member.Stats.NumRepeated;
+			continue;
+		}
+
+		int32 SelectedIndex = Member.Frames.Num() - 1;
+
+		if (!Member.Stats.Lagging)
+		{
+			while ((SelectedIndex > 0) && (GetFrameTime(Member.Frames[SelectedIndex], UseTimestamps) > PresentationTime))
+			{
+				--SelectedIndex;
+			}
+		}
+
+		// a member whose frames are all later than the instant keeps its previous frame
+		const int64 SelectedTime = GetFrameTime(Member.Frames[SelectedIndex], UseTimestamps);
+		Member.Stats.Offset = SelectedTime - PresentationTime;
+
+		if (!Member.Stats.Lagging && (SelectedTime > PresentationTime))
+		{
+			++Member.Stats.NumRepeated;
+			continue;
+		}
+
+		FreeFrames(Member, 0, SelectedIndex);
+		Member.Stats.NumDropped += SelectedIndex;
+		Member.Selected = true;
+	}
+}
@@ -0,0 +1,230 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "NdiMediaAllowPlatformTypes.h"
+	#include "Processing.NDI.Lib.h"
+#include "NdiMediaHidePlatformTypes.h"
+
+
+class INdiMediaBackend;
+
+
+/**
+ * Statistics of a sync group member.
+ */
+struct FNdiMediaSyncMemberStats
+{
+	/** Whether the member's newest frame was too old to be aligned with the other members. */
+	bool Lagging;
+
+	/** The member's name. */
+	FString Name;
+
+	/** Number of frames that were dropped to stay aligned. */
+	uint64 NumDropped;
+
+	/** Number of frames that were presented. */
+	uint64 NumPresented;
+
+	/** Number of presentation instants at which the previous frame was repeated. */
+	uint64 NumRepeated;
+
+	/** Offset of the most recently selected frame from the presentation instant (in 100ns ticks). */
+	int64 Offset;
+
+public:
+
+	/** Default constructor. */
+	FNdiMediaSyncMemberStats()
+		: Lagging(false)
+		, NumDropped(0)
+		, NumPresented(0)
+		, NumRepeated(0)
+		, Offset(0)
+	{ }
+};
+
+
+/**
+ * Presents the video of several NDI receivers in step (software genlock).
+ *
+ * Members push the video frames they capture into the group instead of
+ * presenting them right away. Once per engine frame, the group picks a common
+ * presentation instant, which is the newest time for which every member has
+ * a frame, and selects each member's last frame at or before that instant.
+ * Older frames are dropped, and members without a newer frame repeat their
+ * previous one. Frames are aligned by their sender timestamps if all members
+ * provide them, or by their timecodes otherwise.
+ *
+ * Members whose newest frame is too far behind the others (i.e. because they
+ * lost their connection) don't hold back the group; they present their newest
+ * frame and are reported as lagging.
+ *
+ * Groups are shared by name. All functions are thread-safe. The group never
+ * calls back into its members, so it may be used while holding a player lock.
+ */
+class FNdiMediaSyncGroup
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InName The group's name.
+	 * @see FindOrAdd
+	 */
+	FNdiMediaSyncGroup(const FString& InName);
+
+	/** Destructor. */
+	~FNdiMediaSyncGroup();
+
+public:
+
+	/**
+	 * Add a member to the group.
+	 *
+	 * @param MemberName The member's name (for statistics).
+	 * @param Backend The backend that the member's receiver was created on.
+	 * @param ReceiverInstance The member's receiver, which frees the member's frames.
+	 * @return The member's identifier.
+	 * @see RemoveMember
+	 */
+	int32 AddMember(const FString& MemberName, const TSharedRef<INdiMediaBackend, ESPMode::ThreadSafe>& Backend, void* ReceiverInstance);
+
+	/**
+	 * Get the group's name.
+	 *
+	 * @return Name.
+	 */
+	const FString& GetName() const
+	{
+		return Name;
+	}
+
+	/**
+	 * Get the statistics of all members.
+	 *
+	 * @return Member statistics.
+	 */
+	TArray<FNdiMediaSyncMemberStats> GetStats() const;
+
+	/**
+	 * Get the frame that a member should present now.
+	 *
+	 * The first call in each engine frame selects the frames of all members.
+	 * The caller takes ownership of the returned frame and must free it with
+	 * its receiver.
+	 *
+	 * @param MemberId The member's identifier.
+	 * @param OutFrame Will contain the frame.
+	 * @return true if a frame was returned, false if the member's previous frame should be repeated.
+	 * @see PushFrame
+	 */
+	bool PopFrame(int32 MemberId, NDIlib_video_frame_v2_t& OutFrame);
+
+	/**
+	 * Add a captured frame of a member.
+	 *
+	 * The group takes ownership of the frame.
+	 *
+	 * @param MemberId The member's identifier.
+	 * @param Frame The frame.
+	 * @see PopFrame
+	 */
+	void PushFrame(int32 MemberId, const NDIlib_video_frame_v2_t& Frame);
+
+	/**
+	 * Remove a member from the group and free its frames.
+	 *
+	 * Must be called before the member's receiver is destroyed.
+	 *
+	 * @param MemberId The member's identifier.
+	 * @see AddMember
+	 */
+	void RemoveMember(int32 MemberId);
+
+public:
+
+	/**
+	 * Get the sync group with the given name, creating it if needed.
+	 *
+	 * Groups exist for as long as they are referenced.
+	 *
+	 * @param Name The group's name.
+	 * @return The group.
+	 */
+	static TSharedRef<FNdiMediaSyncGroup, ESPMode::ThreadSafe> FindOrAdd(const FString& Name);
+
+protected:
+
+	/** A member of the group. */
+	struct FMember
+	{
+		/** The backend that the member's receiver was created on. */
+		TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> Backend;
+
+		/** The member's captured frames (oldest first). */
+		TArray<NDIlib_video_frame_v2_t> Frames;
+
+		/** Identifier of the member. */
+		int32 Id;
+
+		/** Whether the oldest frame was selected for presentation. */
+		bool Selected;
+
+		/** The member's receiver. */
+		void* ReceiverInstance;
+
+		/** The member's statistics. */
+		FNdiMediaSyncMemberStats Stats;
+	};
+
+	/**
+	 * Find a member.
+	 *
+	 * @param MemberId The member's identifier.
+	 * @return The member, or nullptr if not found.
+	 */
+	FMember* FindMember(int32 MemberId);
+
+	/**
+	 * Free a range of a member's frames.
+	 *
+	 * @param Member The member.
+	 * @param Index Index of the first frame to free.
+	 * @param Count Number of frames to free.
+	 */
+	static void FreeFrames(FMember& Member, int32 Index, int32 Count);
+
+	/**
+	 * Get the time that a frame is aligned by.
+	 *
+	 * @param Frame The frame.
+	 * @param UseTimestamps Whether to use the sender timestamp (true) or the timecode (false).
+	 * @return Time (in 100ns ticks).
+	 */
+	static int64 GetFrameTime(const NDIlib_video_frame_v2_t& Frame, bool UseTimestamps);
+
+	/** Select the frames of all members for the current presentation instant. */
+	void SelectFrames();
+
+private:
+
+	/** Critical section for synchronizing access to all members. */
+	mutable FCriticalSection CriticalSection;
+
+	/** The engine frame in which frames were last selected. */
+	uint64 LastSelectionFrame;
+
+	/** The group's members. */
+	TArray<FMember> Members;
+
+	/** The group's name. */
+	FString Name;
+
+	/** Identifier of the next member to be added. */
+	int32 NextMemberId;
+};
@@ -0,0 +1,774 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaPrivate.h"
+
+#include "Dom/JsonObject.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Ndi.h"
+#include "NdiMediaCountingMalloc.h"
+#include "NdiMediaLoopbackBackend.h"
+#include "NdiMediaPlatformClock.h"
+#include "NdiMediaPlayer.h"
+#include "NdiMediaSource.h"
+#include "NdiMediaTestSinks.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+
+
+namespace NdiMediaBenchmark
+{
+	/** Version of the result file format. */
+	static const int32 FormatVersion = 1;
+
+	/** Maximum number of pixels that all players of a scenario may receive per frame. */
+	static const int64 MaxPixelsPerScenario = (int64)16 * 3840 * 2160;
+
+	/** Settings that apply to all scenarios of a run. */
+	struct FRunSettings
+	{
+		/** How long each scenario is measured (in seconds). */
+		float Duration;
+
+		/** Frame rate of the synthetic sources. */
+		int32 FrameRate;
+
+		/** How often the players are ticked (in Hz). */
+		int32 TickRate;
+
+		/** How much worse than the baseline a metric may get before it counts as a regression (in percent). */
+		float Tolerance;
+
+		/** How long each scenario runs before it is measured (in seconds). */
+		float Warmup;
+	};
+
+	/** Describes a benchmark scenario. */
+	struct FScenario
+	{
+		/** Number of audio channels. */
+		int32 AudioChannels;
+
+		/** The receiver color format. */
+		ENdiMediaColorFormat ColorFormat;
+
+		/** Short name of the color format (used in the scenario name). */
+		const TCHAR* ColorFormatName;
+
+		/** Height of the video frames. */
+		int32 Height;
+
+		/** Number of concurrent players. */
+		int32 NumPlayers;
+
+		/** Width of the video frames. */
+		int32 Width;
+
+		/** How YUV frames are converted. */
+		ENdiMediaYuvConversion YuvConversion;
+
+		/** Get the scenario's unique name. */
+		FString GetName() const
+		{
+			return FString::Printf(TEXT("%ip_%s_%ich_%ix"), Height, ColorFormatName, AudioChannels, NumPlayers);
+		}
+	};
+
+	/** Describes a metric that is compared against the baseline. */
+	struct FMetric
+	{
+		/** Path of the metric in the scenario object (nested objects are separated by dots). */
+		const TCHAR* Path;
+
+		/** Whether larger values are better. */
+		bool HigherIsBetter;
+
+		/** Smallest absolute change that counts as a regression (suppresses noise on tiny values). */
+		double MinDelta;
+	};
+
+	/** The metrics that are compared against the baseline. */
+	static const FMetric Metrics[] =
+	{
+		{ TEXT("VideoFramesPerSecond"), true, 0.5 },
+		{ TEXT("AudioFramesPerSecond"), true, 0.5 },
+		{ TEXT("CpuMsPerFrame.AudioConversion"), false, 0.02 },
+		{ TEXT("CpuMsPerFrame.ColorConversion"), false, 0.02 },
+		{ TEXT("CpuMsPerFrame.Deinterlace"), false, 0.02 },
+		{ TEXT("CpuMsPerFrame.Resize"), false, 0.02 },
+		{ TEXT("CpuMsPerFrame.VideoCapture"), false, 0.02 },
+		{ TEXT("CpuMsPerFrame.VideoUpload"), false, 0.02 },
+		{ TEXT("AllocationsPerVideoFrame"), false, 0.5 },
+		{ TEXT("VideoLatencyMs.P95"), false, 1.0 },
+		{ TEXT("AudioLatencyMs.P95"), false, 1.0 },
+	};
+
+
+	/**
+	 * Build the list of scenarios to run.
+	 *
+	 * The quick matrix varies one parameter at a time around 1080p UYVY with
+	 * stereo audio and a single player. The full matrix runs all combinations,
+	 * except those whose players would receive more than MaxPixelsPerScenario.
+	 *
+	 * @param Full Whether to build the full matrix.
+	 * @param Filter Only scenarios whose names contain this string are included (empty = all).
+	 * @param OutScenarios Will contain the scenarios.
+	 */
+	static void BuildScenarios(bool Full, const FString& Filter, TArray<FScenario>& OutScenarios)
+	{
+		const FIntPoint Resolutions[] = { FIntPoint(1280, 720), FIntPoint(1920, 1080), FIntPoint(3840, 2160) };
+		const FScenario Formats[] =
+		{
+			{ 0, ENdiMediaColorFormat::UYVY, TEXT("UYVY"), 0, 0, 0, ENdiMediaYuvConversion::Sink },
+			{ 0, ENdiMediaColorFormat::BGRA, TEXT("BGRA"), 0, 0, 0, ENdiMediaYuvConversion::Sink },
+			{ 0, ENdiMediaColorFormat::UYVY, TEXT("UYVYtoBGRA"), 0, 0, 0, ENdiMediaYuvConversion::Bt709 },
+		};
+		const int32 Channels[] = { 2, 8, 16 };
+		const int32 Players[] = { 1, 4, 16, 64 };
+
+		TArray<FScenario> Scenarios;
+
+		auto AddScenario = [&Scenarios](const FIntPoint& Resolution, const FScenario& Format, int32 NumChannels, int32 NumPlayers)
+		{
+			if ((int64)Resolution.X * Resolution.Y * NumPlayers > MaxPixelsPerScenario)
+			{
+				return;
+			}
+
+			FScenario Scenario = Format;
+			{
+				Scenario.AudioChannels = NumChannels;
+				Scenario.Height = Resolution.Y;
+				Scenario.NumPlayers = NumPlayers;
+				Scenario.Width = Resolution.X;
+			}
+
+			Scenarios.Add(Scenario);
+		};
+
+		if (Full)
+		{
+			for (const FIntPoint& Resolution : Resolutions)
+			{
+				for (const FScenario& Format : Formats)
+				{
+					for (const int32 NumChannels : Channels)
+					{
+						for (const int32 NumPlayers : Players)
+						{
+							AddScenario(Resolution, Format, NumChannels, NumPlayers);
+						}
+					}
+				}
+			}
+		}
+		else
+		{
+			for (const FIntPoint& Resolution : Resolutions)
+			{
+				AddScenario(Resolution, Formats[0], 2, 1);
+			}
+
+			AddScenario(Resolutions[1], Formats[1], 2, 1);
+			AddScenario(Resolutions[1], Formats[2], 2, 1);
+			AddScenario(Resolutions[1], Formats[0], 8, 1);
+			AddScenario(Resolutions[1], Formats[0], 16, 1);
+			AddScenario(Resolutions[1], Formats[0], 2, 4);
+			AddScenario(Resolutions[1], Formats[0], 2, 16);
+			AddScenario(Resolutions[0], Formats[0], 2, 64);
+		}
+
+		for (const FScenario& Scenario : Scenarios)
+		{
+			if (Filter.IsEmpty() || Scenario.GetName().Contains(Filter))
+			{
+				OutScenarios.Add(Scenario);
+			}
+		}
+	}
+
+
+	/**
+	 * Create a JSON object with the percentiles of the given samples.
+	 *
+	 * @param Samples The samples (will be sorted).
+	 * @return The percentiles object.
+	 */
+	static TSharedRef<FJsonObject> MakePercentiles(TArray<float>& Samples)
+	{
+		TSharedRef<FJsonObject> Percentiles = MakeShareable(new FJsonObject);
+
+		Samples.Sort();
+
+		auto GetPercentile = [&Samples](double Fraction) -> double
+		{
+			if (Samples.Num() == 0)
+			{
+				return 0.0;
+			}
+
+			const int32 Index = FMath::Min((int32)(Fraction * Samples.Num()), Samples.Num() - 1);
+
+			return Samples[Index];
+		};
+
+		Percentiles->SetNumberField(TEXT("Samples"), Samples.Num());
+		Percentiles->SetNumberField(TEXT("P50"), GetPercentile(0.50));
+		Percentiles->SetNumberField(TEXT("P95"), GetPercentile(0.95));
+		Percentiles->SetNumberField(TEXT("P99"), GetPercentile(0.99));
+		Percentiles->SetNumberField(TEXT("Max"), (Samples.Num() > 0) ? Samples.Last() : 0.0);
+
+		return Percentiles;
+	}
+
+
+	/**
+	 * Get the average time per run that a stage spent between two snapshots.
+	 *
+	 * @param Before The statistics at the start of the measurement.
+	 * @param After The statistics at the end of the measurement.
+	 * @return Time per run (in milliseconds).
+	 */
+	static double GetStageMs(const FNdiMediaStageStats& Before, const FNdiMediaStageStats& After)
+	{
+		const uint64 Count = After.Count - Before.Count;
+
+		if (Count == 0)
+		{
+			return 0.0;
+		}
+
+		return FPlatformTime::GetSecondsPerCycle64() * (After.TotalCycles - Before.TotalCycles) * 1000.0 / Count;
+	}
+
+
+	/**
+	 * Add the statistics of a player to a running sum.
+	 *
+	 * @param Sum The sum to add to.
+	 * @param Stats The statistics to add.
+	 */
+	static void AddStageStats(FNdiMediaPlayerStageStats& Sum, const FNdiMediaPlayerStageStats& Stats)
+	{
+		FNdiMediaStageStats* SumStages[] = { &Sum.AudioConversion, &Sum.ColorConversion, &Sum.Deinterlace, &Sum.Resize, &Sum.VideoCapture, &Sum.VideoUpload };
+		const FNdiMediaStageStats* Stages[] = { &Stats.AudioConversion, &Stats.ColorConversion, &Stats.Deinterlace, &Stats.Resize, &Stats.VideoCapture, &Stats.VideoUpload };
+
+		for (int32 StageIndex = 0; StageIndex < ARRAY_COUNT(Stages); ++StageIndex)
+		{
+			SumStages[StageIndex]->Count += Stages[StageIndex]->Count;
+			SumStages[StageIndex]->TotalCycles += Stages[StageIndex]->TotalCycles;
+		}
+	}
+
+
+	/**
+	 * Get a numeric field from a scenario object.
+	 *
+	 * @param Object The scenario object.
+	 * @param Path Path of the field (nested objects are separated by dots).
+	 * @param OutValue Will contain the value.
+	 * @return true on success, false if the field doesn't exist.
+	 */
+	static bool GetMetric(const TSharedPtr<FJsonObject>& Object, const FString& Path, double& OutValue)
+	{
+		FString ObjectName;
+		FString FieldName;
+
+		if (Path.Split(TEXT("."), &ObjectName, &FieldName))
+		{
+			const TSharedPtr<FJsonObject>* NestedObject = nullptr;
+
+			if (!Object->TryGetObjectField(ObjectName, NestedObject))
+			{
+				return false;
+			}
+
+			return GetMetric(*NestedObject, FieldName, OutValue);
+		}
+
+		return Object->TryGetNumberField(Path, OutValue);
+	}
+
+
+	/**
+	 * Compare scenario results against a baseline.
+	 *
+	 * @param Scenarios The scenario results.
+	 * @param Baseline The baseline results.
+	 * @param Tolerance How much worse a metric may get (in percent).
+	 * @param OutRegressions Will contain a description of each regression.
+	 * @return Number of scenarios that were found in the baseline.
+	 */
+	static int32 CompareWithBaseline(const TArray<TSharedPtr<FJsonValue>>& Scenarios, const FJsonObject& Baseline, float Tolerance, TArray<TSharedPtr<FJsonValue>>& OutRegressions)
+	{
+		const TArray<TSharedPtr<FJsonValue>>* BaselineScenarios = nullptr;
+
+		if (!Baseline.TryGetArrayField(TEXT("Scenarios"), BaselineScenarios))
+		{
+			return 0;
+		}
+
+		int32 NumCompared = 0;
+
+		for (const TSharedPtr<FJsonValue>& ScenarioValue : Scenarios)
+		{
+			const TSharedPtr<FJsonObject> Scenario = ScenarioValue->AsObject();
+			const FString Name = Scenario->GetStringField(TEXT("Name"));
+
+			TSharedPtr<FJsonObject> BaselineScenario;
+
+			for (const TSharedPtr<FJsonValue>& BaselineValue : *BaselineScenarios)
+			{
+				const TSharedPtr<FJsonObject> Candidate = BaselineValue->AsObject();
+
+				if (Candidate.IsValid() && (Candidate->GetStringField(TEXT("Name")) == Name))
+				{
+					BaselineScenario = Candidate;
+					break;
+				}
+			}
+
+			if (!BaselineScenario.IsValid())
+			{
+				continue;
+			}
+
+			++NumCompared;
+
+			for (const FMetric& Metric : Metrics)
+			{
+				double BaselineValue = 0.0;
+				double CurrentValue = 0.0;
+
+				if (!GetMetric(BaselineScenario, Metric.Path, BaselineValue) || !GetMetric(Scenario, Metric.Path, CurrentValue))
+				{
+					continue;
+				}
+
+				const double Delta = Metric.HigherIsBetter ? (BaselineValue - CurrentValue) : (CurrentValue - BaselineValue);
+
+				if ((Delta <= Metric.MinDelta) || (Delta <= FMath::Abs(BaselineValue) * Tolerance / 100.0))
+				{
+					continue;
+				}
+
+				const double Change = (BaselineValue != 0.0) ? ((CurrentValue - BaselineValue) * 100.0 / BaselineValue) : 0.0;
+
+				UE_LOG(LogNdiMedia, Warning, TEXT("NdiMedia benchmark regression in %s: %s changed from %.3f to %.3f (%+.1f%%)"),
+					*Name, Metric.Path, BaselineValue, CurrentValue, Change);
+
+				TSharedRef<FJsonObject> Regression = MakeShareable(new FJsonObject);
+				{
+					Regression->SetStringField(TEXT("Scenario"), Name);
+					Regression->SetStringField(TEXT("Metric"), Metric.Path);
+					Regression->SetNumberField(TEXT("Baseline"), BaselineValue);
+					Regression->SetNumberField(TEXT("Current"), CurrentValue);
+					Regression->SetNumberField(TEXT("ChangePercent"), Change);
+				}
+
+				OutRegressions.Add(MakeShareable(new FJsonValueObject(Regression)));
+			}
+		}
+
+		return NumCompared;
+	}
+
+
+	/**
+	 * Run a single scenario.
+	 *
+	 * Each scenario installs its own loopback backend, so that no frames are
+	 * received from the network, and restores the previous backend when done.
+	 *
+	 * @param Scenario The scenario to run.
+	 * @param Settings The run settings.
+	 * @param Malloc The allocation counter (may be nullptr).
+	 * @return The scenario results.
+	 */
+	static TSharedRef<FJsonObject> RunScenario(const FScenario& Scenario, const FRunSettings& Settings, FNdiMediaCountingMalloc* Malloc)
+	{
+		TSharedRef<INdiMediaClock, ESPMode::ThreadSafe> Clock = MakeShareable(new FNdiMediaPlatformClock);
+
+		// synthetic source
+		FNdiMediaLoopbackSettings LoopbackSettings;
+		{
+			LoopbackSettings.AudioChannels = Scenario.AudioChannels;
+			LoopbackSettings.AudioSamplesPerFrame = LoopbackSettings.AudioSampleRate / Settings.FrameRate;
+			LoopbackSettings.VideoFrameRateD = 1;
+			LoopbackSettings.VideoFrameRateN = Settings.FrameRate;
+			LoopbackSettings.VideoHeight = Scenario.Height;
+			LoopbackSettings.VideoWidth = Scenario.Width;
+		}
+
+		TSharedRef<FNdiMediaLoopbackBackend, ESPMode::ThreadSafe> Backend = MakeShareable(new FNdiMediaLoopbackBackend(LoopbackSettings, Clock));
+		const TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> PreviousBackend = FNdi::GetBackend();
+
+		FNdi::SetBackend(Backend);
+
+		UNdiMediaSource* MediaSource = NewObject<UNdiMediaSource>(GetTransientPackage());
+		{
+			MediaSource->AddToRoot();
+			MediaSource->ColorFormat = Scenario.ColorFormat;
+			MediaSource->PreferredNumAudioChannels = Scenario.AudioChannels;
+			MediaSource->SourceName = TEXT("localhost (Loopback 1)");
+			MediaSource->YuvConversion = Scenario.YuvConversion;
+		}
+
+		// players
+		TArray<FNdiMediaTestAudioSink*> AudioSinks;
+		TArray<FNdiMediaPlayer*> Players;
+		TArray<FNdiMediaTestVideoSink*> VideoSinks;
+
+		for (int32 PlayerIndex = 0; PlayerIndex < Scenario.NumPlayers; ++PlayerIndex)
+		{
+			FNdiMediaPlayer* Player = new FNdiMediaPlayer;
+			FNdiMediaTestAudioSink* AudioSink = new FNdiMediaTestAudioSink(Clock);
+			FNdiMediaTestVideoSink* VideoSink = new FNdiMediaTestVideoSink(Clock);
+
+			if (Player->Open(MediaSource->GetUrl(), *MediaSource))
+			{
+				Player->SetAudioSink(AudioSink);
+				Player->SetVideoSink(VideoSink);
+				Player->SelectTrack(EMediaTrackType::Audio, 0);
+				Player->SelectTrack(EMediaTrackType::Video, 0);
+			}
+
+			AudioSinks.Add(AudioSink);
+			Players.Add(Player);
+			VideoSinks.Add(VideoSink);
+		}
+
+		// tick players at a fixed rate, as the engine would
+		const double TickInterval = 1.0 / Settings.TickRate;
+		double NextTickTime = FPlatformTime::Seconds();
+		uint64 TickCycles = 0;
+		uint64 NumTicks = 0;
+
+		auto TickPlayers = [&](double EndTime)
+		{
+			while (NextTickTime < EndTime)
+			{
+				const uint64 StartCycles = FPlatformTime::Cycles64();
+
+				for (FNdiMediaPlayer* Player : Players)
+				{
+					Player->TickPlayer((float)TickInterval);
+					Player->TickVideo((float)TickInterval);
+				}
+
+				TickCycles += FPlatformTime::Cycles64() - StartCycles;
+				++NumTicks;
+
+				NextTickTime += TickInterval;
+
+				const double Now = FPlatformTime::Seconds();
+
+				if (NextTickTime > Now)
+				{
+					FPlatformProcess::Sleep((float)(NextTickTime - Now));
+				}
+				else
+				{
+					NextTickTime = Now; // running behind; don't try to catch up
+				}
+			}
+		};
+
+		TickPlayers(FPlatformTime::Seconds() + Settings.Warmup);
+
+		// snapshot counters
+		FNdiMediaPlayerStageStats StatsBefore;
+		NDIlib_recv_performance_t DroppedBefore;
+		NDIlib_recv_performance_t TotalBefore;
+		int64 AudioFramesBefore = 0;
+		int64 VideoFramesBefore = 0;
+
+		for (int32 PlayerIndex = 0; PlayerIndex < Players.Num(); ++PlayerIndex)
+		{
+			AddStageStats(StatsBefore, Players[PlayerIndex]->GetStageStats());
+			AudioFramesBefore += AudioSinks[PlayerIndex]->GetNumFrames();
+			VideoFramesBefore += VideoSinks[PlayerIndex]->GetNumFrames();
+
+			const int32 ExpectedFrames = FMath::CeilToInt(Settings.Duration * Settings.FrameRate) + 1;
+
+			AudioSinks[PlayerIndex]->GetLatencies().SetRecording(true, ExpectedFrames);
+			VideoSinks[PlayerIndex]->GetLatencies().SetRecording(true, ExpectedFrames);
+		}
+
+		Backend->GetPerformance(TotalBefore, DroppedBefore);
+
+		const int64 AllocationsBefore = (Malloc != nullptr) ? Malloc->GetNumAllocations() : 0;
+		const double StartTime = FPlatformTime::Seconds();
+		const uint64 TickCyclesBefore = TickCycles;
+		const uint64 NumTicksBefore = NumTicks;
+
+		// measure
+		TickPlayers(StartTime + Settings.Duration);
+
+		const double Elapsed = FPlatformTime::Seconds() - StartTime;
+		const int64 Allocations = (Malloc != nullptr) ? (Malloc->GetNumAllocations() - AllocationsBefore) : 0;
+
+		FNdiMediaPlayerStageStats StatsAfter;
+		NDIlib_recv_performance_t DroppedAfter;
+		NDIlib_recv_performance_t TotalAfter;
+		TArray<float> AudioLatencies;
+		TArray<float> VideoLatencies;
+		int64 AudioFrames = -AudioFramesBefore;
+		int64 VideoFrames = -VideoFramesBefore;
+
+		Backend->GetPerformance(TotalAfter, DroppedAfter);
+
+		for (int32 PlayerIndex = 0; PlayerIndex < Players.Num(); ++PlayerIndex)
+		{
+			AddStageStats(StatsAfter, Players[PlayerIndex]->GetStageStats());
+			AudioFrames += AudioSinks[PlayerIndex]->GetNumFrames();
+			VideoFrames += VideoSinks[PlayerIndex]->GetNumFrames();
+
+			TArray<float> Samples;
+
+			AudioSinks[PlayerIndex]->GetLatencies().SetRecording(false);
+			AudioSinks[PlayerIndex]->GetLatencies().GetSamples(Samples);
+			AudioLatencies.Append(Samples);
+
+			VideoSinks[PlayerIndex]->GetLatencies().SetRecording(false);
+			VideoSinks[PlayerIndex]->GetLatencies().GetSamples(Samples);
+			VideoLatencies.Append(Samples);
+		}
+
+		// tear down (sinks must outlive their players)
+		for (int32 PlayerIndex = 0; PlayerIndex < Players.Num(); ++PlayerIndex)
+		{
+			delete Players[PlayerIndex];
+			delete AudioSinks[PlayerIndex];
+			delete VideoSinks[PlayerIndex];
+		}
+
+		MediaSource->RemoveFromRoot();
+		FNdi::SetBackend(PreviousBackend);
+
+		// results
+		TSharedRef<FJsonObject> CpuMsPerFrame = MakeShareable(new FJsonObject);
+		{
+			CpuMsPerFrame->SetNumberField(TEXT("AudioConversion"), GetStageMs(StatsBefore.AudioConversion, StatsAfter.AudioConversion));
+			CpuMsPerFrame->SetNumberField(TEXT("ColorConversion"), GetStageMs(StatsBefore.ColorConversion, StatsAfter.ColorConversion));
+			CpuMsPerFrame->SetNumberField(TEXT("Deinterlace"), GetStageMs(StatsBefore.Deinterlace, StatsAfter.Deinterlace));
+			CpuMsPerFrame->SetNumberField(TEXT("Resize"), GetStageMs(StatsBefore.Resize, StatsAfter.Resize));
+			CpuMsPerFrame->SetNumberField(TEXT("VideoCapture"), GetStageMs(StatsBefore.VideoCapture, StatsAfter.VideoCapture));
+			CpuMsPerFrame->SetNumberField(TEXT("VideoUpload"), GetStageMs(StatsBefore.VideoUpload, StatsAfter.VideoUpload));
+		}
+
+		const double SecondsPerCycle = FPlatformTime::GetSecondsPerCycle64();
+		const uint64 MeasuredTicks = NumTicks - NumTicksBefore;
+
+		TSharedRef<FJsonObject> Result = MakeShareable(new FJsonObject);
+		{
+			Result->SetStringField(TEXT("Name"), Scenario.GetName());
+			Result->SetNumberField(TEXT("Width"), Scenario.Width);
+			Result->SetNumberField(TEXT("Height"), Scenario.Height);
+			Result->SetStringField(TEXT("ColorFormat"), Scenario.ColorFormatName);
+			Result->SetNumberField(TEXT("AudioChannels"), Scenario.AudioChannels);
+			Result->SetNumberField(TEXT("Players"), Scenario.NumPlayers);
+			Result->SetNumberField(TEXT("Seconds"), Elapsed);
+			Result->SetNumberField(TEXT("VideoFramesPerSecond"), VideoFrames / Elapsed);
+			Result->SetNumberField(TEXT("AudioFramesPerSecond"), AudioFrames / Elapsed);
+			Result->SetNumberField(TEXT("DroppedVideoFrames"), (double)(DroppedAfter.m_video_frames - DroppedBefore.m_video_frames));
+			Result->SetNumberField(TEXT("DroppedAudioFrames"), (double)(DroppedAfter.m_audio_frames - DroppedBefore.m_audio_frames));
+			Result->SetNumberField(TEXT("TickMs"), (MeasuredTicks > 0) ? (SecondsPerCycle * (TickCycles - TickCyclesBefore) * 1000.0 / MeasuredTicks) : 0.0);
+			Result->SetObjectField(TEXT("CpuMsPerFrame"), CpuMsPerFrame);
+			Result->SetNumberField(TEXT("AllocationsPerVideoFrame"), (VideoFrames > 0) ? ((double)Allocations / VideoFrames) : 0.0);
+			Result->SetObjectField(TEXT("AudioLatencyMs"), MakePercentiles(AudioLatencies));
+			Result->SetObjectField(TEXT("VideoLatencyMs"), MakePercentiles(VideoLatencies));
+		}
+
+		return Result;
+	}
+}
+
+
+/* Console commands
+ *****************************************************************************/
+
+/**
+ * Run the receive pipeline benchmark.
+ *
+ * Arguments: [Matrix=Quick|Full] [Filter=<text>] [Duration=<seconds>] [FrameRate=<fps>] [TickRate=<Hz>]
+ * [Tolerance=<percent>] [Baseline=<file>] [SaveBaseline]
+ */
+static void RunBenchmark(const TArray<FString>& Args)
+{
+	using namespace NdiMediaBenchmark;
+
+	const FString Params = FString::Join(Args, TEXT(" "));
+
+	FRunSettings Settings;
+	{
+		Settings.Duration = 3.0f;
+		Settings.FrameRate = 60;
+		Settings.TickRate = 120;
+		Settings.Tolerance = 10.0f;
+		Settings.Warmup = 1.0f;
+
+		FParse::Value(*Params, TEXT("Duration="), Settings.Duration);
+		FParse::Value(*Params, TEXT("FrameRate="), Settings.FrameRate);
+		FParse::Value(*Params, TEXT("TickRate="), Settings.TickRate);
+		FParse::Value(*Params, TEXT("Tolerance="), Settings.Tolerance);
+
+		Settings.Duration = FMath::Max(Settings.Duration, 0.1f);
+		Settings.FrameRate = FMath::Clamp(Settings.FrameRate, 1, 1000);
+		Settings.TickRate = FMath::Clamp(Settings.TickRate, 1, 10000);
+	}
+
+	const FString OutputDir = FPaths::Combine(*FPaths::GameSavedDir(), TEXT("NdiMedia"), TEXT("Benchmark"));
+
+	FString BaselinePath = FPaths::Combine(*OutputDir, TEXT("Baseline.json"));
+	FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+
+	FString Filter;
+	FParse::Value(*Params, TEXT("Filter="), Filter);
+
+	FString Matrix;
+	FParse::Value(*Params, TEXT("Matrix="), Matrix);
+
+	TArray<FScenario> Scenarios;
+	BuildScenarios(Matrix == TEXT("Full"), Filter, Scenarios);
+
+	if (Scenarios.Num() == 0)
+	{
+		UE_LOG(LogNdiMedia, Warning, TEXT("NdiMedia benchmark: no scenarios match the filter '%s'"), *Filter);
+		return;
+	}
+
+	UE_LOG(LogNdiMedia, Display, TEXT("NdiMedia benchmark: running %i scenarios (about %.0f seconds, the game thread is blocked meanwhile)"),
+		Scenarios.Num(), Scenarios.Num() * (Settings.Duration + Settings.Warmup));
+
+	// run scenarios
+	FNdiMediaCountingMalloc* Malloc = FNdiMediaCountingMalloc::Install();
+	TArray<TSharedPtr<FJsonValue>> Results;
+
+	for (const FScenario& Scenario : Scenarios)
+	{
+		TSharedRef<FJsonObject> Result = RunScenario(Scenario, Settings, Malloc);
+
+		UE_LOG(LogNdiMedia, Display, TEXT("NdiMedia benchmark %s: %.1f video fps, %.1f audio fps, %.0f dropped, %.2f allocs/frame, video latency p50 %.2f ms"),
+			*Result->GetStringField(TEXT("Name")),
+			Result->GetNumberField(TEXT("VideoFramesPerSecond")),
+			Result->GetNumberField(TEXT("AudioFramesPerSecond")),
+			Result->GetNumberField(TEXT("DroppedVideoFrames")),
+			Result->GetNumberField(TEXT("AllocationsPerVideoFrame")),
+			Result->GetObjectField(TEXT("VideoLatencyMs"))->GetNumberField(TEXT("P50"))
+		);
+
+		Results.Add(MakeShareable(new FJsonValueObject(Result)));
+	}
+
+	if (Malloc != nullptr)
+	{
+		Malloc->Uninstall();
+	}
+
+	// compare with baseline
+	TArray<TSharedPtr<FJsonValue>> Regressions;
+	FString BaselineString;
+
+	if (FFileHelper::LoadFileToString(BaselineString, *BaselinePath))
+	{
+		TSharedPtr<FJsonObject> Baseline;
+		TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(BaselineString);
+
+		if (FJsonSerializer::Deserialize(Reader, Baseline) && Baseline.IsValid())
+		{
+			const int32 NumCompared = CompareWithBaseline(Results, *Baseline, Settings.Tolerance, Regressions);
+
+			if (Regressions.Num() > 0)
+			{
+				UE_LOG(LogNdiMedia, Error, TEXT("NdiMedia benchmark: %i regressions in %i scenarios compared with %s"), Regressions.Num(), NumCompared, *BaselinePath);
+			}
+			else
+			{
+				UE_LOG(LogNdiMedia, Display, TEXT("NdiMedia benchmark: no regressions in %i scenarios compared with %s"), NumCompared, *BaselinePath);
+			}
+		}
+		else
+		{
+			UE_LOG(LogNdiMedia, Warning, TEXT("NdiMedia benchmark: failed to parse baseline %s"), *BaselinePath);
+		}
+	}
+	else
+	{
+		UE_LOG(LogNdiMedia, Display, TEXT("NdiMedia benchmark: no baseline found at %s"), *BaselinePath);
+	}
+
+	// write results
+	FString CpuBrand = FPlatformMisc::GetCPUBrand();
+	{
+		CpuBrand.Trim();
+		CpuBrand.TrimTrailing();
+	}
+
+	TSharedRef<FJsonObject> Root = MakeShareable(new FJsonObject);
+	{
+		TSharedRef<FJsonObject> SettingsObject = MakeShareable(new FJsonObject);
+		{
+			SettingsObject->SetNumberField(TEXT("Duration"), Settings.Duration);
+			SettingsObject->SetNumberField(TEXT("FrameRate"), Settings.FrameRate);
+			SettingsObject->SetNumberField(TEXT("TickRate"), Settings.TickRate);
+			SettingsObject->SetNumberField(TEXT("Tolerance"), Settings.Tolerance);
+			SettingsObject->SetNumberField(TEXT("Warmup"), Settings.Warmup);
+		}
+
+		Root->SetNumberField(TEXT("Version"), FormatVersion);
+		Root->SetStringField(TEXT("Date"), FDateTime::UtcNow().ToIso8601());
+		Root->SetStringField(TEXT("Machine"), FPlatformProcess::ComputerName());
+		Root->SetStringField(TEXT("Cpu"), CpuBrand);
+		Root->SetNumberField(TEXT("Cores"), FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+		Root->SetBoolField(TEXT("AllocationsCounted"), (Malloc != nullptr));
+		Root->SetObjectField(TEXT("Settings"), SettingsObject);
+		Root->SetArrayField(TEXT("Scenarios"), Results);
+		Root->SetArrayField(TEXT("Regressions"), Regressions);
+	}
+
+	FString ResultString;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&ResultString);
+	FJsonSerializer::Serialize(Root, Writer);
+
+	const FString ResultPath = FPaths::Combine(*OutputDir, *FString::Printf(TEXT("Benchmark-%s.json"), *FDateTime::Now().ToString()));
+
+	if (FFileHelper::SaveStringToFile(ResultString, *ResultPath))
+	{
+		UE_LOG(LogNdiMedia, Display, TEXT("NdiMedia benchmark: results written to %s"), *ResultPath);
+	}
+	else
+	{
+		UE_LOG(LogNdiMedia, Error, TEXT("NdiMedia benchmark: failed to write results to %s"), *ResultPath);
+	}
+
+	if (Args.Contains(TEXT("SaveBaseline")))
+	{
+		if (FFileHelper::SaveStringToFile(ResultString, *BaselinePath))
+		{
+			UE_LOG(LogNdiMedia, Display, TEXT("NdiMedia benchmark: baseline written to %s"), *BaselinePath);
+		}
+		else
+		{
+			UE_LOG(LogNdiMedia, Error, TEXT("NdiMedia benchmark: failed to write baseline to %s"), *BaselinePath);
+		}
+	}
+}
+
+
+static FAutoConsoleCommand BenchmarkCommand(
+	TEXT("NdiMedia.Benchmark"),
+	TEXT("Benchmark the receive pipeline with synthetic sources and compare the results with a baseline.\n")
+	TEXT("Arguments: [Matrix=Quick|Full] [Filter=<text>] [Duration=<seconds>] [FrameRate=<fps>] [TickRate=<Hz>] [Tolerance=<percent>] [Baseline=<file>] [SaveBaseline]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunBenchmark)
+);
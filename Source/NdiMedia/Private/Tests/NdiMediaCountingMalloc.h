@@ -0,0 +1,181 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+
+/**
+ * Implements an allocator proxy that counts the allocations it forwards.
+ *
+ * The proxy is installed in place of the global allocator while a measurement
+ * runs. It counts allocations made by all threads of the process, so engine
+ * background work adds some noise to the counts.
+ *
+ * The proxy doesn't own any memory, which makes it safe to free memory through
+ * either the proxy or the inner allocator. Instances must outlive all threads
+ * that may still be calling into them, so they should never be destroyed.
+ */
+class FNdiMediaCountingMalloc
+	: public FMalloc
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InInner The allocator to forward to.
+	 */
+	explicit FNdiMediaCountingMalloc(FMalloc* InInner)
+		: Inner(InInner)
+		, NumAllocations(0)
+	{ }
+
+public:
+
+	/**
+	 * Install a counting proxy in place of the global allocator.
+	 *
+	 * @return The installed proxy, or nullptr if a proxy is already installed.
+	 * @see Uninstall
+	 */
+	static FNdiMediaCountingMalloc* Install()
+	{
+		static FNdiMediaCountingMalloc* Proxy = nullptr;
+
+		if (Proxy == nullptr)
+		{
+			Proxy = new FNdiMediaCountingMalloc(GMalloc);
+		}
+		else if (GMalloc == Proxy)
+		{
+			return nullptr;
+		}
+
+		Proxy->Inner = GMalloc;
+		GMalloc = Proxy;
+
+		return Proxy;
+	}
+
+	/**
+	 * Restore the allocator that was replaced by this proxy.
+	 *
+	 * The global allocator is left alone if it was replaced again after this
+	 * proxy was installed.
+	 *
+	 * @see Install
+	 */
+	void Uninstall()
+	{
+		if (GMalloc == this)
+		{
+			GMalloc = Inner;
+		}
+	}
+
+	/**
+	 * Get the number of allocations made so far.
+	 *
+	 * @return Number of allocations.
+	 */
+	int64 GetNumAllocations() const
+	{
+		return NumAllocations.GetValue();
+	}
+
+public:
+
+	//~ FMalloc interface
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		NumAllocations.Increment();
+		return Inner->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		if (Original == nullptr)
+		{
+			NumAllocations.Increment();
+		}
+
+		return Inner->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override
+	{
+		Inner->Free(Original);
+	}
+
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+	{
+		return Inner->QuantizeSize(Count, Alignment);
+	}
+
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return Inner->GetAllocationSize(Original, SizeOut);
+	}
+
+	virtual void Trim() override
+	{
+		Inner->Trim();
+	}
+
+	virtual void SetupTLSCachesOnCurrentThread() override
+	{
+		Inner->SetupTLSCachesOnCurrentThread();
+	}
+
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+	{
+		Inner->ClearAndDisableTLSCachesOnCurrentThread();
+	}
+
+	virtual void InitializeStatsMetadata() override
+	{
+		Inner->InitializeStatsMetadata();
+	}
+
+	virtual void UpdateStats() override
+	{
+		Inner->UpdateStats();
+	}
+
+	virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override
+	{
+		Inner->GetAllocatorStats(OutStats);
+	}
+
+	virtual void DumpAllocatorStats(FOutputDevice& Ar) override
+	{
+		Inner->DumpAllocatorStats(Ar);
+	}
+
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return Inner->IsInternallyThreadSafe();
+	}
+
+	virtual bool ValidateHeap() override
+	{
+		return Inner->ValidateHeap();
+	}
+
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return Inner->GetDescriptiveName();
+	}
+
+private:
+
+	/** The allocator to forward to. */
+	FMalloc* Inner;
+
+	/** Number of allocations made so far. */
+	FThreadSafeCounter64 NumAllocations;
+};
@@ -0,0 +1,648 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaSoakTest.h"
+#include "NdiMediaPrivate.h"
+
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Ndi.h"
+#include "NdiMediaFinder.h"
+#include "NdiMediaLoopbackBackend.h"
+#include "NdiMediaPlatformClock.h"
+#include "NdiMediaPlayer.h"
+#include "NdiMediaSource.h"
+#include "NdiMediaTestSinks.h"
+#include "UObject/Package.h"
+#include "UObject/UObjectGlobals.h"
+
+#if PLATFORM_WINDOWS
+	#include "Windows/WindowsHWrapper.h"
+	#include "Windows/AllowWindowsPlatformTypes.h"
+		#include <TlHelp32.h>
+	#include "Windows/HideWindowsPlatformTypes.h"
+#elif PLATFORM_LINUX
+	#include <dirent.h>
+#endif
+
+
+namespace NdiMediaSoak
+{
+	/** Minimum number of samples that a trend is fitted to. */
+	static const int32 MinTrendSamples = 3;
+
+	/** Operations that the soak test performs at random. */
+	enum class EOperation
+	{
+		Reopen,
+		Switch,
+		Close,
+		TogglePause,
+		ToggleAudioSink,
+		ChurnFinder,
+
+		Count
+	};
+
+
+#if PLATFORM_LINUX
+	/**
+	 * Count the entries of a directory.
+	 *
+	 * @param Path The directory path.
+	 * @return Number of entries, excluding '.' and '..', or INDEX_NONE on failure.
+	 */
+	static int32 CountDirectoryEntries(const char* Path)
+	{
+		DIR* Dir = opendir(Path);
+
+		if (Dir == nullptr)
+		{
+			return INDEX_NONE;
+		}
+
+		int32 Count = 0;
+
+		while (dirent* Entry = readdir(Dir))
+		{
+			if ((FCStringAnsi::Strcmp(Entry->d_name, ".") != 0) && (FCStringAnsi::Strcmp(Entry->d_name, "..") != 0))
+			{
+				++Count;
+			}
+		}
+
+		closedir(Dir);
+
+		return Count;
+	}
+#endif
+
+
+	/**
+	 * Get the number of handles that the process has open.
+	 *
+	 * @return Number of handles, or INDEX_NONE if not supported on this platform.
+	 */
+	static int32 GetHandleCount()
+	{
+#if PLATFORM_WINDOWS
+		::DWORD Count = 0;
+		return ::GetProcessHandleCount(::GetCurrentProcess(), &Count) ? (int32)Count : INDEX_NONE;
+#elif PLATFORM_LINUX
+		return CountDirectoryEntries("/proc/self/fd");
+#else
+		return INDEX_NONE;
+#endif
+	}
+
+
+	/**
+	 * Get the number of threads that the process is running.
+	 *
+	 * @return Number of threads, or INDEX_NONE if not supported on this platform.
+	 */
+	static int32 GetThreadCount()
+	{
+#if PLATFORM_WINDOWS
+		HANDLE Snapshot = ::CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+
+		if (Snapshot == INVALID_HANDLE_VALUE)
+		{
+			return INDEX_NONE;
+		}
+
+		const ::DWORD ProcessId = ::GetCurrentProcessId();
+		int32 Count = 0;
+
+		THREADENTRY32 Entry;
+		Entry.dwSize = sizeof(Entry);
+
+		for (BOOL Found = ::Thread32First(Snapshot, &Entry); Found; Found = ::Thread32Next(Snapshot, &Entry))
+		{
+			if (Entry.th32OwnerProcessID == ProcessId)
+			{
+				++Count;
+			}
+		}
+
+		::CloseHandle(Snapshot);
+
+		return Count;
+#elif PLATFORM_LINUX
+		return CountDirectoryEntries("/proc/self/task");
+#else
+		return INDEX_NONE;
+#endif
+	}
+}
+
+
+/* FNdiMediaSoakTest structors
+ *****************************************************************************/
+
+FNdiMediaSoakTest::FNdiMediaSoakTest(const FNdiMediaSoakSettings& InSettings)
+	: Finder(nullptr)
+	, NextChurnTime(0.0)
+	, NextSampleTime(0.0)
+	, NumFinderChanges(0)
+	, NumOpens(0)
+	, NumSwitches(0)
+	, Random(InSettings.Seed)
+	, Settings(InSettings)
+	, StartTime(0.0)
+{
+	Settings.NumPlayers = FMath::Max(Settings.NumPlayers, 1);
+	Settings.NumSources = FMath::Max(Settings.NumSources, 2);
+}
+
+
+FNdiMediaSoakTest::~FNdiMediaSoakTest()
+{
+	if (IsRunning())
+	{
+		Stop();
+	}
+}
+
+
+/* FNdiMediaSoakTest interface
+ *****************************************************************************/
+
+void FNdiMediaSoakTest::Start()
+{
+	if (IsRunning())
+	{
+		return;
+	}
+
+	// synthetic sources (small frames, so that the test measures leaks rather than throughput)
+	FNdiMediaLoopbackSettings LoopbackSettings;
+	{
+		LoopbackSettings.MetadataRate = 5.0f;
+		LoopbackSettings.NumSources = Settings.NumSources;
+		LoopbackSettings.Seed = Settings.Seed;
+		LoopbackSettings.VideoHeight = 360;
+		LoopbackSettings.VideoWidth = 640;
+	}
+
+	Clock = MakeShareable(new FNdiMediaPlatformClock);
+	Backend = MakeShareable(new FNdiMediaLoopbackBackend(LoopbackSettings, Clock.ToSharedRef()));
+	PreviousBackend = FNdi::GetBackend();
+
+	FNdi::SetBackend(Backend);
+
+	for (int32 SourceIndex = 0; SourceIndex < Settings.NumSources; ++SourceIndex)
+	{
+		UNdiMediaSource* MediaSource = NewObject<UNdiMediaSource>(GetTransientPackage());
+		{
+			MediaSource->AddToRoot();
+			MediaSource->SourceName = FString::Printf(TEXT("localhost (Loopback %i)"), SourceIndex + 1);
+		}
+
+		MediaSources.Add(MediaSource);
+	}
+
+	Finder = NewObject<UNdiMediaFinder>(GetTransientPackage());
+	Finder->AddToRoot();
+	Finder->Initialize();
+
+	for (int32 SlotIndex = 0; SlotIndex < Settings.NumPlayers; ++SlotIndex)
+	{
+		FSlot& Slot = Slots[Slots.AddDefaulted()];
+		{
+			Slot.AudioAttached = false;
+			Slot.AudioSink = new FNdiMediaTestAudioSink(Clock.ToSharedRef());
+			Slot.Player = new FNdiMediaPlayer;
+			Slot.SourceIndex = INDEX_NONE;
+			Slot.VideoSink = new FNdiMediaTestVideoSink(Clock.ToSharedRef());
+		}
+
+		OpenSlot(Slot, SlotIndex % Settings.NumSources);
+	}
+
+	// samples are appended as they are taken, so that partial results survive a crash
+	CsvPath = FPaths::Combine(*FPaths::GameSavedDir(), TEXT("NdiMedia"), TEXT("Soak"), *FString::Printf(TEXT("Soak-%s.csv"), *FDateTime::Now().ToString()));
+	FFileHelper::SaveStringToFile(TEXT("Seconds,MemoryMB,Threads,Handles,AvOffsetMs,Opens,Switches,FinderChanges\n"), *CsvPath);
+
+	StartTime = FPlatformTime::Seconds();
+	NextChurnTime = Settings.ChurnInterval;
+	NextSampleTime = 0.0;
+
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FNdiMediaSoakTest::HandleTicker), 0.0f);
+
+	UE_LOG(LogNdiMedia, Display, TEXT("NdiMedia soak test started: %.0f seconds, %i players, %i sources, samples in %s"),
+		Settings.Duration, Settings.NumPlayers, Settings.NumSources, *CsvPath);
+}
+
+
+bool FNdiMediaSoakTest::Stop()
+{
+	if (!IsRunning())
+	{
+		return false;
+	}
+
+	FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+	TickerHandle.Reset();
+
+	Sample();
+
+	// tear down (sinks must outlive their players)
+	for (FSlot& Slot : Slots)
+	{
+		delete Slot.Player;
+		delete Slot.AudioSink;
+		delete Slot.VideoSink;
+	}
+
+	Slots.Empty();
+
+	Finder->Shutdown();
+	Finder->RemoveFromRoot();
+	Finder = nullptr;
+
+	for (UNdiMediaSource* MediaSource : MediaSources)
+	{
+		MediaSource->RemoveFromRoot();
+	}
+
+	MediaSources.Empty();
+
+	FNdi::SetBackend(PreviousBackend);
+	PreviousBackend.Reset();
+	Backend.Reset();
+
+	// evaluate trends
+	struct FCheck
+	{
+		const TCHAR* Name;
+		TFunction<bool(const FSample&, double&)> GetValue;
+		float Threshold;
+		const TCHAR* Unit;
+		bool Signed;
+	};
+
+	const FCheck Checks[] =
+	{
+		{ TEXT("Memory"), [](const FSample& Sample, double& OutValue) { OutValue = Sample.Memory; return true; }, Settings.MaxMemoryGrowth, TEXT("MB/h"), false },
+		{ TEXT("Threads"), [](const FSample& Sample, double& OutValue) { OutValue = Sample.Threads; return (Sample.Threads != INDEX_NONE); }, Settings.MaxThreadGrowth, TEXT("threads/h"), false },
+		{ TEXT("Handles"), [](const FSample& Sample, double& OutValue) { OutValue = Sample.Handles; return (Sample.Handles != INDEX_NONE); }, Settings.MaxHandleGrowth, TEXT("handles/h"), false },
+		{ TEXT("A/V offset"), [](const FSample& Sample, double& OutValue) { OutValue = Sample.AvOffset; return Sample.HasAvOffset; }, Settings.MaxAvDrift, TEXT("ms/h"), true },
+	};
+
+	bool Passed = true;
+
+	for (const FCheck& Check : Checks)
+	{
+		double PerHour = 0.0;
+
+		if (!GetTrend(Check.GetValue, PerHour))
+		{
+			UE_LOG(LogNdiMedia, Display, TEXT("NdiMedia soak test: %s trend not available"), Check.Name);
+			continue;
+		}
+
+		// resources may shrink, but offsets must not drift in either direction
+		if ((Check.Signed ? FMath::Abs(PerHour) : PerHour) > Check.Threshold)
+		{
+			UE_LOG(LogNdiMedia, Error, TEXT("NdiMedia soak test: %s trend %.3f %s exceeds %.3f %s"), Check.Name, PerHour, Check.Unit, Check.Threshold, Check.Unit);
+			Passed = false;
+		}
+		else
+		{
+			UE_LOG(LogNdiMedia, Display, TEXT("NdiMedia soak test: %s trend %.3f %s"), Check.Name, PerHour, Check.Unit);
+		}
+	}
+
+	for (const FSample& Sample : Samples)
+	{
+		if (Sample.HasAvOffset && (FMath::Abs(Sample.AvOffset) > Settings.MaxAvOffset))
+		{
+			UE_LOG(LogNdiMedia, Error, TEXT("NdiMedia soak test: A/V offset %.1f ms at %.0f seconds exceeds %.1f ms"), Sample.AvOffset, Sample.Time, Settings.MaxAvOffset);
+			Passed = false;
+
+			break;
+		}
+	}
+
+	if (Passed)
+	{
+		UE_LOG(LogNdiMedia, Display, TEXT("NdiMedia soak test passed after %.0f seconds (%i opens, %i switches, %i finder changes)"),
+			FPlatformTime::Seconds() - StartTime, NumOpens, NumSwitches, NumFinderChanges);
+	}
+	else
+	{
+		UE_LOG(LogNdiMedia, Error, TEXT("NdiMedia soak test failed after %.0f seconds (samples in %s)"), FPlatformTime::Seconds() - StartTime, *CsvPath);
+	}
+
+	Clock.Reset();
+
+	if (Settings.ExitWhenDone)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+
+	return Passed;
+}
+
+
+/* FNdiMediaSoakTest implementation
+ *****************************************************************************/
+
+void FNdiMediaSoakTest::Churn()
+{
+	FSlot& Slot = Slots[Random.RandHelper(Slots.Num())];
+	const NdiMediaSoak::EOperation Operation = (NdiMediaSoak::EOperation)Random.RandHelper((int32)NdiMediaSoak::EOperation::Count);
+
+	switch (Operation)
+	{
+	case NdiMediaSoak::EOperation::Reopen:
+		OpenSlot(Slot, (Slot.SourceIndex != INDEX_NONE) ? Slot.SourceIndex : 0);
+		break;
+
+	case NdiMediaSoak::EOperation::Switch:
+		OpenSlot(Slot, (FMath::Max(Slot.SourceIndex, 0) + 1 + Random.RandHelper(Settings.NumSources - 1)) % Settings.NumSources);
+		++NumSwitches;
+		break;
+
+	case NdiMediaSoak::EOperation::Close:
+		if (Slot.SourceIndex == INDEX_NONE)
+		{
+			OpenSlot(Slot, Random.RandHelper(Settings.NumSources));
+		}
+		else
+		{
+			Slot.Player->Close();
+			Slot.SourceIndex = INDEX_NONE;
+		}
+		break;
+
+	case NdiMediaSoak::EOperation::TogglePause:
+		Slot.Player->SetRate((Slot.Player->GetRate() == 0.0f) ? 1.0f : 0.0f);
+		break;
+
+	case NdiMediaSoak::EOperation::ToggleAudioSink:
+		Slot.AudioAttached = !Slot.AudioAttached;
+		Slot.Player->SetAudioSink(Slot.AudioAttached ? Slot.AudioSink : nullptr);
+		break;
+
+	case NdiMediaSoak::EOperation::ChurnFinder:
+		{
+			switch (Random.RandHelper(3))
+			{
+			case 0:
+				if (Finder->GetGroupFilters().Num() > 0)
+				{
+					Finder->ClearGroupFilters();
+				}
+				else
+				{
+					Finder->AddGroupFilter(TEXT("public"));
+				}
+				break;
+
+			case 1:
+				if (Finder->GetExtraAddresses().Num() > 0)
+				{
+					Finder->RemoveExtraAddress(TEXT("127.0.0.1"));
+				}
+				else
+				{
+					Finder->AddExtraAddress(TEXT("127.0.0.1"));
+				}
+				break;
+
+			default:
+				Finder->SetShowLocalSources(!Finder->GetShowLocalSources());
+			}
+
+			TArray<FNdiMediaSourceId> FoundSources;
+			Finder->GetSources(FoundSources);
+
+			++NumFinderChanges;
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+
+bool FNdiMediaSoakTest::GetTrend(TFunctionRef<bool(const FSample&, double&)> GetValue, double& OutPerHour) const
+{
+	double SumT = 0.0;
+	double SumTT = 0.0;
+	double SumTV = 0.0;
+	double SumV = 0.0;
+	int32 Count = 0;
+
+	for (const FSample& Sample : Samples)
+	{
+		double Value = 0.0;
+
+		if ((Sample.Time < Settings.Warmup) || !GetValue(Sample, Value))
+		{
+			continue;
+		}
+
+		SumT += Sample.Time;
+		SumTT += Sample.Time * Sample.Time;
+		SumTV += Sample.Time * Value;
+		SumV += Value;
+		++Count;
+	}
+
+	const double Denominator = Count * SumTT - SumT * SumT;
+
+	if ((Count < NdiMediaSoak::MinTrendSamples) || (Denominator <= 0.0))
+	{
+		return false;
+	}
+
+	// least squares slope (per second)
+	OutPerHour = 3600.0 * (Count * SumTV - SumT * SumV) / Denominator;
+
+	return true;
+}
+
+
+void FNdiMediaSoakTest::OpenSlot(FSlot& Slot, int32 SourceIndex)
+{
+	UNdiMediaSource* MediaSource = MediaSources[SourceIndex];
+
+	if (!Slot.Player->Open(MediaSource->GetUrl(), *MediaSource))
+	{
+		Slot.SourceIndex = INDEX_NONE;
+		return;
+	}
+
+	Slot.AudioAttached = true;
+	Slot.Player->SetAudioSink(Slot.AudioSink);
+	Slot.Player->SetVideoSink(Slot.VideoSink);
+	Slot.Player->SelectTrack(EMediaTrackType::Audio, 0);
+	Slot.Player->SelectTrack(EMediaTrackType::Video, 0);
+	Slot.SourceIndex = SourceIndex;
+
+	++NumOpens;
+}
+
+
+void FNdiMediaSoakTest::Sample()
+{
+	FSample& NewSample = Samples[Samples.AddDefaulted()];
+	{
+		NewSample.AvOffset = 0.0;
+		NewSample.Handles = NdiMediaSoak::GetHandleCount();
+		NewSample.HasAvOffset = false;
+		NewSample.Memory = FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0);
+		NewSample.Threads = NdiMediaSoak::GetThreadCount();
+		NewSample.Time = FPlatformTime::Seconds() - StartTime;
+	}
+
+	// only players whose audio and video both arrived recently are considered
+	const FTimespan Now = Clock->GetTime();
+	const FTimespan MaxAge = FTimespan::FromSeconds(1.0);
+	double OffsetSum = 0.0;
+	int32 NumOffsets = 0;
+
+	for (const FSlot& Slot : Slots)
+	{
+		FTimespan AudioArrival;
+		FTimespan VideoArrival;
+
+		const FTimespan AudioTimecode = Slot.AudioSink->GetLatencies().GetLastTimecode(AudioArrival);
+		const FTimespan VideoTimecode = Slot.VideoSink->GetLatencies().GetLastTimecode(VideoArrival);
+
+		if ((Slot.SourceIndex != INDEX_NONE) && (Now - AudioArrival < MaxAge) && (Now - VideoArrival < MaxAge))
+		{
+			OffsetSum += (AudioTimecode - VideoTimecode).GetTotalMilliseconds();
+			++NumOffsets;
+		}
+	}
+
+	if (NumOffsets > 0)
+	{
+		NewSample.AvOffset = OffsetSum / NumOffsets;
+		NewSample.HasAvOffset = true;
+	}
+
+	const FString Line = FString::Printf(TEXT("%.1f,%.2f,%i,%i,%.3f,%i,%i,%i\n"),
+		NewSample.Time, NewSample.Memory, NewSample.Threads, NewSample.Handles, NewSample.AvOffset, NumOpens, NumSwitches, NumFinderChanges);
+
+	FFileHelper::SaveStringToFile(Line, *CsvPath, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+}
+
+
+/* FNdiMediaSoakTest callbacks
+ *****************************************************************************/
+
+bool FNdiMediaSoakTest::HandleTicker(float DeltaTime)
+{
+	for (const FSlot& Slot : Slots)
+	{
+		Slot.Player->TickPlayer(DeltaTime);
+		Slot.Player->TickVideo(DeltaTime);
+	}
+
+	const double Elapsed = FPlatformTime::Seconds() - StartTime;
+
+	if (Elapsed >= NextChurnTime)
+	{
+		Churn();
+		NextChurnTime = Elapsed + Settings.ChurnInterval;
+	}
+
+	if (Elapsed >= NextSampleTime)
+	{
+		Sample();
+		NextSampleTime = Elapsed + Settings.SampleInterval;
+	}
+
+	if (Elapsed >= Settings.Duration)
+	{
+		Stop();
+		return false;
+	}
+
+	return true;
+}
+
+
+/* Console commands
+ *****************************************************************************/
+
+/** The running soak test, if any. */
+static TSharedPtr<FNdiMediaSoakTest> SoakTest;
+
+
+/**
+ * Start or stop the soak test.
+ *
+ * Arguments: [Stop] [Minutes=<duration>] [Players=<count>] [Sources=<count>] [Churn=<seconds>]
+ * [SampleInterval=<seconds>] [Warmup=<seconds>] [Seed=<n>] [MaxMemoryGrowth=<MB/h>] [MaxThreadGrowth=<n/h>]
+ * [MaxHandleGrowth=<n/h>] [MaxAvDrift=<ms/h>] [MaxAvOffset=<ms>] [ExitWhenDone]
+ */
+static void RunSoakTest(const TArray<FString>& Args)
+{
+	if (Args.Contains(TEXT("Stop")))
+	{
+		if (SoakTest.IsValid() && SoakTest->IsRunning())
+		{
+			SoakTest->Stop();
+		}
+		else
+		{
+			UE_LOG(LogNdiMedia, Display, TEXT("NdiMedia soak test is not running"));
+		}
+
+		return;
+	}
+
+	if (SoakTest.IsValid() && SoakTest->IsRunning())
+	{
+		UE_LOG(LogNdiMedia, Warning, TEXT("NdiMedia soak test is already running"));
+		return;
+	}
+
+	const FString Params = FString::Join(Args, TEXT(" "));
+
+	FNdiMediaSoakSettings Settings;
+	{
+		float Minutes = Settings.Duration / 60.0;
+
+		FParse::Value(*Params, TEXT("Minutes="), Minutes);
+		FParse::Value(*Params, TEXT("Players="), Settings.NumPlayers);
+		FParse::Value(*Params, TEXT("Sources="), Settings.NumSources);
+		FParse::Value(*Params, TEXT("Churn="), Settings.ChurnInterval);
+		FParse::Value(*Params, TEXT("SampleInterval="), Settings.SampleInterval);
+		FParse::Value(*Params, TEXT("Warmup="), Settings.Warmup);
+		FParse::Value(*Params, TEXT("Seed="), Settings.Seed);
+		FParse::Value(*Params, TEXT("MaxMemoryGrowth="), Settings.MaxMemoryGrowth);
+		FParse::Value(*Params, TEXT("MaxThreadGrowth="), Settings.MaxThreadGrowth);
+		FParse::Value(*Params, TEXT("MaxHandleGrowth="), Settings.MaxHandleGrowth);
+		FParse::Value(*Params, TEXT("MaxAvDrift="), Settings.MaxAvDrift);
+		FParse::Value(*Params, TEXT("MaxAvOffset="), Settings.MaxAvOffset);
+
+		Settings.Duration = FMath::Max(Minutes, 0.1f) * 60.0;
+		Settings.ExitWhenDone = Args.Contains(TEXT("ExitWhenDone"));
+	}
+
+	SoakTest = MakeShareable(new FNdiMediaSoakTest(Settings));
+	SoakTest->Start();
+}
+
+
+static FAutoConsoleCommand SoakTestCommand(
+	TEXT("NdiMedia.Soak"),
+	TEXT("Run a long-duration soak test of the receive pipeline against synthetic sources, or stop it with 'Stop'.\n")
+	TEXT("Arguments: [Stop] [Minutes=<duration>] [Players=<count>] [Sources=<count>] [Churn=<seconds>] [SampleInterval=<seconds>] [Warmup=<seconds>] [Seed=<n>] ")
+	TEXT("[MaxMemoryGrowth=<MB/h>] [MaxThreadGrowth=<n/h>] [MaxHandleGrowth=<n/h>] [MaxAvDrift=<ms/h>] [MaxAvOffset=<ms>] [ExitWhenDone]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&RunSoakTest)
+);
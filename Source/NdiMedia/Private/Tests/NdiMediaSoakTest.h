@@ -0,0 +1,263 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Math/RandomStream.h"
+
+
+class FNdiMediaLoopbackBackend;
+class FNdiMediaPlayer;
+class FNdiMediaTestAudioSink;
+class FNdiMediaTestVideoSink;
+class INdiMediaBackend;
+class INdiMediaClock;
+class UNdiMediaFinder;
+class UNdiMediaSource;
+
+
+/**
+ * Settings of a soak test run.
+ */
+struct FNdiMediaSoakSettings
+{
+	/** How often a random player or finder operation is performed (in seconds). */
+	float ChurnInterval;
+
+	/** How long the test runs (in seconds). */
+	double Duration;
+
+	/** Whether to request the application to exit when the test is done. */
+	bool ExitWhenDone;
+
+	/** Largest acceptable absolute A/V offset (in milliseconds). */
+	float MaxAvOffset;
+
+	/** Largest acceptable A/V offset drift (in milliseconds per hour). */
+	float MaxAvDrift;
+
+	/** Largest acceptable handle count growth (in handles per hour). */
+	float MaxHandleGrowth;
+
+	/** Largest acceptable resident memory growth (in megabytes per hour). */
+	float MaxMemoryGrowth;
+
+	/** Largest acceptable thread count growth (in threads per hour). */
+	float MaxThreadGrowth;
+
+	/** Number of players that are opened, closed and switched. */
+	int32 NumPlayers;
+
+	/** Number of synthetic sources that players switch between. */
+	int32 NumSources;
+
+	/** How often process metrics are sampled (in seconds). */
+	float SampleInterval;
+
+	/** Seed of the random stream that picks the operations. */
+	int32 Seed;
+
+	/** How long after the start samples are excluded from trends (in seconds). */
+	float Warmup;
+
+public:
+
+	/** Default constructor (one hour with four players). */
+	FNdiMediaSoakSettings()
+		: ChurnInterval(1.0f)
+		, Duration(3600.0)
+		, ExitWhenDone(false)
+		, MaxAvOffset(100.0f)
+		, MaxAvDrift(2.0f)
+		, MaxHandleGrowth(10.0f)
+		, MaxMemoryGrowth(8.0f)
+		, MaxThreadGrowth(1.0f)
+		, NumPlayers(4)
+		, NumSources(4)
+		, SampleInterval(10.0f)
+		, Seed(0)
+		, Warmup(120.0f)
+	{ }
+};
+
+
+/**
+ * Implements a long-running test that looks for leaks and drift in the receive pipeline.
+ *
+ * The test installs a loopback backend and, on every core ticker tick, ticks a
+ * set of players the way the engine would. At random intervals it opens,
+ * closes, pauses and switches players, detaches and reattaches their audio
+ * sinks, and changes the filters of a source finder. Process metrics are
+ * sampled periodically and appended to a CSV file, so that partial results
+ * survive a crash. When the test ends, linear trends are fitted to the samples
+ * and the test fails if any trend exceeds its threshold.
+ *
+ * @see FNdiMediaSoakSettings
+ */
+class FNdiMediaSoakTest
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InSettings The test settings.
+	 */
+	FNdiMediaSoakTest(const FNdiMediaSoakSettings& InSettings);
+
+	/** Destructor. */
+	~FNdiMediaSoakTest();
+
+public:
+
+	/**
+	 * Whether the test is currently running.
+	 *
+	 * @return true if running, false otherwise.
+	 * @see Start, Stop
+	 */
+	bool IsRunning() const
+	{
+		return TickerHandle.IsValid();
+	}
+
+	/**
+	 * Start the test.
+	 *
+	 * @see IsRunning, Stop
+	 */
+	void Start();
+
+	/**
+	 * Stop the test and evaluate the collected samples.
+	 *
+	 * @return true if the test passed, false otherwise.
+	 * @see IsRunning, Start
+	 */
+	bool Stop();
+
+protected:
+
+	/** A sample of the process metrics. */
+	struct FSample
+	{
+		/** Average difference between the audio and video timecodes (in milliseconds). */
+		double AvOffset;
+
+		/** Whether any player received audio and video recently, so that the A/V offset is known. */
+		bool HasAvOffset;
+
+		/** Number of open handles (-1 if unknown). */
+		int32 Handles;
+
+		/** Resident memory (in megabytes). */
+		double Memory;
+
+		/** Number of threads (-1 if unknown). */
+		int32 Threads;
+
+		/** Time since the start of the test (in seconds). */
+		double Time;
+	};
+
+	/** A player and its sinks. */
+	struct FSlot
+	{
+		/** Whether the audio sink is attached. */
+		bool AudioAttached;
+
+		/** The audio sink. */
+		FNdiMediaTestAudioSink* AudioSink;
+
+		/** The player. */
+		FNdiMediaPlayer* Player;
+
+		/** Index of the source that the player is connected to (INDEX_NONE = closed). */
+		int32 SourceIndex;
+
+		/** The video sink. */
+		FNdiMediaTestVideoSink* VideoSink;
+	};
+
+	/** Perform a random player or finder operation. */
+	void Churn();
+
+	/**
+	 * Fit a linear trend to a metric.
+	 *
+	 * @param GetValue Gets the value of the metric in a sample, and returns false if the value is unknown.
+	 * @param OutPerHour Will contain the slope of the trend (in units per hour).
+	 * @return true if enough samples were available, false otherwise.
+	 */
+	bool GetTrend(TFunctionRef<bool(const FSample&, double&)> GetValue, double& OutPerHour) const;
+
+	/**
+	 * Open a player slot on a synthetic source.
+	 *
+	 * @param Slot The slot to open.
+	 * @param SourceIndex Index of the source to open.
+	 */
+	void OpenSlot(FSlot& Slot, int32 SourceIndex);
+
+	/** Sample the process metrics. */
+	void Sample();
+
+private:
+
+	/** Callback for core ticker ticks. */
+	bool HandleTicker(float DeltaTime);
+
+private:
+
+	/** The loopback backend that feeds the players. */
+	TSharedPtr<FNdiMediaLoopbackBackend, ESPMode::ThreadSafe> Backend;
+
+	/** The clock that times the synthetic sources. */
+	TSharedPtr<INdiMediaClock, ESPMode::ThreadSafe> Clock;
+
+	/** Path of the CSV file that samples are appended to. */
+	FString CsvPath;
+
+	/** The source finder whose filters are churned. */
+	UNdiMediaFinder* Finder;
+
+	/** Media sources for each synthetic source. */
+	TArray<UNdiMediaSource*> MediaSources;
+
+	/** Time at which the next churn operation is due (in seconds since the start). */
+	double NextChurnTime;
+
+	/** Time at which the next sample is due (in seconds since the start). */
+	double NextSampleTime;
+
+	/** Number of finder filter changes. */
+	int32 NumFinderChanges;
+
+	/** Number of player opens. */
+	int32 NumOpens;
+
+	/** Number of player switches between sources. */
+	int32 NumSwitches;
+
+	/** The backend that was active before the test started. */
+	TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> PreviousBackend;
+
+	/** Random stream that picks the operations. */
+	FRandomStream Random;
+
+	/** The collected samples. */
+	TArray<FSample> Samples;
+
+	/** The test settings. */
+	FNdiMediaSoakSettings Settings;
+
+	/** The player slots. */
+	TArray<FSlot> Slots;
+
+	/** Platform time at which the test started (in seconds). */
+	double StartTime;
+
+	/** Handle to the registered ticker. */
+	FDelegateHandle TickerHandle;
+};
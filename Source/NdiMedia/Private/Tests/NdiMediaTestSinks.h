@@ -0,0 +1,380 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeCounter64.h"
+#include "IMediaAudioSink.h"
+#include "IMediaTextureSink.h"
+#include "INdiMediaClock.h"
+#include "Misc/ScopeLock.h"
+
+
+/**
+ * Collects the arrival latencies of the frames that a test sink received.
+ *
+ * The latency of a frame is the time between its timecode and its arrival
+ * at the sink, as measured by the clock that times the synthetic source.
+ */
+class FNdiMediaTestLatencies
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InClock The clock that times the frames' source.
+	 */
+	FNdiMediaTestLatencies(const TSharedRef<INdiMediaClock, ESPMode::ThreadSafe>& InClock)
+		: Clock(InClock)
+		, LastArrival(FTimespan::Zero())
+		, LastTimecode(FTimespan::Zero())
+		, Recording(false)
+	{ }
+
+public:
+
+	/**
+	 * Add the latency of a frame that just arrived.
+	 *
+	 * @param Timecode The frame's timecode.
+	 */
+	void Add(FTimespan Timecode)
+	{
+		const FTimespan Now = Clock->GetTime();
+		const FTimespan Latency = Now - Timecode;
+
+		FScopeLock Lock(&CriticalSection);
+
+		LastArrival = Now;
+		LastTimecode = Timecode;
+
+		if (Recording)
+		{
+			Samples.Add((float)Latency.GetTotalMilliseconds());
+		}
+	}
+
+	/**
+	 * Get the timecode of the most recent frame.
+	 *
+	 * @param OutArrival Will contain the time at which the frame arrived.
+	 * @return The frame's timecode, or zero if no frame arrived yet.
+	 */
+	FTimespan GetLastTimecode(FTimespan& OutArrival) const
+	{
+		FScopeLock Lock(&CriticalSection);
+		OutArrival = LastArrival;
+
+		return LastTimecode;
+	}
+
+	/**
+	 * Get the recorded latencies.
+	 *
+	 * @param OutSamples Will contain the latencies (in milliseconds).
+	 */
+	void GetSamples(TArray<float>& OutSamples) const
+	{
+		FScopeLock Lock(&CriticalSection);
+		OutSamples = Samples;
+	}
+
+	/**
+	 * Start or stop recording latencies.
+	 *
+	 * @param InRecording Whether to record.
+	 * @param ExpectedSamples Number of samples to reserve memory for when recording starts.
+	 */
+	void SetRecording(bool InRecording, int32 ExpectedSamples = 0)
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (InRecording && !Recording)
+		{
+			Samples.Reset(ExpectedSamples);
+		}
+
+		Recording = InRecording;
+	}
+
+private:
+
+	/** The clock that times the frames' source. */
+	TSharedRef<INdiMediaClock, ESPMode::ThreadSafe> Clock;
+
+	/** Critical section for synchronizing access to the samples. */
+	mutable FCriticalSection CriticalSection;
+
+	/** Arrival time of the most recent frame. */
+	FTimespan LastArrival;
+
+	/** Timecode of the most recent frame. */
+	FTimespan LastTimecode;
+
+	/** Whether latencies are currently recorded. */
+	bool Recording;
+
+	/** The recorded latencies (in milliseconds). */
+	TArray<float> Samples;
+};
+
+
+/**
+ * Implements an audio sink that discards the samples it receives.
+ */
+class FNdiMediaTestAudioSink
+	: public IMediaAudioSink
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InClock The clock that times the frames' source.
+	 */
+	FNdiMediaTestAudioSink(const TSharedRef<INdiMediaClock, ESPMode::ThreadSafe>& InClock)
+		: Channels(0)
+		, Latencies(InClock)
+		, NumFrames(0)
+		, SampleRate(0)
+	{ }
+
+public:
+
+	/**
+	 * Get the latencies of the received frames.
+	 *
+	 * @return Latency recorder.
+	 */
+	FNdiMediaTestLatencies& GetLatencies()
+	{
+		return Latencies;
+	}
+
+	/**
+	 * Get the number of frames that the sink received.
+	 *
+	 * @return Number of frames.
+	 */
+	int64 GetNumFrames() const
+	{
+		return NumFrames.GetValue();
+	}
+
+public:
+
+	//~ IMediaAudioSink interface
+
+	virtual void FlushAudioSink() override { }
+
+	virtual int32 GetAudioSinkChannels() const override
+	{
+		return Channels;
+	}
+
+	virtual int32 GetAudioSinkSampleRate() const override
+	{
+		return SampleRate;
+	}
+
+	virtual bool InitializeAudioSink(uint32 InChannels, uint32 InSampleRate) override
+	{
+		Channels = InChannels;
+		SampleRate = InSampleRate;
+
+		return true;
+	}
+
+	virtual void PauseAudioSink() override { }
+
+	virtual void PlayAudioSink(const uint8* Buffer, uint32 BufferSize, FTimespan Time) override
+	{
+		Latencies.Add(Time);
+		NumFrames.Increment();
+	}
+
+	virtual void ResumeAudioSink() override { }
+
+	virtual void ShutdownAudioSink() override
+	{
+		Channels = 0;
+		SampleRate = 0;
+	}
+
+private:
+
+	/** Number of audio channels the sink was initialized with. */
+	int32 Channels;
+
+	/** Latencies of the received frames. */
+	FNdiMediaTestLatencies Latencies;
+
+	/** Number of received frames. */
+	FThreadSafeCounter64 NumFrames;
+
+	/** Sample rate the sink was initialized with. */
+	int32 SampleRate;
+};
+
+
+/**
+ * Implements a texture sink that copies each frame into a CPU buffer.
+ *
+ * The copy stands in for the upload that a media texture performs, so that
+ * measurements include the cost of touching every byte of the frame once.
+ */
+class FNdiMediaTestVideoSink
+	: public IMediaTextureSink
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InClock The clock that times the frames' source.
+	 */
+	FNdiMediaTestVideoSink(const TSharedRef<INdiMediaClock, ESPMode::ThreadSafe>& InClock)
+		: BufferDim(FIntPoint::ZeroValue)
+		, Format(EMediaTextureSinkFormat::CharBGRA)
+		, Latencies(InClock)
+		, NumFrames(0)
+		, NumInitializations(0)
+		, OutputDim(FIntPoint::ZeroValue)
+	{ }
+
+public:
+
+	/**
+	 * Get the latencies of the received frames.
+	 *
+	 * @return Latency recorder.
+	 */
+	FNdiMediaTestLatencies& GetLatencies()
+	{
+		return Latencies;
+	}
+
+	/**
+	 * Get the number of frames that the sink displayed.
+	 *
+	 * @return Number of frames.
+	 */
+	int64 GetNumFrames() const
+	{
+		return NumFrames.GetValue();
+	}
+
+	/**
+	 * Get the number of times the sink was initialized.
+	 *
+	 * @return Number of initializations.
+	 */
+	int32 GetNumInitializations() const
+	{
+		return NumInitializations;
+	}
+
+public:
+
+	//~ IMediaTextureSink interface
+
+	virtual void* AcquireTextureSinkBuffer() override
+	{
+		return Buffer.GetData();
+	}
+
+	virtual void DisplayTextureSinkBuffer(FTimespan Time) override
+	{
+		Latencies.Add(Time);
+		NumFrames.Increment();
+	}
+
+	virtual FIntPoint GetTextureSinkDimensions() const override
+	{
+		return BufferDim;
+	}
+
+	virtual EMediaTextureSinkFormat GetTextureSinkFormat() const override
+	{
+		return Format;
+	}
+
+	virtual EMediaTextureSinkMode GetTextureSinkMode() const override
+	{
+		return EMediaTextureSinkMode::Unbuffered;
+	}
+
+	virtual bool InitializeTextureSink(FIntPoint InOutputDim, FIntPoint InBufferDim, EMediaTextureSinkFormat InFormat, EMediaTextureSinkMode InMode) override
+	{
+		BufferDim = InBufferDim;
+		Format = InFormat;
+		OutputDim = InOutputDim;
+
+		// texels are 32 bits wide in all supported formats
+		Buffer.SetNumUninitialized(BufferDim.X * BufferDim.Y * 4);
+		++NumInitializations;
+
+		return true;
+	}
+
+	virtual void ReleaseTextureSinkBuffer() override { }
+
+	virtual void ShutdownTextureSink() override
+	{
+		Buffer.Empty();
+		BufferDim = FIntPoint::ZeroValue;
+		OutputDim = FIntPoint::ZeroValue;
+	}
+
+	virtual bool SupportsTextureSinkFormat(EMediaTextureSinkFormat InFormat) const override
+	{
+		return (InFormat == EMediaTextureSinkFormat::CharBGRA) || (InFormat == EMediaTextureSinkFormat::CharUYVY);
+	}
+
+	virtual void UpdateTextureSinkBuffer(const uint8* Data, uint32 Pitch = 0) override
+	{
+		const uint32 RowSize = BufferDim.X * 4;
+
+		if ((Data == nullptr) || (RowSize == 0))
+		{
+			return;
+		}
+
+		if (Pitch == 0)
+		{
+			Pitch = RowSize;
+		}
+
+		for (int32 Row = 0; Row < BufferDim.Y; ++Row)
+		{
+			FMemory::Memcpy(Buffer.GetData() + Row * RowSize, Data + Row * Pitch, FMath::Min(RowSize, Pitch));
+		}
+	}
+
+	virtual void UpdateTextureSinkResource(FRHITexture* RenderTarget, FRHITexture* ShaderResource) override { }
+
+private:
+
+	/** The CPU copy of the most recent frame. */
+	TArray<uint8> Buffer;
+
+	/** Dimensions of the sink buffer (in texels). */
+	FIntPoint BufferDim;
+
+	/** Format the sink was initialized with. */
+	EMediaTextureSinkFormat Format;
+
+	/** Latencies of the displayed frames. */
+	FNdiMediaTestLatencies Latencies;
+
+	/** Number of displayed frames. */
+	FThreadSafeCounter64 NumFrames;
+
+	/** Number of times the sink was initialized. */
+	int32 NumInitializations;
+
+	/** Dimensions of the visible output (in pixels). */
+	FIntPoint OutputDim;
+};
@@ -0,0 +1,323 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaThumbnailService.h"
+#include "NdiMediaPrivate.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "INdiMediaBackend.h"
+#include "Misc/ScopeLock.h"
+#include "Ndi.h"
+#include "NdiMediaVideoKernels.h"
+#include "NdiMediaVideoScaler.h"
+
+
+/* FNdiMediaThumbnailService structors
+ *****************************************************************************/
+
+FNdiMediaThumbnailService::FNdiMediaThumbnailService(const FNdiMediaThumbnailSettings& InSettings)
+	: Settings(InSettings)
+	, Stopping(false)
+	, WorkEvent(FPlatformProcess::GetSynchEventFromPool(false))
+{ }
+
+
+FNdiMediaThumbnailService::~FNdiMediaThumbnailService()
+{
+	if (Threads.Num() > 0)
+	{
+		Stopping = true;
+
+		for (int32 ThreadIndex = 0; ThreadIndex < Threads.Num(); ++ThreadIndex)
+		{
+			WorkEvent->Trigger();
+		}
+
+		for (FRunnableThread* Thread : Threads)
+		{
+			Thread->WaitForCompletion();
+			delete Thread;
+		}
+
+		Threads.Empty();
+	}
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	WorkEvent = nullptr;
+}
+
+
+/* FNdiMediaThumbnailService interface
+ *****************************************************************************/
+
+TSharedPtr<FNdiMediaThumbnail, ESPMode::ThreadSafe> FNdiMediaThumbnailService::GetThumbnail(const FString& Source)
+{
+	if (Source.IsEmpty())
+	{
+		return nullptr;
+	}
+
+	const double Now = FPlatformTime::Seconds();
+
+	FScopeLock Lock(&CriticalSection);
+
+	FEntry* Entry = Entries.Find(Source);
+
+	if (Entry == nullptr)
+	{
+		PruneEntries();
+
+		Entry = &Entries.Add(Source);
+		Entry->ProbeTime = 0.0;
+		Entry->Probing = false;
+	}
+
+	Entry->AccessTime = Now;
+
+	// queue a probe if the thumbnail is missing or expired
+	const bool Expired = (Entry->ProbeTime == 0.0) || (Now - Entry->ProbeTime >= Settings.TimeToLive.GetTotalSeconds());
+
+	if (Expired && !Entry->Probing && !Stopping)
+	{
+		Entry->Probing = true;
+		PendingSources.Add(Source);
+
+		// start the worker threads on demand
+		if (Threads.Num() == 0)
+		{
+			for (int32 ThreadIndex = 0; ThreadIndex < FMath::Max(1, Settings.MaxProbes); ++ThreadIndex)
+			{
+				FRunnableThread* Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("FNdiMediaThumbnailService %i"), ThreadIndex), 0, TPri_BelowNormal);
+
+				if (Thread != nullptr)
+				{
+					Threads.Add(Thread);
+				}
+			}
+		}
+
+		WorkEvent->Trigger();
+	}
+
+	return Entry->Thumbnail;
+}
+
+
+/* FRunnable interface
+ *****************************************************************************/
+
+bool FNdiMediaThumbnailService::Init()
+{
+	return true;
+}
+
+
+uint32 FNdiMediaThumbnailService::Run()
+{
+	while (!Stopping)
+	{
+		FString Source;
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			if (PendingSources.Num() > 0)
+			{
+				Source = PendingSources[0];
+				PendingSources.RemoveAt(0, 1, false);
+			}
+		}
+
+		if (Source.IsEmpty())
+		{
+			WorkEvent->Wait(100);
+			continue;
+		}
+
+		TSharedPtr<FNdiMediaThumbnail, ESPMode::ThreadSafe> Thumbnail = Probe(Source);
+
+		FScopeLock Lock(&CriticalSection);
+
+		FEntry* Entry = Entries.Find(Source);
+
+		if (Entry != nullptr)
+		{
+			Entry->ProbeTime = FPlatformTime::Seconds();
+			Entry->Probing = false;
+
+			// keep showing the previous thumbnail if the source is temporarily unavailable
+			if (Thumbnail.IsValid())
+			{
+				Entry->Thumbnail = Thumbnail;
+			}
+		}
+	}
+
+	return 0;
+}
+
+
+void FNdiMediaThumbnailService::Stop()
+{
+	Stopping = true;
+	WorkEvent->Trigger();
+}
+
+
+/* FNdiMediaThumbnailService implementation
+ *****************************************************************************/
+
+bool FNdiMediaThumbnailService::MakeThumbnail(const NDIlib_video_frame_v2_t& VideoFrame, FNdiMediaThumbnail& OutThumbnail) const
+{
+	const bool Bgr = (VideoFrame.FourCC == NDIlib_FourCC_type_BGRA) || (VideoFrame.FourCC == NDIlib_FourCC_type_BGRX);
+	const bool Rgb = (VideoFrame.FourCC == NDIlib_FourCC_type_RGBA) || (VideoFrame.FourCC == NDIlib_FourCC_type_RGBX);
+
+	if ((!Bgr && !Rgb) || (VideoFrame.p_data == nullptr) || (VideoFrame.xres <= 0) || (VideoFrame.yres <= 0))
+	{
+		return false;
+	}
+
+	const FIntPoint Size = FNdiMediaVideoScaler::FitSize(VideoFrame.xres, VideoFrame.yres, Settings.MaxWidth, Settings.MaxHeight);
+	FNdiMediaVideoScaler Scaler;
+
+	OutThumbnail.Pixels.SetNumUninitialized(Size.X * Size.Y * 4);
+	Scaler.Process(VideoFrame.p_data, VideoFrame.xres, VideoFrame.yres, VideoFrame.line_stride_in_bytes, OutThumbnail.Pixels.GetData(), Size.X, Size.Y, Size.X * 4);
+
+	if (Rgb)
+	{
+		for (int32 Row = 0; Row < Size.Y; ++Row)
+		{
+			uint8* RowData = OutThumbnail.Pixels.GetData() + Row * Size.X * 4;
+			NdiMediaVideo::SwapRedBlueRow(RowData, RowData, Size.X);
+		}
+	}
+
+	// the alpha channel of BGRX and RGBX frames is undefined
+	if ((VideoFrame.FourCC == NDIlib_FourCC_type_BGRX) || (VideoFrame.FourCC == NDIlib_FourCC_type_RGBX))
+	{
+		for (int32 Index = 3; Index < OutThumbnail.Pixels.Num(); Index += 4)
+		{
+			OutThumbnail.Pixels[Index] = 0xff;
+		}
+	}
+
+	OutThumbnail.Height = Size.Y;
+	OutThumbnail.Time = FDateTime::UtcNow();
+	OutThumbnail.Width = Size.X;
+
+	return true;
+}
+
+
+TSharedPtr<FNdiMediaThumbnail, ESPMode::ThreadSafe> FNdiMediaThumbnailService::Probe(const FString& Source)
+{
+	TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> Backend = FNdi::GetBackend();
+
+	if (!Backend.IsValid())
+	{
+		return nullptr;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// the converted string must outlive the receiver's creation
+	FString SourceStr = Source;
+
+	if (SourceStr.StartsWith(TEXT("localhost ")))
+	{
+		SourceStr.ReplaceInline(TEXT("localhost"), FPlatformProcess::ComputerName());
+	}
+
+	FTCHARToUTF8 SourceUtf8(*SourceStr);
+
+	NDIlib_recv_create_t RcvCreateDesc;
+	{
+		const bool IsEndpoint = (SourceStr.Find(TEXT(":")) != INDEX_NONE);
+
+		RcvCreateDesc.source_to_connect_to.p_ip_address = IsEndpoint ? SourceUtf8.Get() : nullptr;
+		RcvCreateDesc.source_to_connect_to.p_ndi_name = IsEndpoint ? nullptr : SourceUtf8.Get();
+		RcvCreateDesc.color_format = NDIlib_recv_color_format_e_BGRX_BGRA;
+		RcvCreateDesc.bandwidth = NDIlib_recv_bandwidth_lowest;
+		RcvCreateDesc.allow_video_fields = false;
+	}
+
+	NDIlib_recv_instance_t ReceiverInstance = Backend->RecvCreate(RcvCreateDesc);
+
+	if (ReceiverInstance == nullptr)
+	{
+		UE_LOG(LogNdiMedia, Verbose, TEXT("Failed to probe NDI source %s: couldn't create receiver"), *Source);
+
+		return nullptr;
+	}
+
+	// wait for the first video frame, in short steps so that shutdown isn't delayed
+	TSharedPtr<FNdiMediaThumbnail, ESPMode::ThreadSafe> Thumbnail;
+	const double Deadline = StartTime + Settings.ProbeTimeout.GetTotalSeconds();
+
+	while (!Stopping)
+	{
+		const double Remaining = Deadline - FPlatformTime::Seconds();
+
+		if (Remaining <= 0.0)
+		{
+			break;
+		}
+
+		NDIlib_video_frame_v2_t VideoFrame;
+		const NDIlib_frame_type_e FrameType = Backend->RecvCapture(ReceiverInstance, &VideoFrame, nullptr, nullptr, (uint32)FMath::Clamp(Remaining * 1000.0, 1.0, 100.0));
+
+		if (FrameType == NDIlib_frame_type_video)
+		{
+			Thumbnail = MakeShareable(new FNdiMediaThumbnail);
+
+			if (!MakeThumbnail(VideoFrame, *Thumbnail))
+			{
+				Thumbnail.Reset();
+			}
+
+			Backend->RecvFreeVideo(ReceiverInstance, VideoFrame);
+
+			break;
+		}
+
+		if (FrameType == NDIlib_frame_type_error)
+		{
+			break;
+		}
+	}
+
+	// disconnect right away
+	Backend->RecvDestroy(ReceiverInstance);
+
+	UE_LOG(LogNdiMedia, Verbose, TEXT("%s NDI source %s in %.1f ms"), Thumbnail.IsValid() ? TEXT("Probed") : TEXT("Failed to probe"), *Source, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	return Thumbnail;
+}
+
+
+void FNdiMediaThumbnailService::PruneEntries()
+{
+	while (Entries.Num() >= FMath::Max(1, Settings.MaxEntries))
+	{
+		const FString* OldestSource = nullptr;
+		double OldestTime = 0.0;
+
+		for (const auto& Pair : Entries)
+		{
+			if (!Pair.Value.Probing && ((OldestSource == nullptr) || (Pair.Value.AccessTime < OldestTime)))
+			{
+				OldestSource = &Pair.Key;
+				OldestTime = Pair.Value.AccessTime;
+			}
+		}
+
+		// entries that are being probed are kept until their probe finishes
+		if (OldestSource == nullptr)
+		{
+			break;
+		}
+
+		Entries.Remove(FString(*OldestSource));
+	}
+}
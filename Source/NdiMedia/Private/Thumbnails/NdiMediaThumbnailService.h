@@ -0,0 +1,166 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "NdiMediaThumbnail.h"
+
+
+class FEvent;
+class FRunnableThread;
+
+struct NDIlib_video_frame_v2_t;
+
+
+/**
+ * Settings of the thumbnail service.
+ */
+struct FNdiMediaThumbnailSettings
+{
+	/** Maximum number of cached thumbnails. */
+	int32 MaxEntries;
+
+	/** Maximum height of thumbnails (in pixels). */
+	int32 MaxHeight;
+
+	/** Maximum number of sources that are probed at the same time. */
+	int32 MaxProbes;
+
+	/** Maximum width of thumbnails (in pixels). */
+	int32 MaxWidth;
+
+	/** How long to wait for a source's first video frame. */
+	FTimespan ProbeTimeout;
+
+	/** How long a thumbnail is valid before the source is probed again. */
+	FTimespan TimeToLive;
+
+public:
+
+	/** Default constructor (160x90 pixels, 2 probes, 3 second timeout, 30 second lifetime). */
+	FNdiMediaThumbnailSettings()
+		: MaxEntries(256)
+		, MaxHeight(90)
+		, MaxProbes(2)
+		, MaxWidth(160)
+		, ProbeTimeout(FTimespan::FromSeconds(3.0))
+		, TimeToLive(FTimespan::FromSeconds(30.0))
+	{ }
+};
+
+
+/**
+ * Captures and caches preview images of NDI sources.
+ *
+ * A source is probed by connecting a receiver at the lowest bandwidth, which
+ * makes the sender deliver its preview stream, capturing a single video frame,
+ * and disconnecting right away. The frame is downscaled to thumbnail size.
+ *
+ * Probes run on a small number of worker threads, which limits how many sources
+ * are connected at the same time, so that browsing a large number of sources
+ * doesn't flood the network or the CPU. Threads are started on the first request.
+ *
+ * Thumbnails are cached and returned until they expire; expired thumbnails
+ * are still returned while the source is probed again. Failed probes are cached
+ * as well, so unreachable sources are not retried before their entry expires.
+ *
+ * All functions are thread-safe.
+ */
+class FNdiMediaThumbnailService
+	: public FRunnable
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InSettings The service settings.
+	 */
+	FNdiMediaThumbnailService(const FNdiMediaThumbnailSettings& InSettings = FNdiMediaThumbnailSettings());
+
+	/** Destructor. */
+	virtual ~FNdiMediaThumbnailService();
+
+public:
+
+	/**
+	 * Get the thumbnail of a source, and request a probe if needed.
+	 *
+	 * @param Source The source's name or IP endpoint.
+	 * @return The cached thumbnail, or nullptr if none is available yet.
+	 * @see INdiMediaModule::GetThumbnail
+	 */
+	TSharedPtr<FNdiMediaThumbnail, ESPMode::ThreadSafe> GetThumbnail(const FString& Source);
+
+public:
+
+	//~ FRunnable interface
+
+	virtual bool Init() override;
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	virtual void Exit() override { }
+
+protected:
+
+	/** A cached thumbnail. */
+	struct FEntry
+	{
+		/** Time at which the thumbnail was last requested (in seconds). */
+		double AccessTime;
+
+		/** Time at which the source was last probed (in seconds). */
+		double ProbeTime;
+
+		/** Whether the source is queued or being probed. */
+		bool Probing;
+
+		/** The thumbnail (nullptr if the source hasn't been captured). */
+		TSharedPtr<FNdiMediaThumbnail, ESPMode::ThreadSafe> Thumbnail;
+	};
+
+	/**
+	 * Create a thumbnail from a video frame.
+	 *
+	 * @param VideoFrame The frame (BGRA, BGRX, RGBA or RGBX).
+	 * @param OutThumbnail Will contain the thumbnail.
+	 * @return true on success, false if the frame format is not supported.
+	 */
+	bool MakeThumbnail(const NDIlib_video_frame_v2_t& VideoFrame, FNdiMediaThumbnail& OutThumbnail) const;
+
+	/**
+	 * Capture a thumbnail of a source (on a worker thread).
+	 *
+	 * @param Source The source's name or IP endpoint.
+	 * @return The thumbnail, or nullptr if the source couldn't be captured.
+	 */
+	TSharedPtr<FNdiMediaThumbnail, ESPMode::ThreadSafe> Probe(const FString& Source);
+
+	/** Remove the least recently requested entries that exceed the cache size (caller holds the lock). */
+	void PruneEntries();
+
+private:
+
+	/** Critical section for synchronizing access to the cache and request queue. */
+	FCriticalSection CriticalSection;
+
+	/** The cached thumbnails, keyed by source. */
+	TMap<FString, FEntry> Entries;
+
+	/** Sources that are waiting to be probed (oldest first). */
+	TArray<FString> PendingSources;
+
+	/** The service settings. */
+	FNdiMediaThumbnailSettings Settings;
+
+	/** Whether the worker threads should stop. */
+	FThreadSafeBool Stopping;
+
+	/** The worker threads. */
+	TArray<FRunnableThread*> Threads;
+
+	/** Event for waking up worker threads. */
+	FEvent* WorkEvent;
+};
@@ -0,0 +1,349 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaColorConverter.h"
+#include "NdiMediaPrivate.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "NdiMediaDeinterlacer.h"
+#include "NdiMediaVideoFormat.h"
+#include "NdiMediaXmlTokenizer.h"
+
+
+DECLARE_CYCLE_STAT(TEXT("Color Conversion"), STAT_NdiMedia_ColorConversion, STATGROUP_NdiMedia);
+
+
+/* FNdiMediaColorConverter structors
+ *****************************************************************************/
+
+FNdiMediaColorConverter::FNdiMediaColorConverter()
+	: FullRange(false)
+	, InstructionSet(NdiMediaVideo::GetBestInstructionSet())
+	, LastBt709(false)
+	, SourceMatrix(ENdiMediaYuvConversion::Auto)
+	, YuvConversion(ENdiMediaYuvConversion::Sink)
+{ }
+
+
+/* FNdiMediaColorConverter interface
+ *****************************************************************************/
+
+FString FNdiMediaColorConverter::GetMatrixName() const
+{
+	return FString::Printf(TEXT("%s %s"), LastBt709 ? TEXT("BT.709") : TEXT("BT.601"), FullRange ? TEXT("Full") : TEXT("Limited"));
+}
+
+
+bool FNdiMediaColorConverter::NeedsConversion(const NDIlib_video_frame_v2_t& Frame) const
+{
+	switch (Frame.FourCC)
+	{
+	case NDIlib_FourCC_type_RGBA:
+	case NDIlib_FourCC_type_RGBX:
+	case NDIlib_FourCC_type_UYVA:
+		return true;
+
+	case NDIlib_FourCC_type_UYVY:
+		return ConvertsYuv();
+
+	default:
+		return false;
+	}
+}
+
+
+bool FNdiMediaColorConverter::Process(const NDIlib_video_frame_v2_t& InFrame, NDIlib_video_frame_v2_t& OutFrame)
+{
+	if ((InFrame.p_data == nullptr) || (InFrame.xres <= 0) || (InFrame.yres <= 0))
+	{
+		return false;
+	}
+
+	NDIlib_FourCC_type_e OutFourCC;
+	int32 MinStride;
+
+	switch (InFrame.FourCC)
+	{
+	case NDIlib_FourCC_type_RGBA:
+		OutFourCC = NDIlib_FourCC_type_BGRA;
+		MinStride = InFrame.xres * 4;
+		break;
+
+	case NDIlib_FourCC_type_RGBX:
+		OutFourCC = NDIlib_FourCC_type_BGRX;
+		MinStride = InFrame.xres * 4;
+		break;
+
+	case NDIlib_FourCC_type_UYVA:
+		OutFourCC = NDIlib_FourCC_type_BGRA;
+		MinStride = InFrame.xres * 2;
+		break;
+
+	case NDIlib_FourCC_type_UYVY:
+		OutFourCC = NDIlib_FourCC_type_BGRX;
+		MinStride = InFrame.xres * 2;
+		break;
+
+	default:
+		return false;
+	}
+
+	if (InFrame.line_stride_in_bytes < MinStride)
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NdiMedia_ColorConversion);
+	FNdiMediaStageScope StageScope(Stats);
+
+	if ((InFrame.FourCC == NDIlib_FourCC_type_UYVA) || (InFrame.FourCC == NDIlib_FourCC_type_UYVY))
+	{
+		UnpackYuv(InFrame);
+	}
+	else
+	{
+		SwizzleRgba(InFrame);
+	}
+
+	OutFrame = InFrame;
+	OutFrame.FourCC = OutFourCC;
+	OutFrame.line_stride_in_bytes = InFrame.xres * 4;
+	OutFrame.p_data = Buffer.GetData();
+
+	return true;
+}
+
+
+void FNdiMediaColorConverter::Reset()
+{
+	SourceMatrix = ENdiMediaYuvConversion::Auto;
+	Stats.Reset();
+}
+
+
+void FNdiMediaColorConverter::SetYuvConversion(ENdiMediaYuvConversion InConversion, ENdiMediaYuvRange InRange)
+{
+	FullRange = (InRange == ENdiMediaYuvRange::Full);
+	YuvConversion = InConversion;
+}
+
+
+/* FNdiMediaColorConverter implementation
+ *****************************************************************************/
+
+const NdiMediaVideo::FYuvToRgbMatrix& FNdiMediaColorConverter::SelectMatrix(const NDIlib_video_frame_v2_t& Frame)
+{
+	if (Frame.p_metadata != nullptr)
+	{
+		UpdateSourceMatrix(Frame.p_metadata);
+	}
+
+	if ((YuvConversion == ENdiMediaYuvConversion::Bt601) || (YuvConversion == ENdiMediaYuvConversion::Bt709))
+	{
+		LastBt709 = (YuvConversion == ENdiMediaYuvConversion::Bt709);
+	}
+	else if (SourceMatrix != ENdiMediaYuvConversion::Auto)
+	{
+		LastBt709 = (SourceMatrix == ENdiMediaYuvConversion::Bt709);
+	}
+	else
+	{
+		LastBt709 = (FNdiMediaDeinterlacer::GetOutputHeight(Frame) >= 720);
+	}
+
+	return NdiMediaVideo::GetYuvToRgbMatrix(LastBt709, FullRange);
+}
+
+
+void FNdiMediaColorConverter::SwizzleRgba(const NDIlib_video_frame_v2_t& Frame)
+{
+	const int32 Width = Frame.xres;
+	const int32 Rows = Frame.yres;
+	const int32 SrcStride = Frame.line_stride_in_bytes;
+	const int32 DestStride = Width * 4;
+
+	Buffer.SetNumUninitialized(DestStride * Rows, false);
+
+	const uint8* Src = Frame.p_data;
+	uint8* Dest = Buffer.GetData();
+
+	int32 RowsPerBand = 0;
+	const int32 NumBands = NdiMediaVideo::GetNumRowBands(Rows, RowsPerBand);
+
+	ParallelFor(NumBands, [=](int32 BandIndex)
+	{
+		const int32 FirstRow = BandIndex * RowsPerBand;
+		const int32 LastRow = FMath::Min(FirstRow + RowsPerBand, Rows);
+
+		for (int32 Row = FirstRow; Row < LastRow; ++Row)
+		{
+			NdiMediaVideo::SwapRedBlueRow(Dest + Row * DestStride, Src + Row * SrcStride, Width);
+		}
+	});
+}
+
+
+void FNdiMediaColorConverter::UnpackYuv(const NDIlib_video_frame_v2_t& Frame)
+{
+	const int32 Width = Frame.xres;
+	const int32 Rows = Frame.yres;
+	const int32 SrcStride = Frame.line_stride_in_bytes;
+	const int32 DestStride = Width * 4;
+
+	Buffer.SetNumUninitialized(DestStride * Rows, false);
+
+	// the alpha plane of UYVA frames immediately follows the UYVY plane and has one byte per pixel
+	const uint8* Uyvy = Frame.p_data;
+	const uint8* Alpha = (Frame.FourCC == NDIlib_FourCC_type_UYVA) ? Uyvy + SrcStride * Rows : nullptr;
+	uint8* Dest = Buffer.GetData();
+
+	const NdiMediaVideo::FYuvToRgbMatrix& Matrix = SelectMatrix(Frame);
+	const NdiMediaVideo::EInstructionSet RowInstructionSet = InstructionSet;
+
+	int32 RowsPerBand = 0;
+	const int32 NumBands = NdiMediaVideo::GetNumRowBands(Rows, RowsPerBand);
+
+	ParallelFor(NumBands, [=, &Matrix](int32 BandIndex)
+	{
+		const int32 FirstRow = BandIndex * RowsPerBand;
+		const int32 LastRow = FMath::Min(FirstRow + RowsPerBand, Rows);
+
+		for (int32 Row = FirstRow; Row < LastRow; ++Row)
+		{
+			NdiMediaVideo::UyvyRowToBgra(Dest + Row * DestStride, Uyvy + Row * SrcStride, (Alpha != nullptr) ? Alpha + Row * Width : nullptr, Width, Matrix, RowInstructionSet);
+		}
+	});
+}
+
+
+void FNdiMediaColorConverter::UpdateSourceMatrix(const char* Metadata)
+{
+	// only tokenize metadata that may contain color information
+	if (FCStringAnsi::Strstr(Metadata, "ndi_color_info") == nullptr)
+	{
+		return;
+	}
+
+	FNdiMediaXmlTokenizer Tokenizer(Metadata, FCStringAnsi::Strlen(Metadata));
+	FNdiMediaXmlToken Token;
+	bool InColorInfo = false;
+
+	while (Tokenizer.Next(Token))
+	{
+		if (Token.Type == ENdiMediaXmlToken::BeginElement)
+		{
+			InColorInfo = Token.Name.Equals("ndi_color_info");
+		}
+		else if (InColorInfo && (Token.Type == ENdiMediaXmlToken::Attribute) && Token.Name.Equals("matrix"))
+		{
+			if (Token.Value.Equals("bt_601"))
+			{
+				SourceMatrix = ENdiMediaYuvConversion::Bt601;
+			}
+			else if (Token.Value.Equals("bt_709"))
+			{
+				SourceMatrix = ENdiMediaYuvConversion::Bt709;
+			}
+
+			return;
+		}
+	}
+}
+
+
+/* Console commands
+ *****************************************************************************/
+
+/** Compare the SIMD color conversion kernels with the scalar reference implementation. */
+static void VerifyColorConversion()
+{
+	const int32 Widths[] = { 1, 2, 7, 16, 33, 720, 1921 };
+	const uint32 FourCCs[] = { NDIlib_FourCC_type_UYVY, NDIlib_FourCC_type_UYVA, NDIlib_FourCC_type_RGBA };
+	const NdiMediaVideo::EInstructionSet BestInstructionSet = NdiMediaVideo::GetBestInstructionSet();
+
+	FRandomStream Random(0x4e44494d);
+	int32 NumFailures = 0;
+	int32 NumTests = 0;
+
+	FNdiMediaColorConverter Reference;
+	FNdiMediaColorConverter Candidate;
+
+	Reference.SetInstructionSet(NdiMediaVideo::EInstructionSet::Scalar);
+
+	for (int32 Conversion = (int32)ENdiMediaYuvConversion::Bt601; Conversion <= (int32)ENdiMediaYuvConversion::Bt709; ++Conversion)
+	{
+		for (int32 Range = 0; Range < 2; ++Range)
+		{
+			Reference.SetYuvConversion((ENdiMediaYuvConversion)Conversion, (ENdiMediaYuvRange)Range);
+			Candidate.SetYuvConversion((ENdiMediaYuvConversion)Conversion, (ENdiMediaYuvRange)Range);
+
+			for (const uint32 FourCC : FourCCs)
+			{
+				for (const int32 Width : Widths)
+				{
+					// random pixels with padded line stride
+					const int32 Rows = 3;
+					const int32 BytesPerPixel = (FourCC == NDIlib_FourCC_type_RGBA) ? 4 : 2;
+					const int32 Stride = Width * BytesPerPixel + 32;
+
+					TArray<uint8> Pixels;
+					Pixels.SetNumUninitialized(Stride * Rows + Width * Rows);
+
+					for (uint8& Pixel : Pixels)
+					{
+						Pixel = (uint8)Random.RandHelper(256);
+					}
+
+					NDIlib_video_frame_v2_t Frame;
+					{
+						FMemory::Memzero(Frame);
+						Frame.xres = Width;
+						Frame.yres = Rows;
+						Frame.FourCC = (NDIlib_FourCC_type_e)FourCC;
+						Frame.frame_format_type = NDIlib_frame_format_type_progressive;
+						Frame.p_data = Pixels.GetData();
+						Frame.line_stride_in_bytes = Stride;
+					}
+
+					NDIlib_video_frame_v2_t ReferenceFrame;
+					Reference.Process(Frame, ReferenceFrame);
+
+					for (int32 Set = (int32)NdiMediaVideo::EInstructionSet::Simd; Set <= (int32)BestInstructionSet; ++Set)
+					{
+						NDIlib_video_frame_v2_t CandidateFrame;
+
+						Candidate.SetInstructionSet((NdiMediaVideo::EInstructionSet)Set);
+						Candidate.Process(Frame, CandidateFrame);
+						++NumTests;
+
+						if (FMemory::Memcmp(ReferenceFrame.p_data, CandidateFrame.p_data, Width * 4 * Rows) != 0)
+						{
+							UE_LOG(LogNdiMedia, Error, TEXT("%s conversion of %s (%i pixels, %s) differs from the scalar reference"),
+								NdiMediaVideo::GetInstructionSetName((NdiMediaVideo::EInstructionSet)Set),
+								*FNdiMediaVideoFormat::GetFourCCName(FourCC),
+								Width,
+								*Candidate.GetMatrixName()
+							);
+
+							++NumFailures;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	UE_LOG(LogNdiMedia, Display, TEXT("Color conversion verification: %i of %i tests passed (best instruction set: %s)"),
+		NumTests - NumFailures,
+		NumTests,
+		NdiMediaVideo::GetInstructionSetName(BestInstructionSet)
+	);
+}
+
+
+static FAutoConsoleCommand VerifyColorConversionCommand(
+	TEXT("NdiMedia.VerifyColorConversion"),
+	TEXT("Compare the SIMD color conversion kernels with the scalar reference implementation"),
+	FConsoleCommandDelegate::CreateStatic(&VerifyColorConversion)
+);
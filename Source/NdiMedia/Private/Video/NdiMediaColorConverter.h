@@ -0,0 +1,162 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NdiMediaSource.h"
+#include "NdiMediaStageStats.h"
+#include "NdiMediaVideoKernels.h"
+
+
+struct NDIlib_video_frame_v2_t;
+
+
+/**
+ * Converts NDI video frames that texture sinks can't accept into a format they can.
+ *
+ * UYVA frames (a UYVY plane followed by an 8-bit alpha plane) are unpacked to
+ * BGRA, so that keyed sources can be received at 3 bytes per pixel instead of
+ * having the NDI runtime decode them to BGRA. The unpacked frames are uploaded
+ * at 4 bytes per pixel like any other BGRA frame. RGBA and RGBX frames are swizzled
+ * to BGRA and BGRX, because texture sinks have no 8-bit RGBA format. UYVY frames
+ * are converted to BGRA if CPU conversion is enabled, which gives control over
+ * the color matrix and range.
+ *
+ * Output frames are written to an internal buffer that is reused for all frames,
+ * and the rows of each frame are processed in parallel on task graph worker threads.
+ */
+class FNdiMediaColorConverter
+{
+public:
+
+	/** Default constructor. */
+	FNdiMediaColorConverter();
+
+public:
+
+	/**
+	 * Check whether YUV frames are converted to BGRA.
+	 *
+	 * @return true if YUV frames are converted, false if they are uploaded as is.
+	 * @see SetYuvConversion
+	 */
+	bool ConvertsYuv() const
+	{
+		return (YuvConversion != ENdiMediaYuvConversion::Sink);
+	}
+
+	/**
+	 * Get the instruction set used by the conversion kernels.
+	 *
+	 * @return Instruction set.
+	 * @see SetInstructionSet
+	 */
+	NdiMediaVideo::EInstructionSet GetInstructionSet() const
+	{
+		return InstructionSet;
+	}
+
+	/**
+	 * Get the display name of the color matrix used for the most recent YUV frame.
+	 *
+	 * @return Matrix name.
+	 */
+	FString GetMatrixName() const;
+
+	/**
+	 * Get the processing statistics.
+	 *
+	 * @return Statistics.
+	 */
+	const FNdiMediaStageStats& GetStats() const
+	{
+		return Stats;
+	}
+
+	/**
+	 * Check whether the given frame needs to be converted before it can be uploaded.
+	 *
+	 * @param Frame The frame to check.
+	 * @return true if the frame needs conversion, false otherwise.
+	 * @see Process
+	 */
+	bool NeedsConversion(const NDIlib_video_frame_v2_t& Frame) const;
+
+	/**
+	 * Convert a video frame.
+	 *
+	 * The output frame is a copy of the input frame's description that references
+	 * the converter's buffer, which remains valid until the next call to Process.
+	 *
+	 * @param InFrame The frame to convert.
+	 * @param OutFrame Will contain the converted frame.
+	 * @return true if the frame was converted, false if its format is not supported.
+	 * @see NeedsConversion
+	 */
+	bool Process(const NDIlib_video_frame_v2_t& InFrame, NDIlib_video_frame_v2_t& OutFrame);
+
+	/** Reset the statistics and forget the source's color matrix. */
+	void Reset();
+
+	/**
+	 * Set the instruction set used by the conversion kernels.
+	 *
+	 * @param InInstructionSet The instruction set (must be supported by the CPU).
+	 * @see GetInstructionSet, NdiMediaVideo::GetBestInstructionSet
+	 */
+	void SetInstructionSet(NdiMediaVideo::EInstructionSet InInstructionSet)
+	{
+		InstructionSet = InInstructionSet;
+	}
+
+	/**
+	 * Set how YUV frames are converted.
+	 *
+	 * @param InConversion The conversion to use.
+	 * @param InRange The value range of the frames.
+	 * @see ConvertsYuv
+	 */
+	void SetYuvConversion(ENdiMediaYuvConversion InConversion, ENdiMediaYuvRange InRange);
+
+protected:
+
+	/**
+	 * Select the color matrix for a YUV frame.
+	 *
+	 * @param Frame The frame to convert.
+	 * @return The color matrix.
+	 */
+	const NdiMediaVideo::FYuvToRgbMatrix& SelectMatrix(const NDIlib_video_frame_v2_t& Frame);
+
+	/** Swap the red and blue channels of an RGBA or RGBX frame into the buffer. */
+	void SwizzleRgba(const NDIlib_video_frame_v2_t& Frame);
+
+	/** Convert a UYVY or UYVA frame into the buffer. */
+	void UnpackYuv(const NDIlib_video_frame_v2_t& Frame);
+
+	/** Update the source's color matrix from the given frame metadata. */
+	void UpdateSourceMatrix(const char* Metadata);
+
+private:
+
+	/** Buffer holding the output frame. */
+	TArray<uint8> Buffer;
+
+	/** Whether YUV frames use the full value range. */
+	bool FullRange;
+
+	/** The instruction set used by the conversion kernels. */
+	NdiMediaVideo::EInstructionSet InstructionSet;
+
+	/** Whether the most recent YUV frame was converted with BT.709 (true) or BT.601 (false). */
+	bool LastBt709;
+
+	/** The color matrix announced in the source's metadata (Auto = unknown). */
+	ENdiMediaYuvConversion SourceMatrix;
+
+	/** Processing statistics. */
+	FNdiMediaStageStats Stats;
+
+	/** How YUV frames are converted. */
+	ENdiMediaYuvConversion YuvConversion;
+};
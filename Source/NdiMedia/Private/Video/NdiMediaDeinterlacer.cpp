@@ -0,0 +1,264 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaDeinterlacer.h"
+#include "NdiMediaPrivate.h"
+
+#include "Async/ParallelFor.h"
+#include "NdiMediaVideoKernels.h"
+
+
+DECLARE_CYCLE_STAT(TEXT("Deinterlace"), STAT_NdiMedia_Deinterlace, STATGROUP_NdiMedia);
+
+
+/* FNdiMediaDeinterlacer structors
+ *****************************************************************************/
+
+FNdiMediaDeinterlacer::FNdiMediaDeinterlacer()
+	: HasFirstField(false)
+	, FirstFieldDim(FIntPoint::ZeroValue)
+	, FirstFieldStride(0)
+	, FirstFieldTimecode(0)
+	, FirstFieldTimestamp(0)
+	, Mode(ENdiMediaDeinterlaceMode::Weave)
+{ }
+
+
+/* FNdiMediaDeinterlacer interface
+ *****************************************************************************/
+
+int32 FNdiMediaDeinterlacer::GetOutputHeight(const NDIlib_video_frame_v2_t& Frame)
+{
+	if ((Frame.frame_format_type == NDIlib_frame_format_type_field_0) ||
+		(Frame.frame_format_type == NDIlib_frame_format_type_field_1))
+	{
+		return Frame.yres * 2;
+	}
+
+	return Frame.yres;
+}
+
+
+bool FNdiMediaDeinterlacer::Process(const NDIlib_video_frame_v2_t& InFrame, NDIlib_video_frame_v2_t& OutFrame)
+{
+	if ((InFrame.p_data == nullptr) || (InFrame.yres <= 0) || (InFrame.line_stride_in_bytes <= 0))
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NdiMedia_Deinterlace);
+	FNdiMediaStageScope StageScope(Stats);
+
+	OutFrame = InFrame;
+	OutFrame.frame_format_type = NDIlib_frame_format_type_progressive;
+
+	// interleaved frames
+	if (InFrame.frame_format_type == NDIlib_frame_format_type_interleaved)
+	{
+		if (Mode == ENdiMediaDeinterlaceMode::Weave)
+		{
+			return true; // already woven
+		}
+
+		ProcessInterleaved(InFrame);
+		OutFrame.p_data = Buffer.GetData();
+
+		return true;
+	}
+
+	// fields
+	const bool SecondField = (InFrame.frame_format_type == NDIlib_frame_format_type_field_1);
+
+	if (!SecondField && (InFrame.frame_format_type != NDIlib_frame_format_type_field_0))
+	{
+		return true; // progressive
+	}
+
+	OutFrame.yres = InFrame.yres * 2;
+
+	if (Mode == ENdiMediaDeinterlaceMode::Weave)
+	{
+		if (!SecondField)
+		{
+			WeaveField(InFrame, false);
+
+			HasFirstField = true;
+			FirstFieldDim = FIntPoint(InFrame.xres, InFrame.yres);
+			FirstFieldStride = InFrame.line_stride_in_bytes;
+			FirstFieldTimecode = InFrame.timecode;
+			FirstFieldTimestamp = InFrame.timestamp;
+
+			return false;
+		}
+
+		// second field must match the first one
+		if (!HasFirstField ||
+			(FirstFieldDim != FIntPoint(InFrame.xres, InFrame.yres)) ||
+			(FirstFieldStride != InFrame.line_stride_in_bytes))
+		{
+			HasFirstField = false;
+
+			return false;
+		}
+
+		WeaveField(InFrame, true);
+		HasFirstField = false;
+
+		OutFrame.timecode = FirstFieldTimecode;
+		OutFrame.timestamp = FirstFieldTimestamp;
+	}
+	else
+	{
+		ProcessField(InFrame, SecondField);
+
+		// each field produces a frame
+		OutFrame.frame_rate_N = InFrame.frame_rate_N * 2;
+	}
+
+	OutFrame.p_data = Buffer.GetData();
+
+	return true;
+}
+
+
+void FNdiMediaDeinterlacer::Reset()
+{
+	HasFirstField = false;
+	Stats.Reset();
+}
+
+
+void FNdiMediaDeinterlacer::SetMode(ENdiMediaDeinterlaceMode InMode)
+{
+	if (InMode != Mode)
+	{
+		Mode = InMode;
+		HasFirstField = false;
+	}
+}
+
+
+/* FNdiMediaDeinterlacer implementation
+ *****************************************************************************/
+
+void FNdiMediaDeinterlacer::ProcessField(const NDIlib_video_frame_v2_t& Field, bool SecondField)
+{
+	const int32 Stride = Field.line_stride_in_bytes;
+	const int32 FieldRows = Field.yres;
+	const int32 FrameRows = FieldRows * 2;
+	const int32 Parity = SecondField ? 1 : 0;
+	const bool Blend = (Mode == ENdiMediaDeinterlaceMode::Blend);
+
+	Buffer.SetNumUninitialized(Stride * FrameRows, false);
+
+	const uint8* Src = Field.p_data;
+	uint8* Dest = Buffer.GetData();
+
+	int32 RowsPerBand = 0;
+	const int32 NumBands = NdiMediaVideo::GetNumRowBands(FrameRows, RowsPerBand);
+
+	ParallelFor(NumBands, [=](int32 BandIndex)
+	{
+		const int32 FirstRow = BandIndex * RowsPerBand;
+		const int32 LastRow = FMath::Min(FirstRow + RowsPerBand, FrameRows);
+
+		for (int32 Row = FirstRow; Row < LastRow; ++Row)
+		{
+			uint8* DestRow = Dest + Row * Stride;
+
+			// rows that belong to this field are copied as is
+			if (((Row - Parity) & 1) == 0)
+			{
+				FMemory::Memcpy(DestRow, Src + ((Row - Parity) / 2) * Stride, Stride);
+				continue;
+			}
+
+			// field rows above and below the missing row
+			const int32 Above = (Row - Parity - 1) / 2;
+			const int32 Below = Above + 1;
+
+			if (Row < Parity)
+			{
+				FMemory::Memcpy(DestRow, Src, Stride);
+			}
+			else if (!Blend || (Below >= FieldRows))
+			{
+				FMemory::Memcpy(DestRow, Src + Above * Stride, Stride);
+			}
+			else
+			{
+				NdiMediaVideo::AverageRows(DestRow, Src + Above * Stride, Src + Below * Stride, Stride);
+			}
+		}
+	});
+}
+
+
+void FNdiMediaDeinterlacer::ProcessInterleaved(const NDIlib_video_frame_v2_t& Frame)
+{
+	const int32 Stride = Frame.line_stride_in_bytes;
+	const int32 Rows = Frame.yres;
+	const bool Blend = (Mode == ENdiMediaDeinterlaceMode::Blend);
+
+	Buffer.SetNumUninitialized(Stride * Rows, false);
+
+	const uint8* Src = Frame.p_data;
+	uint8* Dest = Buffer.GetData();
+
+	int32 RowsPerBand = 0;
+	const int32 NumBands = NdiMediaVideo::GetNumRowBands(Rows, RowsPerBand);
+
+	ParallelFor(NumBands, [=](int32 BandIndex)
+	{
+		const int32 FirstRow = BandIndex * RowsPerBand;
+		const int32 LastRow = FMath::Min(FirstRow + RowsPerBand, Rows);
+
+		for (int32 Row = FirstRow; Row < LastRow; ++Row)
+		{
+			uint8* DestRow = Dest + Row * Stride;
+
+			if (Blend)
+			{
+				// blend each row with the row below, which belongs to the other field
+				if (Row + 1 < Rows)
+				{
+					NdiMediaVideo::AverageRows(DestRow, Src + Row * Stride, Src + (Row + 1) * Stride, Stride);
+				}
+				else
+				{
+					FMemory::Memcpy(DestRow, Src + Row * Stride, Stride);
+				}
+			}
+			else
+			{
+				// line-double the first field
+				FMemory::Memcpy(DestRow, Src + (Row & ~1) * Stride, Stride);
+			}
+		}
+	});
+}
+
+
+void FNdiMediaDeinterlacer::WeaveField(const NDIlib_video_frame_v2_t& Field, bool SecondField)
+{
+	const int32 Stride = Field.line_stride_in_bytes;
+	const int32 FieldRows = Field.yres;
+
+	Buffer.SetNumUninitialized(Stride * FieldRows * 2, false);
+
+	const uint8* Src = Field.p_data;
+	uint8* Dest = Buffer.GetData() + (SecondField ? Stride : 0);
+
+	int32 RowsPerBand = 0;
+	const int32 NumBands = NdiMediaVideo::GetNumRowBands(FieldRows, RowsPerBand);
+
+	ParallelFor(NumBands, [=](int32 BandIndex)
+	{
+		const int32 FirstRow = BandIndex * RowsPerBand;
+		const int32 LastRow = FMath::Min(FirstRow + RowsPerBand, FieldRows);
+
+		for (int32 Row = FirstRow; Row < LastRow; ++Row)
+		{
+			FMemory::Memcpy(Dest + Row * 2 * Stride, Src + Row * Stride, Stride);
+		}
+	});
+}
@@ -0,0 +1,117 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NdiMediaSource.h"
+#include "NdiMediaStageStats.h"
+
+
+struct NDIlib_video_frame_v2_t;
+
+
+/**
+ * Converts fielded and interleaved NDI video frames into progressive frames.
+ *
+ * Output frames are written to an internal buffer that is reused for all frames,
+ * and the rows of each frame are processed in parallel on task graph worker threads.
+ */
+class FNdiMediaDeinterlacer
+{
+public:
+
+	/** Default constructor. */
+	FNdiMediaDeinterlacer();
+
+public:
+
+	/**
+	 * Get the current deinterlacing mode.
+	 *
+	 * @return Deinterlacing mode.
+	 * @see SetMode
+	 */
+	ENdiMediaDeinterlaceMode GetMode() const
+	{
+		return Mode;
+	}
+
+	/**
+	 * Get the height of the progressive frame that the given frame will produce.
+	 *
+	 * @param Frame The frame to check.
+	 * @return Output height (in pixels).
+	 */
+	static int32 GetOutputHeight(const NDIlib_video_frame_v2_t& Frame);
+
+	/**
+	 * Get the processing statistics.
+	 *
+	 * @return Statistics.
+	 */
+	const FNdiMediaStageStats& GetStats() const
+	{
+		return Stats;
+	}
+
+	/**
+	 * Process a fielded or interleaved video frame.
+	 *
+	 * The output frame is a copy of the input frame's description that references
+	 * either the input frame's data or the deinterlacer's buffer. The latter remains
+	 * valid until the next call to Process or Reset.
+	 *
+	 * @param InFrame The frame to process.
+	 * @param OutFrame Will contain the progressive frame.
+	 * @return true if a frame was produced, false if more fields are needed.
+	 */
+	bool Process(const NDIlib_video_frame_v2_t& InFrame, NDIlib_video_frame_v2_t& OutFrame);
+
+	/** Discard pending fields and statistics. */
+	void Reset();
+
+	/**
+	 * Set the deinterlacing mode.
+	 *
+	 * @param InMode The mode to set.
+	 * @see GetMode
+	 */
+	void SetMode(ENdiMediaDeinterlaceMode InMode);
+
+protected:
+
+	/** Deinterlace a single field into the buffer. */
+	void ProcessField(const NDIlib_video_frame_v2_t& Field, bool SecondField);
+
+	/** Deinterlace an interleaved frame into the buffer. */
+	void ProcessInterleaved(const NDIlib_video_frame_v2_t& Frame);
+
+	/** Weave a single field into the buffer. */
+	void WeaveField(const NDIlib_video_frame_v2_t& Field, bool SecondField);
+
+private:
+
+	/** Buffer holding the output frame. */
+	TArray<uint8> Buffer;
+
+	/** Whether the buffer holds the first field of a frame (weave mode only). */
+	bool HasFirstField;
+
+	/** Dimensions of the pending first field (weave mode only). */
+	FIntPoint FirstFieldDim;
+
+	/** Line stride of the pending first field (weave mode only). */
+	int32 FirstFieldStride;
+
+	/** Timecode of the pending first field (weave mode only). */
+	int64 FirstFieldTimecode;
+
+	/** Timestamp of the pending first field (weave mode only). */
+	int64 FirstFieldTimestamp;
+
+	/** The current deinterlacing mode. */
+	ENdiMediaDeinterlaceMode Mode;
+
+	/** Processing statistics. */
+	FNdiMediaStageStats Stats;
+};
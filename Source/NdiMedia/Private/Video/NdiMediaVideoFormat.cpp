@@ -0,0 +1,78 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaVideoFormat.h"
+#include "NdiMediaPrivate.h"
+
+
+/* FNdiMediaVideoFormat interface
+ *****************************************************************************/
+
+bool FNdiMediaVideoFormat::Initialize(const NDIlib_video_frame_v2_t& Frame, int32 OutputHeight, bool ConvertYuv)
+{
+	int32 PixelsPerTexel = 1;
+
+	switch (Frame.FourCC)
+	{
+	case NDIlib_FourCC_type_BGRA:
+	case NDIlib_FourCC_type_BGRX:
+	case NDIlib_FourCC_type_RGBA: // swizzled to BGRA by FNdiMediaColorConverter
+	case NDIlib_FourCC_type_RGBX: // swizzled to BGRX by FNdiMediaColorConverter
+	case NDIlib_FourCC_type_UYVA: // unpacked to BGRA by FNdiMediaColorConverter
+		SinkFormat = EMediaTextureSinkFormat::CharBGRA;
+		break;
+
+	case NDIlib_FourCC_type_UYVY:
+		if (ConvertYuv)
+		{
+			SinkFormat = EMediaTextureSinkFormat::CharBGRA;
+		}
+		else
+		{
+			PixelsPerTexel = 2;
+			SinkFormat = EMediaTextureSinkFormat::CharUYVY;
+		}
+		break;
+
+	default:
+		return false;
+	}
+
+	FourCC = Frame.FourCC;
+	OutputDim = FIntPoint(Frame.xres, OutputHeight);
+	BufferDim = FIntPoint((Frame.xres + PixelsPerTexel - 1) / PixelsPerTexel, OutputHeight);
+
+	// an aspect ratio of zero means square pixels
+	if (Frame.picture_aspect_ratio > 0.0f)
+	{
+		AspectRatio = Frame.picture_aspect_ratio;
+	}
+	else
+	{
+		AspectRatio = (OutputHeight > 0) ? ((float)Frame.xres / OutputHeight) : 0.0f;
+	}
+
+	return true;
+}
+
+
+/* FNdiMediaVideoFormat static functions
+ *****************************************************************************/
+
+FString FNdiMediaVideoFormat::GetFourCCName(uint32 FourCC)
+{
+	if (FourCC == 0)
+	{
+		return TEXT("None");
+	}
+
+	TCHAR Name[5];
+	{
+		Name[0] = (TCHAR)(FourCC & 0xff);
+		Name[1] = (TCHAR)((FourCC >> 8) & 0xff);
+		Name[2] = (TCHAR)((FourCC >> 16) & 0xff);
+		Name[3] = (TCHAR)((FourCC >> 24) & 0xff);
+		Name[4] = TEXT('\0');
+	}
+
+	return FString(Name);
+}
@@ -0,0 +1,108 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IMediaTextureSink.h"
+
+
+struct NDIlib_video_frame_v2_t;
+
+
+/**
+ * Describes how the pixels of an NDI video frame are uploaded to a texture sink.
+ *
+ * Texture sink buffers use 32-bit texels. Packed RGB formats store one pixel per
+ * texel, while UYVY stores two pixels (one macro-pixel) per texel, so the buffer
+ * width depends on the frame's FourCC rather than its line stride.
+ */
+struct FNdiMediaVideoFormat
+{
+	/** Picture aspect ratio (width / height). */
+	float AspectRatio;
+
+	/** Dimensions of the texture sink buffer (in texels). */
+	FIntPoint BufferDim;
+
+	/** The frame's FourCC code. */
+	uint32 FourCC;
+
+	/** Dimensions of the output (in pixels). */
+	FIntPoint OutputDim;
+
+	/** The texture sink format that the frame's pixels are uploaded in. */
+	EMediaTextureSinkFormat SinkFormat;
+
+public:
+
+	/** Default constructor. */
+	FNdiMediaVideoFormat()
+		: AspectRatio(0.0f)
+		, BufferDim(FIntPoint::ZeroValue)
+		, FourCC(0)
+		, OutputDim(FIntPoint::ZeroValue)
+		, SinkFormat(EMediaTextureSinkFormat::CharUYVY)
+	{ }
+
+public:
+
+	/**
+	 * Check whether a texture sink initialized with the given format can receive frames in this format.
+	 *
+	 * Only the sink format and dimensions matter; the FourCC, aspect ratio and
+	 * line stride may change without reinitializing the sink.
+	 *
+	 * @param Other The format the sink was initialized with.
+	 * @return true if the sink can be reused, false otherwise.
+	 */
+	bool IsSinkCompatible(const FNdiMediaVideoFormat& Other) const
+	{
+		return (SinkFormat == Other.SinkFormat) && (OutputDim == Other.OutputDim) && (BufferDim == Other.BufferDim);
+	}
+
+	/**
+	 * Initialize the format from a received video frame.
+	 *
+	 * @param Frame The video frame.
+	 * @param OutputHeight Height of the progressive frame that will be uploaded (in pixels).
+	 * @param ConvertYuv Whether YUV frames are converted to BGRA before they are uploaded.
+	 * @return true on success, false if the frame's FourCC is not supported.
+	 * @see GetMinStride
+	 */
+	bool Initialize(const NDIlib_video_frame_v2_t& Frame, int32 OutputHeight, bool ConvertYuv);
+
+	/**
+	 * Get the minimum line stride that a frame in this format must have.
+	 *
+	 * @return Line stride (in bytes).
+	 */
+	int32 GetMinStride() const
+	{
+		return BufferDim.X * 4;
+	}
+
+	/**
+	 * Change the output dimensions, i.e. because frames are resized before they are uploaded.
+	 *
+	 * The aspect ratio is not changed.
+	 *
+	 * @param InOutputDim The new output dimensions (in pixels).
+	 */
+	void SetOutputDim(const FIntPoint& InOutputDim)
+	{
+		const int32 PixelsPerTexel = (SinkFormat == EMediaTextureSinkFormat::CharUYVY) ? 2 : 1;
+
+		OutputDim = InOutputDim;
+		BufferDim = FIntPoint((InOutputDim.X + PixelsPerTexel - 1) / PixelsPerTexel, InOutputDim.Y);
+	}
+
+public:
+
+	/**
+	 * Get the printable name of a FourCC code.
+	 *
+	 * @param FourCC The FourCC code.
+	 * @return Name string.
+	 */
+	static FString GetFourCCName(uint32 FourCC);
+};
@@ -0,0 +1,520 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaVideoKernels.h"
+#include "NdiMediaSimd.h"
+
+#if NDIMEDIA_SIMD_AVX2
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+
+namespace NdiMediaVideo
+{
+	/** Full range BT.601 coefficients. */
+	static const FYuvToRgbMatrix Bt601Full = { 64, 0, 90, -22, -46, 113 };
+
+	/** Limited range BT.601 coefficients. */
+	static const FYuvToRgbMatrix Bt601Limited = { 75, 16, 102, -25, -52, 129 };
+
+	/** Full range BT.709 coefficients. */
+	static const FYuvToRgbMatrix Bt709Full = { 64, 0, 101, -12, -30, 119 };
+
+	/** Limited range BT.709 coefficients. */
+	static const FYuvToRgbMatrix Bt709Limited = { 75, 16, 115, -14, -34, 135 };
+
+
+	/** Add two values with signed 16-bit saturation. */
+	FORCEINLINE int32 SaturatingAdd16(int32 A, int32 B)
+	{
+		return FMath::Clamp(A + B, -32768, 32767);
+	}
+
+
+	/** Scale a fixed-point channel value back to 8 bits. */
+	FORCEINLINE uint8 FixedToChannel(int32 Value)
+	{
+		return (uint8)FMath::Clamp(Value >> YuvToRgbShift, 0, 255);
+	}
+
+
+	/** Convert a single pixel from YCbCr to BGRA (scalar reference for the SIMD kernels). */
+	FORCEINLINE void YuvPixelToBgra(uint8* Dest, int32 Y, int32 U, int32 V, uint8 Alpha, const FYuvToRgbMatrix& Matrix)
+	{
+		const int32 Yr = (Y - Matrix.YOffset) * Matrix.YScale + (1 << (YuvToRgbShift - 1));
+
+		Dest[0] = FixedToChannel(SaturatingAdd16(Yr, U * Matrix.BU));
+		Dest[1] = FixedToChannel(SaturatingAdd16(SaturatingAdd16(Yr, U * Matrix.GU), V * Matrix.GV));
+		Dest[2] = FixedToChannel(SaturatingAdd16(Yr, V * Matrix.RV));
+		Dest[3] = Alpha;
+	}
+
+
+	void AverageRows(uint8* Dest, const uint8* RowA, const uint8* RowB, int32 NumBytes)
+	{
+		int32 Index = 0;
+
+#if NDIMEDIA_SIMD_SSE2
+		for (; Index + 16 <= NumBytes; Index += 16)
+		{
+			const __m128i A = _mm_loadu_si128((const __m128i*)(RowA + Index));
+			const __m128i B = _mm_loadu_si128((const __m128i*)(RowB + Index));
+			_mm_storeu_si128((__m128i*)(Dest + Index), _mm_avg_epu8(A, B));
+		}
+#elif NDIMEDIA_SIMD_NEON
+		for (; Index + 16 <= NumBytes; Index += 16)
+		{
+			vst1q_u8(Dest + Index, vrhaddq_u8(vld1q_u8(RowA + Index), vld1q_u8(RowB + Index)));
+		}
+#endif
+
+		for (; Index < NumBytes; ++Index)
+		{
+			Dest[Index] = (uint8)((RowA[Index] + RowB[Index] + 1) >> 1);
+		}
+	}
+
+
+	int32 GetNumRowBands(int32 NumRows, int32& OutRowsPerBand)
+	{
+		// bands should be large enough to amortize the scheduling cost
+		OutRowsPerBand = 64;
+
+		return (NumRows + OutRowsPerBand - 1) / OutRowsPerBand;
+	}
+
+
+	void HalveRows32(uint8* Dest, const uint8* RowA, const uint8* RowB, int32 DestWidth)
+	{
+		int32 X = 0;
+
+#if NDIMEDIA_SIMD_SSE2
+		// 4 output pixels per iteration
+		for (; X + 4 <= DestWidth; X += 4)
+		{
+			const __m128i Low = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(RowA + X * 8)), _mm_loadu_si128((const __m128i*)(RowB + X * 8)));
+			const __m128i High = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(RowA + X * 8 + 16)), _mm_loadu_si128((const __m128i*)(RowB + X * 8 + 16)));
+			const __m128i Even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(Low), _mm_castsi128_ps(High), _MM_SHUFFLE(2, 0, 2, 0)));
+			const __m128i Odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(Low), _mm_castsi128_ps(High), _MM_SHUFFLE(3, 1, 3, 1)));
+
+			_mm_storeu_si128((__m128i*)(Dest + X * 4), _mm_avg_epu8(Even, Odd));
+		}
+#elif NDIMEDIA_SIMD_NEON
+		// 4 output pixels per iteration
+		for (; X + 4 <= DestWidth; X += 4)
+		{
+			const uint32x4x2_t A = vld2q_u32((const uint32_t*)(RowA + X * 8));
+			const uint32x4x2_t B = vld2q_u32((const uint32_t*)(RowB + X * 8));
+			const uint8x16_t Even = vrhaddq_u8(vreinterpretq_u8_u32(A.val[0]), vreinterpretq_u8_u32(B.val[0]));
+			const uint8x16_t Odd = vrhaddq_u8(vreinterpretq_u8_u32(A.val[1]), vreinterpretq_u8_u32(B.val[1]));
+
+			vst1q_u8(Dest + X * 4, vrhaddq_u8(Even, Odd));
+		}
+#endif
+
+		for (; X < DestWidth; ++X)
+		{
+			const uint8* A = RowA + X * 8;
+			const uint8* B = RowB + X * 8;
+
+			for (int32 Channel = 0; Channel < 4; ++Channel)
+			{
+				const int32 Even = (A[Channel] + B[Channel] + 1) >> 1;
+				const int32 Odd = (A[Channel + 4] + B[Channel + 4] + 1) >> 1;
+
+				Dest[X * 4 + Channel] = (uint8)((Even + Odd + 1) >> 1);
+			}
+		}
+	}
+
+
+	void HalveRowsUyvy(uint8* Dest, const uint8* RowA, const uint8* RowB, int32 DestWidth)
+	{
+		// each output macro-pixel is made from an even (A) and an odd (B) input macro-pixel:
+		// U = avg(Ua, Ub), Y0 = avg(Y0a, Y1a), V = avg(Va, Vb), Y1 = avg(Y0b, Y1b)
+		const int32 DestMacros = DestWidth / 2;
+		int32 X = 0;
+
+#if NDIMEDIA_SIMD_SSE2
+		const __m128i ChromaMask = _mm_set1_epi32(0x00ff00ff);
+		const __m128i LumaMaskA = _mm_set1_epi32(0x0000ff00);
+		const __m128i LumaMaskB = _mm_set1_epi32((int32)0xff000000);
+
+		// 4 output macro-pixels per iteration
+		for (; X + 4 <= DestMacros; X += 4)
+		{
+			const __m128i Low = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(RowA + X * 8)), _mm_loadu_si128((const __m128i*)(RowB + X * 8)));
+			const __m128i High = _mm_avg_epu8(_mm_loadu_si128((const __m128i*)(RowA + X * 8 + 16)), _mm_loadu_si128((const __m128i*)(RowB + X * 8 + 16)));
+			const __m128i Even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(Low), _mm_castsi128_ps(High), _MM_SHUFFLE(2, 0, 2, 0)));
+			const __m128i Odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(Low), _mm_castsi128_ps(High), _MM_SHUFFLE(3, 1, 3, 1)));
+
+			// align Y1 with Y0 within each macro-pixel to average the luma pairs
+			const __m128i Chroma = _mm_and_si128(_mm_avg_epu8(Even, Odd), ChromaMask);
+			const __m128i LumaA = _mm_and_si128(_mm_avg_epu8(Even, _mm_srli_epi32(Even, 16)), LumaMaskA);
+			const __m128i LumaB = _mm_and_si128(_mm_avg_epu8(Odd, _mm_slli_epi32(Odd, 16)), LumaMaskB);
+
+			_mm_storeu_si128((__m128i*)(Dest + X * 4), _mm_or_si128(Chroma, _mm_or_si128(LumaA, LumaB)));
+		}
+#elif NDIMEDIA_SIMD_NEON
+		const uint8x16_t ChromaMask = vreinterpretq_u8_u32(vdupq_n_u32(0x00ff00ff));
+		const uint8x16_t LumaMaskA = vreinterpretq_u8_u32(vdupq_n_u32(0x0000ff00));
+
+		// 4 output macro-pixels per iteration
+		for (; X + 4 <= DestMacros; X += 4)
+		{
+			const uint32x4x2_t A = vld2q_u32((const uint32_t*)(RowA + X * 8));
+			const uint32x4x2_t B = vld2q_u32((const uint32_t*)(RowB + X * 8));
+			const uint32x4_t Even = vreinterpretq_u32_u8(vrhaddq_u8(vreinterpretq_u8_u32(A.val[0]), vreinterpretq_u8_u32(B.val[0])));
+			const uint32x4_t Odd = vreinterpretq_u32_u8(vrhaddq_u8(vreinterpretq_u8_u32(A.val[1]), vreinterpretq_u8_u32(B.val[1])));
+
+			// align Y1 with Y0 within each macro-pixel to average the luma pairs
+			const uint8x16_t Chroma = vrhaddq_u8(vreinterpretq_u8_u32(Even), vreinterpretq_u8_u32(Odd));
+			const uint8x16_t LumaA = vrhaddq_u8(vreinterpretq_u8_u32(Even), vreinterpretq_u8_u32(vshrq_n_u32(Even, 16)));
+			const uint8x16_t LumaB = vrhaddq_u8(vreinterpretq_u8_u32(Odd), vreinterpretq_u8_u32(vshlq_n_u32(Odd, 16)));
+
+			vst1q_u8(Dest + X * 4, vbslq_u8(ChromaMask, Chroma, vbslq_u8(LumaMaskA, LumaA, LumaB)));
+		}
+#endif
+
+		for (; X < DestMacros; ++X)
+		{
+			uint8 Even[4];
+			uint8 Odd[4];
+
+			for (int32 Channel = 0; Channel < 4; ++Channel)
+			{
+				Even[Channel] = (uint8)((RowA[X * 8 + Channel] + RowB[X * 8 + Channel] + 1) >> 1);
+				Odd[Channel] = (uint8)((RowA[X * 8 + Channel + 4] + RowB[X * 8 + Channel + 4] + 1) >> 1);
+			}
+
+			uint8* Macro = Dest + X * 4;
+
+			Macro[0] = (uint8)((Even[0] + Odd[0] + 1) >> 1);
+			Macro[1] = (uint8)((Even[1] + Even[3] + 1) >> 1);
+			Macro[2] = (uint8)((Even[2] + Odd[2] + 1) >> 1);
+			Macro[3] = (uint8)((Odd[1] + Odd[3] + 1) >> 1);
+		}
+	}
+
+
+	void SwapRedBlueRow(uint8* Dest, const uint8* Src, int32 Width)
+	{
+		int32 X = 0;
+
+#if NDIMEDIA_SIMD_SSE2
+		const __m128i GreenAlphaMask = _mm_set1_epi32((int32)0xff00ff00);
+		const __m128i LowMask = _mm_set1_epi32(0x000000ff);
+
+		// 4 pixels per iteration
+		for (; X + 4 <= Width; X += 4)
+		{
+			const __m128i Pixels = _mm_loadu_si128((const __m128i*)(Src + X * 4));
+			const __m128i Low = _mm_and_si128(_mm_srli_epi32(Pixels, 16), LowMask);
+			const __m128i High = _mm_slli_epi32(_mm_and_si128(Pixels, LowMask), 16);
+
+			_mm_storeu_si128((__m128i*)(Dest + X * 4), _mm_or_si128(_mm_and_si128(Pixels, GreenAlphaMask), _mm_or_si128(Low, High)));
+		}
+#elif NDIMEDIA_SIMD_NEON
+		// 16 pixels per iteration
+		for (; X + 16 <= Width; X += 16)
+		{
+			uint8x16x4_t Pixels = vld4q_u8(Src + X * 4);
+			const uint8x16_t Red = Pixels.val[0];
+
+			Pixels.val[0] = Pixels.val[2];
+			Pixels.val[2] = Red;
+
+			vst4q_u8(Dest + X * 4, Pixels);
+		}
+#endif
+
+		for (; X < Width; ++X)
+		{
+			const uint8 Red = Src[X * 4];
+
+			Dest[X * 4] = Src[X * 4 + 2];
+			Dest[X * 4 + 1] = Src[X * 4 + 1];
+			Dest[X * 4 + 2] = Red;
+			Dest[X * 4 + 3] = Src[X * 4 + 3];
+		}
+	}
+
+
+#if NDIMEDIA_SIMD_AVX2
+	/** Check whether the CPU and operating system support AVX2. */
+	static bool DetectAvx2()
+	{
+		int32 Info[4];
+
+		auto CpuId = [&Info](int32 Leaf)
+		{
+#if defined(_MSC_VER)
+			__cpuidex(Info, Leaf, 0);
+#else
+			__cpuid_count(Leaf, 0, Info[0], Info[1], Info[2], Info[3]);
+#endif
+		};
+
+		CpuId(0);
+
+		if (Info[0] < 7)
+		{
+			return false;
+		}
+
+		// AVX and OSXSAVE
+		CpuId(1);
+
+		if ((Info[2] & (1 << 27)) == 0 || (Info[2] & (1 << 28)) == 0)
+		{
+			return false;
+		}
+
+		// the operating system must preserve YMM registers
+#if defined(_MSC_VER)
+		const uint64 Xcr0 = _xgetbv(0);
+#else
+		uint32 Eax, Edx;
+		__asm__ volatile("xgetbv" : "=a"(Eax), "=d"(Edx) : "c"(0));
+		const uint64 Xcr0 = ((uint64)Edx << 32) | Eax;
+#endif
+
+		if ((Xcr0 & 0x6) != 0x6)
+		{
+			return false;
+		}
+
+		CpuId(7);
+
+		return ((Info[1] & (1 << 5)) != 0);
+	}
+
+
+	/** Convert blocks of 16 UYVY pixels to BGRA using AVX2, and return the number of pixels converted. */
+	template<bool HasAlpha>
+	NDIMEDIA_TARGET_AVX2 int32 UyvyRowToBgraAvx2(uint8* Dest, const uint8* Uyvy, const uint8* Alpha, int32 Width, const FYuvToRgbMatrix& Matrix)
+	{
+		const __m256i LowMask = _mm256_set1_epi16(0x00ff);
+		const __m256i Chroma = _mm256_set1_epi16(128);
+		const __m256i Opaque = _mm256_set1_epi16(255);
+		const __m256i Round = _mm256_set1_epi16(1 << (YuvToRgbShift - 1));
+		const __m256i YOffset = _mm256_set1_epi16(Matrix.YOffset);
+		const __m256i YScale = _mm256_set1_epi16(Matrix.YScale);
+		const __m256i RV = _mm256_set1_epi16(Matrix.RV);
+		const __m256i GU = _mm256_set1_epi16(Matrix.GU);
+		const __m256i GV = _mm256_set1_epi16(Matrix.GV);
+		const __m256i BU = _mm256_set1_epi16(Matrix.BU);
+
+		int32 X = 0;
+
+		// same as the SSE2 kernel, but on two 128-bit lanes of 8 pixels each
+		for (; X + 16 <= Width; X += 16)
+		{
+			const __m256i Src = _mm256_loadu_si256((const __m256i*)(Uyvy + X * 2));
+			const __m256i UV = _mm256_sub_epi16(_mm256_and_si256(Src, LowMask), Chroma);
+			const __m256i U = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(UV, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+			const __m256i V = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(UV, _MM_SHUFFLE(3, 3, 1, 1)), _MM_SHUFFLE(3, 3, 1, 1));
+			const __m256i Y = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(_mm256_srli_epi16(Src, 8), YOffset), YScale), Round);
+
+			const __m256i B = _mm256_srai_epi16(_mm256_adds_epi16(Y, _mm256_mullo_epi16(U, BU)), YuvToRgbShift);
+			const __m256i G = _mm256_srai_epi16(_mm256_adds_epi16(_mm256_adds_epi16(Y, _mm256_mullo_epi16(U, GU)), _mm256_mullo_epi16(V, GV)), YuvToRgbShift);
+			const __m256i R = _mm256_srai_epi16(_mm256_adds_epi16(Y, _mm256_mullo_epi16(V, RV)), YuvToRgbShift);
+			const __m256i A = HasAlpha ? _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(Alpha + X))) : Opaque;
+
+			const __m256i BR = _mm256_packus_epi16(B, R);
+			const __m256i GA = _mm256_packus_epi16(G, A);
+			const __m256i BG = _mm256_unpacklo_epi8(BR, GA);
+			const __m256i RA = _mm256_unpackhi_epi8(BR, GA);
+			const __m256i Low = _mm256_unpacklo_epi16(BG, RA);  // pixels 0-3, 8-11
+			const __m256i High = _mm256_unpackhi_epi16(BG, RA); // pixels 4-7, 12-15
+
+			_mm256_storeu_si256((__m256i*)(Dest + X * 4), _mm256_permute2x128_si256(Low, High, 0x20));
+			_mm256_storeu_si256((__m256i*)(Dest + X * 4 + 32), _mm256_permute2x128_si256(Low, High, 0x31));
+		}
+
+		return X;
+	}
+#endif
+
+
+	/** Convert a row of UYVY pixels to BGRA. */
+	template<bool HasAlpha>
+	void UyvyRowToBgraImpl(uint8* Dest, const uint8* Uyvy, const uint8* Alpha, int32 Width, const FYuvToRgbMatrix& Matrix, EInstructionSet InstructionSet)
+	{
+		int32 X = 0;
+
+#if NDIMEDIA_SIMD_AVX2
+		if (InstructionSet == EInstructionSet::Avx2)
+		{
+			X = UyvyRowToBgraAvx2<HasAlpha>(Dest, Uyvy, Alpha, Width, Matrix);
+		}
+#endif
+
+#if NDIMEDIA_SIMD_SSE2
+		if (InstructionSet != EInstructionSet::Scalar)
+		{
+			const __m128i Zero = _mm_setzero_si128();
+			const __m128i LowMask = _mm_set1_epi16(0x00ff);
+			const __m128i Chroma = _mm_set1_epi16(128);
+			const __m128i Opaque = _mm_set1_epi16(255);
+			const __m128i Round = _mm_set1_epi16(1 << (YuvToRgbShift - 1));
+			const __m128i YOffset = _mm_set1_epi16(Matrix.YOffset);
+			const __m128i YScale = _mm_set1_epi16(Matrix.YScale);
+			const __m128i RV = _mm_set1_epi16(Matrix.RV);
+			const __m128i GU = _mm_set1_epi16(Matrix.GU);
+			const __m128i GV = _mm_set1_epi16(Matrix.GV);
+			const __m128i BU = _mm_set1_epi16(Matrix.BU);
+
+			// 8 pixels (4 macro-pixels) per iteration
+			for (; X + 8 <= Width; X += 8)
+			{
+				const __m128i Src = _mm_loadu_si128((const __m128i*)(Uyvy + X * 2));
+				const __m128i UV = _mm_sub_epi16(_mm_and_si128(Src, LowMask), Chroma);
+				const __m128i U = _mm_shufflehi_epi16(_mm_shufflelo_epi16(UV, _MM_SHUFFLE(2, 2, 0, 0)), _MM_SHUFFLE(2, 2, 0, 0));
+				const __m128i V = _mm_shufflehi_epi16(_mm_shufflelo_epi16(UV, _MM_SHUFFLE(3, 3, 1, 1)), _MM_SHUFFLE(3, 3, 1, 1));
+				const __m128i Y = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(_mm_srli_epi16(Src, 8), YOffset), YScale), Round);
+
+				const __m128i B = _mm_srai_epi16(_mm_adds_epi16(Y, _mm_mullo_epi16(U, BU)), YuvToRgbShift);
+				const __m128i G = _mm_srai_epi16(_mm_adds_epi16(_mm_adds_epi16(Y, _mm_mullo_epi16(U, GU)), _mm_mullo_epi16(V, GV)), YuvToRgbShift);
+				const __m128i R = _mm_srai_epi16(_mm_adds_epi16(Y, _mm_mullo_epi16(V, RV)), YuvToRgbShift);
+				const __m128i A = HasAlpha ? _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(Alpha + X)), Zero) : Opaque;
+
+				// interleave to BGRA
+				const __m128i BR = _mm_packus_epi16(B, R);
+				const __m128i GA = _mm_packus_epi16(G, A);
+				const __m128i BG = _mm_unpacklo_epi8(BR, GA);
+				const __m128i RA = _mm_unpackhi_epi8(BR, GA);
+
+				_mm_storeu_si128((__m128i*)(Dest + X * 4), _mm_unpacklo_epi16(BG, RA));
+				_mm_storeu_si128((__m128i*)(Dest + X * 4 + 16), _mm_unpackhi_epi16(BG, RA));
+			}
+		}
+#elif NDIMEDIA_SIMD_NEON
+		if (InstructionSet != EInstructionSet::Scalar)
+		{
+			const int16x8_t Chroma = vdupq_n_s16(128);
+			const uint8x8_t Opaque = vdup_n_u8(255);
+			const int16x8_t Round = vdupq_n_s16(1 << (YuvToRgbShift - 1));
+			const int16x8_t YOffset = vdupq_n_s16(Matrix.YOffset);
+			const int16x8_t YScale = vdupq_n_s16(Matrix.YScale);
+			const int16x8_t RV = vdupq_n_s16(Matrix.RV);
+			const int16x8_t GU = vdupq_n_s16(Matrix.GU);
+			const int16x8_t GV = vdupq_n_s16(Matrix.GV);
+			const int16x8_t BU = vdupq_n_s16(Matrix.BU);
+
+			// 16 pixels (8 macro-pixels) per iteration, even and odd pixels share chroma
+			for (; X + 16 <= Width; X += 16)
+			{
+				const uint8x8x4_t Src = vld4_u8(Uyvy + X * 2);
+				const int16x8_t U = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(Src.val[0])), Chroma);
+				const int16x8_t V = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(Src.val[2])), Chroma);
+				const int16x8_t Ye = vaddq_s16(vmulq_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(Src.val[1])), YOffset), YScale), Round);
+				const int16x8_t Yo = vaddq_s16(vmulq_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(Src.val[3])), YOffset), YScale), Round);
+
+				const int16x8_t UB = vmulq_s16(U, BU);
+				const int16x8_t UG = vmulq_s16(U, GU);
+				const int16x8_t VG = vmulq_s16(V, GV);
+				const int16x8_t VR = vmulq_s16(V, RV);
+
+				const uint8x8x2_t B = vzip_u8(vqshrun_n_s16(vqaddq_s16(Ye, UB), YuvToRgbShift), vqshrun_n_s16(vqaddq_s16(Yo, UB), YuvToRgbShift));
+				const uint8x8x2_t G = vzip_u8(vqshrun_n_s16(vqaddq_s16(vqaddq_s16(Ye, UG), VG), YuvToRgbShift), vqshrun_n_s16(vqaddq_s16(vqaddq_s16(Yo, UG), VG), YuvToRgbShift));
+				const uint8x8x2_t R = vzip_u8(vqshrun_n_s16(vqaddq_s16(Ye, VR), YuvToRgbShift), vqshrun_n_s16(vqaddq_s16(Yo, VR), YuvToRgbShift));
+
+				uint8x8x4_t Out;
+				{
+					Out.val[0] = B.val[0];
+					Out.val[1] = G.val[0];
+					Out.val[2] = R.val[0];
+					Out.val[3] = HasAlpha ? vld1_u8(Alpha + X) : Opaque;
+				}
+
+				vst4_u8(Dest + X * 4, Out);
+
+				Out.val[0] = B.val[1];
+				Out.val[1] = G.val[1];
+				Out.val[2] = R.val[1];
+				Out.val[3] = HasAlpha ? vld1_u8(Alpha + X + 8) : Opaque;
+
+				vst4_u8(Dest + X * 4 + 32, Out);
+			}
+		}
+#endif
+
+		// remaining macro-pixels
+		for (; X < Width; X += 2)
+		{
+			const uint8* Macro = Uyvy + X * 2;
+			const int32 U = Macro[0] - 128;
+			const int32 V = Macro[2] - 128;
+
+			YuvPixelToBgra(Dest + X * 4, Macro[1], U, V, HasAlpha ? Alpha[X] : 255, Matrix);
+
+			if (X + 1 < Width)
+			{
+				YuvPixelToBgra(Dest + X * 4 + 4, Macro[3], U, V, HasAlpha ? Alpha[X + 1] : 255, Matrix);
+			}
+		}
+	}
+
+
+	EInstructionSet GetBestInstructionSet()
+	{
+#if NDIMEDIA_SIMD_AVX2
+		static const bool SupportsAvx2 = DetectAvx2();
+
+		if (SupportsAvx2)
+		{
+			return EInstructionSet::Avx2;
+		}
+#endif
+
+#if NDIMEDIA_SIMD_SSE2 || NDIMEDIA_SIMD_NEON
+		return EInstructionSet::Simd;
+#else
+		return EInstructionSet::Scalar;
+#endif
+	}
+
+
+	const TCHAR* GetInstructionSetName(EInstructionSet InstructionSet)
+	{
+		switch (InstructionSet)
+		{
+		case EInstructionSet::Avx2:
+			return TEXT("AVX2");
+
+		case EInstructionSet::Simd:
+			return NDIMEDIA_SIMD_NEON ? TEXT("NEON") : TEXT("SSE2");
+
+		default:
+			return TEXT("Scalar");
+		}
+	}
+
+
+	const FYuvToRgbMatrix& GetYuvToRgbMatrix(bool Bt709, bool FullRange)
+	{
+		if (Bt709)
+		{
+			return FullRange ? Bt709Full : Bt709Limited;
+		}
+
+		return FullRange ? Bt601Full : Bt601Limited;
+	}
+
+
+	void UyvyRowToBgra(uint8* Dest, const uint8* Uyvy, const uint8* Alpha, int32 Width, const FYuvToRgbMatrix& Matrix, EInstructionSet InstructionSet)
+	{
+		if (Alpha != nullptr)
+		{
+			UyvyRowToBgraImpl<true>(Dest, Uyvy, Alpha, Width, Matrix, InstructionSet);
+		}
+		else
+		{
+			UyvyRowToBgraImpl<false>(Dest, Uyvy, Alpha, Width, Matrix, InstructionSet);
+		}
+	}
+}
@@ -0,0 +1,157 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/**
+ * Row kernels shared by the video processing stages.
+ *
+ * Unless noted otherwise, kernels operate on rows of packed 8-bit pixels, so they
+ * work for all packed formats received from NDI (BGRA, RGBA, UYVY).
+ */
+namespace NdiMediaVideo
+{
+	/**
+	 * Fixed-point coefficients for converting 8-bit YCbCr to RGB.
+	 *
+	 * Coefficients are scaled by 64 so that all intermediate values fit into
+	 * saturating 16-bit arithmetic. The SIMD and scalar kernels perform the
+	 * same operations in the same order and therefore produce identical output.
+	 */
+	struct FYuvToRgbMatrix
+	{
+		/** Luma scale. */
+		int16 YScale;
+
+		/** Luma offset (black level). */
+		int16 YOffset;
+
+		/** Cr contribution to red. */
+		int16 RV;
+
+		/** Cb contribution to green. */
+		int16 GU;
+
+		/** Cr contribution to green. */
+		int16 GV;
+
+		/** Cb contribution to blue. */
+		int16 BU;
+	};
+
+	/** Number of fractional bits in FYuvToRgbMatrix coefficients. */
+	static const int32 YuvToRgbShift = 6;
+
+	/**
+	 * Instruction sets that the color conversion kernels can run with.
+	 */
+	enum class EInstructionSet : uint8
+	{
+		/** Portable C++ (reference implementation). */
+		Scalar,
+
+		/** SSE2 on x86 and x64, NEON on ARM. */
+		Simd,
+
+		/** AVX2 on x64 (selected at run-time if the CPU and OS support it). */
+		Avx2
+	};
+
+	/**
+	 * Get the fastest instruction set supported by the current CPU.
+	 *
+	 * @return Instruction set.
+	 */
+	EInstructionSet GetBestInstructionSet();
+
+	/**
+	 * Get the display name of an instruction set.
+	 *
+	 * @param InstructionSet The instruction set.
+	 * @return Display name.
+	 */
+	const TCHAR* GetInstructionSetName(EInstructionSet InstructionSet);
+
+	/**
+	 * Get a YCbCr to RGB conversion matrix.
+	 *
+	 * @param Bt709 Whether to use BT.709 (true) or BT.601 (false) coefficients.
+	 * @param FullRange Whether luma and chroma use the full 8-bit range (true) or video range (false).
+	 * @return Conversion matrix.
+	 */
+	const FYuvToRgbMatrix& GetYuvToRgbMatrix(bool Bt709, bool FullRange);
+
+	/**
+	 * Average two rows of bytes (rounding up).
+	 *
+	 * @param Dest The row to write to (may be the same as one of the inputs).
+	 * @param RowA The first input row.
+	 * @param RowB The second input row.
+	 * @param NumBytes Number of bytes in each row.
+	 */
+	void AverageRows(uint8* Dest, const uint8* RowA, const uint8* RowB, int32 NumBytes);
+
+	/**
+	 * Get the number of row bands to split a frame into for parallel processing.
+	 *
+	 * @param NumRows The number of rows in the frame.
+	 * @param OutRowsPerBand Will contain the number of rows per band.
+	 * @return Number of bands.
+	 */
+	int32 GetNumRowBands(int32 NumRows, int32& OutRowsPerBand);
+
+	/**
+	 * Halve a pair of rows of 32-bit pixels with a 2x2 box filter.
+	 *
+	 * Each output pixel is the rounded average of a 2x2 block, computed as two
+	 * successive pairwise averages, so the SIMD and scalar paths produce identical
+	 * output. Works for all 32-bit packed formats (BGRA, BGRX, RGBA, RGBX).
+	 *
+	 * @param Dest The row to write to (DestWidth pixels).
+	 * @param RowA The first input row (2 * DestWidth pixels).
+	 * @param RowB The second input row (2 * DestWidth pixels).
+	 * @param DestWidth The number of pixels in the output row.
+	 */
+	void HalveRows32(uint8* Dest, const uint8* RowA, const uint8* RowB, int32 DestWidth);
+
+	/**
+	 * Halve a pair of rows of UYVY pixels with a 2x2 box filter.
+	 *
+	 * Luma is averaged over 2x2 pixels and chroma over 2x2 macro-pixels, each as
+	 * two successive pairwise averages, so the SIMD and scalar paths produce
+	 * identical output.
+	 *
+	 * @param Dest The row to write to (DestWidth pixels).
+	 * @param RowA The first input row (2 * DestWidth pixels).
+	 * @param RowB The second input row (2 * DestWidth pixels).
+	 * @param DestWidth The number of pixels in the output row (must be even).
+	 * @see HalveRows32
+	 */
+	void HalveRowsUyvy(uint8* Dest, const uint8* RowA, const uint8* RowB, int32 DestWidth);
+
+	/**
+	 * Swap the red and blue channels of a row of 32-bit pixels (RGBA <-> BGRA).
+	 *
+	 * @param Dest The row to write to (may be the same as Src).
+	 * @param Src The row to read from.
+	 * @param Width The number of pixels in the row.
+	 */
+	void SwapRedBlueRow(uint8* Dest, const uint8* Src, int32 Width);
+
+	/**
+	 * Convert a row of UYVY pixels, and optionally a row of 8-bit alpha values, to BGRA.
+	 *
+	 * All instruction sets produce identical output.
+	 *
+	 * @param Dest The BGRA row to write to (4 bytes per pixel).
+	 * @param Uyvy The UYVY row to read from (2 bytes per pixel).
+	 * @param Alpha The alpha row to read from (1 byte per pixel), or nullptr for opaque output.
+	 * @param Width The number of pixels in the row.
+	 * @param Matrix The YCbCr to RGB matrix to use.
+	 * @param InstructionSet The instruction set to use (must be supported by the CPU).
+	 * @see GetBestInstructionSet
+	 */
+	void UyvyRowToBgra(uint8* Dest, const uint8* Uyvy, const uint8* Alpha, int32 Width, const FYuvToRgbMatrix& Matrix, EInstructionSet InstructionSet);
+}
@@ -0,0 +1,117 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaVideoResizer.h"
+#include "NdiMediaPrivate.h"
+
+
+DECLARE_CYCLE_STAT(TEXT("Resize"), STAT_NdiMedia_Resize, STATGROUP_NdiMedia);
+
+
+/* FNdiMediaVideoResizer structors
+ *****************************************************************************/
+
+FNdiMediaVideoResizer::FNdiMediaVideoResizer()
+	: MaxSize(FIntPoint::ZeroValue)
+{
+	Scaler.SetParallel(true);
+}
+
+
+/* FNdiMediaVideoResizer interface
+ *****************************************************************************/
+
+FIntPoint FNdiMediaVideoResizer::GetOutputSize(const FIntPoint& FrameSize, bool Uyvy) const
+{
+	if ((MaxSize.X <= 0) && (MaxSize.Y <= 0))
+	{
+		return FrameSize;
+	}
+
+	FIntPoint OutputSize = FNdiMediaVideoScaler::FitSize(
+		FrameSize.X,
+		FrameSize.Y,
+		(MaxSize.X > 0) ? MaxSize.X : MAX_int32,
+		(MaxSize.Y > 0) ? MaxSize.Y : MAX_int32
+	);
+
+	// UYVY rows consist of whole macro-pixels
+	if (Uyvy && (OutputSize.X != FrameSize.X))
+	{
+		OutputSize.X = FMath::Max(2, OutputSize.X & ~1);
+	}
+
+	return OutputSize;
+}
+
+
+bool FNdiMediaVideoResizer::NeedsResize(const NDIlib_video_frame_v2_t& Frame) const
+{
+	const FIntPoint FrameSize(Frame.xres, Frame.yres);
+
+	switch (Frame.FourCC)
+	{
+	case NDIlib_FourCC_type_BGRA:
+	case NDIlib_FourCC_type_BGRX:
+	case NDIlib_FourCC_type_RGBA:
+	case NDIlib_FourCC_type_RGBX:
+		return (GetOutputSize(FrameSize, false) != FrameSize);
+
+	case NDIlib_FourCC_type_UYVY:
+		return (GetOutputSize(FrameSize, true) != FrameSize);
+
+	default:
+		return false;
+	}
+}
+
+
+bool FNdiMediaVideoResizer::Process(const NDIlib_video_frame_v2_t& InFrame, NDIlib_video_frame_v2_t& OutFrame)
+{
+	if ((InFrame.p_data == nullptr) || (InFrame.xres <= 0) || (InFrame.yres <= 0))
+	{
+		return false;
+	}
+
+	const bool Uyvy = (InFrame.FourCC == NDIlib_FourCC_type_UYVY);
+
+	if (!Uyvy &&
+		(InFrame.FourCC != NDIlib_FourCC_type_BGRA) &&
+		(InFrame.FourCC != NDIlib_FourCC_type_BGRX) &&
+		(InFrame.FourCC != NDIlib_FourCC_type_RGBA) &&
+		(InFrame.FourCC != NDIlib_FourCC_type_RGBX))
+	{
+		return false;
+	}
+
+	const int32 BytesPerPixel = Uyvy ? 2 : 4;
+
+	if (InFrame.line_stride_in_bytes < InFrame.xres * BytesPerPixel)
+	{
+		return false;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_NdiMedia_Resize);
+	FNdiMediaStageScope StageScope(Stats);
+
+	const FIntPoint OutputSize = GetOutputSize(FIntPoint(InFrame.xres, InFrame.yres), Uyvy);
+	const int32 DestStride = OutputSize.X * BytesPerPixel;
+
+	Buffer.SetNumUninitialized(DestStride * OutputSize.Y, false);
+
+	Scaler.SetLayout(Uyvy ? FNdiMediaVideoScaler::ELayout::Uyvy : FNdiMediaVideoScaler::ELayout::Packed32);
+	Scaler.Process(InFrame.p_data, InFrame.xres, InFrame.yres, InFrame.line_stride_in_bytes, Buffer.GetData(), OutputSize.X, OutputSize.Y, DestStride);
+
+	OutFrame = InFrame;
+	OutFrame.xres = OutputSize.X;
+	OutFrame.yres = OutputSize.Y;
+	OutFrame.line_stride_in_bytes = DestStride;
+	OutFrame.p_data = Buffer.GetData();
+
+	return true;
+}
+
+
+void FNdiMediaVideoResizer::Reset()
+{
+	Stats.Reset();
+}
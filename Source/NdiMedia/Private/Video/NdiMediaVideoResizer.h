@@ -0,0 +1,115 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "NdiMediaStageStats.h"
+#include "NdiMediaVideoScaler.h"
+
+
+struct NDIlib_video_frame_v2_t;
+
+
+/**
+ * Downscales NDI video frames that exceed a maximum size.
+ *
+ * The preferred video size is only a hint to the sender, and many senders ignore
+ * it. This stage makes received frames conform to it locally, so that uploads and
+ * texture memory match the requested size. Frames keep their aspect ratio and are
+ * never enlarged.
+ *
+ * Progressive BGRA, BGRX, RGBA, RGBX and UYVY frames are supported. Output frames
+ * are written to an internal buffer that is reused for all frames, and the rows
+ * of each frame are processed in parallel on task graph worker threads.
+ *
+ * @see FNdiMediaVideoScaler
+ */
+class FNdiMediaVideoResizer
+{
+public:
+
+	/** Default constructor. */
+	FNdiMediaVideoResizer();
+
+public:
+
+	/**
+	 * Get the maximum size of output frames.
+	 *
+	 * @return Maximum size (in pixels, zero = unlimited).
+	 * @see SetMaxSize
+	 */
+	const FIntPoint& GetMaxSize() const
+	{
+		return MaxSize;
+	}
+
+	/**
+	 * Get the size of the frames that frames of the given size will be resized to.
+	 *
+	 * @param FrameSize The frame's size (in pixels).
+	 * @param Uyvy Whether the frame consists of UYVY macro-pixels.
+	 * @return Output size (in pixels).
+	 */
+	FIntPoint GetOutputSize(const FIntPoint& FrameSize, bool Uyvy) const;
+
+	/**
+	 * Get the processing statistics.
+	 *
+	 * @return Statistics.
+	 */
+	const FNdiMediaStageStats& GetStats() const
+	{
+		return Stats;
+	}
+
+	/**
+	 * Check whether the given frame needs to be resized before it can be uploaded.
+	 *
+	 * @param Frame The frame to check.
+	 * @return true if the frame needs resizing, false otherwise.
+	 * @see Process
+	 */
+	bool NeedsResize(const NDIlib_video_frame_v2_t& Frame) const;
+
+	/**
+	 * Resize a video frame.
+	 *
+	 * The output frame is a copy of the input frame's description that references
+	 * the resizer's buffer, which remains valid until the next call to Process.
+	 *
+	 * @param InFrame The frame to resize.
+	 * @param OutFrame Will contain the resized frame.
+	 * @return true if the frame was resized, false if its format is not supported.
+	 * @see NeedsResize
+	 */
+	bool Process(const NDIlib_video_frame_v2_t& InFrame, NDIlib_video_frame_v2_t& OutFrame);
+
+	/** Reset the statistics. */
+	void Reset();
+
+	/**
+	 * Set the maximum size of output frames.
+	 *
+	 * @param InMaxSize The maximum size (in pixels, zero = unlimited).
+	 * @see GetMaxSize
+	 */
+	void SetMaxSize(const FIntPoint& InMaxSize)
+	{
+		MaxSize = InMaxSize;
+	}
+
+private:
+
+	/** Buffer holding the output frame. */
+	TArray<uint8> Buffer;
+
+	/** Maximum size of output frames (in pixels, zero = unlimited). */
+	FIntPoint MaxSize;
+
+	/** The scaler that resizes frames. */
+	FNdiMediaVideoScaler Scaler;
+
+	/** Processing statistics. */
+	FNdiMediaStageStats Stats;
+};
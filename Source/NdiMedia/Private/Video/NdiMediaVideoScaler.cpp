@@ -0,0 +1,236 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaVideoScaler.h"
+#include "NdiMediaPrivate.h"
+
+#include "Async/ParallelFor.h"
+#include "NdiMediaVideoKernels.h"
+
+
+/* FNdiMediaVideoScaler structors
+ *****************************************************************************/
+
+FNdiMediaVideoScaler::FNdiMediaVideoScaler()
+	: Layout(ELayout::Packed32)
+	, Parallel(false)
+{ }
+
+
+/* FNdiMediaVideoScaler interface
+ *****************************************************************************/
+
+FIntPoint FNdiMediaVideoScaler::FitSize(int32 Width, int32 Height, int32 MaxWidth, int32 MaxHeight)
+{
+	if ((Width <= MaxWidth) && (Height <= MaxHeight))
+	{
+		return FIntPoint(Width, Height);
+	}
+
+	// compare aspect ratios without rounding
+	if ((int64)Width * MaxHeight > (int64)Height * MaxWidth)
+	{
+		return FIntPoint(MaxWidth, FMath::Max(1, (int32)((int64)Height * MaxWidth / Width)));
+	}
+
+	return FIntPoint(FMath::Max(1, (int32)((int64)Width * MaxHeight / Height)), MaxHeight);
+}
+
+
+void FNdiMediaVideoScaler::Process(const uint8* Src, int32 SrcWidth, int32 SrcHeight, int32 SrcStride, uint8* Dest, int32 DestWidth, int32 DestHeight, int32 DestStride)
+{
+	check(DestWidth > 0);
+	check(DestHeight > 0);
+
+	const bool Uyvy = (Layout == ELayout::Uyvy);
+	const int32 BytesPerPixel = Uyvy ? 2 : 4;
+
+	int32 BufferIndex = 0;
+
+	// halve with SIMD while the frame is at least twice the output size
+	// (halved UYVY rows must consist of whole macro-pixels)
+	while ((SrcWidth >= DestWidth * 2) && (SrcHeight >= DestHeight * 2) && (!Uyvy || (SrcWidth % 4 == 0)))
+	{
+		const int32 HalfWidth = SrcWidth / 2;
+		const int32 HalfHeight = SrcHeight / 2;
+		const int32 HalfStride = HalfWidth * BytesPerPixel;
+
+		TArray<uint8>& HalfBuffer = HalfBuffers[BufferIndex];
+		HalfBuffer.SetNumUninitialized(HalfStride * HalfHeight, false);
+
+		const uint8* HalfSrc = Src;
+		const int32 HalfSrcStride = SrcStride;
+		uint8* HalfDest = HalfBuffer.GetData();
+
+		ForEachRowBand(HalfHeight, [=](int32 FirstRow, int32 LastRow)
+		{
+			for (int32 Row = FirstRow; Row < LastRow; ++Row)
+			{
+				const uint8* RowA = HalfSrc + (Row * 2) * HalfSrcStride;
+
+				if (Uyvy)
+				{
+					NdiMediaVideo::HalveRowsUyvy(HalfDest + Row * HalfStride, RowA, RowA + HalfSrcStride, HalfWidth);
+				}
+				else
+				{
+					NdiMediaVideo::HalveRows32(HalfDest + Row * HalfStride, RowA, RowA + HalfSrcStride, HalfWidth);
+				}
+			}
+		});
+
+		Src = HalfDest;
+		SrcWidth = HalfWidth;
+		SrcHeight = HalfHeight;
+		SrcStride = HalfStride;
+		BufferIndex ^= 1;
+	}
+
+	if ((SrcWidth == DestWidth) && (SrcHeight == DestHeight))
+	{
+		for (int32 Row = 0; Row < DestHeight; ++Row)
+		{
+			FMemory::Memcpy(Dest + Row * DestStride, Src + Row * SrcStride, DestWidth * BytesPerPixel);
+		}
+	}
+	else
+	{
+		ForEachRowBand(DestHeight, [=](int32 FirstRow, int32 LastRow)
+		{
+			if (Uyvy)
+			{
+				BoxFilterUyvy(Src, SrcWidth, SrcHeight, SrcStride, Dest, DestWidth, DestHeight, DestStride, FirstRow, LastRow);
+			}
+			else
+			{
+				BoxFilter32(Src, SrcWidth, SrcHeight, SrcStride, Dest, DestWidth, DestHeight, DestStride, FirstRow, LastRow);
+			}
+		});
+	}
+}
+
+
+/* FNdiMediaVideoScaler implementation
+ *****************************************************************************/
+
+void FNdiMediaVideoScaler::BoxFilter32(const uint8* Src, int32 SrcWidth, int32 SrcHeight, int32 SrcStride, uint8* Dest, int32 DestWidth, int32 DestHeight, int32 DestStride, int32 FirstRow, int32 LastRow)
+{
+	for (int32 Y = FirstRow; Y < LastRow; ++Y)
+	{
+		uint8* DestPixel = Dest + Y * DestStride;
+
+		// each output pixel covers the source pixels from its start up to the next pixel's start
+		// (at least one, which replicates pixels when enlarging)
+		const int32 StartY = Y * SrcHeight / DestHeight;
+		const int32 EndY = FMath::Max(StartY + 1, (Y + 1) * SrcHeight / DestHeight);
+
+		for (int32 X = 0; X < DestWidth; ++X)
+		{
+			const int32 StartX = X * SrcWidth / DestWidth;
+			const int32 EndX = FMath::Max(StartX + 1, (X + 1) * SrcWidth / DestWidth);
+			const int32 NumPixels = (EndX - StartX) * (EndY - StartY);
+
+			uint32 Sums[4] = { 0, 0, 0, 0 };
+
+			for (int32 SrcY = StartY; SrcY < EndY; ++SrcY)
+			{
+				const uint8* Pixel = Src + SrcY * SrcStride + StartX * 4;
+
+				for (int32 SrcX = StartX; SrcX < EndX; ++SrcX, Pixel += 4)
+				{
+					Sums[0] += Pixel[0];
+					Sums[1] += Pixel[1];
+					Sums[2] += Pixel[2];
+					Sums[3] += Pixel[3];
+				}
+			}
+
+			for (int32 Channel = 0; Channel < 4; ++Channel)
+			{
+				*DestPixel++ = (uint8)((Sums[Channel] + NumPixels / 2) / NumPixels);
+			}
+		}
+	}
+}
+
+
+void FNdiMediaVideoScaler::BoxFilterUyvy(const uint8* Src, int32 SrcWidth, int32 SrcHeight, int32 SrcStride, uint8* Dest, int32 DestWidth, int32 DestHeight, int32 DestStride, int32 FirstRow, int32 LastRow)
+{
+	const int32 SrcMacros = SrcWidth / 2;
+	const int32 DestMacros = DestWidth / 2;
+
+	for (int32 Y = FirstRow; Y < LastRow; ++Y)
+	{
+		uint8* DestMacro = Dest + Y * DestStride;
+
+		const int32 StartY = Y * SrcHeight / DestHeight;
+		const int32 EndY = FMath::Max(StartY + 1, (Y + 1) * SrcHeight / DestHeight);
+
+		for (int32 M = 0; M < DestMacros; ++M, DestMacro += 4)
+		{
+			// chroma is shared by the two pixels of a macro-pixel
+			const int32 StartM = M * SrcMacros / DestMacros;
+			const int32 EndM = FMath::Max(StartM + 1, (M + 1) * SrcMacros / DestMacros);
+			const int32 NumMacros = (EndM - StartM) * (EndY - StartY);
+
+			uint32 SumU = 0;
+			uint32 SumV = 0;
+
+			for (int32 SrcY = StartY; SrcY < EndY; ++SrcY)
+			{
+				const uint8* Macro = Src + SrcY * SrcStride + StartM * 4;
+
+				for (int32 SrcM = StartM; SrcM < EndM; ++SrcM, Macro += 4)
+				{
+					SumU += Macro[0];
+					SumV += Macro[2];
+				}
+			}
+
+			DestMacro[0] = (uint8)((SumU + NumMacros / 2) / NumMacros);
+			DestMacro[2] = (uint8)((SumV + NumMacros / 2) / NumMacros);
+
+			// luma is averaged per pixel
+			for (int32 Half = 0; Half < 2; ++Half)
+			{
+				const int32 X = M * 2 + Half;
+				const int32 StartX = X * SrcWidth / DestWidth;
+				const int32 EndX = FMath::Max(StartX + 1, (X + 1) * SrcWidth / DestWidth);
+				const int32 NumPixels = (EndX - StartX) * (EndY - StartY);
+
+				uint32 SumY = 0;
+
+				for (int32 SrcY = StartY; SrcY < EndY; ++SrcY)
+				{
+					const uint8* Row = Src + SrcY * SrcStride;
+
+					for (int32 SrcX = StartX; SrcX < EndX; ++SrcX)
+					{
+						SumY += Row[SrcX * 2 + 1];
+					}
+				}
+
+				DestMacro[1 + Half * 2] = (uint8)((SumY + NumPixels / 2) / NumPixels);
+			}
+		}
+	}
+}
+
+
+void FNdiMediaVideoScaler::ForEachRowBand(int32 NumRows, TFunctionRef<void(int32 FirstRow, int32 LastRow)> Function) const
+{
+	if (!Parallel)
+	{
+		Function(0, NumRows);
+
+		return;
+	}
+
+	int32 RowsPerBand = 0;
+	const int32 NumBands = NdiMediaVideo::GetNumRowBands(NumRows, RowsPerBand);
+
+	ParallelFor(NumBands, [&](int32 BandIndex)
+	{
+		const int32 FirstRow = BandIndex * RowsPerBand;
+		Function(FirstRow, FMath::Min(FirstRow + RowsPerBand, NumRows));
+	});
+}
@@ -0,0 +1,151 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Function.h"
+
+
+/**
+ * Downscales frames of 32-bit pixels (BGRA, BGRX, RGBA, RGBX) or UYVY pixels.
+ *
+ * Frames are halved with a SIMD 2x2 box filter for as long as they are at least
+ * twice the output size. The remaining factor, which is less than two, is covered
+ * by a scalar box filter that averages the source pixels under each output pixel.
+ * Frames that are smaller than the output are enlarged by pixel replication.
+ *
+ * Intermediate images are written to internal buffers that are reused for all frames.
+ * If parallel processing is enabled, the rows of each pass are processed in bands on
+ * task graph worker threads.
+ *
+ * @see NdiMediaVideo::HalveRows32, NdiMediaVideo::HalveRowsUyvy
+ */
+class FNdiMediaVideoScaler
+{
+public:
+
+	/**
+	 * Pixel layouts that the scaler can process.
+	 */
+	enum class ELayout : uint8
+	{
+		/** 32-bit pixels (BGRA, BGRX, RGBA, RGBX). */
+		Packed32,
+
+		/** UYVY macro-pixels (frame widths must be even). */
+		Uyvy
+	};
+
+public:
+
+	/** Default constructor (32-bit pixels, sequential processing). */
+	FNdiMediaVideoScaler();
+
+public:
+
+	/**
+	 * Get the largest size that fits into the given bounds and keeps a frame's aspect ratio.
+	 *
+	 * Frames that already fit are not enlarged.
+	 *
+	 * @param Width The frame's width (in pixels).
+	 * @param Height The frame's height (in pixels).
+	 * @param MaxWidth The maximum width (in pixels).
+	 * @param MaxHeight The maximum height (in pixels).
+	 * @return The fitted size.
+	 */
+	static FIntPoint FitSize(int32 Width, int32 Height, int32 MaxWidth, int32 MaxHeight);
+
+	/**
+	 * Scale a frame.
+	 *
+	 * @param Src The frame's pixels.
+	 * @param SrcWidth The frame's width (in pixels).
+	 * @param SrcHeight The frame's height (in pixels).
+	 * @param SrcStride The distance between the frame's rows (in bytes).
+	 * @param Dest The buffer to write the output pixels to.
+	 * @param DestWidth The output width (in pixels).
+	 * @param DestHeight The output height (in pixels).
+	 * @param DestStride The distance between the output rows (in bytes).
+	 */
+	void Process(const uint8* Src, int32 SrcWidth, int32 SrcHeight, int32 SrcStride, uint8* Dest, int32 DestWidth, int32 DestHeight, int32 DestStride);
+
+	/**
+	 * Set the pixel layout of the frames to be scaled.
+	 *
+	 * @param InLayout The pixel layout.
+	 */
+	void SetLayout(ELayout InLayout)
+	{
+		Layout = InLayout;
+	}
+
+	/**
+	 * Set whether rows are processed in parallel.
+	 *
+	 * Scalers that are already used on worker threads should process sequentially.
+	 *
+	 * @param InParallel Whether to process in parallel.
+	 */
+	void SetParallel(bool InParallel)
+	{
+		Parallel = InParallel;
+	}
+
+protected:
+
+	/**
+	 * Scale a range of output rows of a 32-bit frame with a box filter (scalar).
+	 *
+	 * @param Src The frame's pixels.
+	 * @param SrcWidth The frame's width (in pixels).
+	 * @param SrcHeight The frame's height (in pixels).
+	 * @param SrcStride The distance between the frame's rows (in bytes).
+	 * @param Dest The buffer to write the output pixels to.
+	 * @param DestWidth The output width (in pixels).
+	 * @param DestHeight The output height (in pixels).
+	 * @param DestStride The distance between the output rows (in bytes).
+	 * @param FirstRow The first output row to write.
+	 * @param LastRow The output row after the last one to write.
+	 * @see BoxFilterUyvy
+	 */
+	static void BoxFilter32(const uint8* Src, int32 SrcWidth, int32 SrcHeight, int32 SrcStride, uint8* Dest, int32 DestWidth, int32 DestHeight, int32 DestStride, int32 FirstRow, int32 LastRow);
+
+	/**
+	 * Scale a range of output rows of a UYVY frame with a box filter (scalar).
+	 *
+	 * Luma is averaged over the pixels and chroma over the macro-pixels under each output macro-pixel.
+	 *
+	 * @param Src The frame's pixels.
+	 * @param SrcWidth The frame's width (in pixels, even).
+	 * @param SrcHeight The frame's height (in pixels).
+	 * @param SrcStride The distance between the frame's rows (in bytes).
+	 * @param Dest The buffer to write the output pixels to.
+	 * @param DestWidth The output width (in pixels, even).
+	 * @param DestHeight The output height (in pixels).
+	 * @param DestStride The distance between the output rows (in bytes).
+	 * @param FirstRow The first output row to write.
+	 * @param LastRow The output row after the last one to write.
+	 * @see BoxFilter32
+	 */
+	static void BoxFilterUyvy(const uint8* Src, int32 SrcWidth, int32 SrcHeight, int32 SrcStride, uint8* Dest, int32 DestWidth, int32 DestHeight, int32 DestStride, int32 FirstRow, int32 LastRow);
+
+	/**
+	 * Execute a function for bands of rows, in parallel if enabled.
+	 *
+	 * @param NumRows The total number of rows.
+	 * @param Function The function to execute for each band (receives the first row and the row after the last).
+	 */
+	void ForEachRowBand(int32 NumRows, TFunctionRef<void(int32 FirstRow, int32 LastRow)> Function) const;
+
+private:
+
+	/** Buffers holding the halved frames (used alternately). */
+	TArray<uint8> HalfBuffers[2];
+
+	/** The pixel layout of the frames. */
+	ELayout Layout;
+
+	/** Whether rows are processed in parallel. */
+	bool Parallel;
+};
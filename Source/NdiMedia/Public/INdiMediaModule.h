@@ -7,6 +7,7 @@
 
 
 class IMediaPlayer;
+struct FNdiMediaThumbnail;
 
 
 /**
@@ -24,6 +25,20 @@ public:
 	 */
 	virtual TSharedPtr<IMediaPlayer, ESPMode::ThreadSafe> CreatePlayer() = 0;
 
+	/**
+	 * Get a preview image of an NDI source.
+	 *
+	 * Thumbnails are captured asynchronously by briefly connecting to the source at
+	 * the lowest bandwidth. This function never blocks: it returns the cached thumbnail,
+	 * which may be outdated, and requests a new capture if there is none or if it has
+	 * expired. Call it periodically, i.e. while the source is visible in a user interface,
+	 * to pick up the thumbnail once it is ready.
+	 *
+	 * @param Source The source's name (i.e. "MACHINE (Stream)") or IP endpoint (i.e. "1.2.3.4:5678").
+	 * @return The thumbnail, or nullptr if it hasn't been captured yet or the source has no video.
+	 */
+	virtual TSharedPtr<FNdiMediaThumbnail, ESPMode::ThreadSafe> GetThumbnail(const FString& Source) = 0;
+
 public:
 
 	/** Virtual destructor. */
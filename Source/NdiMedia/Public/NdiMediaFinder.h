@@ -10,6 +10,9 @@
 #include "NdiMediaFinder.generated.h"
 
 
+class INdiMediaBackend;
+
+
 /**
  * Identifies an NDI media source.
  */
@@ -90,6 +93,18 @@ public:
 	UFUNCTION(BlueprintCallable, Category=NDI)
 	bool Initialize();
 
+	/**
+	 * Whether this finder is discovering NDI sources on the network.
+	 *
+	 * @return true if initialized, false otherwise.
+	 * @see Initialize, Shutdown
+	 */
+	UFUNCTION(BlueprintCallable, Category=NDI)
+	bool IsInitialized() const
+	{
+		return (FindInstance != nullptr);
+	}
+
 	/**
 	 * Shut down this finder and stop discovering NDI sources on the network.
 	 *
@@ -238,6 +253,9 @@ private:
 
 private:
 
+	/** The backend that the finder instance was created on. */
+	TSharedPtr<INdiMediaBackend, ESPMode::ThreadSafe> Backend;
+
 	/** The NDI source finder instance. */
 	void* FindInstance;
 };
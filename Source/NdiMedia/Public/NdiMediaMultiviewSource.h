@@ -0,0 +1,71 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "UObject/ObjectMacros.h"
+#include "BaseMediaSource.h"
+#include "NdiMediaSource.h"
+
+#include "NdiMediaMultiviewSource.generated.h"
+
+
+/**
+ * Media source that tiles the video of multiple NDI streams into a single texture.
+ *
+ * The streams are composited on the CPU, so that the whole multiview costs one
+ * texture upload per frame, regardless of the number of tiles. Audio and metadata
+ * are not received.
+ */
+UCLASS(BlueprintType)
+class NDIMEDIA_API UNdiMediaMultiviewSource
+	: public UBaseMediaSource
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Bandwidth of the tiles' streams (default = Lowest, which receives the senders' preview streams). */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
+	ENdiMediaBandwidth Bandwidth;
+
+	/** Number of tile columns (0 = as many columns as rows). */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI)
+	int32 Columns;
+
+	/** Height of the output texture (in pixels, default = 1080). */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI)
+	int32 OutputHeight;
+
+	/** Width of the output texture (in pixels, default = 1920). */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI)
+	int32 OutputWidth;
+
+	/**
+	 * The names or IP endpoints of the NDI sources to be tiled, i.e. "MACHINE_NAME (NDI_SOURCE_NAME)" or "1.2.3.4:5678".
+	 *
+	 * Tiles are laid out in rows, in the order of this list.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AssetRegistrySearchable)
+	TArray<FString> Sources;
+
+public:
+
+	/** Default constructor. */
+	UNdiMediaMultiviewSource();
+
+public:
+
+	//~ IMediaOptions interface
+
+	virtual int64 GetMediaOption(const FName& Key, int64 DefaultValue) const override;
+	virtual bool HasMediaOption(const FName& Key) const override;
+
+public:
+
+	//~ UMediaSource interface
+
+	virtual FString GetUrl() const override;
+	virtual bool Validate() const override;
+};
@@ -23,7 +23,27 @@ enum class ENdiMediaBandwidth : uint8
 	Lowest,
 
 	/** Receive audio stream only. */
-	AudioOnly
+	AudioOnly,
+
+	/** Receive metadata stream only, i.e. for tracking or control data. */
+	MetadataOnly
+};
+
+
+/**
+ * Deinterlacing options for fielded and interleaved NDI video.
+ */
+UENUM(BlueprintType)
+enum class ENdiMediaDeinterlaceMode : uint8
+{
+	/** Combine pairs of fields into full frames (half the field rate, interleaved frames are passed through). */
+	Weave,
+
+	/** Line-double each field (full field rate, half the vertical resolution). */
+	Bob,
+
+	/** Interpolate the missing lines of each field, or blend the fields of interleaved frames. */
+	Blend
 };
 
 
@@ -45,8 +65,96 @@ enum class ENdiMediaFrameFormatPreference : uint8
 UENUM(BlueprintType)
 enum class ENdiMediaColorFormat : uint8
 {
+	/** BGRX, or BGRA for sources with alpha. */
 	BGRA,
-	UYVY
+
+	/** UYVY, or BGRA for sources with alpha. */
+	UYVY,
+
+	/**
+	 * UYVY, or UYVY with an alpha plane (UYVA) for sources with alpha (requires NDI runtime 3.0 or newer).
+	 *
+	 * UYVA frames are delivered by the runtime at 3 bytes per pixel, but texture sinks
+	 * have no UYVA format, so they are unpacked to BGRA on the CPU. Keyed sources are
+	 * therefore still uploaded at 4 bytes per pixel, after an extra pass over each
+	 * frame. Falls back to UYVY with BGRA for older runtimes.
+	 */
+	UYVA,
+
+	/**
+	 * RGBX, or RGBA for sources with alpha.
+	 *
+	 * Texture sinks have no 8-bit RGBA format, so frames are swizzled to BGRA on the
+	 * CPU, which costs an extra pass over each frame. Slower than BGRA, and only
+	 * provided for compatibility with senders that require it.
+	 */
+	RGBA,
+
+	/**
+	 * UYVY, or RGBA for sources with alpha.
+	 *
+	 * Frames with alpha are swizzled to BGRA on the CPU, which costs an extra pass
+	 * over each frame. Slower than UYVY, and only provided for compatibility with
+	 * senders that require it.
+	 */
+	UYVY_RGBA
+};
+
+
+/**
+ * Tally states that players report to the sources they receive.
+ */
+UENUM(BlueprintType)
+enum class ENdiMediaTallyMode : uint8
+{
+	/** On program while the video is drawn or the audio is played, on preview while the video is only bound to a texture. */
+	Automatic,
+
+	/** Neither on program nor on preview. */
+	Off,
+
+	/** On preview only. */
+	Preview,
+
+	/** On program only. */
+	Program,
+
+	/** On program and on preview. */
+	PreviewAndProgram
+};
+
+
+/**
+ * Available conversions of YUV video frames.
+ */
+UENUM(BlueprintType)
+enum class ENdiMediaYuvConversion : uint8
+{
+	/** Upload YUV frames as is and let the texture sink convert them. */
+	Sink,
+
+	/** Convert to BGRA on the CPU using the source's color matrix if known, or BT.709 for HD and BT.601 for SD video. */
+	Auto,
+
+	/** Convert to BGRA on the CPU using BT.601. */
+	Bt601,
+
+	/** Convert to BGRA on the CPU using BT.709. */
+	Bt709
+};
+
+
+/**
+ * Available value ranges of YUV video frames.
+ */
+UENUM(BlueprintType)
+enum class ENdiMediaYuvRange : uint8
+{
+	/** Video range (luma 16-235, chroma 16-240). */
+	Limited,
+
+	/** Full range (0-255). */
+	Full
 };
 
 
@@ -69,6 +177,10 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
 	ENdiMediaColorFormat ColorFormat;
 
+	/** How to deinterlace fielded or interleaved video frames (default = Weave). */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
+	ENdiMediaDeinterlaceMode DeinterlaceMode;
+
 	/**
 	 * The IP address and port number of the NDI source to be played, i.e "1.2.3.4:5678".
 	 *
@@ -88,6 +200,17 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AssetRegistrySearchable)
 	FString SourceName;
 
+	/**
+	 * Names or IP endpoints of the sources to fall back to, in order of priority.
+	 *
+	 * While the source is playing, one backup source is kept connected. If the
+	 * playing source's health drops (it disconnects, stalls, drops frames or falls
+	 * behind), playback switches to the backup within a frame. Playback returns to
+	 * a higher priority source once it has been healthy for a few seconds.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
+	TArray<FString> BackupSources;
+
 	/** Preferred number of audio channels (0 = no preference, default = 2). */
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
 	int32 PreferredNumAudioChannels;
@@ -104,6 +227,16 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
 	int32 PreferredVideoHeight;
 
+	/**
+	 * Whether to downscale received video locally if it exceeds the preferred width or height (default = false).
+	 *
+	 * The preferred video size is only a hint, which many senders ignore. When this is
+	 * enabled, larger frames are resized on the CPU before they are uploaded, so that
+	 * texture uploads and memory match the preferred size.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
+	bool ConformVideoSize;
+
 	/** Numerator of preferred video frame rate, i.e. '30000' in 30000/1001 = 29.97 fps (0 = no preference). */
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
 	int32 PreferredFrameRateNumerator;
@@ -116,11 +249,79 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
 	ENdiMediaFrameFormatPreference PreferredFrameFormat;
 
+	/**
+	 * Directory to record the received stream into (empty = don't record).
+	 *
+	 * Each time the source is opened, a new recording file named after the
+	 * source and the current time is created in this directory.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
+	FString RecordingDirectory;
+
+	/**
+	 * Name of the group of sources whose video is presented in step (empty = not synchronized).
+	 *
+	 * Players of sources in the same sync group align their video frames by timestamp
+	 * and present them together, repeating or dropping frames as needed. Each player's
+	 * offset from the common presentation time is shown in its statistics.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
+	FString SyncGroup;
+
+	/**
+	 * The tally state that players report to the source (default = Automatic).
+	 *
+	 * Many senders lower their encoding effort for streams that are neither on
+	 * program nor on preview. Use SetTallyMode to change the state of players
+	 * that are already playing this source.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
+	ENdiMediaTallyMode TallyMode;
+
+	/**
+	 * How much of the received stream is kept for pausing, rewinding and instant replay (in seconds, 0 = disabled).
+	 *
+	 * While the player is paused or behind the live stream, received frames are
+	 * buffered and played back later. Seeking to the end of the buffer returns
+	 * to the live stream.
+	 */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
+	int32 TimeShiftDuration;
+
+	/** Maximum amount of memory used for time-shifted frames (in MB, default = 512). */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
+	int32 TimeShiftMemoryBudget;
+
+	/** Directory that time-shifted frames beyond the memory budget are written to (empty = discard them). */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
+	FString TimeShiftSpillDirectory;
+
+	/** How to convert YUV video frames for texture sinks (default = Sink). */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
+	ENdiMediaYuvConversion YuvConversion;
+
+	/** Value range of YUV video frames converted on the CPU (default = Limited). */
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category=NDI, AdvancedDisplay)
+	ENdiMediaYuvRange YuvRange;
+
 public:
 
 	/** Default constructor. */
 	UNdiMediaSource();
 
+public:
+
+	/**
+	 * Change the tally state that players of this source report.
+	 *
+	 * The new state also applies to players that are already playing this
+	 * source, and to other media sources with the same source name or endpoint.
+	 *
+	 * @param Mode The tally state.
+	 */
+	UFUNCTION(BlueprintCallable, Category=NDI)
+	void SetTallyMode(ENdiMediaTallyMode Mode);
+
 public:
 
 	//~ IMediaOptions interface
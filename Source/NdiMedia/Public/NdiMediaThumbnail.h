@@ -0,0 +1,35 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/DateTime.h"
+
+
+/**
+ * A preview image of an NDI media source.
+ *
+ * @see INdiMediaModule::GetThumbnail
+ */
+struct FNdiMediaThumbnail
+{
+	/** Height of the image (in pixels). */
+	int32 Height;
+
+	/** The image's BGRA pixels (rows are packed without padding). */
+	TArray<uint8> Pixels;
+
+	/** Time at which the image was captured (in UTC). */
+	FDateTime Time;
+
+	/** Width of the image (in pixels). */
+	int32 Width;
+
+public:
+
+	/** Default constructor. */
+	FNdiMediaThumbnail()
+		: Height(0)
+		, Width(0)
+	{ }
+};
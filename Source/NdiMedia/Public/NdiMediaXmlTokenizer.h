@@ -0,0 +1,257 @@
+// Copyright 1998-2016 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/**
+ * A span of characters inside an NDI metadata buffer.
+ *
+ * Spans point directly into the buffer that was passed to the tokenizer and are
+ * not null-terminated. They are only valid as long as that buffer is alive.
+ */
+struct NDIMEDIA_API FNdiMediaXmlSpan
+{
+	/** Pointer to the first character. */
+	const ANSICHAR* Data;
+
+	/** Number of characters. */
+	int32 Length;
+
+public:
+
+	/** Default constructor. */
+	FNdiMediaXmlSpan()
+		: Data(nullptr)
+		, Length(0)
+	{ }
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InData Pointer to the first character.
+	 * @param InLength Number of characters.
+	 */
+	FNdiMediaXmlSpan(const ANSICHAR* InData, int32 InLength)
+		: Data(InData)
+		, Length(InLength)
+	{ }
+
+public:
+
+	/**
+	 * Copy this span's text into a caller provided buffer, decoding XML entities.
+	 *
+	 * The predefined entities (&amp; &lt; &gt; &quot; &apos;) and numeric character
+	 * references in the ASCII range are decoded. The result is always null-terminated.
+	 *
+	 * @param OutBuffer The buffer to write to.
+	 * @param BufferSize Size of the buffer (in characters, including the terminator).
+	 * @return Number of characters written (excluding the terminator).
+	 */
+	int32 Decode(ANSICHAR* OutBuffer, int32 BufferSize) const;
+
+	/**
+	 * Check whether this span matches the given string (case sensitive).
+	 *
+	 * @param Other The null-terminated string to compare with.
+	 * @return true if the strings are equal, false otherwise.
+	 */
+	bool Equals(const ANSICHAR* Other) const;
+
+	/**
+	 * Check whether this span is empty.
+	 *
+	 * @return true if empty, false otherwise.
+	 */
+	bool IsEmpty() const
+	{
+		return (Length == 0);
+	}
+
+	/**
+	 * Parse this span as a floating point number.
+	 *
+	 * @param OutValue Will contain the parsed value.
+	 * @return true on success, false if the span is not a number.
+	 */
+	bool ToDouble(double& OutValue) const;
+
+	/**
+	 * Parse this span as a signed integer.
+	 *
+	 * @param OutValue Will contain the parsed value.
+	 * @return true on success, false if the span is not an integer.
+	 */
+	bool ToInt64(int64& OutValue) const;
+
+	/**
+	 * Convert this span to a string.
+	 *
+	 * This allocates memory and is intended for debugging and logging only.
+	 *
+	 * @return The string.
+	 */
+	FString ToString() const;
+};
+
+
+/**
+ * Types of tokens produced by the XML tokenizer.
+ */
+enum class ENdiMediaXmlToken : uint8
+{
+	/** An element was opened, i.e. <name. Name is set. */
+	BeginElement,
+
+	/** An attribute of the current element, i.e. key="value". Name and Value are set. */
+	Attribute,
+
+	/** An element was closed, i.e. </name> or />. Name is set. */
+	EndElement,
+
+	/** Character data between elements (whitespace-only data is skipped). Value is set. */
+	Text
+};
+
+
+/**
+ * A token produced by the XML tokenizer.
+ */
+struct FNdiMediaXmlToken
+{
+	/** The token type. */
+	ENdiMediaXmlToken Type;
+
+	/** Element or attribute name. */
+	FNdiMediaXmlSpan Name;
+
+	/** Attribute value or character data (entities are not decoded). */
+	FNdiMediaXmlSpan Value;
+
+	/** Nesting depth (0 = root element and its attributes, character data is one level below its parent). */
+	int32 Depth;
+};
+
+
+/**
+ * Streaming, allocation-free XML tokenizer for NDI metadata frames.
+ *
+ * The tokenizer works in place over the UTF-8 text of an NDI metadata frame, i.e.
+ * the data passed to IMediaBinarySink::ProcessBinarySinkData by the NDI media player,
+ * and returns spans into that buffer. It does not build a document tree, allocate
+ * memory or decode entities, which makes it suitable for high-rate metadata, such
+ * as per-frame camera tracking.
+ *
+ * Processing instructions, comments and DOCTYPE declarations are skipped. CDATA
+ * sections are returned as Text tokens. The tokenizer checks that tags are well
+ * formed, but it does not check that closing tags match their opening tags.
+ *
+ * Usage:
+ *
+ *     FNdiMediaXmlTokenizer Tokenizer((const ANSICHAR*)Data, Size);
+ *     FNdiMediaXmlToken Token;
+ *
+ *     while (Tokenizer.Next(Token))
+ *     {
+ *         if ((Token.Type == ENdiMediaXmlToken::Attribute) && Token.Name.Equals("pan"))
+ *         {
+ *             Token.Value.ToDouble(Pan);
+ *         }
+ *     }
+ */
+class NDIMEDIA_API FNdiMediaXmlTokenizer
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * Tokenization stops at the end of the buffer or at the first null character,
+	 * so the length of an NDI metadata frame (which includes the terminator) can
+	 * be passed as is.
+	 *
+	 * @param InData The XML text to tokenize.
+	 * @param InLength Length of the text (in bytes).
+	 */
+	FNdiMediaXmlTokenizer(const ANSICHAR* InData, int32 InLength);
+
+public:
+
+	/**
+	 * Check whether the tokenizer encountered malformed XML.
+	 *
+	 * @return true if an error occurred, false otherwise.
+	 * @see Next
+	 */
+	bool HasError() const
+	{
+		return Error;
+	}
+
+	/**
+	 * Get the next token.
+	 *
+	 * @param OutToken Will contain the token.
+	 * @return true if a token was returned, false at the end of the data or on error.
+	 * @see HasError, Reset
+	 */
+	bool Next(FNdiMediaXmlToken& OutToken);
+
+	/**
+	 * Restart tokenization from the beginning of the buffer.
+	 *
+	 * @see Next
+	 */
+	void Reset();
+
+protected:
+
+	/** Fail with an error and stop tokenization. */
+	bool Fail();
+
+	/** Check whether the given character is valid inside a name. */
+	static bool IsNameChar(ANSICHAR Char);
+
+	/** Check whether the given character is XML whitespace. */
+	static bool IsSpace(ANSICHAR Char)
+	{
+		return (Char == ' ') || (Char == '\t') || (Char == '\r') || (Char == '\n');
+	}
+
+	/** Read the next token inside a start tag. */
+	bool NextInTag(FNdiMediaXmlToken& OutToken);
+
+	/** Read a name starting at the current position. */
+	FNdiMediaXmlSpan ReadName();
+
+	/** Skip to (and past) the given terminator sequence. */
+	bool SkipPast(const ANSICHAR* Terminator, int32 TerminatorLength);
+
+	/** Skip whitespace at the current position. */
+	void SkipSpace();
+
+private:
+
+	/** The text being tokenized. */
+	const ANSICHAR* Data;
+
+	/** Current nesting depth. */
+	int32 Depth;
+
+	/** Whether malformed XML was encountered. */
+	bool Error;
+
+	/** Whether the current position is inside a start tag. */
+	bool InTag;
+
+	/** Length of the text. */
+	int32 Length;
+
+	/** Name of the element whose start tag is being tokenized. */
+	FNdiMediaXmlSpan OpenElement;
+
+	/** Current read position. */
+	int32 Position;
+};
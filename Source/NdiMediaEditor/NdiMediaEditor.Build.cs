@@ -12,6 +12,7 @@ namespace UnrealBuildTool.Rules
 				new string[] {
 					"Core",
 					"CoreUObject",
+					"EditorStyle",
 					"MediaAssets",
 					"NdiMedia",
 					"PropertyEditor",
@@ -32,6 +33,7 @@ namespace UnrealBuildTool.Rules
 					"NdiMediaEditor/Private",
 					"NdiMediaEditor/Private/Customizations",
 					"NdiMediaEditor/Private/Factories",
+					"NdiMediaEditor/Private/Widgets",
 				}
 			);
 		}
@@ -10,7 +10,9 @@
 #include "IDetailPropertyRow.h"
 #include "NdiMediaFinder.h"
 #include "NdiMediaSource.h"
+#include "SNdiMediaSourceThumbnail.h"
 #include "Widgets/Input/SComboButton.h"
+#include "Widgets/Text/STextBlock.h"
 
 
 #define LOCTEXT_NAMESPACE "FNdiMediaSourceCustomization"
@@ -21,6 +23,14 @@
 
 void FNdiMediaSourceCustomization::CustomizeDetails(IDetailLayoutBuilder& DetailBuilder)
 {
+	// start discovering sources before the source menus are opened
+	UNdiMediaFinder* DefaultFinder = GetMutableDefault<UNdiMediaFinder>();
+
+	if (!DefaultFinder->IsInitialized())
+	{
+		DefaultFinder->Initialize();
+	}
+
 	// customize 'NDI' category
 	IDetailCategoryBuilder& NdiCategory = DetailBuilder.EditCategory("NDI");
 	{
@@ -125,9 +135,6 @@ TSharedRef<SWidget> FNdiMediaSourceCustomization::HandleSourceComboButtonMenuCon
 			const FString UrlStr = FString(TEXT("ndi://")) + ValueStr;
 
 			MenuBuilder.AddMenuEntry(
-				FText::FromString(Source.ToString()),
-				FText::FromString(UrlStr),
-				FSlateIcon(),
 				FUIAction(
 					FExecuteAction::CreateLambda([=] {
 						ValueProperty->SetValue(ValueStr);
@@ -139,7 +146,9 @@ TSharedRef<SWidget> FNdiMediaSourceCustomization::HandleSourceComboButtonMenuCon
 						return ((ValueProperty->GetValue(CurrentValue) == FPropertyAccess::Success) && CurrentValue == ValueStr);
 					})
 				),
+				MakeSourceMenuEntryWidget(Source.ToString(), Source.Name),
 				NAME_None,
+				FText::FromString(UrlStr),
 				EUserInterfaceActionType::RadioButton
 			);
 
@@ -185,9 +194,6 @@ TSharedRef<SWidget> FNdiMediaSourceCustomization::HandleSourceComboButtonMenuCon
 			const FString UrlStr = FString(TEXT("ndi://")) + ValueStr;
 
 			MenuBuilder.AddMenuEntry(
-				FText::FromString(SourceStr),
-				FText::FromString(UrlStr),
-				FSlateIcon(),
 				FUIAction(
 					FExecuteAction::CreateLambda([=] {
 						ValueProperty->SetValue(ValueStr);
@@ -199,7 +205,9 @@ TSharedRef<SWidget> FNdiMediaSourceCustomization::HandleSourceComboButtonMenuCon
 						return ((ValueProperty->GetValue(CurrentValue) == FPropertyAccess::Success) && CurrentValue == ValueStr);
 					})
 				),
+				MakeSourceMenuEntryWidget(SourceStr, Source.Name),
 				NAME_None,
+				FText::FromString(UrlStr),
 				EUserInterfaceActionType::RadioButton
 			);
 
@@ -217,4 +225,29 @@ TSharedRef<SWidget> FNdiMediaSourceCustomization::HandleSourceComboButtonMenuCon
 }
 
 
+/* FNdiMediaSourceCustomization implementation
+ *****************************************************************************/
+
+TSharedRef<SWidget> FNdiMediaSourceCustomization::MakeSourceMenuEntryWidget(const FString& Label, const FString& ThumbnailSource)
+{
+	return SNew(SHorizontalBox)
+
+		+ SHorizontalBox::Slot()
+			.AutoWidth()
+			.Padding(0.0f, 2.0f, 6.0f, 2.0f)
+			[
+				SNew(SNdiMediaSourceThumbnail)
+					.Source(ThumbnailSource)
+			]
+
+		+ SHorizontalBox::Slot()
+			.FillWidth(1.0f)
+			.VAlign(VAlign_Center)
+			[
+				SNew(STextBlock)
+					.Text(FText::FromString(Label))
+			];
+}
+
+
 #undef LOCTEXT_NAMESPACE
@@ -43,6 +43,15 @@ private:
 	/** Callback for generating the menu content of the SourceName combo box. */
 	TSharedRef<SWidget> HandleSourceComboButtonMenuContent(EProperty Property) const;
 
+	/**
+	 * Create the widget of a source menu entry.
+	 *
+	 * @param Label The entry's label.
+	 * @param ThumbnailSource Name of the source whose thumbnail to show.
+	 * @return The widget.
+	 */
+	static TSharedRef<SWidget> MakeSourceMenuEntryWidget(const FString& Label, const FString& ThumbnailSource);
+
 private:
 
 	/** Pointer to the SourceEndpoint property handle. */
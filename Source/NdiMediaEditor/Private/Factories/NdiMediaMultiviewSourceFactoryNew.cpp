@@ -0,0 +1,39 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "NdiMediaMultiviewSourceFactoryNew.h"
+
+#include "AssetTypeCategories.h"
+#include "NdiMediaMultiviewSource.h"
+
+
+/* UNdiMediaMultiviewSourceFactoryNew structors
+ *****************************************************************************/
+
+UNdiMediaMultiviewSourceFactoryNew::UNdiMediaMultiviewSourceFactoryNew(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer)
+{
+	SupportedClass = UNdiMediaMultiviewSource::StaticClass();
+	bCreateNew = true;
+	bEditAfterNew = true;
+}
+
+
+/* UFactory overrides
+ *****************************************************************************/
+
+UObject* UNdiMediaMultiviewSourceFactoryNew::FactoryCreateNew(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, UObject* Context, FFeedbackContext* Warn)
+{
+	return NewObject<UNdiMediaMultiviewSource>(InParent, InClass, InName, Flags);
+}
+
+
+uint32 UNdiMediaMultiviewSourceFactoryNew::GetMenuCategories() const
+{
+	return EAssetTypeCategories::Media;
+}
+
+
+bool UNdiMediaMultiviewSourceFactoryNew::ShouldShowInNewMenu() const
+{
+	return true;
+}
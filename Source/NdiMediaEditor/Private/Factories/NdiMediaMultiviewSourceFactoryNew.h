@@ -0,0 +1,25 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "Factories/Factory.h"
+#include "NdiMediaMultiviewSourceFactoryNew.generated.h"
+
+
+/**
+ * Implements a factory for UNdiMediaMultiviewSource objects.
+ */
+UCLASS(hidecategories=Object)
+class UNdiMediaMultiviewSourceFactoryNew
+	: public UFactory
+{
+	GENERATED_UCLASS_BODY()
+
+public:
+
+	//~ UFactory Interface
+
+	virtual UObject* FactoryCreateNew(UClass* InClass, UObject* InParent, FName InName, EObjectFlags Flags, UObject* Context, FFeedbackContext* Warn) override;
+	virtual uint32 GetMenuCategories() const override;
+	virtual bool ShouldShowInNewMenu() const override;
+};
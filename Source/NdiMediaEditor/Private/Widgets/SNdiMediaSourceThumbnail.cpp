@@ -0,0 +1,74 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#include "SNdiMediaSourceThumbnail.h"
+
+#include "Brushes/SlateDynamicImageBrush.h"
+#include "EditorStyleSet.h"
+#include "INdiMediaModule.h"
+#include "ModuleManager.h"
+#include "NdiMediaThumbnail.h"
+#include "Widgets/Images/SImage.h"
+#include "Widgets/Layout/SBorder.h"
+#include "Widgets/Layout/SBox.h"
+
+
+/* SNdiMediaSourceThumbnail interface
+ *****************************************************************************/
+
+void SNdiMediaSourceThumbnail::Construct(const FArguments& InArgs)
+{
+	NdiMediaModule = FModuleManager::LoadModulePtr<INdiMediaModule>("NdiMedia");
+	Source = InArgs._Source;
+
+	ChildSlot
+	[
+		SNew(SBox)
+			.WidthOverride(InArgs._Size.X)
+			.HeightOverride(InArgs._Size.Y)
+			[
+				SNew(SBorder)
+					.BorderImage(FEditorStyle::GetBrush("BlackBrush"))
+					.Padding(0.0f)
+					[
+						SNew(SImage)
+							.Image(this, &SNdiMediaSourceThumbnail::HandleImageImage)
+					]
+			]
+	];
+}
+
+
+/* SWidget interface
+ *****************************************************************************/
+
+void SNdiMediaSourceThumbnail::Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime)
+{
+	SCompoundWidget::Tick(AllottedGeometry, InCurrentTime, InDeltaTime);
+
+	if (NdiMediaModule == nullptr)
+	{
+		return;
+	}
+
+	// requesting the thumbnail also keeps it fresh while the widget is visible
+	TSharedPtr<FNdiMediaThumbnail, ESPMode::ThreadSafe> NewThumbnail = NdiMediaModule->GetThumbnail(Source);
+
+	if (!NewThumbnail.IsValid() || (NewThumbnail == Thumbnail))
+	{
+		return;
+	}
+
+	Thumbnail = NewThumbnail;
+
+	const FName ResourceName = *FString::Printf(TEXT("NdiMediaThumbnail %s %lld"), *Source, Thumbnail->Time.GetTicks());
+	Brush = FSlateDynamicImageBrush::CreateWithImageData(ResourceName, FVector2D(Thumbnail->Width, Thumbnail->Height), Thumbnail->Pixels);
+}
+
+
+/* SNdiMediaSourceThumbnail callbacks
+ *****************************************************************************/
+
+const FSlateBrush* SNdiMediaSourceThumbnail::HandleImageImage() const
+{
+	return Brush.IsValid() ? Brush.Get() : FEditorStyle::GetNoBrush();
+}
@@ -0,0 +1,72 @@
+// Copyright 2015 Headcrash Industries LLC. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/DeclarativeSyntaxSupport.h"
+#include "Widgets/SCompoundWidget.h"
+
+
+class INdiMediaModule;
+struct FNdiMediaThumbnail;
+struct FSlateBrush;
+struct FSlateDynamicImageBrush;
+
+
+/**
+ * Displays the thumbnail of an NDI media source.
+ *
+ * The thumbnail is requested from the NdiMedia module while the widget is
+ * visible, and the image is updated whenever a new thumbnail was captured.
+ */
+class SNdiMediaSourceThumbnail
+	: public SCompoundWidget
+{
+public:
+
+	SLATE_BEGIN_ARGS(SNdiMediaSourceThumbnail)
+		: _Size(FVector2D(80.0f, 45.0f))
+	{ }
+
+		/** The size at which the thumbnail is displayed. */
+		SLATE_ARGUMENT(FVector2D, Size)
+
+		/** The source's name or IP endpoint. */
+		SLATE_ARGUMENT(FString, Source)
+
+	SLATE_END_ARGS()
+
+public:
+
+	/**
+	 * Construct this widget.
+	 *
+	 * @param InArgs The declaration data for this widget.
+	 */
+	void Construct(const FArguments& InArgs);
+
+public:
+
+	//~ SWidget interface
+
+	virtual void Tick(const FGeometry& AllottedGeometry, const double InCurrentTime, const float InDeltaTime) override;
+
+private:
+
+	/** Callback for getting the brush of the thumbnail image. */
+	const FSlateBrush* HandleImageImage() const;
+
+private:
+
+	/** The brush holding the current thumbnail. */
+	TSharedPtr<FSlateDynamicImageBrush> Brush;
+
+	/** Pointer to the NdiMedia module. */
+	INdiMediaModule* NdiMediaModule;
+
+	/** The source's name or IP endpoint. */
+	FString Source;
+
+	/** The thumbnail that the brush was created from. */
+	TSharedPtr<FNdiMediaThumbnail, ESPMode::ThreadSafe> Thumbnail;
+};
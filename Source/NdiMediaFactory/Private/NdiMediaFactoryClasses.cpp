@@ -9,7 +9,20 @@ UNdiMediaSettings::UNdiMediaSettings(const FObjectInitializer& ObjectInitializer
 	, ProductName(TEXT("NdiMedia"))
 	, ProductDescription(TEXT("Unreal Engine 4 plug-in for NDI media streaming"))
 	, Manufacturer(TEXT("Headcrash Industries LLC"))
+	, ConnectionPollInterval(0.25f)
+	, Revision(0)
 {
 	TSharedPtr<IPlugin> Plugin = IPluginManager::Get().FindPlugin(TEXT("NdiMedia"));
 	VersionName = Plugin.IsValid() ? Plugin->GetDescriptor().VersionName : FString(TEXT("1.0"));
 }
+
+
+#if WITH_EDITOR
+
+void UNdiMediaSettings::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	++Revision;
+}
+
+#endif //WITH_EDITOR
@@ -4,6 +4,7 @@
 #include "IMediaPlayerFactory.h"
 #include "IMediaModule.h"
 #include "INdiMediaModule.h"
+#include "Misc/Paths.h"
 #include "ModuleInterface.h"
 #include "ModuleManager.h"
 #include "UObject/Class.h"
@@ -47,6 +48,24 @@ public:
 			return false;
 		}
 
+		// check file extension
+		if (Scheme == TEXT("file"))
+		{
+			const FString Extension = FPaths::GetExtension(Location, false);
+
+			if (!SupportedFileExtensions.Contains(Extension))
+			{
+				if (OutErrors != nullptr)
+				{
+					OutErrors->Add(FText::Format(LOCTEXT("ExtensionNotSupported", "The file extension '{0}' is not supported"), FText::FromString(Extension)));
+				}
+
+				return false;
+			}
+
+			return true;
+		}
+
 		if (!SupportedUriSchemes.Contains(Scheme))
 		{
 			if (OutErrors != nullptr)
@@ -93,8 +112,12 @@ public:
 		SupportedPlatforms.Add(TEXT("Mac"));
 		SupportedPlatforms.Add(TEXT("Windows"));
 
+		// supported file extensions
+		SupportedFileExtensions.Add(TEXT("ndirec"));
+
 		// supported schemes
 		SupportedUriSchemes.Add(TEXT("ndi"));
+		SupportedUriSchemes.Add(TEXT("ndimv"));
 
 #if WITH_EDITOR
 		// register settings
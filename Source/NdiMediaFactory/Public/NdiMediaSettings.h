@@ -42,8 +42,41 @@ class NDIMEDIAFACTORY_API UNdiMediaSettings
 	UPROPERTY(config, EditAnywhere, Category=Connection, AdvancedDisplay, meta=(Multiline="true"))
 	FString CustomMetaData;
 
+	/**
+	 * How often the connections of all NDI receivers are checked (in seconds, default = 0.25).
+	 *
+	 * Connections are checked on a background thread. Receivers whose source stays
+	 * disconnected are recreated, with increasing delays between attempts.
+	 */
+	UPROPERTY(config, EditAnywhere, Category=Connection, AdvancedDisplay, meta=(ClampMin="0.01"))
+	float ConnectionPollInterval;
+
+	/**
+	 * Path to the NDI runtime library to load (empty = default).
+	 *
+	 * Use this setting to pick up a newer NDI runtime without rebuilding the plug-in.
+	 * The path may name the library file or the directory that contains it. If it
+	 * is empty or the library can't be used, the runtime in the directory named by
+	 * the NDI_RUNTIME_DIR_V2 environment variable and the runtime that ships with
+	 * the plug-in are tried in that order. Changes take effect after a restart.
+	 */
+	UPROPERTY(config, EditAnywhere, Category=Runtime, AdvancedDisplay)
+	FString RuntimeLibraryPath;
+
 public:
 
+	/**
+	 * Get the number of times the settings were changed.
+	 *
+	 * Use this to invalidate data that is derived from the settings.
+	 *
+	 * @return Revision number.
+	 */
+	uint32 GetRevision() const
+	{
+		return Revision;
+	}
+
 	/**
 	 * Get the plug-in's version number.
 	 *
@@ -54,8 +87,19 @@ public:
 		return VersionName;
 	}
 
+public:
+
+	//~ UObject interface
+
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
 private:
 
+	/** Number of times the settings were changed. */
+	uint32 Revision;
+
 	/** Version number of this plug-in. */
 	FString VersionName;
 };